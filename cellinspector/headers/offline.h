@@ -0,0 +1,18 @@
+#ifndef __OFFLINE_H__
+#define __OFFLINE_H__
+
+#include "srsran/srsran.h"
+#include "cellinspector/headers/asn_decoder.h"
+
+/* Parallel decoding of a recorded capture. The file is memory-mapped, a first
+ * pass finds the frame timing and reads SIB1, then the capture is split in
+ * chunks of whole radio frames decoded by the workers. Only the SIB1 subframes
+ * and the SI windows are decoded. The messages are pushed in TTI order */
+
+#define OFFLINE_CHUNK_FRAMES        512     // radio frames per chunk
+#define OFFLINE_SYNC_FRAMES         8       // frames read before a chunk to find the PSS and the SFN
+#define OFFLINE_FIRST_PASS_FRAMES   200     // the first pass looks for the MIB and SIB1 in these frames
+
+int offline_decode(char* input, srsran_cell_t* cell, ASNDecoder* decoder, int nof_workers);
+
+#endif
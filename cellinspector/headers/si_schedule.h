@@ -0,0 +1,33 @@
+#ifndef __SI_SCHEDULE_H__
+#define __SI_SCHEDULE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "srsran/phy/common/phy_common.h"
+
+#define SI_SCHEDULE_MAX_SI 32
+
+/* Where the SI messages can be, from the scheduling info of SIB1 (36.331 5.2.3) */
+typedef struct {
+    bool                valid;
+    uint32_t            win_len;                            // SI window, subframes
+    uint32_t            nof_si;
+    uint32_t            periodicity[SI_SCHEDULE_MAX_SI];    // radio frames, one per SI message
+    srsran_tdd_config_t tdd_config;
+} si_schedule_t;
+
+/* len in bits. Returns 0 if the payload is a SIB1 and the schedule is filled */
+int si_schedule_from_sib1(const uint8_t* payload, uint32_t len, si_schedule_t* sched);
+
+/* SIB1 subframes and the SI windows, every subframe if the schedule is not known */
+bool si_schedule_is_si_sf(si_schedule_t* sched, uint32_t sfn, uint32_t sf_idx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -201,6 +201,10 @@ ASNDecoder * init_asn_decoder(char * path, char * name)
 
 void terminate_asn_decoder(ASNDecoder * decoder)
 {
+    /* Let the processor write the messages still in the queue */
+    while(decoder->first != NULL && decoder->file != NULL) {
+        usleep(MSG_QUEUE_POLL_TIME);
+    }
     pthread_mutex_lock(&(decoder->file_mux));
     fclose(decoder->file);
     decoder->file = NULL;
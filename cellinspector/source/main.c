@@ -35,6 +35,7 @@
 /* Local libs */
 #include "cellinspector/headers/cpu.h"
 #include "cellinspector/headers/asn_decoder.h"
+#include "cellinspector/headers/offline.h"
 
 /* SRS libs */
 #include "srsran/common/crash_handler.h"
@@ -72,6 +73,7 @@ typedef struct {
   char *   output;
   char *   input;
   char *   cell;
+  int      nof_workers;
 } prog_args_t;
 
 void args_default(prog_args_t* args)
@@ -81,16 +83,18 @@ void args_default(prog_args_t* args)
   args->output         = ".";
   args->input          = NULL;
   args->cell           = NULL;
+  args->nof_workers    = 0;
 }
 
 void usage(prog_args_t* args, char* prog)
 {
-  printf("Usage: %s [oiafn]\n", prog);
+  printf("Usage: %s [oiacfn]\n", prog);
   printf("\t-o Output folder\n");
   printf("\t-i Input file (cannot use with -f)\n");
   printf("\t-c Cell info file (use with -i)\n");
   printf("\t-a RF args [Default %s]\n", args->rf_args);
   printf("\t-f rx_frequency (in Hz)\n");
+  printf("\t-n decode the input file on this many threads, SI subframes only (use with -i) [Default 0: one thread, every subframe]\n");
 }
 
 void parse_args(prog_args_t* args, int argc, char** argv)
@@ -98,7 +102,7 @@ void parse_args(prog_args_t* args, int argc, char** argv)
   int opt;
   args_default(args);
 
-  while ((opt = getopt(argc, argv, "hafoci")) != -1) {
+  while ((opt = getopt(argc, argv, "hafocin")) != -1) {
     switch (opt) {
         case 'a':
             args->rf_args = argv[optind];
@@ -115,6 +119,9 @@ void parse_args(prog_args_t* args, int argc, char** argv)
         case 'c':
             args->cell = argv[optind];
             break;
+        case 'n':
+            args->nof_workers = atoi(argv[optind]);
+            break;
         case 'h':
             usage(args, argv[0]);
             exit(0);
@@ -340,6 +347,13 @@ int main(int argc, char** argv)
         if(read_cell_from_file(prog_args.cell, &cell)) {
             exit(1);
         }
+        /* Parallel decoding of the whole capture */
+        if(prog_args.nof_workers > 0) {
+            ret = offline_decode(prog_args.input, &cell, decoder, prog_args.nof_workers);
+            terminate_asn_decoder(decoder);
+            printf("\nBye\n");
+            exit(ret ? 1 : 0);
+        }
         /* Initialize structures to get IQs from file */
         if (srsran_ue_sync_init_file_multi(&ue_sync,
                                         cell.nof_prb,
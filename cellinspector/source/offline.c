@@ -0,0 +1,517 @@
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "cellinspector/headers/offline.h"
+#include "cellinspector/headers/si_schedule.h"
+
+#define OFFLINE_MAX_TTI 10240
+
+extern bool go_exit;
+
+/*************************/
+/* Structure definitions */
+/*************************/
+
+/* A decoded message, kept until the chunks before it are pushed */
+typedef struct {
+    int64_t     key;        // subframe since the first pass MIB, then message in the subframe
+    uint32_t    tti;
+    PayloadType type;
+    int         len;
+    uint8_t*    payload;
+} offline_msg_t;
+
+/* Radio frames decoded by one worker, the subframes starting in [start, end) belong to it */
+typedef struct {
+    uint64_t       start;
+    uint64_t       end;
+    offline_msg_t* msg;
+    int            nof_msg;
+    int            max_msg;
+    bool           done;
+} offline_chunk_t;
+
+typedef struct {
+    cf_t*            samples;       // the mapped capture
+    uint64_t         nof_samples;
+    size_t           map_size;
+    srsran_cell_t    cell;
+    uint32_t         sf_len;
+
+    /* Timing found by the first pass */
+    uint64_t         frame0_pos;
+    uint32_t         frame0_sfn;
+    si_schedule_t    sched;
+
+    offline_chunk_t* chunks;
+    uint32_t         nof_chunks;
+    uint32_t         next_chunk;
+    int              nof_running;
+    pthread_mutex_t  mutex;
+    pthread_cond_t   cond;
+} offline_ctx_t;
+
+typedef struct {
+    offline_ctx_t*         ctx;
+    pthread_t              thread;
+
+    /* Region of the capture read by ue_sync */
+    uint64_t               pos;
+    uint64_t               end;
+
+    srsran_ue_sync_t       ue_sync;
+    srsran_ue_mib_t        ue_mib;
+    srsran_ue_dl_t         ue_dl;
+    srsran_ue_dl_cfg_t     ue_dl_cfg;
+    srsran_dl_sf_cfg_t     dl_sf;
+    srsran_pdsch_cfg_t     pdsch_cfg;
+    srsran_chest_dl_cfg_t  chest_pdsch_cfg;
+    srsran_softbuffer_rx_t rx_softbuffers[SRSRAN_MAX_CODEWORDS];
+    cf_t*                  sf_buffer[SRSRAN_MAX_PORTS];
+    uint32_t               max_num_samples;
+    uint8_t*               data[SRSRAN_MAX_CODEWORDS];
+
+    uint64_t               nof_decoded;
+    uint64_t               nof_skipped;
+} offline_worker_t;
+
+
+/*********************************/
+/* Capture access and bookkeeping */
+/*********************************/
+
+/* ue_sync reads the mapped capture, the end of the region is the end of the stream */
+static int offline_recv(void* h, cf_t* data[SRSRAN_MAX_PORTS], uint32_t nsamples, srsran_timestamp_t* t)
+{
+    offline_worker_t* w = (offline_worker_t*)h;
+    if (w->pos + nsamples > w->end) {
+        return SRSRAN_ERROR;
+    }
+    memcpy(data[0], &w->ctx->samples[w->pos], nsamples * sizeof(cf_t));
+    w->pos += nsamples;
+    return nsamples;
+}
+
+/* Subframes counted from the subframe 0 of the first pass. The TTI wraps every
+ * 10.24 s and the sample clock drifts, the position only picks the TTI period */
+static int64_t offline_abs_sf(offline_ctx_t* ctx, uint64_t sf_pos, uint32_t tti)
+{
+    int64_t nominal = llround(((double)sf_pos - (double)ctx->frame0_pos) / ctx->sf_len);
+    int64_t d       = ((int64_t)tti - (int64_t)ctx->frame0_sfn * 10 - nominal) % OFFLINE_MAX_TTI;
+    if (d < 0) {
+        d += OFFLINE_MAX_TTI;
+    }
+    if (d >= OFFLINE_MAX_TTI / 2) {
+        d -= OFFLINE_MAX_TTI;
+    }
+    return nominal + d;
+}
+
+static void offline_chunk_add(offline_chunk_t* chunk, int64_t key, uint32_t tti, PayloadType type, uint8_t* payload, int len)
+{
+    if (chunk->nof_msg == chunk->max_msg) {
+        int            max_msg = chunk->max_msg > 0 ? 2 * chunk->max_msg : 64;
+        offline_msg_t* msg     = (offline_msg_t*)realloc(chunk->msg, max_msg * sizeof(offline_msg_t));
+        if (msg == NULL) {
+            printf("Error allocating the decoded messages\n");
+            return;
+        }
+        chunk->msg     = msg;
+        chunk->max_msg = max_msg;
+    }
+    offline_msg_t* m = &chunk->msg[chunk->nof_msg];
+    if ((m->payload = (uint8_t*)malloc(len)) == NULL) {
+        return;
+    }
+    memcpy(m->payload, payload, len);
+    m->key  = key;
+    m->tti  = tti;
+    m->type = type;
+    m->len  = len;
+    chunk->nof_msg++;
+}
+
+
+/***********/
+/* Workers */
+/***********/
+
+static int offline_worker_init(offline_worker_t* w, offline_ctx_t* ctx)
+{
+    srsran_cell_t cell = ctx->cell;
+
+    bzero(w, sizeof(offline_worker_t));
+    w->ctx             = ctx;
+    w->max_num_samples = 3 * ctx->sf_len;
+    if ((w->sf_buffer[0] = srsran_vec_cf_malloc(w->max_num_samples)) == NULL) {
+        return -1;
+    }
+    for (int i = 0; i < SRSRAN_MAX_CODEWORDS; i++) {
+        if ((w->data[i] = srsran_vec_u8_malloc(2000 * 8)) == NULL) {
+            return -1;
+        }
+    }
+
+    /* Each worker finds the PSS again at the start of its chunk */
+    if (srsran_ue_sync_init_multi_decim(&w->ue_sync, cell.nof_prb, false, offline_recv, 1, (void*)w, 0) ||
+        srsran_ue_sync_set_cell(&w->ue_sync, cell)) {
+        ERROR("Error initiating ue_sync");
+        return -1;
+    }
+    w->ue_sync.cfo_correct_enable_track = true;
+
+    if (srsran_ue_mib_init(&w->ue_mib, w->sf_buffer[0], cell.nof_prb) || srsran_ue_mib_set_cell(&w->ue_mib, cell)) {
+        ERROR("Error initaiting UE MIB decoder");
+        return -1;
+    }
+    if (srsran_ue_dl_init(&w->ue_dl, w->sf_buffer, cell.nof_prb, 1) || srsran_ue_dl_set_cell(&w->ue_dl, cell)) {
+        ERROR("Error initiating UE downlink processing module");
+        return -1;
+    }
+
+    w->pdsch_cfg.meas_evm_en = true;
+    w->pdsch_cfg.rnti        = SRSRAN_SIRNTI; /* Broadcast RNTI */
+    for (uint32_t i = 0; i < SRSRAN_MAX_CODEWORDS; i++) {
+        w->pdsch_cfg.softbuffers.rx[i] = &w->rx_softbuffers[i];
+        srsran_softbuffer_rx_init(w->pdsch_cfg.softbuffers.rx[i], cell.nof_prb);
+    }
+
+    w->chest_pdsch_cfg.cfo_estimate_enable  = false;
+    w->chest_pdsch_cfg.cfo_estimate_sf_mask = 1023;
+    w->chest_pdsch_cfg.estimator_alg        = srsran_chest_dl_str2estimator_alg("interpolate");
+    w->chest_pdsch_cfg.sync_error_enable    = true;
+    return 0;
+}
+
+static void offline_worker_free(offline_worker_t* w)
+{
+    if (w->ctx == NULL) {
+        return;
+    }
+    srsran_ue_dl_free(&w->ue_dl);
+    srsran_ue_mib_free(&w->ue_mib);
+    srsran_ue_sync_free(&w->ue_sync);
+    for (int i = 0; i < SRSRAN_MAX_CODEWORDS; i++) {
+        srsran_softbuffer_rx_free(&w->rx_softbuffers[i]);
+        if (w->data[i]) {
+            free(w->data[i]);
+        }
+    }
+    if (w->sf_buffer[0]) {
+        free(w->sf_buffer[0]);
+    }
+}
+
+/* PDSCH on the SI-RNTI of one subframe. Without a chunk (first pass) SIB1 gives the SI schedule */
+static void offline_decode_sf(offline_worker_t* w, offline_chunk_t* chunk, uint32_t sfn, uint32_t sf_idx, uint64_t sf_pos)
+{
+    offline_ctx_t* ctx = w->ctx;
+    uint32_t       tti = sfn * 10 + sf_idx;
+    int            n   = 0;
+
+    w->nof_decoded++;
+    for (uint32_t tm = 0; tm < 4 && !n; tm++) {
+        bool acks[SRSRAN_MAX_CODEWORDS] = {false};
+
+        w->dl_sf.tti                             = tti;
+        w->dl_sf.sf_type                         = SRSRAN_SF_NORM;
+        w->dl_sf.tdd_config                      = ctx->sched.tdd_config;
+        w->ue_dl_cfg.cfg.tm                      = (srsran_tm_t)tm; /* Transmission mode */
+        w->ue_dl_cfg.cfg.pdsch.use_tbs_index_alt = false;           /*enable_256qam*/
+        w->ue_dl_cfg.chest_cfg                   = w->chest_pdsch_cfg;
+
+        if ((w->ue_dl_cfg.cfg.tm == SRSRAN_TM1 && ctx->cell.nof_ports == 1) ||
+            (w->ue_dl_cfg.cfg.tm > SRSRAN_TM1 && ctx->cell.nof_ports > 1)) {
+            n = srsran_ue_dl_find_and_decode(&w->ue_dl, &w->dl_sf, &w->ue_dl_cfg, &w->pdsch_cfg, w->data, acks);
+            if (n > 0) {
+                for (uint32_t tb = 0; tb < SRSRAN_MAX_CODEWORDS; tb++) {
+                    if (w->pdsch_cfg.grant.tb[tb].enabled && acks[tb]) {
+                        int len = w->pdsch_cfg.grant.tb[tb].tbs;
+                        if (chunk != NULL) {
+                            int64_t key = offline_abs_sf(ctx, sf_pos, tti) * 4 + 1 + tb;
+                            offline_chunk_add(chunk, key, tti, SIB_4G, w->data[tb], len);
+                        } else if (sf_idx == 5 && sfn % 2 == 0 && !ctx->sched.valid) {
+                            si_schedule_from_sib1(w->data[tb], len, &ctx->sched);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+/* Decodes the region [start, end) of the capture. With a chunk, only the
+ * subframes starting in it are kept. Without, it is the first pass: it
+ * stops once the frame timing and the SI schedule are known */
+static int offline_run(offline_worker_t* w, offline_chunk_t* chunk, uint64_t start, uint64_t end)
+{
+    offline_ctx_t* ctx       = w->ctx;
+    bool           mib_found = false;
+    uint32_t       sfn       = 0;
+    int            n;
+
+    w->pos = start;
+    w->end = end;
+    srsran_ue_sync_reset(&w->ue_sync);
+    srsran_pbch_decode_reset(&w->ue_mib.pbch);
+
+    while (!go_exit) {
+        cf_t* buffers[SRSRAN_MAX_CHANNELS] = {w->sf_buffer[0]};
+
+        /* An error is the end of the region */
+        n = srsran_ue_sync_zerocopy(&w->ue_sync, buffers, w->max_num_samples);
+        if (n < 0) {
+            break;
+        } else if (n == 0) {
+            continue;
+        }
+        uint32_t sf_idx = srsran_ue_sync_get_sfidx(&w->ue_sync);
+        uint64_t sf_pos = w->pos >= w->ue_sync.frame_len ? w->pos - w->ue_sync.frame_len : 0;
+        if (chunk != NULL && sf_pos + ctx->sf_len / 2 >= chunk->end) {
+            break;
+        }
+
+        /* The SFN is needed first */
+        if (!mib_found) {
+            if (sf_idx != 0) {
+                continue;
+            }
+            uint8_t bch_payload[SRSRAN_BCH_PAYLOAD_LEN];
+            int     sfn_offset;
+            bzero(bch_payload, SRSRAN_BCH_PAYLOAD_LEN);
+            n = srsran_ue_mib_decode(&w->ue_mib, bch_payload, NULL, &sfn_offset);
+            if (n < 0) {
+                ERROR("Error decoding UE MIB");
+                return -1;
+            } else if (n != SRSRAN_UE_MIB_FOUND) {
+                continue;
+            }
+            srsran_cell_t cell = ctx->cell;
+            srsran_pbch_mib_unpack(bch_payload, &cell, &sfn);
+            sfn       = (sfn + sfn_offset) % 1024;
+            mib_found = true;
+            if (chunk == NULL) {
+                ctx->frame0_pos = sf_pos;
+                ctx->frame0_sfn = sfn;
+            } else if (sf_pos + ctx->sf_len / 2 >= chunk->start) {
+                offline_chunk_add(chunk, offline_abs_sf(ctx, sf_pos, sfn * 10) * 4, sfn * 10, MIB_4G, bch_payload,
+                                  SRSRAN_BCH_PAYLOAD_LEN);
+            }
+        }
+
+        bool owned = chunk != NULL && sf_pos + ctx->sf_len / 2 >= chunk->start;
+        if (chunk == NULL ? (sf_idx == 5 && sfn % 2 == 0) : (owned && si_schedule_is_si_sf(&ctx->sched, sfn, sf_idx))) {
+            offline_decode_sf(w, chunk, sfn, sf_idx, sf_pos);
+            if (chunk == NULL && ctx->sched.valid) {
+                return 0;
+            }
+        } else if (owned) {
+            w->nof_skipped++;
+        }
+
+        if (sf_idx == 9) {
+            sfn = (sfn + 1) % 1024;
+        }
+    }
+    return mib_found ? 0 : -1;
+}
+
+static void* offline_worker_thread(void* arg)
+{
+    offline_worker_t* w          = (offline_worker_t*)arg;
+    offline_ctx_t*    ctx        = w->ctx;
+    uint64_t          sync_len   = (uint64_t)OFFLINE_SYNC_FRAMES * 10 * ctx->sf_len;
+    uint64_t          frame_len  = 10 * ctx->sf_len;
+
+    while (!go_exit) {
+        pthread_mutex_lock(&ctx->mutex);
+        if (ctx->next_chunk == ctx->nof_chunks) {
+            pthread_mutex_unlock(&ctx->mutex);
+            break;
+        }
+        offline_chunk_t* chunk = &ctx->chunks[ctx->next_chunk++];
+        pthread_mutex_unlock(&ctx->mutex);
+
+        /* Some frames before the chunk to sync, one after for the last subframes */
+        uint64_t start = chunk->start > sync_len ? chunk->start - sync_len : 0;
+        uint64_t end   = SRSRAN_MIN(chunk->end + frame_len, ctx->nof_samples);
+        if (offline_run(w, chunk, start, end) < 0) {
+            printf("No MIB found in the chunk at sample %lu\n", chunk->start);
+        }
+
+        pthread_mutex_lock(&ctx->mutex);
+        chunk->done = true;
+        pthread_cond_broadcast(&ctx->cond);
+        pthread_mutex_unlock(&ctx->mutex);
+    }
+
+    pthread_mutex_lock(&ctx->mutex);
+    ctx->nof_running--;
+    pthread_cond_broadcast(&ctx->cond);
+    pthread_mutex_unlock(&ctx->mutex);
+    return NULL;
+}
+
+
+/********************/
+/* Public functions */
+/********************/
+
+int offline_decode(char* input, srsran_cell_t* cell, ASNDecoder* decoder, int nof_workers)
+{
+    offline_ctx_t     ctx;
+    offline_worker_t* workers = NULL;
+    struct stat       st;
+    struct timeval    t_start, t_end;
+    int               ret = -1;
+
+    bzero(&ctx, sizeof(offline_ctx_t));
+    ctx.cell   = *cell;
+    ctx.sf_len = SRSRAN_SF_LEN_PRB(cell->nof_prb);
+    pthread_mutex_init(&ctx.mutex, NULL);
+    pthread_cond_init(&ctx.cond, NULL);
+    gettimeofday(&t_start, NULL);
+
+    /* The capture is not read in memory, the workers touch their chunk only */
+    int fd = open(input, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(cf_t)) {
+        printf("Error opening %s\n", input);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    ctx.map_size    = st.st_size;
+    ctx.nof_samples = st.st_size / sizeof(cf_t);
+    ctx.samples     = (cf_t*)mmap(NULL, ctx.map_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ctx.samples == MAP_FAILED) {
+        printf("Error mapping %s\n", input);
+        return -1;
+    }
+    madvise(ctx.samples, ctx.map_size, MADV_SEQUENTIAL);
+
+    nof_workers = SRSRAN_MAX(nof_workers, 1);
+    workers     = (offline_worker_t*)calloc(nof_workers, sizeof(offline_worker_t));
+    if (workers == NULL) {
+        goto clean_exit;
+    }
+    for (int i = 0; i < nof_workers; i++) {
+        if (offline_worker_init(&workers[i], &ctx)) {
+            printf("Error initiating the offline worker %d\n", i);
+            goto clean_exit;
+        }
+    }
+
+    /* First pass: frame timing from the MIB, SI windows from SIB1 */
+    uint64_t frame_len = 10 * ctx.sf_len;
+    if (offline_run(&workers[0], NULL, 0, SRSRAN_MIN(ctx.nof_samples, OFFLINE_FIRST_PASS_FRAMES * frame_len)) < 0) {
+        printf("No MIB found in the first %d frames of the capture\n", OFFLINE_FIRST_PASS_FRAMES);
+        goto clean_exit;
+    }
+    if (ctx.sched.valid) {
+        printf("SI schedule: window %d ms, %d SI messages\n", ctx.sched.win_len, ctx.sched.nof_si);
+    } else {
+        printf("SIB1 not decoded in the first %d frames, every subframe is decoded\n", OFFLINE_FIRST_PASS_FRAMES);
+    }
+    workers[0].nof_decoded = 0;
+
+    /* Chunks of whole frames from the subframe 0 found by the first pass */
+    uint64_t chunk_len = (uint64_t)OFFLINE_CHUNK_FRAMES * frame_len;
+    for (int pass = 0; pass < 2; pass++) {
+        uint64_t start = 0;
+        uint64_t end   = ctx.frame0_pos + chunk_len;
+        ctx.nof_chunks = 0;
+        while (start < ctx.nof_samples) {
+            if (pass == 1) {
+                ctx.chunks[ctx.nof_chunks].start = start;
+                ctx.chunks[ctx.nof_chunks].end   = SRSRAN_MIN(end, ctx.nof_samples);
+            }
+            ctx.nof_chunks++;
+            start = end;
+            end += chunk_len;
+        }
+        if (pass == 0 && (ctx.chunks = (offline_chunk_t*)calloc(ctx.nof_chunks, sizeof(offline_chunk_t))) == NULL) {
+            goto clean_exit;
+        }
+    }
+    printf("Decoding %.1f s of capture in %d chunks with %d workers\n",
+           (double)ctx.nof_samples / srsran_sampling_freq_hz(cell->nof_prb), ctx.nof_chunks, nof_workers);
+
+    ctx.nof_running = nof_workers;
+    for (int i = 0; i < nof_workers; i++) {
+        pthread_create(&workers[i].thread, NULL, offline_worker_thread, &workers[i]);
+    }
+
+    /* Merge: the chunks are pushed in order as they complete, the overlap is not pushed twice */
+    int64_t last_key = INT64_MIN;
+    for (uint32_t i = 0; i < ctx.nof_chunks; i++) {
+        offline_chunk_t* chunk = &ctx.chunks[i];
+        pthread_mutex_lock(&ctx.mutex);
+        while (!chunk->done && ctx.nof_running > 0) {
+            pthread_cond_wait(&ctx.cond, &ctx.mutex);
+        }
+        bool done = chunk->done;
+        pthread_mutex_unlock(&ctx.mutex);
+        if (!done) {
+            break;
+        }
+        for (int m = 0; m < chunk->nof_msg; m++) {
+            offline_msg_t* msg = &chunk->msg[m];
+            if (msg->key > last_key) {
+                if (push_asn_payload(decoder, msg->payload, msg->len, msg->type, msg->tti)) {
+                    printf("Error pushing SIB payload\n");
+                }
+                last_key = msg->key;
+            }
+            free(msg->payload);
+        }
+        free(chunk->msg);
+        chunk->msg     = NULL;
+        chunk->nof_msg = 0;
+        printf("Chunk %d/%d decoded\n", i + 1, ctx.nof_chunks);
+    }
+    for (int i = 0; i < nof_workers; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+
+    uint64_t nof_decoded = 0, nof_skipped = 0;
+    for (int i = 0; i < nof_workers; i++) {
+        nof_decoded += workers[i].nof_decoded;
+        nof_skipped += workers[i].nof_skipped;
+    }
+    gettimeofday(&t_end, NULL);
+    printf("%lu subframes decoded, %lu without SI skipped, in %.1f s\n", nof_decoded, nof_skipped,
+           (t_end.tv_sec - t_start.tv_sec) + (t_end.tv_usec - t_start.tv_usec) / 1e6);
+    ret = 0;
+
+clean_exit:
+    if (ctx.chunks != NULL) {
+        for (uint32_t i = 0; i < ctx.nof_chunks; i++) {
+            for (int m = 0; m < ctx.chunks[i].nof_msg; m++) {
+                free(ctx.chunks[i].msg[m].payload);
+            }
+            free(ctx.chunks[i].msg);
+        }
+        free(ctx.chunks);
+    }
+    if (workers != NULL) {
+        for (int i = 0; i < nof_workers; i++) {
+            offline_worker_free(&workers[i]);
+        }
+        free(workers);
+    }
+    munmap(ctx.samples, ctx.map_size);
+    pthread_mutex_destroy(&ctx.mutex);
+    pthread_cond_destroy(&ctx.cond);
+    return ret;
+}
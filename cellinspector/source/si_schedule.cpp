@@ -0,0 +1,52 @@
+#include <string.h>
+#include "cellinspector/headers/si_schedule.h"
+#include "srsran/asn1/rrc.h"
+
+int si_schedule_from_sib1(const uint8_t* payload, uint32_t len, si_schedule_t* sched)
+{
+    asn1::rrc::bcch_dl_sch_msg_s dlsch_msg;
+    asn1::cbit_ref               dlsch_bref(payload, len / 8);
+
+    if (dlsch_msg.unpack(dlsch_bref) != asn1::SRSASN_SUCCESS ||
+        dlsch_msg.msg.type().value != asn1::rrc::bcch_dl_sch_msg_type_c::types_opts::c1 ||
+        dlsch_msg.msg.c1().type().value != asn1::rrc::bcch_dl_sch_msg_type_c::c1_c_::types_opts::sib_type1) {
+        return -1;
+    }
+    asn1::rrc::sib_type1_s& sib1 = dlsch_msg.msg.c1().sib_type1();
+
+    memset(sched, 0, sizeof(si_schedule_t));
+    sched->win_len = sib1.si_win_len.to_number();
+    for (uint32_t i = 0; i < sib1.sched_info_list.size() && i < SI_SCHEDULE_MAX_SI; i++) {
+        sched->periodicity[sched->nof_si++] = sib1.sched_info_list[i].si_periodicity.to_number();
+    }
+    if (sib1.tdd_cfg_present) {
+        sched->tdd_config.sf_config  = sib1.tdd_cfg.sf_assign.to_number();
+        sched->tdd_config.ss_config  = sib1.tdd_cfg.special_sf_patterns.to_number();
+        sched->tdd_config.configured = true;
+    }
+    sched->valid = true;
+    return 0;
+}
+
+bool si_schedule_is_si_sf(si_schedule_t* sched, uint32_t sfn, uint32_t sf_idx)
+{
+    /* SIB1 */
+    if (sf_idx == 5 && sfn % 2 == 0) {
+        return true;
+    }
+    if (!sched->valid) {
+        return true;
+    }
+    if (sched->tdd_config.configured && srsran_sfidx_tdd_type(sched->tdd_config, sf_idx) == SRSRAN_TDD_SF_U) {
+        return false;
+    }
+    /* The window of the n-th SI message starts x = n * w subframes into its period */
+    for (uint32_t n = 0; n < sched->nof_si; n++) {
+        uint32_t x   = n * sched->win_len;
+        uint32_t pos = (sfn % sched->periodicity[n]) * 10 + sf_idx;
+        if (pos >= x && pos < x + sched->win_len) {
+            return true;
+        }
+    }
+    return false;
+}
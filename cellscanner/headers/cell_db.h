@@ -0,0 +1,63 @@
+#ifndef __CELL_DB_H__
+#define __CELL_DB_H__
+
+#include <stdint.h>
+#include <time.h>
+#include "cellscanner/headers/cell_scan.h"
+
+/* Persistent cell cache: the cells found by the previous scans, so a rescan
+ * first checks the known cells and a monitoring node can be configured
+ * without a blind search.
+ *
+ * On disk it is a text file, one cell per line:
+ * band,cell_id,dl_earfcn,freq_mhz,prbs,ports,pss_power_dbm,first_seen,last_seen,nof_seen,nof_missed
+ * with the times in seconds since the epoch. Lines starting with # are comments. */
+
+#define CELL_DB_MAX_CELLS   512
+#define CELL_DB_MAX_MISSED  3     // a cell not confirmed by this many verifications in a row is dropped
+
+typedef struct {
+  int      band;
+  int      cell_id;
+  int      dl_earfcn;
+  float    freq;          // MHz
+  int      nof_prb;
+  int      nof_ports;
+  float    power_dbm;     // PSS power of the last detection
+  time_t   first_seen;
+  time_t   last_seen;
+  uint32_t nof_seen;
+  uint32_t nof_missed;    // verifications in a row without the cell
+} cell_db_entry_t;
+
+typedef struct {
+  cell_db_entry_t cells[CELL_DB_MAX_CELLS];
+  int             nof_cells;
+} cell_db_t;
+
+/* A missing file is an empty cache */
+int cell_db_load(cell_db_t* db, const char* path);
+
+/* The file is replaced at once, an interrupted save leaves the previous cache */
+int cell_db_save(cell_db_t* db, const char* path);
+
+/* EARFCNs of the known cells, most recently seen first, without duplicates */
+int cell_db_earfcns(cell_db_t* db, int* earfcns, int max_earfcns);
+
+/* Bands of the list sorted by the last time one of their cells was seen,
+ * the bands without known cells keep their order at the end */
+void cell_db_band_order(cell_db_t* db, int* bands, int nof_bands, int* ordered);
+
+/* Adds the found cells or refreshes the known ones */
+void cell_db_update(cell_db_t* db, struct cells* found, int nof_found, time_t now);
+
+/* Result of a verification of the given EARFCNs, the ones actually searched
+ * (not the ones left out by the time budget or an error): the known cells on them
+ * that were not found count a miss. Returns the number of confirmed cells */
+int cell_db_verify(cell_db_t* db, int* earfcns, int nof_earfcns, struct cells* found, int nof_found, time_t now);
+
+/* NG-Scope configuration: one rf_config per radio, on the strongest of the
+ * recently seen cells (one cell per frequency) */
+int cell_db_write_rf_config(cell_db_t* db, const char* path, char** rf_args, int nof_rf);
+
+#endif
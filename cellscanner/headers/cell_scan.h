@@ -1,6 +1,7 @@
-#ifndef __CELL_SCAN_h__
+#ifndef __CELL_SCAN_H__
 #define __CELL_SCAN_H__
 
+#include <stdio.h>
 #include "srsran/phy/rf/rf_utils.h"
 
 struct cells {
@@ -8,11 +9,59 @@ struct cells {
   float         freq;
   int           dl_earfcn;
   float         power;
+  int           band;
+  int           rf_idx;
 };
 
+/* Default setup of the parallel scan */
+#define CELL_SCAN_SNAPSHOT_MS   120   // IQ captured per EARFCN, PSS search + MIB
+#define CELL_SCAN_SETTLE_MS     5     // samples dropped after a retune
+#define CELL_SCAN_RX_GAIN       50
+
+/* Wideband mode: one capture covers many EARFCNs, the channelizer splits it in 1.92 MHz sub-channels */
+#define CELL_SCAN_WIDEBAND_USABLE   0.8   // part of the capture clear of the radio filter roll-off
+#define CELL_SCAN_WIDEBAND_GROUP    8     // sub-channels extracted at once by a worker
+#define CELL_SCAN_WIDEBAND_IFFT     256   // inverse DFT of a 1.92 MHz sub-channel
+#define CELL_SCAN_MAX_WIDEBAND_CH   256
+
+typedef struct {
+  uint32_t nof_workers;     // detection threads
+  uint32_t nof_snapshots;   // capture buffers shared by the radios and the workers, 0: 2 per worker
+  uint32_t snapshot_ms;
+  double   wideband_srate;  // Hz, multiple of 1.92 MHz. 0: one capture per EARFCN
+  uint32_t time_budget_ms;  // the radios stop capturing after it, the captured EARFCNs are still searched. 0: no limit
+  int*     earfcns;         // only these EARFCNs are captured, one by one (the bands are ignored). NULL: sweep the bands
+  int      nof_earfcns;
+  int*     skip_earfcns;    // EARFCNs left out of the sweep, e.g. already verified
+  int      nof_skip_earfcns;
+  FILE*    csv;             // the cells are written as soon as they are found, NULL: not written
+  int*     captured_earfcns;      // output, the EARFCNs whose snapshot has been searched. NULL: not reported
+  int      max_captured_earfcns;
+  int      nof_captured_earfcns;
+} cell_scan_args_t;
+
+void cell_scan_args_default(cell_scan_args_t* args);
+
+/* Scan the bands with nof_rf radios at once, each radio takes its share of
+ * the bands (band i goes to radio i % nof_rf). The radios only capture a
+ * snapshot per EARFCN and retune, the workers run the PSS/SSS/MIB detection
+ * on the snapshots. With a wideband_srate, a capture covers all the EARFCNs
+ * of CELL_SCAN_WIDEBAND_USABLE of the rate and the workers channelize it
+ * before the detection. With a list of earfcns, only those are captured
+ * (narrow captures, even with a wideband_srate). Returns the number of
+ * cells in results */
+int cell_scan_multi(srsran_rf_t*       rf,
+                    int                nof_rf,
+                    cell_search_cfg_t* cell_detect_config,
+                    cell_scan_args_t*  args,
+                    int*               bands,
+                    int                nof_bands,
+                    struct cells*      results,
+                    int                max_cells);
+
 int cell_scan(srsran_rf_t * rf, cell_search_cfg_t * cell_detect_config,
             struct cells * results,
             int max_cells,
             int band);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,268 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "srsran/srsran.h"
+#include "cellscanner/headers/cell_db.h"
+
+#define CELL_DB_LINE_LEN 256
+
+static cell_db_entry_t* cell_db_find(cell_db_t* db, int dl_earfcn, int cell_id)
+{
+    for (int i = 0; i < db->nof_cells; i++) {
+        if (db->cells[i].dl_earfcn == dl_earfcn && db->cells[i].cell_id == cell_id) {
+            return &db->cells[i];
+        }
+    }
+    return NULL;
+}
+
+int cell_db_load(cell_db_t* db, const char* path)
+{
+    char line[CELL_DB_LINE_LEN];
+
+    bzero(db, sizeof(cell_db_t));
+    FILE* f = fopen(path, "r");
+    if (f == NULL) {
+        printf("Cell cache %s not found, starting with an empty cache\n", path);
+        return 0;
+    }
+
+    int nof_line = 0;
+    while (fgets(line, CELL_DB_LINE_LEN, f) != NULL) {
+        nof_line++;
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+        if (db->nof_cells == CELL_DB_MAX_CELLS) {
+            printf("Cell cache %s: more than %d cells, the rest is ignored\n", path, CELL_DB_MAX_CELLS);
+            break;
+        }
+        cell_db_entry_t* c = &db->cells[db->nof_cells];
+        long first_seen, last_seen;
+        if (sscanf(line, "%d,%d,%d,%f,%d,%d,%f,%ld,%ld,%u,%u", &c->band, &c->cell_id, &c->dl_earfcn, &c->freq,
+                   &c->nof_prb, &c->nof_ports, &c->power_dbm, &first_seen, &last_seen, &c->nof_seen,
+                   &c->nof_missed) != 11) {
+            printf("Cell cache %s: line %d is not valid, ignored\n", path, nof_line);
+            continue;
+        }
+        c->first_seen = (time_t)first_seen;
+        c->last_seen  = (time_t)last_seen;
+        db->nof_cells++;
+    }
+    fclose(f);
+    printf("Cell cache %s: %d known cells\n", path, db->nof_cells);
+    return db->nof_cells;
+}
+
+int cell_db_save(cell_db_t* db, const char* path)
+{
+    char tmp_path[512];
+
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE* f = fopen(tmp_path, "w");
+    if (f == NULL) {
+        ERROR("Error opening %s", tmp_path);
+        return -1;
+    }
+    fprintf(f, "# band,cell_id,dl_earfcn,freq_mhz,prbs,ports,pss_power_dbm,first_seen,last_seen,nof_seen,nof_missed\n");
+    for (int i = 0; i < db->nof_cells; i++) {
+        cell_db_entry_t* c = &db->cells[i];
+        fprintf(f, "%d,%d,%d,%.1f,%d,%d,%.1f,%ld,%ld,%u,%u\n", c->band, c->cell_id, c->dl_earfcn, c->freq, c->nof_prb,
+                c->nof_ports, c->power_dbm, (long)c->first_seen, (long)c->last_seen, c->nof_seen, c->nof_missed);
+    }
+    if (fclose(f) != 0 || rename(tmp_path, path) != 0) {
+        ERROR("Error writing the cell cache %s", path);
+        return -1;
+    }
+    return 0;
+}
+
+int cell_db_earfcns(cell_db_t* db, int* earfcns, int max_earfcns)
+{
+    int  nof_earfcns = 0;
+    bool taken[CELL_DB_MAX_CELLS];
+
+    bzero(taken, sizeof(taken));
+    /* Selection by last seen time, the cache is small */
+    while (nof_earfcns < max_earfcns) {
+        int best = -1;
+        for (int i = 0; i < db->nof_cells; i++) {
+            if (!taken[i] && (best < 0 || db->cells[i].last_seen > db->cells[best].last_seen)) {
+                best = i;
+            }
+        }
+        if (best < 0) {
+            break;
+        }
+        /* The other cells on the same EARFCN come with the same capture */
+        for (int i = 0; i < db->nof_cells; i++) {
+            if (db->cells[i].dl_earfcn == db->cells[best].dl_earfcn) {
+                taken[i] = true;
+            }
+        }
+        earfcns[nof_earfcns++] = db->cells[best].dl_earfcn;
+    }
+    return nof_earfcns;
+}
+
+static time_t cell_db_band_last_seen(cell_db_t* db, int band)
+{
+    time_t last_seen = 0;
+    for (int i = 0; i < db->nof_cells; i++) {
+        if (db->cells[i].band == band && db->cells[i].last_seen > last_seen) {
+            last_seen = db->cells[i].last_seen;
+        }
+    }
+    return last_seen;
+}
+
+void cell_db_band_order(cell_db_t* db, int* bands, int nof_bands, int* ordered)
+{
+    memcpy(ordered, bands, nof_bands * sizeof(int));
+
+    /* Insertion sort, stable: the bands never seen keep the region order */
+    for (int i = 1; i < nof_bands; i++) {
+        int    band      = ordered[i];
+        time_t last_seen = cell_db_band_last_seen(db, band);
+        int    j         = i - 1;
+        while (j >= 0 && cell_db_band_last_seen(db, ordered[j]) < last_seen) {
+            ordered[j + 1] = ordered[j];
+            j--;
+        }
+        ordered[j + 1] = band;
+    }
+}
+
+void cell_db_update(cell_db_t* db, struct cells* found, int nof_found, time_t now)
+{
+    for (int i = 0; i < nof_found; i++) {
+        cell_db_entry_t* c = cell_db_find(db, found[i].dl_earfcn, found[i].cell.id);
+        if (c == NULL) {
+            if (db->nof_cells == CELL_DB_MAX_CELLS) {
+                printf("Cell cache full, cell %d at EARFCN %d is not cached\n", found[i].cell.id, found[i].dl_earfcn);
+                continue;
+            }
+            c = &db->cells[db->nof_cells++];
+            bzero(c, sizeof(cell_db_entry_t));
+            c->cell_id    = found[i].cell.id;
+            c->dl_earfcn  = found[i].dl_earfcn;
+            c->first_seen = now;
+        }
+        c->band       = found[i].band;
+        c->freq       = found[i].freq;
+        c->nof_prb    = found[i].cell.nof_prb;
+        c->nof_ports  = found[i].cell.nof_ports;
+        c->power_dbm  = srsran_convert_power_to_dB(found[i].power);
+        c->last_seen  = now;
+        c->nof_seen++;
+        c->nof_missed = 0;
+    }
+}
+
+int cell_db_verify(cell_db_t* db, int* earfcns, int nof_earfcns, struct cells* found, int nof_found, time_t now)
+{
+    int nof_confirmed = 0;
+
+    cell_db_update(db, found, nof_found, now);
+
+    for (int i = 0; i < db->nof_cells;) {
+        cell_db_entry_t* c       = &db->cells[i];
+        bool             checked = false;
+        for (int j = 0; j < nof_earfcns; j++) {
+            if (earfcns[j] == c->dl_earfcn) {
+                checked = true;
+                break;
+            }
+        }
+        if (checked && c->last_seen == now) {
+            nof_confirmed++;
+        } else if (checked) {
+            c->nof_missed++;
+            printf("Cell %d at EARFCN %d (%.1f MHz) not confirmed (%d in a row)\n", c->cell_id, c->dl_earfcn, c->freq,
+                   c->nof_missed);
+            if (c->nof_missed >= CELL_DB_MAX_MISSED) {
+                printf("Cell %d at EARFCN %d removed from the cache\n", c->cell_id, c->dl_earfcn);
+                *c = db->cells[--db->nof_cells];
+                continue;
+            }
+        }
+        i++;
+    }
+    return nof_confirmed;
+}
+
+int cell_db_write_rf_config(cell_db_t* db, const char* path, char** rf_args, int nof_rf)
+{
+    int  selected[CELL_DB_MAX_CELLS];
+    int  nof_selected = 0;
+    bool taken[CELL_DB_MAX_CELLS];
+
+    bzero(taken, sizeof(taken));
+    nof_rf = SRSRAN_MAX(nof_rf, 1);
+
+    /* Strongest cells first, only the ones confirmed by the last scan of their EARFCN */
+    while (nof_selected < nof_rf) {
+        int best = -1;
+        for (int i = 0; i < db->nof_cells; i++) {
+            cell_db_entry_t* c = &db->cells[i];
+            if (!taken[i] && c->nof_missed == 0 && (best < 0 || c->power_dbm > db->cells[best].power_dbm)) {
+                best = i;
+            }
+        }
+        if (best < 0) {
+            break;
+        }
+        /* NG-Scope does not take two carriers on the same frequency */
+        for (int i = 0; i < db->nof_cells; i++) {
+            if (db->cells[i].dl_earfcn == db->cells[best].dl_earfcn) {
+                taken[i] = true;
+            }
+        }
+        selected[nof_selected++] = best;
+    }
+    if (nof_selected == 0) {
+        printf("No confirmed cell in the cache, %s is not written\n", path);
+        return -1;
+    }
+
+    FILE* f = fopen(path, "w");
+    if (f == NULL) {
+        ERROR("Error opening %s", path);
+        return -1;
+    }
+    fprintf(f, "// generated by cellscanner from the cell cache\n");
+    /* The keys ngscope_read_config requires, the optional ones keep their defaults */
+    fprintf(f, "nof_rf_dev = %d;\n", nof_selected);
+    fprintf(f, "rnti = 0;\n");
+    fprintf(f, "remote_enable = false;\n");
+    fprintf(f, "decode_single_ue = false;\n");
+    fprintf(f, "decode_SIB = false;\n");
+    for (int i = 0; i < nof_selected; i++) {
+        cell_db_entry_t* c = &db->cells[selected[i]];
+        fprintf(f, "rf_config%d = {\n", i);
+        fprintf(f, "    // band %d, EARFCN %d, cell %d, %d PRB, PSS power %.1f dBm\n", c->band, c->dl_earfcn,
+                c->cell_id, c->nof_prb, c->power_dbm);
+        /* From the EARFCN, the cached MHz are rounded */
+        fprintf(f, "    rf_freq   = %lldL;\n", (long long)llround(srsran_band_fd(c->dl_earfcn) * 1e6));
+        fprintf(f, "    N_id_2  = %d;\n", c->cell_id % 3);
+        fprintf(f, "    rf_args   = \"%s\";\n", (rf_args != NULL && rf_args[i] != NULL) ? rf_args[i] : "");
+        fprintf(f, "    nof_thread  = 4;\n");
+        fprintf(f, "    disable_plot    = true;\n");
+        fprintf(f, "    log_dl  = true;\n");
+        fprintf(f, "    log_ul  = true;\n");
+        fprintf(f, "    log_phich  = false;\n");
+        fprintf(f, "}\n");
+    }
+    fprintf(f, "dci_log_config = {\n");
+    fprintf(f, "    log_dl  = true;\n");
+    fprintf(f, "    log_ul  = true;\n");
+    fprintf(f, "    log_interval  = 0;\n");
+    fprintf(f, "}\n");
+    fclose(f);
+
+    printf("NG-Scope configuration with %d carriers written to %s\n", nof_selected, path);
+    return nof_selected;
+}
@@ -1,122 +1,866 @@
 #include <math.h>
+#include <pthread.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>
 #include <sys/time.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "srsran/srsran.h"
 #include "srsran/common/crash_handler.h"
 #include "srsran/phy/rf/rf.h"
+#include "srsran/phy/resampling/channelizer.h"
 #include "cellscanner/headers/cell_scan.h"
 
 #define MHZ 1000000
-#define SAMP_FREQ 1920000
-#define FLEN 9600
-#define FLEN_PERIOD 0.005
 
 #define MAX_EARFCN 1000
 
-int cellsearch_recv_wrapper(void* h, void* data, uint32_t nsamples, srsran_timestamp_t* t)
+/* IQ of one EARFCN, captured at SRSRAN_CS_SAMP_FREQ */
+typedef struct {
+    int      band;
+    int      rf_idx;
+    int      dl_earfcn;
+    float    freq;          // MHz
+    cf_t*    samples;
+    uint32_t nof_samples;
+} scan_snapshot_t;
+
+/* Wideband capture, it covers the EARFCNs in channels */
+typedef struct {
+    int             band;
+    int             rf_idx;
+    double          center_freq;    // MHz
+    cf_t*           samples;
+    uint32_t        nof_samples;
+    srsran_earfcn_t channels[CELL_SCAN_MAX_WIDEBAND_CH];
+    int             nof_channels;
+    int             nof_pending;    // groups of sub-channels not processed yet
+} scan_wide_snapshot_t;
+
+/* Group of sub-channels of a wideband capture, processed by one worker */
+typedef struct {
+    int wide;
+    int first;
+    int count;
+} scan_job_t;
+
+/* fifo of snapshot indexes */
+typedef struct {
+    int*     idx;
+    uint32_t size;
+    uint32_t head;
+    uint32_t count;
+} scan_fifo_t;
+
+typedef struct {
+    cell_search_cfg_t* config;
+    uint32_t           snapshot_len;
+    uint32_t           max_frames_pbch;
+
+    scan_snapshot_t*   snapshots;
+    uint32_t           nof_snapshots;
+    scan_fifo_t        free_fifo;       // snapshots the radios can fill
+    scan_fifo_t        ready_fifo;      // snapshots waiting for a worker
+    pthread_mutex_t    mutex;
+    pthread_cond_t     cond;
+    int                nof_capture_running;
+
+    // wideband mode
+    double                wideband_srate;
+    uint32_t              wideband_fft;
+    uint32_t              wideband_hop;
+    uint32_t              wideband_nof_blocks;
+    scan_wide_snapshot_t* wides;
+    uint32_t              nof_wides;
+    scan_fifo_t           wide_free_fifo;
+    scan_job_t*           jobs;
+    uint32_t              jobs_size;
+    uint32_t              jobs_head;
+    uint32_t              jobs_count;
+
+    // what the radios capture
+    int*               earfcns;
+    int                nof_earfcns;
+    int*               skip_earfcns;
+    int                nof_skip_earfcns;
+    uint64_t           t_end_ms;        // 0: no time budget
+    bool               budget_reached;
+    int*               captured_earfcns; // the EARFCNs searched so far
+    int                max_captured_earfcns;
+    int                nof_captured_earfcns;
+    int                nof_failed;      // snapshots whose search failed
+
+    FILE*              csv;
+    struct cells*      results;
+    int                max_cells;
+    int                nof_cells;
+} scan_ctx_t;
+
+typedef struct {
+    scan_ctx_t*  ctx;
+    srsran_rf_t* rf;
+    int          rf_idx;
+    int          nof_rf;
+    int*         bands;
+    int          nof_bands;
+    pthread_t    thread;
+} scan_radio_t;
+
+typedef struct {
+    scan_ctx_t*            ctx;
+    pthread_t              thread;
+    srsran_ue_cellsearch_t cs;
+    srsran_ue_mib_sync_t   ue_mib;
+
+    // wideband mode: the sub-channels of a job, seen as narrow snapshots by the search
+    srsran_channelizer_t   chan;
+    cf_t*                  wb_output[SRSRAN_CHANNELIZER_MAX_CHANNELS];
+    scan_snapshot_t        wb_snapshot;
+
+    // the search reads the snapshot through the receive callbacks
+    scan_snapshot_t*       snapshot;
+    uint32_t               pos;
+} scan_worker_t;
+
+extern bool go_exit;
+
+static int scan_fifo_init(scan_fifo_t* q, uint32_t size)
 {
-  DEBUG(" ----  Receive %d samples  ---- ", nsamples);
-  return srsran_rf_recv_with_time((srsran_rf_t*)h, data, nsamples, 1, NULL, NULL);
+    bzero(q, sizeof(scan_fifo_t));
+    q->idx = calloc(size, sizeof(int));
+    if (q->idx == NULL) {
+        return -1;
+    }
+    q->size = size;
+    return 0;
 }
 
+static void scan_fifo_push(scan_fifo_t* q, int idx)
+{
+    q->idx[(q->head + q->count) % q->size] = idx;
+    q->count++;
+}
 
-int cell_scan(srsran_rf_t * rf,
-            cell_search_cfg_t * cell_detect_config,
-            struct cells * results,
-            int max_cells,
-            int band)
+static int scan_fifo_pop(scan_fifo_t* q)
 {
-    int n;
-    srsran_ue_cellsearch_t cs;
+    int idx = q->idx[q->head];
+    q->head = (q->head + 1) % q->size;
+    q->count--;
+    return idx;
+}
+
+/**********************************************************************/
+/* Workers: PSS/SSS and MIB detection on the snapshots                */
+/**********************************************************************/
+
+static int snapshot_read(scan_worker_t* w, cf_t* data, uint32_t nsamples)
+{
+    uint32_t n = 0;
+    if (w->snapshot == NULL) {
+        return SRSRAN_ERROR;
+    }
+    /* Past the end of the snapshot the search only sees silence. The MIB
+     * decoder only counts frames once synchronized, so the silence is
+     * bounded to one snapshot or a partial cell would never let it go */
+    if (w->pos >= 2 * w->snapshot->nof_samples) {
+        return SRSRAN_ERROR;
+    }
+    if (w->pos < w->snapshot->nof_samples) {
+        n = SRSRAN_MIN(nsamples, w->snapshot->nof_samples - w->pos);
+        memcpy(data, &w->snapshot->samples[w->pos], n * sizeof(cf_t));
+    }
+    if (n < nsamples) {
+        srsran_vec_cf_zero(&data[n], nsamples - n);
+    }
+    w->pos += nsamples;
+    return nsamples;
+}
+
+/* The search stopped because the reader ran out of the snapshot and its padding */
+static bool snapshot_exhausted(scan_worker_t* w)
+{
+    return w->pos >= 2 * w->snapshot->nof_samples;
+}
+
+static int cellsearch_snapshot_recv(void* h, void* data, uint32_t nsamples, srsran_timestamp_t* t)
+{
+    DEBUG(" ----  Receive %d samples  ---- ", nsamples);
+    return snapshot_read((scan_worker_t*)h, (cf_t*)data, nsamples);
+}
+
+static int mib_snapshot_recv(void* h, cf_t* data[SRSRAN_MAX_CHANNELS], uint32_t nsamples, srsran_timestamp_t* t)
+{
+    return snapshot_read((scan_worker_t*)h, data[0], nsamples);
+}
+
+static void scan_add_cell(scan_ctx_t* ctx, scan_snapshot_t* s, srsran_cell_t* cell, float power)
+{
+    pthread_mutex_lock(&ctx->mutex);
+    if (ctx->nof_cells < ctx->max_cells) {
+        struct cells* r = &ctx->results[ctx->nof_cells];
+        r->cell      = *cell;
+        r->freq      = s->freq;
+        r->dl_earfcn = s->dl_earfcn;
+        r->power     = power;
+        r->band      = s->band;
+        r->rf_idx    = s->rf_idx;
+        ctx->nof_cells++;
+    }
+    /* Results are streamed, a long scan can be followed (or interrupted) */
+    if (ctx->csv != NULL) {
+        fprintf(ctx->csv, "%d,%d,%d,%.1f,%d,%.1f\n", s->band, cell->id, s->dl_earfcn, s->freq, cell->nof_prb,
+                srsran_convert_power_to_dB(power));
+        fflush(ctx->csv);
+    }
+    printf("[RF %d] Found cell %d in band %d, EARFCN %d (%.1f MHz), %d PRB, PSS power %.1f dBm\n", s->rf_idx,
+           cell->id, s->band, s->dl_earfcn, s->freq, cell->nof_prb, srsran_convert_power_to_dB(power));
+    pthread_mutex_unlock(&ctx->mutex);
+}
+
+static int scan_snapshot_process(scan_worker_t* w, scan_snapshot_t* s)
+{
+    scan_ctx_t*                   ctx = w->ctx;
     srsran_ue_cellsearch_result_t found_cells[3];
-    int nof_freqs;
-    srsran_earfcn_t channels[MAX_EARFCN];
-    uint32_t freq;
-    uint32_t n_found_cells = 0;
-    extern bool go_exit;
-    srsran_cell_t cell;
-    int i;
+    uint8_t                       bch_payload[SRSRAN_BCH_PAYLOAD_LEN];
 
+    bzero(found_cells, 3 * sizeof(srsran_ue_cellsearch_result_t));
+    w->snapshot = s;
 
-    /* Set gain to 50 */
-    srsran_rf_set_rx_gain(rf, 50);
+    /* Every N_id_2 is searched on the whole snapshot */
+    for (uint32_t N_id_2 = 0; N_id_2 < 3 && !go_exit; N_id_2++) {
+        w->pos = 0;
+        /* Running out of the snapshot only means nothing was found for this N_id_2 */
+        if (srsran_ue_cellsearch_scan_N_id_2(&w->cs, N_id_2, &found_cells[N_id_2]) < 0) {
+            if (!snapshot_exhausted(w)) {
+                ERROR("Error searching N_id_2 %d at %.1f MHz", N_id_2, s->freq);
+                return SRSRAN_ERROR;
+            }
+            bzero(&found_cells[N_id_2], sizeof(srsran_ue_cellsearch_result_t));
+        }
+    }
 
-    /* Initialize CellSearch structure */
-    if (srsran_ue_cellsearch_init(&cs, cell_detect_config->max_frames_pss, cellsearch_recv_wrapper, (void*)rf)) {
-        ERROR("Error initiating UE cell detect");
-        return -1;
+    for (int i = 0; i < 3 && !go_exit; i++) {
+        /* If pagging success rate is larger than 2, try to decode the MIB */
+        if (found_cells[i].psr > 2.0) {
+            srsran_cell_t cell;
+            bzero(&cell, sizeof(srsran_cell_t));
+            cell.id = found_cells[i].cell_id;
+            cell.cp = found_cells[i].cp;
+
+            w->pos = 0;
+            if (srsran_ue_mib_sync_set_cell(&w->ue_mib, cell)) {
+                ERROR("Error initiating srsran_ue_mib_sync");
+                return -1;
+            }
+            bzero(bch_payload, SRSRAN_BCH_PAYLOAD_LEN);
+            int ret = srsran_ue_mib_sync_decode(&w->ue_mib, ctx->max_frames_pbch, bch_payload, &cell.nof_ports, NULL);
+            if (ret == SRSRAN_UE_MIB_FOUND) {
+                srsran_pbch_mib_unpack(bch_payload, &cell, NULL);
+                /* Cell is added to the list of valid detected cells if the number of ports is larger than 0 */
+                if (cell.nof_ports > 0) {
+                    scan_add_cell(ctx, s, &cell, found_cells[i].peak);
+                }
+            } else if (ret < 0) {
+                if (!snapshot_exhausted(w)) {
+                    ERROR("Error decoding the MIB of cell %d at %.1f MHz", cell.id, s->freq);
+                    return SRSRAN_ERROR;
+                }
+                INFO("No MIB for cell %d at %.1f MHz within the snapshot", cell.id, s->freq);
+            }
+        }
+    }
+    return 0;
+}
+
+/* Extracts a group of sub-channels of a wideband capture and searches them */
+static void scan_job_process(scan_worker_t* w, scan_job_t* job)
+{
+    scan_ctx_t*           ctx = w->ctx;
+    scan_wide_snapshot_t* ws  = &ctx->wides[job->wide];
+
+    for (int c = 0; c < SRSRAN_CHANNELIZER_MAX_CHANNELS; c++) {
+        srsran_channelizer_disable_channel(&w->chan, c);
     }
+    for (int c = 0; c < job->count; c++) {
+        double offset = ((double)ws->channels[job->first + c].fd - ws->center_freq) * MHZ;
+        if (srsran_channelizer_set_channel(&w->chan, c, offset, SRSRAN_CS_SAMP_FREQ)) {
+            ERROR("Error setting the sub-channel at %.1f MHz", ws->channels[job->first + c].fd);
+            return;
+        }
+    }
+
+    /* One forward DFT per block for the whole group */
+    srsran_channelizer_run(&w->chan, ws->samples, ctx->wideband_nof_blocks, 0, w->wb_output);
 
-    if (cell_detect_config->max_frames_pss) {
-        srsran_ue_cellsearch_set_nof_valid_frames(&cs, cell_detect_config->nof_valid_pss_frames);
+    scan_snapshot_t* s = &w->wb_snapshot;
+    for (int c = 0; c < job->count && !go_exit; c++) {
+        s->band        = ws->band;
+        s->rf_idx      = ws->rf_idx;
+        s->dl_earfcn   = ws->channels[job->first + c].id;
+        s->freq        = ws->channels[job->first + c].fd;
+        s->samples     = w->wb_output[c];
+        s->nof_samples = ctx->snapshot_len;
+        if (scan_snapshot_process(w, s) < 0) {
+            pthread_mutex_lock(&ctx->mutex);
+            ctx->nof_failed++;
+            pthread_mutex_unlock(&ctx->mutex);
+        }
     }
+}
+
+static void* scan_worker_thread(void* arg)
+{
+    scan_worker_t* w   = (scan_worker_t*)arg;
+    scan_ctx_t*    ctx = w->ctx;
+
+    while (true) {
+        pthread_mutex_lock(&ctx->mutex);
+        while (ctx->ready_fifo.count == 0 && ctx->jobs_count == 0 && ctx->nof_capture_running > 0 && !go_exit) {
+            pthread_cond_wait(&ctx->cond, &ctx->mutex);
+        }
+        if ((ctx->ready_fifo.count == 0 && ctx->jobs_count == 0) || go_exit) {
+            pthread_mutex_unlock(&ctx->mutex);
+            break;
+        }
+        if (ctx->jobs_count > 0) {
+            scan_job_t job = ctx->jobs[ctx->jobs_head];
+            ctx->jobs_head = (ctx->jobs_head + 1) % ctx->jobs_size;
+            ctx->jobs_count--;
+            pthread_mutex_unlock(&ctx->mutex);
+
+            scan_job_process(w, &job);
 
-    /* Supress RF messages */
-    srsran_rf_suppress_stdout(rf);
+            /* The capture is released with its last group */
+            pthread_mutex_lock(&ctx->mutex);
+            if (--ctx->wides[job.wide].nof_pending == 0) {
+                scan_fifo_push(&ctx->wide_free_fifo, job.wide);
+                pthread_cond_broadcast(&ctx->cond);
+            }
+            pthread_mutex_unlock(&ctx->mutex);
+            continue;
+        }
+        int idx = scan_fifo_pop(&ctx->ready_fifo);
+        pthread_mutex_unlock(&ctx->mutex);
+
+        int ret = scan_snapshot_process(w, &ctx->snapshots[idx]);
+
+        /* An EARFCN whose search failed is not counted as searched */
+        pthread_mutex_lock(&ctx->mutex);
+        if (ret < 0) {
+            ctx->nof_failed++;
+        } else if (ctx->captured_earfcns != NULL && ctx->nof_captured_earfcns < ctx->max_captured_earfcns) {
+            ctx->captured_earfcns[ctx->nof_captured_earfcns++] = ctx->snapshots[idx].dl_earfcn;
+        }
+        scan_fifo_push(&ctx->free_fifo, idx);
+        pthread_cond_broadcast(&ctx->cond);
+        pthread_mutex_unlock(&ctx->mutex);
+    }
+    return NULL;
+}
+
+/**********************************************************************/
+/* Radios: one snapshot per EARFCN, then retune                       */
+/**********************************************************************/
+
+static uint64_t scan_time_ms(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000 + t.tv_nsec / 1000000;
+}
+
+/* Early exit: no capture is started after the time budget */
+static bool scan_budget_exceeded(scan_ctx_t* ctx)
+{
+    if (ctx->t_end_ms == 0 || scan_time_ms() < ctx->t_end_ms) {
+        return false;
+    }
+    pthread_mutex_lock(&ctx->mutex);
+    if (!ctx->budget_reached) {
+        ctx->budget_reached = true;
+        printf("Scan time budget reached, the remaining EARFCNs are not captured\n");
+    }
+    pthread_mutex_unlock(&ctx->mutex);
+    return true;
+}
+
+static bool scan_skip_earfcn(scan_ctx_t* ctx, int earfcn)
+{
+    for (int i = 0; i < ctx->nof_skip_earfcns; i++) {
+        if (ctx->skip_earfcns[i] == earfcn) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Raster of a band, without the EARFCNs left out of the sweep */
+static int scan_band_channels(scan_ctx_t* ctx, int band, srsran_earfcn_t* channels)
+{
     /* Find frequencies for the selected band with no earfcn limits (-1) */
-    nof_freqs = srsran_band_get_fd_band(band, channels, -1, -1, MAX_EARFCN);
+    int nof_freqs = srsran_band_get_fd_band(band, channels, -1, -1, MAX_EARFCN);
     if (nof_freqs < 0) {
         ERROR("Error getting EARFCN list");
         return -1;
     }
+    int n = 0;
+    for (int i = 0; i < nof_freqs; i++) {
+        if (!scan_skip_earfcn(ctx, channels[i].id)) {
+            channels[n++] = channels[i];
+        }
+    }
+    return n;
+}
 
-    /* For each of the frequencies in the selected band */
-    for (freq = 0; freq < nof_freqs && !go_exit && n_found_cells < max_cells; freq++) {
-        printf(
-            "[%3d/%d]: Looking for PSS at %.2f MHz...\n", freq, nof_freqs, channels[freq].fd);
+static int rf_recv_all(srsran_rf_t* rf, cf_t* data, uint32_t nsamples)
+{
+    uint32_t count = 0;
+    while (count < nsamples && !go_exit) {
+        int n = srsran_rf_recv_with_time(rf, &data[count], nsamples - count, true, NULL, NULL);
+        if (n < 0) {
+            return -1;
+        }
+        count += n;
+    }
+    return count;
+}
+
+static int scan_channels_capture(scan_radio_t*    r,
+                                 srsran_earfcn_t* channels,
+                                 int              nof_freqs,
+                                 cf_t*            settle_buffer,
+                                 uint32_t         settle_len)
+{
+    scan_ctx_t* ctx = r->ctx;
+
+    for (int freq = 0; freq < nof_freqs && !go_exit && !scan_budget_exceeded(ctx); freq++) {
+        int band = srsran_band_get_band(channels[freq].id);
+        printf("[RF %d] band %d [%3d/%d]: capturing %.2f MHz...\n", r->rf_idx, band, freq, nof_freqs,
+               channels[freq].fd);
         fflush(stdout);
 
-        /* Clear CellSearchResult structures (3) */
-        bzero(found_cells, 3 * sizeof(srsran_ue_cellsearch_result_t));
-        
-        /* Adjust Radio parameters */
-        /* Set the RX frequency */
-        srsran_rf_set_rx_freq(rf, 0, (double)channels[freq].fd * MHZ);
-        /* Set sampling rate */
-        srsran_rf_set_rx_srate(rf, SRSRAN_CS_SAMP_FREQ);
+        /* Wait for a free snapshot */
+        pthread_mutex_lock(&ctx->mutex);
+        while (ctx->free_fifo.count == 0 && !go_exit) {
+            pthread_cond_wait(&ctx->cond, &ctx->mutex);
+        }
+        if (go_exit) {
+            pthread_mutex_unlock(&ctx->mutex);
+            break;
+        }
+        int idx = scan_fifo_pop(&ctx->free_fifo);
+        pthread_mutex_unlock(&ctx->mutex);
 
-        /* Start RX streaming */
-        srsran_rf_start_rx_stream(rf, false);
+        scan_snapshot_t* s = &ctx->snapshots[idx];
+        s->band      = band;
+        s->rf_idx    = r->rf_idx;
+        s->dl_earfcn = channels[freq].id;
+        s->freq      = channels[freq].fd;
 
-        /* Search for cells */
-        n = srsran_ue_cellsearch_scan(&cs, found_cells, NULL);
-        if (n < 0) {
-            ERROR("Error searching cell");
+        /* Retune, the samples of the previous frequency and of the retune are dropped */
+        srsran_rf_set_rx_freq(r->rf, 0, (double)channels[freq].fd * MHZ);
+        srsran_rf_flush_buffer(r->rf);
+        int ret = rf_recv_all(r->rf, settle_buffer, settle_len);
+        if (ret >= 0) {
+            ret = rf_recv_all(r->rf, s->samples, ctx->snapshot_len);
+        }
+
+        pthread_mutex_lock(&ctx->mutex);
+        if (ret == (int)ctx->snapshot_len) {
+            s->nof_samples = ret;
+            scan_fifo_push(&ctx->ready_fifo, idx);
+        } else {
+            scan_fifo_push(&ctx->free_fifo, idx);
+        }
+        pthread_cond_broadcast(&ctx->cond);
+        pthread_mutex_unlock(&ctx->mutex);
+
+        if (ret < 0) {
+            ERROR("Error receiving samples");
             return -1;
-        } else if (n > 0) {
-            for (i = 0; i < 3; i++) {
-                /* If pagging success rate is larger than 2, try to decode the MIB */
-                if (found_cells[i].psr > 2.0) {
-                    /* Set cell parameters for MIB decoding */
-                    cell.id = found_cells[i].cell_id;
-                    cell.cp = found_cells[i].cp;
-                    int ret = rf_mib_decoder(rf, 1, cell_detect_config, &cell, NULL);
-                    if (ret == SRSRAN_UE_MIB_FOUND) {
-                        /* Cell is added to the list of valid detected cells if the number of ports is larger than 0 */
-                        if (cell.nof_ports > 0) {
-                            results[n_found_cells].cell = cell;
-                            results[n_found_cells].freq = channels[freq].fd;
-                            results[n_found_cells].dl_earfcn = channels[freq].id;
-                            results[n_found_cells].power = found_cells[i].peak;
-                            n_found_cells++;
-                        }
-                    }
-                    else if (ret < 0) {
-                        ERROR("Error decoding MIB");
-                        return -1;
+        }
+    }
+    return 0;
+}
+
+/* Wideband mode: the EARFCNs of the band are covered by as few captures as possible */
+static int scan_band_capture_wide(scan_radio_t* r, int band, cf_t* settle_buffer, uint32_t settle_len)
+{
+    scan_ctx_t*     ctx = r->ctx;
+    srsran_earfcn_t channels[MAX_EARFCN];
+    double          half_span;
+
+    int nof_freqs = scan_band_channels(ctx, band, channels);
+    if (nof_freqs < 0) {
+        return -1;
+    }
+
+    /* Centers of the sub-channels that stay inside the usable part of the capture */
+    half_span = (CELL_SCAN_WIDEBAND_USABLE * ctx->wideband_srate - SRSRAN_CS_SAMP_FREQ) / 2 / MHZ;
+
+    int first = 0;
+    while (first < nof_freqs && !go_exit && !scan_budget_exceeded(ctx)) {
+        double center = channels[first].fd + half_span;
+        int    last   = first;
+        while (last + 1 < nof_freqs && last + 1 - first < CELL_SCAN_MAX_WIDEBAND_CH &&
+               channels[last + 1].fd <= center + half_span) {
+            last++;
+        }
+        int count = last - first + 1;
+
+        printf("[RF %d] band %d [%3d-%3d/%d]: capturing %.2f MHz +/- %.2f MHz...\n", r->rf_idx, band, first, last,
+               nof_freqs, center, half_span);
+        fflush(stdout);
+
+        pthread_mutex_lock(&ctx->mutex);
+        while (ctx->wide_free_fifo.count == 0 && !go_exit) {
+            pthread_cond_wait(&ctx->cond, &ctx->mutex);
+        }
+        if (go_exit) {
+            pthread_mutex_unlock(&ctx->mutex);
+            break;
+        }
+        int idx = scan_fifo_pop(&ctx->wide_free_fifo);
+        pthread_mutex_unlock(&ctx->mutex);
+
+        scan_wide_snapshot_t* ws = &ctx->wides[idx];
+        ws->band         = band;
+        ws->rf_idx       = r->rf_idx;
+        ws->center_freq  = center;
+        ws->nof_channels = count;
+        memcpy(ws->channels, &channels[first], count * sizeof(srsran_earfcn_t));
+
+        srsran_rf_set_rx_freq(r->rf, 0, center * MHZ);
+        srsran_rf_flush_buffer(r->rf);
+        int ret = rf_recv_all(r->rf, settle_buffer, settle_len);
+        if (ret >= 0) {
+            ret = rf_recv_all(r->rf, ws->samples, ws->nof_samples);
+        }
+
+        /* Split the sub-channels in groups for the workers */
+        pthread_mutex_lock(&ctx->mutex);
+        if (ret == (int)ws->nof_samples) {
+            ws->nof_pending = 0;
+            for (int c = 0; c < count; c += CELL_SCAN_WIDEBAND_GROUP) {
+                scan_job_t* job = &ctx->jobs[(ctx->jobs_head + ctx->jobs_count) % ctx->jobs_size];
+                job->wide       = idx;
+                job->first      = c;
+                job->count      = SRSRAN_MIN(CELL_SCAN_WIDEBAND_GROUP, count - c);
+                ctx->jobs_count++;
+                ws->nof_pending++;
+            }
+        } else {
+            scan_fifo_push(&ctx->wide_free_fifo, idx);
+        }
+        pthread_cond_broadcast(&ctx->cond);
+        pthread_mutex_unlock(&ctx->mutex);
+
+        if (ret < 0) {
+            ERROR("Error receiving samples");
+            return -1;
+        }
+        first = last + 1;
+    }
+    return 0;
+}
+
+static void* scan_radio_thread(void* arg)
+{
+    scan_radio_t* r          = (scan_radio_t*)arg;
+    scan_ctx_t*   ctx        = r->ctx;
+    bool          wideband   = ctx->wideband_srate > 0;
+    srsran_earfcn_t channels[MAX_EARFCN];
+    double        srate      = wideband ? ctx->wideband_srate : SRSRAN_CS_SAMP_FREQ;
+    uint32_t      settle_len = (uint32_t)(CELL_SCAN_SETTLE_MS * srate / 1000);
+    cf_t*         settle_buf = srsran_vec_cf_malloc(settle_len);
+    int           ret;
+
+    if (settle_buf != NULL) {
+        srsran_rf_set_rx_gain(r->rf, CELL_SCAN_RX_GAIN);
+        /* Supress RF messages */
+        srsran_rf_suppress_stdout(r->rf);
+        srsran_rf_set_rx_srate(r->rf, wideband ? ctx->wideband_srate : SRSRAN_CS_SAMP_FREQ);
+        srsran_rf_start_rx_stream(r->rf, false);
+
+        if (ctx->earfcns != NULL) {
+            /* Given EARFCNs: the radios take one in nof_rf */
+            int nof_freqs = 0;
+            for (int j = r->rf_idx; j < ctx->nof_earfcns && nof_freqs < MAX_EARFCN; j += r->nof_rf) {
+                channels[nof_freqs].id = ctx->earfcns[j];
+                channels[nof_freqs].fd = srsran_band_fd(ctx->earfcns[j]);
+                nof_freqs++;
+            }
+            printf("[RF %d] Checking %d EARFCNs\n", r->rf_idx, nof_freqs);
+            scan_channels_capture(r, channels, nof_freqs, settle_buf, settle_len);
+        } else {
+            /* The radios scan disjoint bands */
+            for (int j = r->rf_idx; j < r->nof_bands && !go_exit && !scan_budget_exceeded(ctx); j += r->nof_rf) {
+                printf("[RF %d] Searching in band %d\n", r->rf_idx, r->bands[j]);
+                if (wideband) {
+                    ret = scan_band_capture_wide(r, r->bands[j], settle_buf, settle_len);
+                } else {
+                    int nof_freqs = scan_band_channels(ctx, r->bands[j], channels);
+                    ret = nof_freqs < 0 ? -1 : scan_channels_capture(r, channels, nof_freqs, settle_buf, settle_len);
+                }
+                if (ret < 0) {
+                    break;
+                }
+            }
+        }
+
+        srsran_rf_stop_rx_stream(r->rf);
+        free(settle_buf);
+    }
+
+    pthread_mutex_lock(&ctx->mutex);
+    ctx->nof_capture_running--;
+    pthread_cond_broadcast(&ctx->cond);
+    pthread_mutex_unlock(&ctx->mutex);
+    return NULL;
+}
+
+/**********************************************************************/
+
+void cell_scan_args_default(cell_scan_args_t* args)
+{
+    long nof_cpu = sysconf(_SC_NPROCESSORS_ONLN);
+
+    args->nof_workers   = nof_cpu > 2 ? nof_cpu - 1 : 1;
+    args->nof_snapshots = 0;
+    args->snapshot_ms   = CELL_SCAN_SNAPSHOT_MS;
+    args->wideband_srate = 0;
+    args->time_budget_ms = 0;
+    args->earfcns       = NULL;
+    args->nof_earfcns   = 0;
+    args->skip_earfcns  = NULL;
+    args->nof_skip_earfcns = 0;
+    args->csv           = NULL;
+    args->captured_earfcns     = NULL;
+    args->max_captured_earfcns = 0;
+    args->nof_captured_earfcns = 0;
+}
+
+int cell_scan_multi(srsran_rf_t*       rf,
+                    int                nof_rf,
+                    cell_search_cfg_t* cell_detect_config,
+                    cell_scan_args_t*  args,
+                    int*               bands,
+                    int                nof_bands,
+                    struct cells*      results,
+                    int                max_cells)
+{
+    scan_ctx_t     ctx;
+    scan_worker_t* workers = NULL;
+    scan_radio_t*  radios  = NULL;
+    uint32_t       nof_workers;
+    int            ret     = -1;
+
+    if (rf == NULL || nof_rf <= 0 || args == NULL || args->snapshot_ms < 10 || (bands == NULL && args->earfcns == NULL)) {
+        ERROR("Invalid scan arguments");
+        return -1;
+    }
+
+    bzero(&ctx, sizeof(scan_ctx_t));
+    nof_workers             = SRSRAN_MAX(args->nof_workers, 1);
+    ctx.config              = cell_detect_config;
+    ctx.snapshot_len        = args->snapshot_ms * (uint32_t)SRSRAN_CS_SAMP_FREQ / 1000;
+    /* Bound the MIB search by the snapshot, a frame is counted up to every 5 ms while searching */
+    ctx.max_frames_pbch     = SRSRAN_MIN(cell_detect_config->max_frames_pbch, args->snapshot_ms / 5);
+    ctx.nof_snapshots       = args->nof_snapshots > 0 ? args->nof_snapshots : 2 * nof_workers + nof_rf;
+    ctx.csv                 = args->csv;
+    ctx.results             = results;
+    ctx.max_cells           = max_cells;
+    ctx.nof_capture_running = nof_rf;
+    ctx.earfcns             = args->earfcns;
+    ctx.nof_earfcns         = args->nof_earfcns;
+    ctx.skip_earfcns        = args->skip_earfcns;
+    ctx.nof_skip_earfcns    = args->nof_skip_earfcns;
+    ctx.t_end_ms            = args->time_budget_ms > 0 ? scan_time_ms() + args->time_budget_ms : 0;
+    ctx.captured_earfcns     = args->captured_earfcns;
+    ctx.max_captured_earfcns = args->max_captured_earfcns;
+    pthread_mutex_init(&ctx.mutex, NULL);
+    pthread_cond_init(&ctx.cond, NULL);
+
+    /* Known EARFCNs are checked one by one, the wideband captures are for the sweep */
+    if (args->wideband_srate > 0 && args->earfcns == NULL) {
+        /* The 1.92 MHz sub-channels must fall on the DFT grid */
+        double ratio = args->wideband_srate / SRSRAN_CS_SAMP_FREQ;
+        if (fabs(ratio - round(ratio)) > 1e-6 || ratio < 2) {
+            ERROR("The wideband rate %.2f MHz is not a multiple of 1.92 MHz", args->wideband_srate / MHZ);
+            goto clean_exit;
+        }
+        ctx.wideband_srate      = args->wideband_srate;
+        ctx.wideband_fft        = CELL_SCAN_WIDEBAND_IFFT * (uint32_t)round(ratio);
+        ctx.wideband_hop        = ctx.wideband_fft / 2;
+        ctx.wideband_nof_blocks = ctx.snapshot_len / (CELL_SCAN_WIDEBAND_IFFT / 2);
+        ctx.snapshot_len        = ctx.wideband_nof_blocks * (CELL_SCAN_WIDEBAND_IFFT / 2);
+        /* Two captures per radio: one is channelized while the next one is received */
+        ctx.nof_wides           = 2 * nof_rf;
+        ctx.nof_snapshots       = 0;
+        ctx.jobs_size           = ctx.nof_wides * (CELL_SCAN_MAX_WIDEBAND_CH / CELL_SCAN_WIDEBAND_GROUP + 1);
+        ctx.wides               = calloc(ctx.nof_wides, sizeof(scan_wide_snapshot_t));
+        ctx.jobs                = calloc(ctx.jobs_size, sizeof(scan_job_t));
+        if (ctx.wides == NULL || ctx.jobs == NULL || scan_fifo_init(&ctx.wide_free_fifo, ctx.nof_wides)) {
+            ERROR("Error allocating the scan buffers");
+            goto clean_exit;
+        }
+        for (uint32_t i = 0; i < ctx.nof_wides; i++) {
+            ctx.wides[i].nof_samples = (ctx.wideband_nof_blocks + 1) * ctx.wideband_hop;
+            ctx.wides[i].samples     = srsran_vec_cf_malloc(ctx.wides[i].nof_samples);
+            if (ctx.wides[i].samples == NULL) {
+                ERROR("Error allocating the scan buffers");
+                goto clean_exit;
+            }
+            scan_fifo_push(&ctx.wide_free_fifo, i);
+        }
+    }
+
+    ctx.snapshots = calloc(SRSRAN_MAX(ctx.nof_snapshots, 1), sizeof(scan_snapshot_t));
+    workers       = calloc(nof_workers, sizeof(scan_worker_t));
+    radios        = calloc(nof_rf, sizeof(scan_radio_t));
+    if (ctx.snapshots == NULL || workers == NULL || radios == NULL ||
+        scan_fifo_init(&ctx.free_fifo, SRSRAN_MAX(ctx.nof_snapshots, 1)) ||
+        scan_fifo_init(&ctx.ready_fifo, SRSRAN_MAX(ctx.nof_snapshots, 1))) {
+        ERROR("Error allocating the scan buffers");
+        goto clean_exit;
+    }
+    for (uint32_t i = 0; i < ctx.nof_snapshots; i++) {
+        ctx.snapshots[i].samples = srsran_vec_cf_malloc(ctx.snapshot_len);
+        if (ctx.snapshots[i].samples == NULL) {
+            ERROR("Error allocating the scan buffers");
+            goto clean_exit;
+        }
+        scan_fifo_push(&ctx.free_fifo, i);
+    }
+
+    /* The detection objects are set up here, the workers only run them */
+    for (uint32_t i = 0; i < nof_workers; i++) {
+        scan_worker_t* w = &workers[i];
+        w->ctx           = &ctx;
+        if (srsran_ue_cellsearch_init(&w->cs, cell_detect_config->max_frames_pss, cellsearch_snapshot_recv, (void*)w)) {
+            ERROR("Error initiating UE cell detect");
+            goto clean_exit;
+        }
+        if (cell_detect_config->max_frames_pss) {
+            srsran_ue_cellsearch_set_nof_valid_frames(&w->cs, cell_detect_config->nof_valid_pss_frames);
+        }
+        if (srsran_ue_mib_sync_init_multi(&w->ue_mib, mib_snapshot_recv, 1, (void*)w)) {
+            ERROR("Error initiating srsran_ue_mib_sync");
+            goto clean_exit;
+        }
+        if (ctx.wideband_srate > 0) {
+            if (srsran_channelizer_init(&w->chan, ctx.wideband_srate, ctx.wideband_fft)) {
+                ERROR("Error initiating the channelizer");
+                goto clean_exit;
+            }
+            for (int c = 0; c < CELL_SCAN_WIDEBAND_GROUP; c++) {
+                w->wb_output[c] = srsran_vec_cf_malloc(ctx.snapshot_len);
+                if (w->wb_output[c] == NULL) {
+                    ERROR("Error allocating the scan buffers");
+                    goto clean_exit;
+                }
+            }
+        }
+    }
+
+    if (ctx.earfcns != NULL) {
+        printf("Checking %d EARFCNs with %d radios, %d workers and %d snapshots of %d ms\n", ctx.nof_earfcns, nof_rf,
+               nof_workers, ctx.nof_snapshots, args->snapshot_ms);
+    } else if (ctx.wideband_srate > 0) {
+        printf("Scanning %d bands with %d radios at %.2f MHz, %d workers and %d captures of %d ms\n", nof_bands, nof_rf,
+               ctx.wideband_srate / MHZ, nof_workers, ctx.nof_wides, args->snapshot_ms);
+    } else {
+        printf("Scanning %d bands with %d radios, %d workers and %d snapshots of %d ms\n", nof_bands, nof_rf,
+               nof_workers, ctx.nof_snapshots, args->snapshot_ms);
+    }
+
+    for (uint32_t i = 0; i < nof_workers; i++) {
+        pthread_create(&workers[i].thread, NULL, scan_worker_thread, &workers[i]);
+    }
+    for (int i = 0; i < nof_rf; i++) {
+        radios[i].ctx       = &ctx;
+        radios[i].rf        = &rf[i];
+        radios[i].rf_idx    = i;
+        radios[i].nof_rf    = nof_rf;
+        radios[i].bands     = bands;
+        radios[i].nof_bands = nof_bands;
+        pthread_create(&radios[i].thread, NULL, scan_radio_thread, &radios[i]);
+    }
+    for (int i = 0; i < nof_rf; i++) {
+        pthread_join(radios[i].thread, NULL);
+    }
+    for (uint32_t i = 0; i < nof_workers; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+    if (ctx.nof_failed > 0) {
+        printf("The search failed on %d snapshots, see the errors above\n", ctx.nof_failed);
+    }
+    ret = ctx.nof_cells;
+    args->nof_captured_earfcns = ctx.nof_captured_earfcns;
+
+clean_exit:
+    if (workers != NULL) {
+        for (uint32_t i = 0; i < nof_workers; i++) {
+            if (workers[i].ctx != NULL) {
+                srsran_ue_cellsearch_free(&workers[i].cs);
+                srsran_ue_mib_sync_free(&workers[i].ue_mib);
+                srsran_channelizer_free(&workers[i].chan);
+                for (int c = 0; c < CELL_SCAN_WIDEBAND_GROUP; c++) {
+                    if (workers[i].wb_output[c] != NULL) {
+                        free(workers[i].wb_output[c]);
                     }
                 }
             }
         }
+        free(workers);
+    }
+    if (ctx.snapshots != NULL) {
+        for (uint32_t i = 0; i < ctx.nof_snapshots; i++) {
+            if (ctx.snapshots[i].samples != NULL) {
+                free(ctx.snapshots[i].samples);
+            }
+        }
+        free(ctx.snapshots);
+    }
+    if (ctx.wides != NULL) {
+        for (uint32_t i = 0; i < ctx.nof_wides; i++) {
+            if (ctx.wides[i].samples != NULL) {
+                free(ctx.wides[i].samples);
+            }
+        }
+        free(ctx.wides);
     }
+    if (ctx.jobs != NULL) {
+        free(ctx.jobs);
+    }
+    if (ctx.wide_free_fifo.idx != NULL) {
+        free(ctx.wide_free_fifo.idx);
+    }
+    if (ctx.free_fifo.idx != NULL) {
+        free(ctx.free_fifo.idx);
+    }
+    if (ctx.ready_fifo.idx != NULL) {
+        free(ctx.ready_fifo.idx);
+    }
+    if (radios != NULL) {
+        free(radios);
+    }
+    pthread_mutex_destroy(&ctx.mutex);
+    pthread_cond_destroy(&ctx.cond);
+    return ret;
+}
 
-    srsran_ue_cellsearch_free(&cs);
-    srsran_rf_stop_rx_stream(rf);
-    return n_found_cells;
-}
\ No newline at end of file
+int cell_scan(srsran_rf_t * rf,
+            cell_search_cfg_t * cell_detect_config,
+            struct cells * results,
+            int max_cells,
+            int band)
+{
+    cell_scan_args_t args;
+    cell_scan_args_default(&args);
+    return cell_scan_multi(rf, 1, cell_detect_config, &args, &band, 1, results, max_cells);
+}
@@ -37,6 +37,7 @@
 
 /* Local libs */
 #include "cellscanner/headers/cell_scan.h"
+#include "cellscanner/headers/cell_db.h"
 #include "cellscanner/headers/bands.h"
 
 /* SRS libs */
@@ -89,31 +90,99 @@ srsran_cell_t      cell;
 
 
 #define MAX_SCAN_CELLS 128
+#define MAX_SCAN_RF 8
 
+void usage(char* prog)
+{
+  printf("USAGE: %s [-w nof_workers] [-s nof_snapshots] [-t snapshot_ms] [-W wideband_srate_mhz] [-d cell_cache] [-v] "
+         "[-b time_budget_s] [-c ngscope_config] <Output file> <Region (0: All, 1: USA, 2: Europe)> [USRP Args] [USRP Args] ...\n", prog);
+  printf("\tOne RF device is opened per USRP Args, the devices scan disjoint bands\n");
+  printf("\t-w detection threads [Default: nof cpus - 1]\n");
+  printf("\t-s capture buffers [Default: 2 per thread]\n");
+  printf("\t-t IQ captured per EARFCN [Default %d ms]\n", CELL_SCAN_SNAPSHOT_MS);
+  printf("\t-W capture %.0f%% of this rate at once and channelize it, multiple of 1.92 MHz (e.g. 23.04) [Default off]\n",
+         100 * CELL_SCAN_WIDEBAND_USABLE);
+  printf("\t-d cell cache, loaded before and saved after the scan [Default none]\n");
+  printf("\t-v verify: check the cached cells on their EARFCN first, then sweep the rest, recently active bands first\n");
+  printf("\t-b stop capturing after this many seconds [Default no limit]\n");
+  printf("\t-c write an NG-Scope configuration on the strongest cached cells, one per radio\n");
+}
+
+static void scan_print_cells(struct cells* scanned_cells, int nof_cells)
+{
+    for (int i = 0; i < nof_cells; i++) {
+        printf("CELL %d:\n\tBand: %d\n\tCell ID: %d\n\tEARFCN(DL): %d\n\tFreq: %.1f MHz\n\tPRBs: %d\n\tPSS Power: %.1f dBm\n",
+            i+1,
+            scanned_cells[i].band,
+            scanned_cells[i].cell.id,
+            scanned_cells[i].dl_earfcn,
+            scanned_cells[i].freq,
+            scanned_cells[i].cell.nof_prb,
+            srsran_convert_power_to_dB(scanned_cells[i].power));
+            //srsran_cell_fprint(stdout, &(scanned_cells[i].cell), 0);
+    }
+}
 
 /********/
 /* Main */
 /********/
 int main(int argc, char** argv)
 {
-    int ret, i, band, j, region, bands_length;
+    int ret, i, region, bands_length, opt, nof_rf;
     int * bands;
-    srsran_rf_t rf; /* RF structure */
+    srsran_rf_t rf[MAX_SCAN_RF]; /* RF structures */
     struct cells scanned_cells[MAX_SCAN_CELLS]; /* List of available cells */
+    cell_scan_args_t scan_args;
     FILE * file;
+    char * db_path = NULL;
+    char * ngscope_config = NULL;
+    bool verify = false;
+    uint32_t time_budget_s = 0;
+
+    cell_scan_args_default(&scan_args);
+    while ((opt = getopt(argc, argv, "w:s:t:W:d:vb:c:")) != -1) {
+      switch (opt) {
+        case 'w':
+          scan_args.nof_workers = (uint32_t)strtol(optarg, NULL, 10);
+          break;
+        case 's':
+          scan_args.nof_snapshots = (uint32_t)strtol(optarg, NULL, 10);
+          break;
+        case 't':
+          scan_args.snapshot_ms = (uint32_t)strtol(optarg, NULL, 10);
+          break;
+        case 'W':
+          scan_args.wideband_srate = strtod(optarg, NULL) * 1e6;
+          break;
+        case 'd':
+          db_path = optarg;
+          break;
+        case 'v':
+          verify = true;
+          break;
+        case 'b':
+          time_budget_s = (uint32_t)strtol(optarg, NULL, 10);
+          break;
+        case 'c':
+          ngscope_config = optarg;
+          break;
+        default:
+          usage(argv[0]);
+          exit(1);
+      }
+    }
 
-
-    if(argc < 2 || argc > 4) {
-      printf("USAGE: %s <Output file> <Region (0: All, 1: USA, 2: Europe)> <USRP Args (Optional)>\n", argv[0]);
+    if(argc - optind < 2 || argc - optind > 2 + MAX_SCAN_RF || ((verify || ngscope_config) && db_path == NULL)) {
+      usage(argv[0]);
       exit(1);
     }
 
-    if((file = fopen(argv[1], "w")) == NULL) {
-      printf("Error openning %s\n", argv[1]);
+    if((file = fopen(argv[optind], "w")) == NULL) {
+      printf("Error openning %s\n", argv[optind]);
       exit(1);
     }
 
-    region = atoi(argv[2]);
+    region = atoi(argv[optind + 1]);
     if(region == 0) {
       bands_length = all_bands_length;
       bands = all_bands;
@@ -139,30 +208,36 @@ int main(int argc, char** argv)
 
     srsran_use_standard_symbol_size(true);
 
-    /* Initialize radio */
-    if(argc == 2) {
+    /* Initialize radios */
+    nof_rf = argc - optind - 2;
+    if(nof_rf == 0) {
       printf("Opening RF device with 1 RX antennas...\n");
-      if (srsran_rf_open_devname(&rf, "", "", 1)) {
+      if (srsran_rf_open_devname(&rf[0], "", "", 1)) {
           fprintf(stderr, "Error opening rf\n");
           exit(-1);
       }
+      nof_rf = 1;
     }
     else {
-      printf("Opening RF device with 1 RX antennas and \"%s\" as arguments...\n", argv[3]);
-      if (srsran_rf_open_devname(&rf, "", argv[3], 1)) {
-          fprintf(stderr, "Error opening rf\n");
-          exit(-1);
+      for(i = 0; i < nof_rf; i++) {
+        printf("Opening RF device %d with 1 RX antennas and \"%s\" as arguments...\n", i, argv[optind + 2 + i]);
+        if (srsran_rf_open_devname(&rf[i], "", argv[optind + 2 + i], 1)) {
+            fprintf(stderr, "Error opening rf\n");
+            exit(-1);
+        }
       }
     }
 
     
-    printf("Starting AGC thread...\n");
-    if (srsran_rf_start_gain_thread(&rf, false)) {
-        ERROR("Error opening rf");
-        exit(-1);
+    for(i = 0; i < nof_rf; i++) {
+      printf("Starting AGC thread...\n");
+      if (srsran_rf_start_gain_thread(&rf[i], false)) {
+          ERROR("Error opening rf");
+          exit(-1);
+      }
+      srsran_rf_set_rx_gain(&rf[i], srsran_rf_get_rx_gain(&rf[i]));
     }
-    srsran_rf_set_rx_gain(&rf, srsran_rf_get_rx_gain(&rf));
-    cell_detect_config.init_agc = srsran_rf_get_rx_gain(&rf);
+    cell_detect_config.init_agc = srsran_rf_get_rx_gain(&rf[0]);
 
 
     /* Set signal handler */
@@ -172,41 +247,84 @@ int main(int argc, char** argv)
     sigprocmask(SIG_UNBLOCK, &sigset, NULL);
     signal(SIGINT, sig_int_handler);
 
+    /* Known cells */
+    static cell_db_t db;
+    if(db_path != NULL) {
+        cell_db_load(&db, db_path);
+    }
+    struct timeval t_start;
+    gettimeofday(&t_start, NULL);
+
     fprintf(file, "band,cell_id,dl_earfcn,freq_mhz,prbs,pss_power_dbm\n");
-    /* Scanning loop */
-    for(j=0; j < bands_length; j++) {
-      band = bands[j];
-
-      printf("Searching in band %d\n", band);
-      /* Scan for cells in the selected band */
-      ret = cell_scan(&rf, &cell_detect_config, scanned_cells, MAX_SCAN_CELLS, band);
-      if(ret < 0) {
-          printf("Error scanning for cells");
-          exit(1);
-      }
-      else if(ret == 0) {
-          printf("0 cell found in band %d\n", band);
-          continue;
-      }
+    fflush(file);
+    scan_args.csv = file;
+
+    /* Verification: the radios tune directly to the EARFCNs of the cached cells */
+    int verified_earfcns[CELL_DB_MAX_CELLS];
+    int nof_verified = 0;
+    if(verify && db.nof_cells > 0) {
+        cell_scan_args_t verify_args = scan_args;
+        nof_verified = cell_db_earfcns(&db, verified_earfcns, CELL_DB_MAX_CELLS);
+        verify_args.earfcns = verified_earfcns;
+        verify_args.nof_earfcns = nof_verified;
+        verify_args.time_budget_ms = time_budget_s * 1000;
+        /* Only the EARFCNs searched in this run can miss a cell (budget, exit or receive errors) */
+        int captured_earfcns[CELL_DB_MAX_CELLS];
+        verify_args.captured_earfcns = captured_earfcns;
+        verify_args.max_captured_earfcns = CELL_DB_MAX_CELLS;
+        ret = cell_scan_multi(rf, nof_rf, &cell_detect_config, &verify_args, NULL, 0, scanned_cells, MAX_SCAN_CELLS);
+        if(ret < 0) {
+            printf("Error verifying the cached cells");
+            exit(1);
+        }
+        int nof_captured = verify_args.nof_captured_earfcns;
+        int nof_confirmed = cell_db_verify(&db, captured_earfcns, nof_captured, scanned_cells, ret, time(NULL));
+        printf("\n\n%d cached cells confirmed on %d of %d EARFCNs\n", nof_confirmed, nof_captured, nof_verified);
+        scan_print_cells(scanned_cells, ret);
+        cell_db_save(&db, db_path);
+    }
 
-      printf("\n\nFound %d cells in band %d\n", ret, band);
-      for (i = 0; i < ret; i++) {
-          fprintf(file, "%d,%d,%d,%.1f,%d,%.1f\n", band, scanned_cells[i].cell.id, scanned_cells[i].dl_earfcn, scanned_cells[i].freq, scanned_cells[i].cell.nof_prb, srsran_convert_power_to_dB(scanned_cells[i].power));
-          printf("CELL %d:\n\tCell ID: %d\n\tEARFCN(DL): %d\n\tFreq: %.1f MHz\n\tPRBs: %d\n\tPSS Power: %.1f dBm\n",
-              i+1,
-              scanned_cells[i].cell.id,
-              scanned_cells[i].dl_earfcn,
-              scanned_cells[i].freq,
-              scanned_cells[i].cell.nof_prb,
-              srsran_convert_power_to_dB(scanned_cells[i].power));
-              //srsran_cell_fprint(stdout, &(scanned_cells[i].cell), 0);
-      }
+    /* Sweep of the rest of the raster, in the time left */
+    struct timeval t_now;
+    gettimeofday(&t_now, NULL);
+    uint64_t elapsed_ms = (t_now.tv_sec - t_start.tv_sec) * 1000 + (t_now.tv_usec - t_start.tv_usec) / 1000;
+    ret = 0;
+    if(time_budget_s == 0 || elapsed_ms < time_budget_s * 1000) {
+        int ordered_bands[bands_length];
+        if(verify) {
+            cell_db_band_order(&db, bands, bands_length, ordered_bands);
+            scan_args.skip_earfcns = verified_earfcns;
+            scan_args.nof_skip_earfcns = nof_verified;
+        } else {
+            memcpy(ordered_bands, bands, bands_length * sizeof(int));
+        }
+        scan_args.time_budget_ms = time_budget_s > 0 ? time_budget_s * 1000 - elapsed_ms : 0;
+        /* Scanning: the radios capture, the workers detect and write the cells as they are found */
+        ret = cell_scan_multi(rf, nof_rf, &cell_detect_config, &scan_args, ordered_bands, bands_length, scanned_cells, MAX_SCAN_CELLS);
+        if(ret < 0) {
+            printf("Error scanning for cells");
+            exit(1);
+        }
+    }
+
+    printf("\n\nFound %d cells\n", ret);
+    scan_print_cells(scanned_cells, ret);
+
+    if(db_path != NULL) {
+        cell_db_update(&db, scanned_cells, ret, time(NULL));
+        cell_db_save(&db, db_path);
+        printf("Cell cache %s: %d cells\n", db_path, db.nof_cells);
+    }
+    if(ngscope_config != NULL) {
+        cell_db_write_rf_config(&db, ngscope_config, nof_rf > 0 && argc - optind > 2 ? &argv[optind + 2] : NULL, nof_rf);
     }
 
     fclose(file);
 
-    srsran_rf_close(&rf);
+    for(i = 0; i < nof_rf; i++) {
+      srsran_rf_close(&rf[i]);
+    }
 
     printf("\nBye\n");
     exit(0);
-  }
\ No newline at end of file
+  }
@@ -167,6 +167,16 @@ SRSRAN_API int srsran_chest_dl_estimate_cfg(srsran_chest_dl_t*     q,
                                             cf_t*                  input[SRSRAN_MAX_PORTS],
                                             srsran_chest_dl_res_t* res);
 
+/* Estimates the channel of a normal subframe in the first nof_symbols only (control region). It uses the CRS of the
+ * first reference symbol of each port, so these must be demodulated. Noise is always estimated from the pilots and
+ * the CFO is not estimated */
+SRSRAN_API int srsran_chest_dl_estimate_ctrl(srsran_chest_dl_t*     q,
+                                             srsran_dl_sf_cfg_t*    sf,
+                                             srsran_chest_dl_cfg_t* cfg,
+                                             cf_t*                  input[SRSRAN_MAX_PORTS],
+                                             srsran_chest_dl_res_t* res,
+                                             uint32_t               nof_symbols);
+
 SRSRAN_API srsran_chest_dl_estimator_alg_t srsran_chest_dl_str2estimator_alg(const char* str);
 
 #endif // SRSRAN_CHEST_DL_H
@@ -24,6 +24,7 @@
 
 #include "srsran/config.h"
 #include <stdbool.h>
+#include <stdint.h>
 
 /**********************************************************************************************
  *  File:         dft.h
@@ -82,6 +83,22 @@ SRSRAN_API int srsran_dft_plan_guru_c(srsran_dft_plan_t* plan,
                                       int                idist,
                                       int                odist);
 
+/* Same as srsran_dft_plan_guru_c with a second, outer, loop dimension. It allows a single plan to transform
+ * how_many symbols in each of nof_batch blocks (e.g. slots of several subframes) */
+SRSRAN_API int srsran_dft_plan_guru_batch_c(srsran_dft_plan_t* plan,
+                                            int                dft_points,
+                                            srsran_dft_dir_t   dir,
+                                            cf_t*              in_buffer,
+                                            cf_t*              out_buffer,
+                                            int                istride,
+                                            int                ostride,
+                                            int                how_many,
+                                            int                idist,
+                                            int                odist,
+                                            int                nof_batch,
+                                            int                batch_idist,
+                                            int                batch_odist);
+
 SRSRAN_API int srsran_dft_plan_r(srsran_dft_plan_t* plan, int dft_points, srsran_dft_dir_t dir);
 
 SRSRAN_API int srsran_dft_replan(srsran_dft_plan_t* plan, const int new_dft_points);
@@ -102,6 +119,13 @@ SRSRAN_API int srsran_dft_replan_r(srsran_dft_plan_t* plan, int new_dft_points);
 
 SRSRAN_API void srsran_dft_plan_free(srsran_dft_plan_t* plan);
 
+/* Plans describing the same transform (size, direction, strides, flags and buffer alignment) share a single FFTW
+ * plan, this returns the number of distinct FFTW plans currently in use */
+SRSRAN_API uint32_t srsran_dft_plan_cache_size();
+
+/* Stores the accumulated FFTW wisdom in the wisdom file, it is also done at exit */
+SRSRAN_API int srsran_dft_export_wisdom();
+
 /* Set options */
 
 SRSRAN_API void srsran_dft_plan_set_mirror(srsran_dft_plan_t* plan, bool val);
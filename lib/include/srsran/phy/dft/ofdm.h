@@ -72,6 +72,8 @@ typedef struct SRSRAN_API {
   srsran_ofdm_cfg_t cfg;
   srsran_dft_plan_t fft_plan;
   srsran_dft_plan_t fft_plan_sf[2];
+  srsran_dft_plan_t fft_plan_ctrl; ///< Rx only, first nof_symbols_ctrl symbols of the subframe
+  uint32_t          nof_symbols_ctrl;
   uint32_t          max_prb;
   uint32_t          nof_symbols;
   uint32_t          nof_guards;
@@ -90,6 +92,22 @@ typedef struct SRSRAN_API {
   srsran_cfr_t      tx_cfr; ///< Tx CFR object
 } srsran_ofdm_t;
 
+#define SRSRAN_OFDM_BATCH_MAX_SF 8
+
+/**
+ * @struct srsran_ofdm_batch_t
+ * Demodulates several consecutive normal subframes with a single DFT execution. It borrows the configuration (CP,
+ * symbol size, window offset, normalization and phase compensation) of an already initialised OFDM receiver.
+ */
+typedef struct SRSRAN_API {
+  srsran_ofdm_t*    ofdm;
+  srsran_dft_plan_t plan[SRSRAN_OFDM_BATCH_MAX_SF]; ///< One plan for each number of subframes in the batch
+  uint32_t          max_nof_sf;
+  uint32_t          sf_sz;
+  cf_t*             in_buffer; ///< Time domain input, one subframe every sf_sz samples
+  cf_t*             tmp;
+} srsran_ofdm_batch_t;
+
 /**
  * @brief Initialises or reconfigures OFDM receiver
  *
@@ -128,6 +146,51 @@ SRSRAN_API void srsran_ofdm_rx_free(srsran_ofdm_t* q);
 
 SRSRAN_API void srsran_ofdm_rx_sf(srsran_ofdm_t* q);
 
+/**
+ * @brief Initialises a batch OFDM receiver on top of the OFDM receiver ofdm
+ *
+ * @attention The batch object must be initialised again if the OFDM receiver is reconfigured
+ *
+ * @param q Batch OFDM object
+ * @param ofdm Initialised OFDM receiver, it provides the demodulation parameters
+ * @param max_nof_sf Maximum number of subframes in a batch
+ * @return SRSRAN_SUCCESS if the initialization is successful, SRSRAN_ERROR code otherwise
+ */
+SRSRAN_API int srsran_ofdm_rx_batch_init(srsran_ofdm_batch_t* q, srsran_ofdm_t* ofdm, uint32_t max_nof_sf);
+
+SRSRAN_API void srsran_ofdm_rx_batch_free(srsran_ofdm_batch_t* q);
+
+/**
+ * @brief Returns the input buffer for the subframe sf_idx of the batch
+ */
+SRSRAN_API cf_t* srsran_ofdm_rx_batch_input(srsran_ofdm_batch_t* q, uint32_t sf_idx);
+
+/**
+ * @brief Demodulates the first nof_sf subframes of the batch input, the subframe i is written in output[i]
+ *
+ * @return SRSRAN_SUCCESS if the demodulation is successful, SRSRAN_ERROR code otherwise
+ */
+SRSRAN_API int
+srsran_ofdm_rx_batch_run(srsran_ofdm_batch_t* q, cf_t* output[SRSRAN_OFDM_BATCH_MAX_SF], uint32_t nof_sf);
+
+/**
+ * @brief Demodulates only the largest possible control region of a normal subframe, this is the first 3 OFDM symbols
+ * (4 for 10 PRB or less). It includes the CRS of all ports in the first slot symbols. The rest of the output buffer is
+ * left untouched.
+ *
+ * @param q OFDM object
+ * @return The number of demodulated symbols
+ */
+SRSRAN_API uint32_t srsran_ofdm_rx_sf_ctrl(srsran_ofdm_t* q);
+
+/**
+ * @brief Demodulates the whole subframe after srsran_ofdm_rx_sf_ctrl, on the same input. The frequency shift that
+ * srsran_ofdm_rx_sf_ctrl applied in place to the control symbols is not applied again.
+ *
+ * @param q OFDM object
+ */
+SRSRAN_API void srsran_ofdm_rx_sf_complete(srsran_ofdm_t* q);
+
 SRSRAN_API void srsran_ofdm_rx_sf_ng(srsran_ofdm_t* q, cf_t* input, cf_t* output);
 
 SRSRAN_API int
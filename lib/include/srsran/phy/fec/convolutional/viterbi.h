@@ -92,4 +92,29 @@ SRSRAN_API int srsran_viterbi_init_avx2(srsran_viterbi_t*     q,
                                         uint32_t              max_frame_length,
                                         bool                  tail_bitting);
 
+/* Batch decoder for tail-biting r=1/3 K=7 codewords (PDCCH). Up to SRSRAN_VITERBI_BATCH_MAX codewords of the same
+ * length are decoded at once, one codeword per SIMD lane with 16-bit path metrics */
+#define SRSRAN_VITERBI_BATCH_MAX 16
+
+typedef struct SRSRAN_API {
+  uint32_t  max_frame_length;
+  uint32_t  max_nof_steps;
+  uint8_t   outputs[128]; // encoder output bits of every register value
+  int16_t*  symbols;      // quantized symbols, SRSRAN_VITERBI_BATCH_MAX lanes for every coded bit
+  uint32_t* decisions;    // survivor decisions, bit 2 * lane of every state and step
+  int16_t*  metrics;      // final path metrics, SRSRAN_VITERBI_BATCH_MAX lanes for every state
+  int16_t*  tmp;
+} srsran_viterbi_batch_t;
+
+SRSRAN_API int srsran_viterbi_batch_init(srsran_viterbi_batch_t* q, int poly[3], uint32_t max_frame_length);
+
+SRSRAN_API void srsran_viterbi_batch_free(srsran_viterbi_batch_t* q);
+
+/* Decodes nof_cw codewords of 3 * frame_length real-valued symbols each */
+SRSRAN_API int srsran_viterbi_batch_decode_f(srsran_viterbi_batch_t* q,
+                                             float*                  symbols[SRSRAN_VITERBI_BATCH_MAX],
+                                             uint8_t*                data[SRSRAN_VITERBI_BATCH_MAX],
+                                             uint32_t                nof_cw,
+                                             uint32_t                frame_length);
+
 #endif // SRSRAN_VITERBI_H
@@ -38,6 +38,7 @@
 #include "srsran/phy/fec/convolutional/viterbi.h"
 #include "srsran/phy/fec/crc.h"
 #include "srsran/phy/mimo/layermap.h"
+#include <pthread.h>
 #include "srsran/phy/mimo/precoding.h"
 #include "srsran/phy/modem/demod_soft.h"
 #include "srsran/phy/modem/mod.h"
@@ -47,6 +48,38 @@
 
 typedef enum SRSRAN_API { SEARCH_UE, SEARCH_COMMON } srsran_pdcch_search_mode_t;
 
+/* Number of aggregation levels (1, 2, 4 and 8 CCEs) in the CCE energy map */
+#define SRSRAN_PDCCH_NOF_AGGREGATION_LEVELS 4
+
+/* Candidate pruning: fixed LLR_RATIO gate or a gate learned from the idle CCEs of the cell */
+typedef enum SRSRAN_API { SRSRAN_PDCCH_LLR_GATE_FIXED = 0, SRSRAN_PDCCH_LLR_GATE_ADAPTIVE } srsran_pdcch_llr_gate_mode_t;
+
+typedef struct SRSRAN_API {
+  uint64_t nof_sf;         // subframes seen by the gate
+  uint64_t nof_candidates; // candidates compared against the gate
+  uint64_t nof_gated;      // candidates skipped because their mean |LLR| is under the gate
+  uint64_t nof_detected;   // DCIs found in the subframes
+} srsran_pdcch_llr_gate_stats_t;
+
+typedef struct SRSRAN_API {
+  srsran_pdcch_llr_gate_mode_t  mode;
+  float                         threshold;   // learned threshold, used once nof_updates reaches the warm-up
+  float                         idle_mean;   // average mean |LLR| of the CCEs without DCI
+  float                         idle_var;    // its variance across CCEs
+  float                         noise;       // equalized noise variance the statistics were learned with
+  uint32_t                      nof_updates; // subframes learned since the last (re)start
+} srsran_pdcch_llr_gate_t;
+
+/* Candidates decoded ahead by srsran_pdcch_decode_batch_yx, one table per DCI size of the subframe */
+#define SRSRAN_PDCCH_BATCH_NOF_SIZES 6
+
+typedef struct SRSRAN_API {
+  uint8_t  payload[SRSRAN_DCI_MAX_BITS / 8]; // packed
+  uint16_t crc;                              // CRC remainder, RNTI of the candidate
+  float    prob;                             // re-encoding match, as srsran_pdcch_dci_decode_yx
+  uint32_t gen;                              // valid while equal to batch_gen
+} srsran_pdcch_batch_result_t;
+
 /* PDCCH object */
 typedef struct SRSRAN_API {
   srsran_cell_t cell;
@@ -67,6 +100,27 @@ typedef struct SRSRAN_API {
   float    rm_f[3 * (SRSRAN_DCI_MAX_BITS + 16)];
   float*   llr;
 
+  /* CCE energy map: sum of |LLR| of every candidate of each aggregation level, computed once per subframe */
+  float*   cce_energy[SRSRAN_PDCCH_NOF_AGGREGATION_LEVELS];
+  uint32_t max_cce;
+  uint32_t nof_cce_energy;
+
+  /* Adaptive LLR gate, the CCEs used by the DCIs found in the subframe are marked in cce_used. llr_gate points at
+   * llr_gate_own or at a gate shared with other PDCCH receivers of the cell, the statistics are always our own */
+  srsran_pdcch_llr_gate_t       llr_gate_own;
+  srsran_pdcch_llr_gate_t*      llr_gate;
+  pthread_mutex_t*              llr_gate_mutex;
+  srsran_pdcch_llr_gate_stats_t llr_gate_stats;
+  uint8_t*                      cce_used;
+
+  /* Batch decoding, the results are kept until the next srsran_pdcch_extract_llr */
+  srsran_viterbi_batch_t       decoder_batch;
+  float*                       rm_batch;
+  srsran_pdcch_batch_result_t* batch_results;
+  uint32_t                     batch_sizes[SRSRAN_PDCCH_BATCH_NOF_SIZES];
+  uint32_t                     nof_batch_sizes;
+  uint32_t                     batch_gen;
+
   /* tx & rx objects */
   srsran_modem_table_t mod;
   srsran_sequence_t    seq[SRSRAN_NOF_SF_X_FRAME];
@@ -102,6 +156,40 @@ SRSRAN_API int srsran_pdcch_extract_llr(srsran_pdcch_t*        q,
                                         srsran_chest_dl_res_t* channel,
                                         cf_t*                  sf_symbols[SRSRAN_MAX_PORTS]);
 
+/* CCE energy map, available after calling srsran_pdcch_extract_llr */
+
+/* Mean |LLR| of the candidate starting at CCE ncce with aggregation level L (1 << L CCEs) */
+SRSRAN_API float srsran_pdcch_cce_mean_llr(srsran_pdcch_t* q, uint32_t ncce, uint32_t L);
+
+/* Mean |LLR| of each CCE of the subframe, it returns the number of CCEs */
+SRSRAN_API uint32_t srsran_pdcch_cce_energy(srsran_pdcch_t* q, float* energy, uint32_t max_nof_cce);
+
+/* LLR gate: candidates with a mean |LLR| under the gate are not decoded. The fixed mode (default) and the adaptive
+ * mode before its warm-up use LLR_RATIO. set_mode only changes the mode, what the gate learned is kept */
+SRSRAN_API void srsran_pdcch_llr_gate_set_mode(srsran_pdcch_t* q, srsran_pdcch_llr_gate_mode_t mode);
+
+SRSRAN_API float srsran_pdcch_llr_gate(srsran_pdcch_t* q);
+
+/* Forgets what the gate learned and puts it in the fixed mode. Call it once, before the gate is shared */
+SRSRAN_API void srsran_pdcch_llr_gate_reset(srsran_pdcch_llr_gate_t* gate);
+
+/* Learns into gate instead of our own, so that the PDCCH receivers of the same cell (the decoder threads of a
+ * carrier) share one gate. mutex serializes their accesses to it, gate NULL goes back to our own */
+SRSRAN_API void srsran_pdcch_llr_gate_share(srsran_pdcch_t* q, srsran_pdcch_llr_gate_t* gate, pthread_mutex_t* mutex);
+
+/* Compares the mean |LLR| of a candidate against the gate and counts it in the gate statistics */
+SRSRAN_API bool srsran_pdcch_llr_gate_pass(srsran_pdcch_t* q, float mean_llr);
+
+/* Learns the gate from the CCEs not covered by the DCIs found in the subframe and the noise of the channel estimate.
+ * Call it once per subframe after the search, with the locations of the DCIs found */
+SRSRAN_API int srsran_pdcch_llr_gate_update(srsran_pdcch_t*              q,
+                                            const srsran_chest_dl_res_t* channel,
+                                            const srsran_dci_location_t* locations,
+                                            uint32_t                     nof_locations);
+
+/* Copies the gate statistics and optionally restarts them */
+SRSRAN_API void srsran_pdcch_llr_gate_stats(srsran_pdcch_t* q, srsran_pdcch_llr_gate_stats_t* stats, bool reset);
+
 /* Decoding functions: Try to decode a DCI message after calling srsran_pdcch_extract_llr */
 SRSRAN_API int
 srsran_pdcch_decode_msg(srsran_pdcch_t* q, srsran_dl_sf_cfg_t* sf, srsran_dci_cfg_t* dci_cfg, srsran_dci_msg_t* msg);
@@ -109,6 +197,17 @@ srsran_pdcch_decode_msg(srsran_pdcch_t* q, srsran_dl_sf_cfg_t* sf, srsran_dci_cf
 SRSRAN_API int
 srsran_pdcch_decode_msg_yx(srsran_pdcch_t* q, srsran_dl_sf_cfg_t* sf, srsran_dci_cfg_t* dci_cfg, srsran_dci_msg_t* msg, float* prob);
 
+/* Decodes the candidates of one format together with the batch Viterbi decoder and keeps the results, so that the
+ * following srsran_pdcch_decode_msg_yx calls for the same location and format do not decode again. The candidates
+ * under the LLR gate are skipped, and so are the last ones when they are too few to fill the batch decoder: they are
+ * faster decoded one by one. Returns the number of candidates decoded */
+SRSRAN_API int srsran_pdcch_decode_batch_yx(srsran_pdcch_t*              q,
+                                            srsran_dl_sf_cfg_t*          sf,
+                                            srsran_dci_cfg_t*            dci_cfg,
+                                            srsran_dci_format_t          format,
+                                            const srsran_dci_location_t* locations,
+                                            uint32_t                     nof_locations);
+
 
 /**
  * @brief Computes decoded DCI correlation. It encodes the given DCI message and compares it with the received LLRs
@@ -0,0 +1,137 @@
+/**
+ * Copyright 2013-2023 Software Radio Systems Limited
+ *
+ * This file is part of srsRAN.
+ *
+ * srsRAN is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsRAN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+/******************************************************************************
+ *  File:         channelizer.h
+ *
+ *  Description:  Fast-convolution (FFT filter bank) channelizer. One forward
+ *                DFT of a wideband capture is shared by all the channels, each
+ *                channel selects the bins around its center, applies a raised
+ *                cosine mask and returns to the time domain with a smaller
+ *                inverse DFT at its own sampling rate (overlap-save, 50%).
+ *
+ *  Reference:    M. Renfors et al., "Fast-convolution filter banks", 2016
+ *****************************************************************************/
+
+#ifndef SRSRAN_CHANNELIZER_H
+#define SRSRAN_CHANNELIZER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "srsran/config.h"
+#include "srsran/phy/dft/dft.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SRSRAN_CHANNELIZER_MAX_CHANNELS 16
+
+/**
+ * @brief Extraction state of one channel
+ */
+typedef struct {
+  bool              enabled;
+  double            offset_hz;   ///< Channel center relative to the capture center
+  double            srate;       ///< Output sampling rate
+  uint32_t          ifft_size;   ///< Inverse DFT size, ifft_size / fft_size = srate / input srate
+  int32_t           bin_offset;  ///< Channel center in input bins
+  double            residual;    ///< Remaining frequency offset in cycles per output sample
+  float*            filter;      ///< Frequency mask in DFT order, includes the DFT normalisation
+  cf_t*             rotation;    ///< Per sample residual correction of one block
+  cf_t*             in_buffer;   ///< Inverse DFT input
+  cf_t*             out_buffer;  ///< Inverse DFT output
+  srsran_dft_plan_t ifft;
+} srsran_channelizer_channel_t;
+
+/**
+ * @brief Channelizer internal buffers and subcomponents
+ */
+typedef struct {
+  double                       srate;     ///< Input sampling rate
+  uint32_t                     fft_size;  ///< Forward DFT size
+  uint32_t                     hop;       ///< New input samples per block (fft_size / 2)
+  cf_t*                        in_buffer; ///< Forward DFT input
+  cf_t*                        spectrum;  ///< Forward DFT output
+  srsran_dft_plan_t            fft;
+  srsran_channelizer_channel_t channels[SRSRAN_CHANNELIZER_MAX_CHANNELS];
+} srsran_channelizer_t;
+
+/**
+ * Initialise a channelizer without channels
+ * @param q Object pointer
+ * @param srate Input sampling rate in Hz
+ * @param fft_size Forward DFT size, it must be even. It sets the frequency resolution (srate / fft_size) of the
+ * output rates
+ * @return SRSRAN_SUCCESS if no error, otherwise an SRSRAN error code
+ */
+SRSRAN_API int srsran_channelizer_init(srsran_channelizer_t* q, double srate, uint32_t fft_size);
+
+/**
+ * Configure (or re-configure) one channel
+ * @param q Object pointer
+ * @param ch Channel index, lower than SRSRAN_CHANNELIZER_MAX_CHANNELS
+ * @param offset_hz Channel center frequency relative to the capture center
+ * @param srate Output sampling rate, fft_size * srate / input srate must be an even integer
+ * @return SRSRAN_SUCCESS if no error, otherwise an SRSRAN error code
+ */
+SRSRAN_API int srsran_channelizer_set_channel(srsran_channelizer_t* q, uint32_t ch, double offset_hz, double srate);
+
+/**
+ * Stop producing samples for one channel
+ */
+SRSRAN_API void srsran_channelizer_disable_channel(srsran_channelizer_t* q, uint32_t ch);
+
+/**
+ * Number of output samples of one channel for each block, 0 if the channel is disabled
+ */
+SRSRAN_API uint32_t srsran_channelizer_block_out(const srsran_channelizer_t* q, uint32_t ch);
+
+/**
+ * Channelize consecutive blocks. The input holds q->hop history samples followed by nof_blocks * q->hop new
+ * samples. The processing is stateless, so consecutive chunks of one stream can be run in parallel by several
+ * channelizers configured the same way; first_block keeps the phase of the outputs continuous across chunks.
+ *
+ * @param q Object pointer
+ * @param input (nof_blocks + 1) * hop input samples
+ * @param nof_blocks Number of blocks
+ * @param first_block Index of the first block in the stream
+ * @param output Output buffer of each channel, nof_blocks * srsran_channelizer_block_out() samples. The buffers of
+ * the disabled channels can be NULL
+ */
+SRSRAN_API void srsran_channelizer_run(srsran_channelizer_t* q,
+                                       const cf_t*           input,
+                                       uint32_t              nof_blocks,
+                                       uint64_t              first_block,
+                                       cf_t*                 output[SRSRAN_CHANNELIZER_MAX_CHANNELS]);
+
+/**
+ * Free channelizer buffers and subcomponents
+ * @param q Object pointer
+ */
+SRSRAN_API void srsran_channelizer_free(srsran_channelizer_t* q);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SRSRAN_CHANNELIZER_H
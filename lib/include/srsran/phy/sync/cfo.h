@@ -57,6 +57,18 @@ SRSRAN_API void srsran_cfo_set_tol(srsran_cfo_t* h, float tol);
 
 SRSRAN_API void srsran_cfo_correct(srsran_cfo_t* h, const cf_t* input, cf_t* output, float freq);
 
+/* Corrects the same frequency offset on several channels (antennas) in a single pass, the complex exponential is
+ * generated once and applied to all channels. NULL channels are skipped. */
+SRSRAN_API void srsran_cfo_correct_multi(srsran_cfo_t* h,
+                                         cf_t*         input[SRSRAN_MAX_CHANNELS],
+                                         cf_t*         output[SRSRAN_MAX_CHANNELS],
+                                         uint32_t      nof_channels,
+                                         float         freq);
+
+/* In-place version of srsran_cfo_correct_multi, e.g. for correcting directly on the receive buffers */
+SRSRAN_API void
+srsran_cfo_correct_multi_inplace(srsran_cfo_t* h, cf_t* buffer[SRSRAN_MAX_CHANNELS], uint32_t nof_channels, float freq);
+
 SRSRAN_API void
 srsran_cfo_correct_offset(srsran_cfo_t* h, const cf_t* input, cf_t* output, float freq, int cexp_offset, int nsamples);
 
@@ -45,6 +45,24 @@ SRSRAN_API int srsran_ngscope_search_all_space_array_yx(srsran_ue_dl_t*     	q,
 														 ngscope_tree_t* 				tree,
 														 uint16_t 						targetRNTI);
 
+/* Hybrid search: decode only the search spaces of the RNTIs in rnti_list and the SI and paging DCIs, the full
+ * search over the tree runs if full_search is set or if the CCE energy map shows occupied CCEs that the DCIs
+ * found don't explain. The LLR gate only learns from the full search.
+ * si_loc are the SI DCIs the caller already found in this subframe, nof_si_loc < 0 if it did not look for them.
+ * Returns 1 if the full search ran and the tree holds its results, 0 otherwise */
+SRSRAN_API int srsran_ngscope_search_hybrid_yx(srsran_ue_dl_t*        q,
+                                               srsran_dl_sf_cfg_t*    sf,
+                                               srsran_ue_dl_cfg_t*    cfg,
+                                               srsran_pdsch_cfg_t*    pdsch_cfg,
+                                               ngscope_dci_per_sub_t* dci_per_sub,
+                                               ngscope_tree_t*        tree,
+                                               const uint16_t*        rnti_list,
+                                               uint32_t               nof_rnti,
+                                               const srsran_dci_location_t* si_loc,
+                                               int                    nof_si_loc,
+                                               bool                   full_search,
+                                               uint16_t               targetRNTI);
+
 SRSRAN_API int srsran_ngscope_search_all_space_array_singleUE_yx(srsran_ue_dl_t*     q,
 																 srsran_dl_sf_cfg_t* sf,
 																 srsran_ue_dl_cfg_t* cfg,
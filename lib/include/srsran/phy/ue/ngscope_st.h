@@ -51,7 +51,8 @@ typedef struct SRSRAN_API {
     ngscope_dci_msg_t  ul_msg[MAX_DCI_PER_SUB];
     uint32_t           nof_ul_dci;
 
-	uint64_t 			timestamp;
+	uint64_t 			timestamp;          // air time of the subframe (wall clock, us)
+	uint64_t 			decode_timestamp;   // when the decoding completed (wall clock, us)
 } ngscope_dci_per_sub_t;
 
 int ngscope_push_dci_to_per_sub(ngscope_dci_per_sub_t* q, ngscope_dci_msg_t* msg);
@@ -29,6 +29,7 @@ typedef struct{
 	srsran_dci_location_t 	dci_location[MAX_CANDIDATES_ALL];
 	int 					nof_location;
 	int 					nof_cce;
+	float 					llr_gate;	// mean llr under which a location is treated as empty
 }ngscope_tree_t;
 
 void srsran_ngscope_tree_copy_dci_fromArray2PerSub(ngscope_tree_t* q,
@@ -88,6 +88,7 @@ typedef struct SRSRAN_API {
   srsran_pdsch_t  pdsch;
   srsran_pmch_t   pmch;
   srsran_phich_t  phich;
+  bool            pdsch_enable; // false if only the control channels were created
 
   // Control region
   srsran_regs_t regs[SRSRAN_MI_MAX_REGS];
@@ -100,6 +101,23 @@ typedef struct SRSRAN_API {
   srsran_ofdm_t         fft[SRSRAN_MAX_PORTS];
   srsran_ofdm_t         fft_mbsfn;
 
+  // Batch OFDM demodulation of consecutive subframes
+  srsran_ofdm_batch_t fft_batch[SRSRAN_MAX_PORTS];
+  uint32_t            batch_max_sf;
+  uint32_t            batch_nof_sf;
+  uint32_t            batch_tti[SRSRAN_OFDM_BATCH_MAX_SF];
+  cf_t*               batch_symbols[SRSRAN_OFDM_BATCH_MAX_SF][SRSRAN_MAX_PORTS];
+
+  // Control region only demodulation, the rest of the subframe is demodulated on demand
+  bool                  ctrl_only_enable;
+  bool                  ctrl_only_pending;
+  srsran_dl_sf_cfg_t    ctrl_only_sf;
+  srsran_chest_dl_cfg_t ctrl_only_chest_cfg;
+
+  // Control region written by the caller, e.g. replayed from a capture
+  uint32_t ctrl_symbols_tti;
+  uint32_t ctrl_symbols_nof;
+
   // Buffers to store channel symbols after demodulation
   cf_t*              sf_symbols[SRSRAN_MAX_PORTS];
   dci_blind_search_t current_ss_common;
@@ -162,6 +180,11 @@ typedef struct {
 SRSRAN_API int
 srsran_ue_dl_init(srsran_ue_dl_t* q, cf_t* input[SRSRAN_MAX_PORTS], uint32_t max_prb, uint32_t nof_rx_antennas);
 
+/* Control channels only (PCFICH, PHICH and PDCCH): PDSCH and PMCH are not created, which keeps the memory of a
+ * DCI decoder small. Decoding a PDSCH or a PMCH with such an object fails */
+SRSRAN_API int
+srsran_ue_dl_init_ctrl(srsran_ue_dl_t* q, cf_t* input[SRSRAN_MAX_PORTS], uint32_t max_prb, uint32_t nof_rx_antennas);
+
 SRSRAN_API void srsran_ue_dl_free(srsran_ue_dl_t* q);
 
 SRSRAN_API int srsran_ue_dl_set_cell(srsran_ue_dl_t* q, srsran_cell_t cell);
@@ -174,6 +197,10 @@ SRSRAN_API void srsran_ue_dl_set_mi_manual(srsran_ue_dl_t* q, uint32_t mi_idx);
 
 SRSRAN_API void srsran_ue_dl_set_mi_auto(srsran_ue_dl_t* q);
 
+/* In control-only mode decode_fft_estimate() demodulates and estimates the control region only. The PDSCH/PMCH
+ * decoding and RI/PMI selection functions complete the demodulation of the subframe when they need it */
+SRSRAN_API void srsran_ue_dl_set_control_only(srsran_ue_dl_t* q, bool enable);
+
 /* Perform signal demodulation and channel estimation and store signals in the object */
 SRSRAN_API int srsran_ue_dl_decode_fft_estimate(srsran_ue_dl_t* q, srsran_dl_sf_cfg_t* sf, srsran_ue_dl_cfg_t* cfg);
 
@@ -182,6 +209,28 @@ SRSRAN_API int srsran_ue_dl_decode_fft_estimate_noguru(srsran_ue_dl_t*     q,
                                                        srsran_ue_dl_cfg_t* cfg,
                                                        cf_t*               input[SRSRAN_MAX_PORTS]);
 
+/* Batch OFDM demodulation. Subframes are written with srsran_ue_dl_batch_input() and demodulated together with
+ * srsran_ue_dl_batch_fft(). A later call to decode_fft_estimate() for any of the batched TTI only runs the channel
+ * estimation on the batch output. srsran_ue_dl_batch_init() must be called after srsran_ue_dl_set_cell() */
+SRSRAN_API int srsran_ue_dl_batch_init(srsran_ue_dl_t* q, uint32_t max_nof_sf);
+
+SRSRAN_API void srsran_ue_dl_batch_free(srsran_ue_dl_t* q);
+
+SRSRAN_API cf_t* srsran_ue_dl_batch_input(srsran_ue_dl_t* q, uint32_t sf_idx, uint32_t port);
+
+SRSRAN_API int srsran_ue_dl_batch_fft(srsran_ue_dl_t* q, const uint32_t* tti, uint32_t nof_sf);
+
+/* Drops the current batch, decode_fft_estimate() demodulates the input buffers again */
+SRSRAN_API void srsran_ue_dl_batch_reset(srsran_ue_dl_t* q);
+
+/* Demodulated control region given by the caller. The first nof_symbols OFDM symbols of the subframe (SRSRAN_NRE *
+ * nof_prb REs each) are written to srsran_ue_dl_ctrl_symbols() for every receive antenna, then decode_fft_estimate()
+ * for tti only runs the control region channel estimation on them. The PDSCH of such a subframe can not be decoded.
+ * A nof_symbols of 0 goes back to the demodulation of the input buffers */
+SRSRAN_API cf_t* srsran_ue_dl_ctrl_symbols(srsran_ue_dl_t* q, uint32_t port);
+
+SRSRAN_API int srsran_ue_dl_set_ctrl_symbols(srsran_ue_dl_t* q, uint32_t tti, uint32_t nof_symbols);
+
 /* Finds UL/DL DCI in the signal processed in a previous call to decode_fft_estimate() */
 SRSRAN_API int srsran_ue_dl_find_ul_dci(srsran_ue_dl_t*     q,
                                         srsran_dl_sf_cfg_t* sf,
@@ -276,6 +325,14 @@ SRSRAN_API int srsran_ue_decode_dci_yx(srsran_ue_dl_t*     q,
                                  ngscope_dci_per_sub_t* dci_res, 
 								 uint16_t 				targetRNTI);
 
+/* Same search on the LLRs of the last srsran_ue_dl_decode_fft_estimate, the DCIs found are appended to dci_res */
+SRSRAN_API int srsran_ue_decode_dci_target_yx(srsran_ue_dl_t*        q,
+                                              srsran_dl_sf_cfg_t*    sf,
+                                              srsran_ue_dl_cfg_t*    cfg,
+                                              srsran_pdsch_cfg_t*    pdsch_cfg,
+                                              ngscope_dci_per_sub_t* dci_res,
+                                              uint16_t               targetRNTI);
+
 SRSRAN_API void srsran_ue_dl_save_signal(srsran_ue_dl_t* q, srsran_dl_sf_cfg_t* sf, srsran_pdsch_cfg_t* pdsch_cfg);
 
 #endif // SRSRAN_UE_DL_H
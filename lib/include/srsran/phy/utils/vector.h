@@ -124,6 +124,9 @@ SRSRAN_API void srsran_vec_xor_bbb(const uint8_t* x, const uint8_t* y, uint8_t*
 SRSRAN_API float srsran_vec_acc_ff(const float* x, const uint32_t len);
 SRSRAN_API cf_t  srsran_vec_acc_cc(const cf_t* x, const uint32_t len);
 
+/** Return the sum of the absolute values of all the elements */
+SRSRAN_API float srsran_vec_abs_acc_ff(const float* x, const uint32_t len);
+
 SRSRAN_API void* srsran_vec_malloc(uint32_t size);
 SRSRAN_API cf_t*  srsran_vec_cf_malloc(uint32_t size);
 SRSRAN_API float* srsran_vec_f_malloc(uint32_t size);
@@ -369,6 +372,10 @@ SRSRAN_API cf_t srsran_vec_gen_sine(cf_t amplitude, float freq, cf_t* z, int len
 
 SRSRAN_API void srsran_vec_apply_cfo(const cf_t* x, float cfo, cf_t* z, int len);
 
+/* Same as srsran_vec_apply_cfo for several channels sharing the same oscillator, which is generated only once.
+ * x and z may be the same buffers (in-place) */
+SRSRAN_API void srsran_vec_apply_cfo_multi(cf_t** x, float cfo, cf_t** z, int nof_channels, int len);
+
 SRSRAN_API float srsran_vec_estimate_frequency(const cf_t* x, int len);
 
 /*!
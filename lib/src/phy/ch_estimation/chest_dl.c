@@ -321,6 +321,20 @@ int srsran_chest_dl_set_cell(srsran_chest_dl_t* q, srsran_cell_t cell)
   return ret;
 }
 
+// Compares each pilot with its neighbours in frequency, it only uses the first nref estimates
+static float estimate_noise_pilots_freq(srsran_chest_dl_t* q, uint32_t nref)
+{
+  const float weight    = 1.0f;
+  cf_t*       tmp_noise = q->tmp_noise;
+
+  srsran_vec_sc_prod_cfc(q->pilot_estimates + 1, weight, tmp_noise, nref - 2);
+  srsran_vec_sum_ccc(q->pilot_estimates + 0, tmp_noise, tmp_noise, nref - 2);
+  srsran_vec_sum_ccc(q->pilot_estimates + 2, tmp_noise, tmp_noise, nref - 2);
+  srsran_vec_sc_prod_cfc(tmp_noise, 1.0f / (weight + 2.0f), tmp_noise, nref - 2);
+  srsran_vec_sub_ccc(q->pilot_estimates + 1, tmp_noise, tmp_noise, nref - 2);
+  return srsran_vec_avg_power_cf(tmp_noise, nref - 2);
+}
+
 /* Uses the difference between the averaged and non-averaged pilot estimates */
 static float estimate_noise_pilots(srsran_chest_dl_t* q, srsran_dl_sf_cfg_t* sf, uint32_t port_id)
 {
@@ -344,13 +358,7 @@ static float estimate_noise_pilots(srsran_chest_dl_t* q, srsran_dl_sf_cfg_t* sf,
 
   // Special case for 1 or 2 symbol
   if (nsymbols < 3) {
-    srsran_vec_sc_prod_cfc(q->pilot_estimates + 1, weight, tmp_noise, nref - 2);
-    srsran_vec_sum_ccc(q->pilot_estimates + 0, tmp_noise, tmp_noise, nref - 2);
-    srsran_vec_sum_ccc(q->pilot_estimates + 2, tmp_noise, tmp_noise, nref - 2);
-    srsran_vec_sc_prod_cfc(tmp_noise, 1.0f / (weight + 2.0f), tmp_noise, nref - 2);
-    srsran_vec_sub_ccc(q->pilot_estimates + 1, tmp_noise, tmp_noise, nref - 2);
-    sum_power = srsran_vec_avg_power_cf(tmp_noise, nref - 2);
-    return sum_power;
+    return estimate_noise_pilots_freq(q, nref);
   }
 
   // Convert pilots to 2D to ease access
@@ -1026,6 +1034,149 @@ int srsran_chest_dl_estimate_cfg(srsran_chest_dl_t*     q,
   return SRSRAN_SUCCESS;
 }
 
+/* Least-squares estimates of the CRS in the first reference symbol of the port, it returns the number of pilots */
+static uint32_t estimate_ctrl_ls(srsran_chest_dl_t* q, srsran_dl_sf_cfg_t* sf, cf_t* input, uint32_t port_id)
+{
+  uint32_t nref    = 2 * q->cell.nof_prb;
+  uint32_t nsymbol = srsran_refsignal_cs_nsymbol(0, q->cell.cp, port_id);
+  uint32_t fidx    = srsran_refsignal_cs_fidx(q->cell, 0, port_id, 0);
+
+  for (uint32_t i = 0; i < nref; i++) {
+    q->pilot_recv_signal[i] = input[SRSRAN_RE_IDX(q->cell.nof_prb, nsymbol, fidx)];
+    fidx += SRSRAN_NRE / 2; // 2 references per PRB
+  }
+
+  srsran_vec_prod_conj_ccc(
+      q->pilot_recv_signal, q->csr_refs.pilots[port_id / 2][sf->tti % 10], q->pilot_estimates, nref);
+
+  return nref;
+}
+
+static void chest_dl_ctrl_correct_sync_error(srsran_chest_dl_t*  q,
+                                             srsran_dl_sf_cfg_t* sf,
+                                             cf_t*               input,
+                                             uint32_t            rxant_id,
+                                             uint32_t            nof_symbols)
+{
+  float pwr_sum  = 0.0f;
+  float sync_err = 0.0f;
+  float k        = (float)srsran_symbol_sz(q->cell.nof_prb) / 6.0f;
+
+  for (uint32_t cell_port_id = 0; cell_port_id < q->cell.nof_ports; cell_port_id++) {
+    uint32_t nref = estimate_ctrl_ls(q, sf, input, cell_port_id);
+    float    sum  = srsran_vec_estimate_frequency(q->pilot_estimates, nref) * k;
+    float    pwr  = srsran_vec_avg_power_cf(q->pilot_estimates, nref);
+
+    q->sync_err[rxant_id][cell_port_id] = sum;
+
+    if (!isinf(sum) && !isnan(sum) && !isinf(pwr) && !isnan(pwr)) {
+      sync_err += sum * pwr;
+      pwr_sum += pwr;
+    }
+  }
+
+  if (isnormal(pwr_sum)) {
+    sync_err /= pwr_sum;
+  }
+
+  if (isnormal(sync_err) && fabsf(sync_err) > 0.05f) {
+    float    cfo = sync_err / (float)srsran_symbol_sz(q->cell.nof_prb);
+    uint32_t nre = SRSRAN_NRE * q->cell.nof_prb;
+
+    for (uint32_t i = 0; i < nof_symbols; i++) {
+      cf_t* ptr = &input[i * nre];
+      srsran_vec_apply_cfo(ptr, cfo, ptr, nre);
+    }
+  }
+}
+
+static void estimate_port_ctrl(srsran_chest_dl_t*     q,
+                               srsran_dl_sf_cfg_t*    sf,
+                               srsran_chest_dl_cfg_t* cfg,
+                               cf_t*                  input,
+                               cf_t*                  ce,
+                               uint32_t               port_id,
+                               uint32_t               rxant_id,
+                               uint32_t               nof_symbols)
+{
+  float    filter[SRSRAN_CHEST_MAX_SMOOTH_FIL_LEN];
+  uint32_t filter_len = 0;
+  uint32_t nre        = q->cell.nof_prb * SRSRAN_NRE;
+  uint32_t nsymbol    = srsran_refsignal_cs_nsymbol(0, q->cell.cp, port_id);
+  uint32_t nref       = estimate_ctrl_ls(q, sf, input, port_id);
+
+  if (cfg->rsrp_neighbour) {
+    double energy                   = cabsf(srsran_vec_acc_cc(q->pilot_estimates, nref) / nref);
+    q->rsrp_corr[rxant_id][port_id] = energy * energy;
+  }
+  q->rsrp[rxant_id][port_id] = srsran_vec_avg_power_cf(q->pilot_recv_signal, nref);
+  cf_t* rs_symbol            = &input[nsymbol * nre];
+  q->rssi[rxant_id][port_id] = srsran_vec_dot_prod_conj_ccc(rs_symbol, rs_symbol, nre);
+
+  // PSS and empty subcarriers are outside of the control region, always use the pilots
+  q->noise_estimate[rxant_id][port_id] = estimate_noise_pilots_freq(q, nref);
+
+  if (ce == NULL) {
+    return;
+  }
+
+  switch (cfg->filter_type) {
+    case SRSRAN_CHEST_FILTER_GAUSS:
+      if (cfg->filter_coef[0] <= 0) {
+        filter_len = srsran_chest_set_smooth_filter_gauss(filter, 4, q->noise_estimate[rxant_id][port_id] * 200.0f);
+      } else {
+        filter_len = srsran_chest_set_smooth_filter_gauss(filter, (uint32_t)cfg->filter_coef[0], cfg->filter_coef[1]);
+      }
+      break;
+    case SRSRAN_CHEST_FILTER_TRIANGLE:
+      filter_len = srsran_chest_set_smooth_filter3_coeff(filter, cfg->filter_coef[0]);
+      break;
+    default:
+      break;
+  }
+
+  // Smooth in frequency and interpolate the reference symbol
+  cf_t* estimates = q->pilot_estimates;
+  if (cfg->filter_type != SRSRAN_CHEST_FILTER_NONE) {
+    srsran_conv_same_cf(q->pilot_estimates, filter, q->pilot_estimates_average, nref, filter_len);
+    estimates = q->pilot_estimates_average;
+  }
+  uint32_t fidx_offset = srsran_refsignal_cs_fidx(q->cell, 0, port_id, 0);
+  srsran_interp_linear_offset(&q->srsran_interp_lin, estimates, ce, fidx_offset, SRSRAN_NRE / 2 - fidx_offset);
+
+  // The channel is considered constant over the control region
+  for (uint32_t l = 1; l < nof_symbols; l++) {
+    memcpy(&ce[l * nre], ce, sizeof(cf_t) * nre);
+  }
+}
+
+int srsran_chest_dl_estimate_ctrl(srsran_chest_dl_t*     q,
+                                  srsran_dl_sf_cfg_t*    sf,
+                                  srsran_chest_dl_cfg_t* cfg,
+                                  cf_t*                  input[SRSRAN_MAX_PORTS],
+                                  srsran_chest_dl_res_t* res,
+                                  uint32_t               nof_symbols)
+{
+  if (q == NULL || sf == NULL || cfg == NULL || res == NULL || sf->sf_type != SRSRAN_SF_NORM ||
+      nof_symbols > SRSRAN_CP_NSYMB(q->cell.cp)) {
+    return SRSRAN_ERROR_INVALID_INPUTS;
+  }
+
+  for (uint32_t rxant_id = 0; rxant_id < q->nof_rx_antennas; rxant_id++) {
+    if (cfg->sync_error_enable) {
+      chest_dl_ctrl_correct_sync_error(q, sf, input[rxant_id], rxant_id, nof_symbols);
+    }
+
+    for (uint32_t port_id = 0; port_id < q->cell.nof_ports; port_id++) {
+      estimate_port_ctrl(q, sf, cfg, input[rxant_id], res->ce[port_id][rxant_id], port_id, rxant_id, nof_symbols);
+    }
+  }
+
+  fill_res(q, res);
+
+  return SRSRAN_SUCCESS;
+}
+
 srsran_chest_dl_estimator_alg_t srsran_chest_dl_str2estimator_alg(const char* str)
 {
   srsran_chest_dl_estimator_alg_t ret = SRSRAN_ESTIMATOR_ALG_AVERAGE;
@@ -80,7 +80,7 @@ void parse_args(int argc, char** argv)
 int main(int argc, char** argv)
 {
   srsran_chest_dl_t est;
-  cf_t *            input = NULL, *ce = NULL, *h = NULL, *output = NULL;
+  cf_t *            input = NULL, *ce = NULL, *h = NULL, *output = NULL, *ce_ctrl = NULL;
   int               i, j;
   int               ret = -1;
   int               max_cid;
@@ -119,6 +119,11 @@ int main(int argc, char** argv)
     perror("srsran_vec_malloc");
     goto do_exit;
   }
+  ce_ctrl = srsran_vec_cf_malloc(num_re);
+  if (!ce_ctrl) {
+    perror("srsran_vec_malloc");
+    goto do_exit;
+  }
 
   if (cell.id == 1000) {
     cid     = 0;
@@ -224,6 +229,45 @@ int main(int argc, char** argv)
         srsran_vec_fprint_c(fmatlab, ce, num_re);
         fprintf(fmatlab, ";\n");
       }
+
+      // Control region only estimate. In the first reference symbol it must be the estimate of the full subframe
+      // interpolating in time (no averaging across symbols) with the same frequency filter, and constant over the
+      // control symbols
+      uint32_t              nre         = cell.nof_prb * SRSRAN_NRE;
+      uint32_t              nof_ctrl    = 3;
+      srsran_chest_dl_cfg_t ctrl_cfg[2] = {};
+      ctrl_cfg[0].filter_type           = SRSRAN_CHEST_FILTER_NONE;
+      ctrl_cfg[1].filter_type           = SRSRAN_CHEST_FILTER_TRIANGLE;
+      ctrl_cfg[1].filter_coef[0]        = 0.1f;
+
+      for (uint32_t c = 0; c < 2; c++) {
+        ctrl_cfg[c].estimator_alg = SRSRAN_ESTIMATOR_ALG_INTERPOLATE;
+
+        res.ce[0][0] = ce;
+        srsran_chest_dl_estimate_cfg(&est, &sf_cfg, &ctrl_cfg[c], input_m, &res);
+
+        res.ce[0][0] = ce_ctrl;
+        gettimeofday(&t[1], NULL);
+        for (int k = 0; k < 100; k++) {
+          srsran_chest_dl_estimate_ctrl(&est, &sf_cfg, &ctrl_cfg[c], input_m, &res, nof_ctrl);
+        }
+        gettimeofday(&t[2], NULL);
+        get_time_interval(t);
+        printf("CHEST-CTRL: %f us\n", (float)t[0].tv_usec / 100);
+
+        float max_err = 0;
+        for (i = 0; i < nre; i++) {
+          max_err = SRSRAN_MAX(max_err, cabsf(ce_ctrl[i] - ce[i]));
+          for (j = 1; j < nof_ctrl; j++) {
+            max_err = SRSRAN_MAX(max_err, cabsf(ce_ctrl[j * nre + i] - ce_ctrl[i]));
+          }
+        }
+        printf("CTRL max error: %e\n", max_err);
+
+        if (max_err > 1e-3) {
+          goto do_exit;
+        }
+      }
     }
     cid += 10;
     INFO("cid=%d", cid);
@@ -239,6 +283,9 @@ do_exit:
   if (ce) {
     free(ce);
   }
+  if (ce_ctrl) {
+    free(ce_ctrl);
+  }
   if (input) {
     free(input);
   }
@@ -53,6 +53,124 @@ static int get_fftw_wisdom_file(char* full_path, uint32_t n)
 
 static pthread_mutex_t fft_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+/* Process-wide cache of FFTW plans. Plans are immutable once created and fftwf_execute_dft()/fftwf_execute_r2r() are
+ * thread-safe, so every srsran_dft_plan_t describing the same transform shares one plan and runs it on its own
+ * buffers. The key includes the buffer alignment and in-place flag because the new-array execute functions require
+ * them to match the buffers the plan was created with. The cache is protected by fft_mutex. */
+typedef struct {
+  bool        r2r;
+  int         sign; // FFTW_FORWARD/FFTW_BACKWARD or fftwf_r2r_kind
+  unsigned    flags;
+  fftwf_iodim dim;
+  int         howmany_rank;
+  fftwf_iodim howmany[2];
+  bool        in_place;
+  int         in_align;
+  int         out_align;
+} dft_plan_key_t;
+
+typedef struct dft_plan_entry_s {
+  dft_plan_key_t           key;
+  fftwf_plan               p;
+  uint32_t                 refcount;
+  struct dft_plan_entry_s* next;
+} dft_plan_entry_t;
+
+static dft_plan_entry_t* plan_cache = NULL;
+
+static bool dft_plan_key_equal(const dft_plan_key_t* a, const dft_plan_key_t* b)
+{
+  if (a->r2r != b->r2r || a->sign != b->sign || a->flags != b->flags || a->howmany_rank != b->howmany_rank ||
+      a->in_place != b->in_place || a->in_align != b->in_align || a->out_align != b->out_align) {
+    return false;
+  }
+  if (memcmp(&a->dim, &b->dim, sizeof(fftwf_iodim)) != 0) {
+    return false;
+  }
+  return memcmp(a->howmany, b->howmany, sizeof(fftwf_iodim) * a->howmany_rank) == 0;
+}
+
+/* Returns a plan for the transform from the cache, creating it if it does not exist. Must be called with fft_mutex */
+static fftwf_plan dft_plan_cache_get(bool               r2r,
+                                     int                sign,
+                                     const fftwf_iodim* dim,
+                                     int                howmany_rank,
+                                     const fftwf_iodim* howmany,
+                                     void*              in,
+                                     void*              out)
+{
+  dft_plan_key_t key = {};
+  key.r2r            = r2r;
+  key.sign           = sign;
+  key.flags          = FFTW_TYPE;
+  key.dim            = *dim;
+  key.howmany_rank   = howmany_rank;
+  if (howmany_rank > 0) {
+    memcpy(key.howmany, howmany, sizeof(fftwf_iodim) * howmany_rank);
+  }
+  key.in_place  = (in == out);
+  key.in_align  = fftwf_alignment_of((float*)in);
+  key.out_align = fftwf_alignment_of((float*)out);
+
+  for (dft_plan_entry_t* e = plan_cache; e != NULL; e = e->next) {
+    if (dft_plan_key_equal(&e->key, &key)) {
+      e->refcount++;
+      return e->p;
+    }
+  }
+
+  fftwf_plan p = NULL;
+  if (r2r) {
+    fftwf_r2r_kind kind = (fftwf_r2r_kind)sign;
+    p                   = fftwf_plan_guru_r2r(1, dim, howmany_rank, howmany, in, out, &kind, FFTW_TYPE);
+  } else {
+    p = fftwf_plan_guru_dft(1, dim, howmany_rank, howmany, in, out, sign, FFTW_TYPE);
+  }
+  if (p == NULL) {
+    return NULL;
+  }
+
+  dft_plan_entry_t* e = calloc(1, sizeof(dft_plan_entry_t));
+  if (e == NULL) {
+    fftwf_destroy_plan(p);
+    return NULL;
+  }
+  e->key      = key;
+  e->p        = p;
+  e->refcount = 1;
+  e->next     = plan_cache;
+  plan_cache  = e;
+
+  return p;
+}
+
+/* Releases a plan obtained from the cache, it is destroyed when no DFT plan uses it. Must be called with fft_mutex */
+static void dft_plan_cache_put(fftwf_plan p)
+{
+  dft_plan_entry_t** prev = &plan_cache;
+  for (dft_plan_entry_t* e = plan_cache; e != NULL; prev = &e->next, e = e->next) {
+    if (e->p == p) {
+      if (--e->refcount == 0) {
+        *prev = e->next;
+        fftwf_destroy_plan(e->p);
+        free(e);
+      }
+      return;
+    }
+  }
+}
+
+uint32_t srsran_dft_plan_cache_size()
+{
+  uint32_t n = 0;
+  pthread_mutex_lock(&fft_mutex);
+  for (dft_plan_entry_t* e = plan_cache; e != NULL; e = e->next) {
+    n++;
+  }
+  pthread_mutex_unlock(&fft_mutex);
+  return n;
+}
+
 // This function is called in the beggining of any executable where it is linked
 __attribute__((constructor)) static void srsran_dft_load()
 {
@@ -81,29 +199,37 @@ __attribute__((constructor)) static void srsran_dft_load()
 #endif
 }
 
-// This function is called in the ending of any executable where it is linked
-__attribute__((destructor)) void srsran_dft_exit()
+int srsran_dft_export_wisdom()
 {
 #ifdef FFTW_WISDOM_FILE
   char full_path[256];
   get_fftw_wisdom_file(full_path, sizeof(full_path));
   FILE* fd = fopen(full_path, "w");
   if (fd == NULL) {
-    return;
+    return SRSRAN_ERROR;
   }
   if (lockf(fileno(fd), F_LOCK, 0) == -1) {
     perror("lockf()");
     fclose(fd);
-    return;
+    return SRSRAN_ERROR;
   }
+  pthread_mutex_lock(&fft_mutex);
   fftwf_export_wisdom_to_file(fd);
+  pthread_mutex_unlock(&fft_mutex);
   if (lockf(fileno(fd), F_ULOCK, 0) == -1) {
     perror("u-lockf()");
     fclose(fd);
-    return;
+    return SRSRAN_ERROR;
   }
   fclose(fd);
 #endif
+  return SRSRAN_SUCCESS;
+}
+
+// This function is called in the ending of any executable where it is linked
+__attribute__((destructor)) void srsran_dft_exit()
+{
+  srsran_dft_export_wisdom();
   fftwf_cleanup();
 }
 
@@ -158,16 +284,18 @@ int srsran_dft_replan_guru_c(srsran_dft_plan_t* plan,
 
   pthread_mutex_lock(&fft_mutex);
 
-  /* Destroy current plan */
-  fftwf_destroy_plan(plan->p);
+  /* Release current plan */
+  dft_plan_cache_put(plan->p);
 
-  plan->p = fftwf_plan_guru_dft(1, &iodim, 1, &howmany_dims, in_buffer, out_buffer, sign, FFTW_TYPE);
+  plan->p = dft_plan_cache_get(false, sign, &iodim, 1, &howmany_dims, in_buffer, out_buffer);
 
   pthread_mutex_unlock(&fft_mutex);
 
   if (!plan->p) {
     return -1;
   }
+  plan->in        = in_buffer;
+  plan->out       = out_buffer;
   plan->size      = new_dft_points;
   plan->init_size = plan->size;
 
@@ -183,12 +311,14 @@ int srsran_dft_replan_c(srsran_dft_plan_t* plan, const int new_dft_points)
     return 0;
   }
 
+  const fftwf_iodim iodim = {new_dft_points, 1, 1};
+
   pthread_mutex_lock(&fft_mutex);
   if (plan->p) {
-    fftwf_destroy_plan(plan->p);
+    dft_plan_cache_put(plan->p);
     plan->p = NULL;
   }
-  plan->p = fftwf_plan_dft_1d(new_dft_points, plan->in, plan->out, sign, FFTW_TYPE);
+  plan->p = dft_plan_cache_get(false, sign, &iodim, 0, NULL, plan->in, plan->out);
   pthread_mutex_unlock(&fft_mutex);
 
   if (!plan->p) {
@@ -216,13 +346,59 @@ int srsran_dft_plan_guru_c(srsran_dft_plan_t* plan,
 
   pthread_mutex_lock(&fft_mutex);
 
-  plan->p = fftwf_plan_guru_dft(1, &iodim, 1, &howmany_dims, in_buffer, out_buffer, sign, FFTW_TYPE);
+  plan->p = dft_plan_cache_get(false, sign, &iodim, 1, &howmany_dims, in_buffer, out_buffer);
   pthread_mutex_unlock(&fft_mutex);
 
   if (!plan->p) {
     return -1;
   }
 
+  plan->in        = in_buffer;
+  plan->out       = out_buffer;
+  plan->size      = dft_points;
+  plan->init_size = plan->size;
+  plan->mode      = SRSRAN_DFT_COMPLEX;
+  plan->dir       = dir;
+  plan->forward   = (dir == SRSRAN_DFT_FORWARD) ? true : false;
+  plan->mirror    = false;
+  plan->db        = false;
+  plan->norm      = false;
+  plan->dc        = false;
+  plan->is_guru   = true;
+
+  return 0;
+}
+
+int srsran_dft_plan_guru_batch_c(srsran_dft_plan_t* plan,
+                                 const int          dft_points,
+                                 srsran_dft_dir_t   dir,
+                                 cf_t*              in_buffer,
+                                 cf_t*              out_buffer,
+                                 int                istride,
+                                 int                ostride,
+                                 int                how_many,
+                                 int                idist,
+                                 int                odist,
+                                 int                nof_batch,
+                                 int                batch_idist,
+                                 int                batch_odist)
+{
+  int sign = (dir == SRSRAN_DFT_FORWARD) ? FFTW_FORWARD : FFTW_BACKWARD;
+
+  const fftwf_iodim iodim           = {dft_points, istride, ostride};
+  const fftwf_iodim howmany_dims[2] = {{nof_batch, batch_idist, batch_odist}, {how_many, idist, odist}};
+
+  pthread_mutex_lock(&fft_mutex);
+
+  plan->p = dft_plan_cache_get(false, sign, &iodim, 2, howmany_dims, in_buffer, out_buffer);
+  pthread_mutex_unlock(&fft_mutex);
+
+  if (!plan->p) {
+    return -1;
+  }
+
+  plan->in        = in_buffer;
+  plan->out       = out_buffer;
   plan->size      = dft_points;
   plan->init_size = plan->size;
   plan->mode      = SRSRAN_DFT_COMPLEX;
@@ -243,8 +419,9 @@ int srsran_dft_plan_c(srsran_dft_plan_t* plan, const int dft_points, srsran_dft_
 
   pthread_mutex_lock(&fft_mutex);
 
-  int sign = (dir == SRSRAN_DFT_FORWARD) ? FFTW_FORWARD : FFTW_BACKWARD;
-  plan->p  = fftwf_plan_dft_1d(dft_points, plan->in, plan->out, sign, FFTW_TYPE);
+  int               sign  = (dir == SRSRAN_DFT_FORWARD) ? FFTW_FORWARD : FFTW_BACKWARD;
+  const fftwf_iodim iodim = {dft_points, 1, 1};
+  plan->p                 = dft_plan_cache_get(false, sign, &iodim, 0, NULL, plan->in, plan->out);
 
   pthread_mutex_unlock(&fft_mutex);
 
@@ -269,12 +446,14 @@ int srsran_dft_replan_r(srsran_dft_plan_t* plan, const int new_dft_points)
 {
   int sign = (plan->dir == SRSRAN_DFT_FORWARD) ? FFTW_R2HC : FFTW_HC2R;
 
+  const fftwf_iodim iodim = {new_dft_points, 1, 1};
+
   pthread_mutex_lock(&fft_mutex);
   if (plan->p) {
-    fftwf_destroy_plan(plan->p);
+    dft_plan_cache_put(plan->p);
     plan->p = NULL;
   }
-  plan->p = fftwf_plan_r2r_1d(new_dft_points, plan->in, plan->out, sign, FFTW_TYPE);
+  plan->p = dft_plan_cache_get(true, sign, &iodim, 0, NULL, plan->in, plan->out);
   pthread_mutex_unlock(&fft_mutex);
 
   if (!plan->p) {
@@ -287,10 +466,11 @@ int srsran_dft_replan_r(srsran_dft_plan_t* plan, const int new_dft_points)
 int srsran_dft_plan_r(srsran_dft_plan_t* plan, const int dft_points, srsran_dft_dir_t dir)
 {
   allocate(plan, sizeof(float), sizeof(float), dft_points);
-  int sign = (dir == SRSRAN_DFT_FORWARD) ? FFTW_R2HC : FFTW_HC2R;
+  int               sign  = (dir == SRSRAN_DFT_FORWARD) ? FFTW_R2HC : FFTW_HC2R;
+  const fftwf_iodim iodim = {dft_points, 1, 1};
 
   pthread_mutex_lock(&fft_mutex);
-  plan->p = fftwf_plan_r2r_1d(dft_points, plan->in, plan->out, sign, FFTW_TYPE);
+  plan->p = dft_plan_cache_get(true, sign, &iodim, 0, NULL, plan->in, plan->out);
   pthread_mutex_unlock(&fft_mutex);
 
   if (!plan->p) {
@@ -372,7 +552,7 @@ void srsran_dft_run_c(srsran_dft_plan_t* plan, const cf_t* in, cf_t* out)
   fftwf_complex* f_out = plan->out;
 
   copy_pre((uint8_t*)plan->in, (uint8_t*)in, sizeof(cf_t), plan->size, plan->forward, plan->mirror, plan->dc);
-  fftwf_execute(plan->p);
+  fftwf_execute_dft(plan->p, plan->in, plan->out);
   if (plan->norm) {
     norm = 1.0 / sqrtf(plan->size);
     srsran_vec_sc_prod_cfc(f_out, norm, f_out, plan->size);
@@ -388,7 +568,7 @@ void srsran_dft_run_c(srsran_dft_plan_t* plan, const cf_t* in, cf_t* out)
 void srsran_dft_run_guru_c(srsran_dft_plan_t* plan)
 {
   if (plan->is_guru == true) {
-    fftwf_execute(plan->p);
+    fftwf_execute_dft(plan->p, plan->in, plan->out);
   } else {
     ERROR("srsran_dft_run_guru_c: the selected plan is not guru!");
   }
@@ -402,7 +582,7 @@ void srsran_dft_run_r(srsran_dft_plan_t* plan, const float* in, float* out)
   float* f_out = plan->out;
 
   memcpy(plan->in, in, sizeof(float) * plan->size);
-  fftwf_execute(plan->p);
+  fftwf_execute_r2r(plan->p, plan->in, plan->out);
   if (plan->norm) {
     norm = 1.0 / plan->size;
     srsran_vec_sc_prod_fff(f_out, norm, f_out, plan->size);
@@ -430,7 +610,7 @@ void srsran_dft_plan_free(srsran_dft_plan_t* plan)
       fftwf_free(plan->out);
   }
   if (plan->p)
-    fftwf_destroy_plan(plan->p);
+    dft_plan_cache_put(plan->p);
   pthread_mutex_unlock(&fft_mutex);
   bzero(plan, sizeof(srsran_dft_plan_t));
 }
@@ -76,6 +76,7 @@ static int ofdm_init_mbsfn_(srsran_ofdm_t* q, srsran_ofdm_cfg_t* cfg, srsran_dft
   q->nof_guards        = (q->cfg.symbol_sz - q->nof_re) / 2U;
   q->slot_sz           = (uint32_t)SRSRAN_SLOT_LEN(q->cfg.symbol_sz);
   q->sf_sz             = (uint32_t)SRSRAN_SF_LEN(q->cfg.symbol_sz);
+  q->nof_symbols_ctrl  = SRSRAN_MIN(q->nof_symbols, (cfg->nof_prb <= 10) ? 4 : 3);
 
   // Set the CFR parameters related to OFDM symbol and FFT size
   q->cfg.cfr_tx_cfg.symbol_sz = symbol_sz;
@@ -204,6 +205,26 @@ static int ofdm_init_mbsfn_(srsran_ofdm_t* q, srsran_ofdm_cfg_t* cfg, srsran_dft
       }
     }
   }
+
+  // Control region plan, it shares the temporal buffer with the first slot plan
+  if (q->fft_plan_ctrl.size) {
+    srsran_dft_plan_free(&q->fft_plan_ctrl);
+  }
+  if (dir == SRSRAN_DFT_FORWARD) {
+    if (srsran_dft_plan_guru_c(&q->fft_plan_ctrl,
+                               symbol_sz,
+                               dir,
+                               in_buffer + cp1 - q->window_offset_n,
+                               q->tmp,
+                               1,
+                               1,
+                               q->nof_symbols_ctrl,
+                               symbol_sz + cp2,
+                               symbol_sz)) {
+      ERROR("Creating Guru DFT plan (control region)");
+      return SRSRAN_ERROR;
+    }
+  }
 #endif
 
   srsran_dft_plan_set_mirror(&q->fft_plan, true);
@@ -253,6 +274,9 @@ void srsran_ofdm_free_(srsran_ofdm_t* q)
       srsran_dft_plan_free(&q->fft_plan_sf[slot]);
     }
   }
+  if (q->fft_plan_ctrl.init_size) {
+    srsran_dft_plan_free(&q->fft_plan_ctrl);
+  }
 #endif
 
   if (q->tmp) {
@@ -468,6 +492,44 @@ void srsran_ofdm_rx_slot_ng(srsran_ofdm_t* q, cf_t* input, cf_t* output)
   }
 }
 
+#ifndef AVOID_GURU
+/* Post-processes the DFT output of the symbol l (within the subframe): window offset, FFT shift, normalization and
+ * phase compensation.
+ */
+static void ofdm_rx_symbol(srsran_ofdm_t* q, cf_t* tmp, cf_t* output, uint32_t l)
+{
+  uint32_t nof_re    = q->nof_re;
+  uint32_t symbol_sz = q->cfg.symbol_sz;
+  float    norm      = 1.0f / sqrtf(q->fft_plan.size);
+  uint32_t dc        = (q->fft_plan.dc) ? 1 : 0;
+
+  // Apply frequency domain window offset
+  if (q->window_offset_n) {
+    srsran_vec_prod_ccc(tmp, q->window_offset_buffer, tmp, symbol_sz);
+  }
+
+  // Perform FFT shift
+  memcpy(output, tmp + symbol_sz - nof_re / 2, sizeof(cf_t) * nof_re / 2);
+  memcpy(output + nof_re / 2, &tmp[dc], sizeof(cf_t) * nof_re / 2);
+
+  // Normalize output
+  if (isnormal(q->cfg.phase_compensation_hz)) {
+    // Get phase compensation
+    cf_t phase_compensation = conjf(q->phase_compensation[l]);
+
+    // Apply normalization
+    if (q->fft_plan.norm) {
+      phase_compensation *= norm;
+    }
+
+    // Apply correction
+    srsran_vec_sc_prod_ccc(output, phase_compensation, output, nof_re);
+  } else if (q->fft_plan.norm) {
+    srsran_vec_sc_prod_cfc(output, norm, output, nof_re);
+  }
+}
+#endif /* AVOID_GURU */
+
 /* Transforms input samples into output OFDM symbols.
  * Performs FFT on a each symbol and removes CP.
  */
@@ -481,37 +543,12 @@ static void ofdm_rx_slot(srsran_ofdm_t* q, int slot_in_sf)
   uint32_t nof_re = q->nof_re;
   cf_t* output = q->cfg.out_buffer + slot_in_sf * nof_re * nof_symbols;
   uint32_t symbol_sz = q->cfg.symbol_sz;
-  float norm = 1.0f / sqrtf(q->fft_plan.size);
   cf_t* tmp = q->tmp;
-  uint32_t dc = (q->fft_plan.dc) ? 1 : 0;
 
   srsran_dft_run_guru_c(&q->fft_plan_sf[slot_in_sf]);
 
   for (int i = 0; i < q->nof_symbols; i++) {
-    // Apply frequency domain window offset
-    if (q->window_offset_n) {
-      srsran_vec_prod_ccc(tmp, q->window_offset_buffer, tmp, symbol_sz);
-    }
-
-    // Perform FFT shift
-    memcpy(output, tmp + symbol_sz - nof_re / 2, sizeof(cf_t) * nof_re / 2);
-    memcpy(output + nof_re / 2, &tmp[dc], sizeof(cf_t) * nof_re / 2);
-
-    // Normalize output
-    if (isnormal(q->cfg.phase_compensation_hz)) {
-      // Get phase compensation
-      cf_t phase_compensation = conjf(q->phase_compensation[slot_in_sf * q->nof_symbols + i]);
-
-      // Apply normalization
-      if (q->fft_plan.norm) {
-        phase_compensation *= norm;
-      }
-
-      // Apply correction
-      srsran_vec_sc_prod_ccc(output, phase_compensation, output, nof_re);
-    } else if (q->fft_plan.norm) {
-      srsran_vec_sc_prod_cfc(output, norm, output, nof_re);
-    }
+    ofdm_rx_symbol(q, tmp, output, slot_in_sf * nof_symbols + i);
 
     tmp += symbol_sz;
     output += nof_re;
@@ -548,11 +585,8 @@ void srsran_ofdm_rx_slot_zerocopy(srsran_ofdm_t* q, cf_t* input, cf_t* output)
   }
 }
 
-void srsran_ofdm_rx_sf(srsran_ofdm_t* q)
+static void ofdm_rx_sf_shifted(srsran_ofdm_t* q)
 {
-  if (isnormal(q->cfg.freq_shift_f)) {
-    srsran_vec_prod_ccc(q->cfg.in_buffer, q->shift_buffer, q->cfg.in_buffer, q->sf_sz);
-  }
   if (!q->mbsfn_subframe) {
     for (uint32_t n = 0; n < SRSRAN_NOF_SLOTS_PER_SF; n++) {
       ofdm_rx_slot(q, n);
@@ -563,6 +597,72 @@ void srsran_ofdm_rx_sf(srsran_ofdm_t* q)
   }
 }
 
+void srsran_ofdm_rx_sf(srsran_ofdm_t* q)
+{
+  if (isnormal(q->cfg.freq_shift_f)) {
+    srsran_vec_prod_ccc(q->cfg.in_buffer, q->shift_buffer, q->cfg.in_buffer, q->sf_sz);
+  }
+  ofdm_rx_sf_shifted(q);
+}
+
+// Samples of the control symbols at the start of the subframe
+static uint32_t ofdm_ctrl_len(srsran_ofdm_t* q)
+{
+  uint32_t len = 0;
+  for (uint32_t i = 0; i < q->nof_symbols_ctrl; i++) {
+    len += q->cfg.symbol_sz + (SRSRAN_CP_ISNORM(q->cfg.cp) ? SRSRAN_CP_LEN_NORM(i, q->cfg.symbol_sz)
+                                                           : SRSRAN_CP_LEN_EXT(q->cfg.symbol_sz));
+  }
+  return len;
+}
+
+uint32_t srsran_ofdm_rx_sf_ctrl(srsran_ofdm_t* q)
+{
+  uint32_t    nof_symbols = q->nof_symbols_ctrl;
+  uint32_t    symbol_sz   = q->cfg.symbol_sz;
+  srsran_cp_t cp          = q->cfg.cp;
+
+  if (isnormal(q->cfg.freq_shift_f)) {
+    srsran_vec_prod_ccc(q->cfg.in_buffer, q->shift_buffer, q->cfg.in_buffer, ofdm_ctrl_len(q));
+  }
+
+#ifdef AVOID_GURU
+  cf_t* input  = q->cfg.in_buffer;
+  cf_t* output = q->cfg.out_buffer;
+  for (uint32_t i = 0; i < nof_symbols; i++) {
+    input += SRSRAN_CP_ISNORM(cp) ? SRSRAN_CP_LEN_NORM(i, symbol_sz) : SRSRAN_CP_LEN_EXT(symbol_sz);
+    srsran_dft_run_c(&q->fft_plan, input - q->window_offset_n, q->tmp);
+    memcpy(output, &q->tmp[q->nof_guards], q->nof_re * sizeof(cf_t));
+    input += symbol_sz;
+    output += q->nof_re;
+  }
+#else
+  cf_t* output = q->cfg.out_buffer;
+  cf_t* tmp    = q->tmp;
+
+  srsran_dft_run_guru_c(&q->fft_plan_ctrl);
+
+  for (uint32_t i = 0; i < nof_symbols; i++) {
+    ofdm_rx_symbol(q, tmp, output, i);
+
+    tmp += symbol_sz;
+    output += q->nof_re;
+  }
+#endif /* AVOID_GURU */
+
+  return nof_symbols;
+}
+
+void srsran_ofdm_rx_sf_complete(srsran_ofdm_t* q)
+{
+  // The control symbols are shifted already
+  if (isnormal(q->cfg.freq_shift_f)) {
+    uint32_t len = ofdm_ctrl_len(q);
+    srsran_vec_prod_ccc(&q->cfg.in_buffer[len], &q->shift_buffer[len], &q->cfg.in_buffer[len], q->sf_sz - len);
+  }
+  ofdm_rx_sf_shifted(q);
+}
+
 void srsran_ofdm_rx_sf_ng(srsran_ofdm_t* q, cf_t* input, cf_t* output)
 {
   uint32_t n;
@@ -579,6 +679,134 @@ void srsran_ofdm_rx_sf_ng(srsran_ofdm_t* q, cf_t* input, cf_t* output)
   }
 }
 
+int srsran_ofdm_rx_batch_init(srsran_ofdm_batch_t* q, srsran_ofdm_t* ofdm, uint32_t max_nof_sf)
+{
+  if (q == NULL || ofdm == NULL || max_nof_sf == 0 || max_nof_sf > SRSRAN_OFDM_BATCH_MAX_SF) {
+    return SRSRAN_ERROR_INVALID_INPUTS;
+  }
+
+  bzero(q, sizeof(srsran_ofdm_batch_t));
+
+  q->ofdm       = ofdm;
+  q->max_nof_sf = max_nof_sf;
+  q->sf_sz      = ofdm->sf_sz;
+
+  q->in_buffer = srsran_vec_cf_malloc(q->sf_sz * max_nof_sf);
+  q->tmp       = srsran_vec_cf_malloc(q->sf_sz * max_nof_sf);
+  if (!q->in_buffer || !q->tmp) {
+    perror("malloc");
+    srsran_ofdm_rx_batch_free(q);
+    return SRSRAN_ERROR;
+  }
+  srsran_vec_cf_zero(q->in_buffer, q->sf_sz * max_nof_sf);
+  srsran_vec_cf_zero(q->tmp, q->sf_sz * max_nof_sf);
+
+#ifndef AVOID_GURU
+  uint32_t    symbol_sz = ofdm->cfg.symbol_sz;
+  srsran_cp_t cp        = ofdm->cfg.cp;
+  int         cp1       = SRSRAN_CP_ISNORM(cp) ? SRSRAN_CP_LEN_NORM(0, symbol_sz) : SRSRAN_CP_LEN_EXT(symbol_sz);
+  int         cp2       = SRSRAN_CP_ISNORM(cp) ? SRSRAN_CP_LEN_NORM(1, symbol_sz) : SRSRAN_CP_LEN_EXT(symbol_sz);
+
+  // The outer dimension walks the slots of all the subframes, the inner one the symbols within each slot
+  for (uint32_t n = 0; n < max_nof_sf; n++) {
+    if (srsran_dft_plan_guru_batch_c(&q->plan[n],
+                                     symbol_sz,
+                                     SRSRAN_DFT_FORWARD,
+                                     q->in_buffer + cp1 - ofdm->window_offset_n,
+                                     q->tmp,
+                                     1,
+                                     1,
+                                     SRSRAN_CP_NSYMB(cp),
+                                     symbol_sz + cp2,
+                                     symbol_sz,
+                                     (n + 1) * SRSRAN_NOF_SLOTS_PER_SF,
+                                     ofdm->slot_sz,
+                                     SRSRAN_CP_NSYMB(cp) * symbol_sz)) {
+      ERROR("Creating batch Guru DFT plan (%d)", n + 1);
+      srsran_ofdm_rx_batch_free(q);
+      return SRSRAN_ERROR;
+    }
+  }
+#endif /* AVOID_GURU */
+
+  return SRSRAN_SUCCESS;
+}
+
+void srsran_ofdm_rx_batch_free(srsran_ofdm_batch_t* q)
+{
+  if (q == NULL) {
+    return;
+  }
+  for (uint32_t n = 0; n < SRSRAN_OFDM_BATCH_MAX_SF; n++) {
+    if (q->plan[n].init_size) {
+      srsran_dft_plan_free(&q->plan[n]);
+    }
+  }
+  if (q->in_buffer) {
+    free(q->in_buffer);
+  }
+  if (q->tmp) {
+    free(q->tmp);
+  }
+  SRSRAN_MEM_ZERO(q, srsran_ofdm_batch_t, 1);
+}
+
+cf_t* srsran_ofdm_rx_batch_input(srsran_ofdm_batch_t* q, uint32_t sf_idx)
+{
+  if (q == NULL || q->in_buffer == NULL || sf_idx >= q->max_nof_sf) {
+    return NULL;
+  }
+  return &q->in_buffer[sf_idx * q->sf_sz];
+}
+
+int srsran_ofdm_rx_batch_run(srsran_ofdm_batch_t* q, cf_t* output[SRSRAN_OFDM_BATCH_MAX_SF], uint32_t nof_sf)
+{
+  if (q == NULL || q->ofdm == NULL || output == NULL || nof_sf == 0 || nof_sf > q->max_nof_sf) {
+    return SRSRAN_ERROR_INVALID_INPUTS;
+  }
+
+  srsran_ofdm_t* ofdm = q->ofdm;
+
+  if (ofdm->mbsfn_subframe || ofdm->sf_sz != q->sf_sz) {
+    ERROR("Batch OFDM does not match the OFDM receiver configuration");
+    return SRSRAN_ERROR;
+  }
+
+  if (isnormal(ofdm->cfg.freq_shift_f)) {
+    for (uint32_t sf = 0; sf < nof_sf; sf++) {
+      cf_t* input = &q->in_buffer[sf * q->sf_sz];
+      srsran_vec_prod_ccc(input, ofdm->shift_buffer, input, q->sf_sz);
+    }
+  }
+
+#ifdef AVOID_GURU
+  for (uint32_t sf = 0; sf < nof_sf; sf++) {
+    for (uint32_t n = 0; n < SRSRAN_NOF_SLOTS_PER_SF; n++) {
+      srsran_ofdm_rx_slot_ng(ofdm,
+                             &q->in_buffer[sf * q->sf_sz + n * ofdm->slot_sz],
+                             &output[sf][n * ofdm->nof_re * ofdm->nof_symbols]);
+    }
+  }
+#else
+  uint32_t nof_symbols = ofdm->nof_symbols * SRSRAN_NOF_SLOTS_PER_SF;
+  cf_t*    tmp         = q->tmp;
+
+  srsran_dft_run_guru_c(&q->plan[nof_sf - 1]);
+
+  for (uint32_t sf = 0; sf < nof_sf; sf++) {
+    cf_t* out = output[sf];
+    for (uint32_t l = 0; l < nof_symbols; l++) {
+      ofdm_rx_symbol(ofdm, tmp, out, l);
+
+      tmp += ofdm->cfg.symbol_sz;
+      out += ofdm->nof_re;
+    }
+  }
+#endif /* AVOID_GURU */
+
+  return SRSRAN_SUCCESS;
+}
+
 /* Transforms input OFDM symbols into output samples.
  * Performs the FFT on each symbol and adds CP.
  */
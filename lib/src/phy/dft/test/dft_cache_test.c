@@ -0,0 +1,145 @@
+/**
+ * Copyright 2013-2023 Software Radio Systems Limited
+ *
+ * This file is part of srsRAN.
+ *
+ * srsRAN is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsRAN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "srsran/phy/utils/random.h"
+#include "srsran/srsran.h"
+#include "srsran/support/srsran_test.h"
+
+#define DFT_SIZE 1536
+#define NOF_SYMBOLS 7
+
+static srsran_random_t random_gen = NULL;
+
+static float max_error(const cf_t* a, const cf_t* b, uint32_t len)
+{
+  float err = 0.0f;
+  for (uint32_t i = 0; i < len; i++) {
+    err = SRSRAN_MAX(err, cabsf(a[i] - b[i]));
+  }
+  return err;
+}
+
+// Plans of the same size and direction share the FFTW plan, each one keeps running on its own buffers
+static int test_plan_c()
+{
+  srsran_dft_plan_t fwd_a = {}, fwd_b = {}, bwd = {};
+  cf_t*             in    = srsran_vec_cf_malloc(DFT_SIZE);
+  cf_t*             out_a = srsran_vec_cf_malloc(DFT_SIZE);
+  cf_t*             out_b = srsran_vec_cf_malloc(DFT_SIZE);
+  TESTASSERT(in != NULL && out_a != NULL && out_b != NULL);
+
+  TESTASSERT(srsran_dft_plan_c(&fwd_a, DFT_SIZE, SRSRAN_DFT_FORWARD) == SRSRAN_SUCCESS);
+  TESTASSERT(srsran_dft_plan_c(&fwd_b, DFT_SIZE, SRSRAN_DFT_FORWARD) == SRSRAN_SUCCESS);
+  TESTASSERT(fwd_a.p == fwd_b.p);
+  TESTASSERT(srsran_dft_plan_cache_size() == 1);
+
+  TESTASSERT(srsran_dft_plan_c(&bwd, DFT_SIZE, SRSRAN_DFT_BACKWARD) == SRSRAN_SUCCESS);
+  TESTASSERT(bwd.p != fwd_a.p);
+  TESTASSERT(srsran_dft_plan_cache_size() == 2);
+
+  srsran_random_uniform_complex_dist_vector(random_gen, in, DFT_SIZE, -1.0f, 1.0f);
+  srsran_dft_run_c(&fwd_a, in, out_a);
+  srsran_dft_run_c(&fwd_b, in, out_b);
+  TESTASSERT(max_error(out_a, out_b, DFT_SIZE) < 1e-6f);
+
+  // The shared plan remains valid after releasing one of its users
+  srsran_dft_plan_free(&fwd_a);
+  TESTASSERT(srsran_dft_plan_cache_size() == 2);
+  srsran_dft_run_c(&fwd_b, in, out_b);
+  TESTASSERT(max_error(out_a, out_b, DFT_SIZE) < 1e-6f);
+
+  // Backward transform recovers the input
+  srsran_dft_run_c(&bwd, out_b, out_a);
+  srsran_vec_sc_prod_cfc(out_a, 1.0f / DFT_SIZE, out_a, DFT_SIZE);
+  TESTASSERT(max_error(in, out_a, DFT_SIZE) < 1e-3f);
+
+  srsran_dft_plan_free(&fwd_b);
+  srsran_dft_plan_free(&bwd);
+  TESTASSERT(srsran_dft_plan_cache_size() == 0);
+
+  free(in);
+  free(out_a);
+  free(out_b);
+  return SRSRAN_SUCCESS;
+}
+
+// Guru plans over different buffers with the same layout share the FFTW plan
+static int test_plan_guru_c()
+{
+  srsran_dft_plan_t plan_a = {}, plan_b = {}, plan_c = {};
+  uint32_t          len    = DFT_SIZE * NOF_SYMBOLS + 1;
+  cf_t*             in_a   = srsran_vec_cf_malloc(len);
+  cf_t*             in_b   = srsran_vec_cf_malloc(len);
+  cf_t*             out_a  = srsran_vec_cf_malloc(len);
+  cf_t*             out_b  = srsran_vec_cf_malloc(len);
+  TESTASSERT(in_a != NULL && in_b != NULL && out_a != NULL && out_b != NULL);
+
+  TESTASSERT(srsran_dft_plan_guru_c(
+                 &plan_a, DFT_SIZE, SRSRAN_DFT_FORWARD, in_a, out_a, 1, 1, NOF_SYMBOLS, DFT_SIZE, DFT_SIZE) ==
+             SRSRAN_SUCCESS);
+  TESTASSERT(srsran_dft_plan_guru_c(
+                 &plan_b, DFT_SIZE, SRSRAN_DFT_FORWARD, in_b, out_b, 1, 1, NOF_SYMBOLS, DFT_SIZE, DFT_SIZE) ==
+             SRSRAN_SUCCESS);
+  TESTASSERT(plan_a.p == plan_b.p);
+
+  // A misaligned input can not reuse the plan
+  TESTASSERT(srsran_dft_plan_guru_c(
+                 &plan_c, DFT_SIZE, SRSRAN_DFT_FORWARD, in_a + 1, out_a, 1, 1, NOF_SYMBOLS, DFT_SIZE, DFT_SIZE) ==
+             SRSRAN_SUCCESS);
+  TESTASSERT(plan_c.p != plan_a.p);
+  srsran_dft_plan_free(&plan_c);
+
+  // Planning may overwrite the buffers, fill them afterwards
+  srsran_random_uniform_complex_dist_vector(random_gen, in_a, len, -1.0f, 1.0f);
+  srsran_vec_cf_copy(in_b, in_a, len);
+  srsran_dft_run_guru_c(&plan_a);
+  srsran_dft_run_guru_c(&plan_b);
+  TESTASSERT(max_error(out_a, out_b, DFT_SIZE * NOF_SYMBOLS) < 1e-6f);
+
+  srsran_dft_plan_free(&plan_a);
+  srsran_dft_plan_free(&plan_b);
+  TESTASSERT(srsran_dft_plan_cache_size() == 0);
+
+  free(in_a);
+  free(in_b);
+  free(out_a);
+  free(out_b);
+  return SRSRAN_SUCCESS;
+}
+
+int main(int argc, char** argv)
+{
+  random_gen = srsran_random_init(0);
+
+  int ret = SRSRAN_SUCCESS;
+  if (test_plan_c() != SRSRAN_SUCCESS || test_plan_guru_c() != SRSRAN_SUCCESS) {
+    ret = SRSRAN_ERROR;
+  }
+
+  srsran_random_free(random_gen);
+
+  printf("%s!\n", ret == SRSRAN_SUCCESS ? "Ok" : "Failed");
+  return ret;
+}
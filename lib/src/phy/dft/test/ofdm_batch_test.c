@@ -0,0 +1,209 @@
+/**
+ * Copyright 2013-2023 Software Radio Systems Limited
+ *
+ * This file is part of srsRAN.
+ *
+ * srsRAN is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsRAN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+#include "srsran/phy/utils/random.h"
+#include "srsran/srsran.h"
+
+static srsran_cp_t cp                    = SRSRAN_CP_NORM;
+static uint32_t    max_nof_sf            = 4;
+static int         nof_repetitions       = 1;
+static float       rx_window_offset      = 0.5f;
+static double      phase_compensation_hz = 0.0;
+static double      elapsed_us(struct timeval* ts_start, struct timeval* ts_end)
+{
+  if (ts_end->tv_usec > ts_start->tv_usec) {
+    return ((double)ts_end->tv_sec - (double)ts_start->tv_sec) * 1000000 + (double)ts_end->tv_usec -
+           (double)ts_start->tv_usec;
+  } else {
+    return ((double)ts_end->tv_sec - (double)ts_start->tv_sec - 1) * 1000000 + ((double)ts_end->tv_usec + 1000000) -
+           (double)ts_start->tv_usec;
+  }
+}
+
+static void usage(char* prog)
+{
+  printf("Usage: %s\n", prog);
+  printf("\t-b maximum number of subframes in a batch [Default %d]\n", max_nof_sf);
+  printf("\t-e extended cyclic prefix [Default Normal]\n");
+  printf("\t-r nof_repetitions [Default %d]\n", nof_repetitions);
+  printf("\t-o rx window offset (portion of CP length) [Default %.1f]\n", rx_window_offset);
+  printf("\t-p Phase compensation carrier frequency in Hz [Default %.1f]\n", phase_compensation_hz);
+}
+
+static void parse_args(int argc, char** argv)
+{
+  int opt;
+  while ((opt = getopt(argc, argv, "berop")) != -1) {
+    switch (opt) {
+      case 'b':
+        max_nof_sf = (uint32_t)strtol(argv[optind], NULL, 10);
+        max_nof_sf = SRSRAN_MIN(SRSRAN_OFDM_BATCH_MAX_SF, SRSRAN_MAX(1, max_nof_sf));
+        break;
+      case 'e':
+        cp = SRSRAN_CP_EXT;
+        break;
+      case 'r':
+        nof_repetitions = (int)strtol(argv[optind], NULL, 10);
+        break;
+      case 'o':
+        rx_window_offset = SRSRAN_MIN(1.0f, SRSRAN_MAX(0.0f, strtof(argv[optind], NULL)));
+        break;
+      case 'p':
+        phase_compensation_hz = strtod(argv[optind], NULL);
+        break;
+      default:
+        usage(argv[0]);
+        exit(-1);
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  srsran_random_t     random_gen = srsran_random_init(0);
+  struct timeval      start, end;
+  srsran_ofdm_t       fft = {}, ifft = {};
+  srsran_ofdm_batch_t batch = {};
+  uint32_t            prb_list[] = {6, 15, 25, 50, 75, 100};
+
+  parse_args(argc, argv);
+
+  for (uint32_t p = 0; p < sizeof(prb_list) / sizeof(prb_list[0]); p++) {
+    uint32_t n_prb  = prb_list[p];
+    uint32_t n_re   = SRSRAN_CP_NSYMB(cp) * n_prb * SRSRAN_NRE * SRSRAN_NOF_SLOTS_PER_SF;
+    uint32_t sf_len = SRSRAN_SF_LEN((uint32_t)srsran_symbol_sz(n_prb));
+
+    cf_t* input[SRSRAN_OFDM_BATCH_MAX_SF]  = {};
+    cf_t* outfft[SRSRAN_OFDM_BATCH_MAX_SF] = {};
+    cf_t* txbuf                            = srsran_vec_cf_malloc(n_re);
+    cf_t* outifft                          = srsran_vec_cf_malloc(sf_len);
+    cf_t* outref                           = srsran_vec_cf_malloc(n_re);
+    for (uint32_t sf = 0; sf < max_nof_sf; sf++) {
+      input[sf]  = srsran_vec_cf_malloc(n_re);
+      outfft[sf] = srsran_vec_cf_malloc(n_re);
+      if (!input[sf] || !outfft[sf]) {
+        perror("malloc");
+        exit(-1);
+      }
+    }
+    if (!txbuf || !outifft || !outref) {
+      perror("malloc");
+      exit(-1);
+    }
+    srsran_vec_cf_zero(outifft, sf_len);
+
+    srsran_ofdm_cfg_t ofdm_cfg     = {};
+    ofdm_cfg.cp                    = cp;
+    ofdm_cfg.in_buffer             = txbuf;
+    ofdm_cfg.out_buffer            = outifft;
+    ofdm_cfg.nof_prb               = n_prb;
+    ofdm_cfg.normalize             = true;
+    ofdm_cfg.phase_compensation_hz = phase_compensation_hz;
+    if (srsran_ofdm_tx_init_cfg(&ifft, &ofdm_cfg)) {
+      ERROR("Error initializing iFFT");
+      exit(-1);
+    }
+
+    ofdm_cfg.in_buffer        = outifft;
+    ofdm_cfg.out_buffer       = outref;
+    ofdm_cfg.rx_window_offset = rx_window_offset;
+    if (srsran_ofdm_rx_init_cfg(&fft, &ofdm_cfg)) {
+      ERROR("Error initializing FFT");
+      exit(-1);
+    }
+
+    if (srsran_ofdm_rx_batch_init(&batch, &fft, max_nof_sf)) {
+      ERROR("Error initializing batch FFT");
+      exit(-1);
+    }
+
+    // Modulate a different random subframe in every batch position
+    for (uint32_t sf = 0; sf < max_nof_sf; sf++) {
+      srsran_random_uniform_complex_dist_vector(random_gen, input[sf], n_re, -1.0f, +1.0f);
+      memcpy(txbuf, input[sf], sizeof(cf_t) * n_re);
+      srsran_ofdm_tx_sf(&ifft);
+      memcpy(srsran_ofdm_rx_batch_input(&batch, sf), outifft, sizeof(cf_t) * sf_len);
+    }
+
+    for (uint32_t nof_sf = 1; nof_sf <= max_nof_sf; nof_sf++) {
+      printf("Running test for %d PRB, %d subframes...", n_prb, nof_sf);
+
+      // Reference, one subframe at a time
+      gettimeofday(&start, NULL);
+      for (uint32_t i = 0; i < nof_repetitions; i++) {
+        for (uint32_t sf = 0; sf < nof_sf; sf++) {
+          memcpy(outifft, srsran_ofdm_rx_batch_input(&batch, sf), sizeof(cf_t) * sf_len);
+          srsran_ofdm_rx_sf(&fft);
+        }
+      }
+      gettimeofday(&end, NULL);
+      printf(" Rx@%.1fMsps", (double)(sf_len * nof_sf * nof_repetitions) / elapsed_us(&start, &end));
+
+      // Batch, the DFT does not modify its input
+      gettimeofday(&start, NULL);
+      for (uint32_t i = 0; i < nof_repetitions; i++) {
+        if (srsran_ofdm_rx_batch_run(&batch, outfft, nof_sf)) {
+          ERROR("Error running batch FFT");
+          exit(-1);
+        }
+      }
+      gettimeofday(&end, NULL);
+      printf(" Batch@%.1fMsps", (double)(sf_len * nof_sf * nof_repetitions) / elapsed_us(&start, &end));
+
+      // compute Mean Square Error
+      float mse = 0.0f;
+      for (uint32_t sf = 0; sf < nof_sf; sf++) {
+        srsran_vec_sub_ccc(input[sf], outfft[sf], outref, n_re);
+        mse = SRSRAN_MAX(mse, sqrtf(srsran_vec_avg_power_cf(outref, n_re)));
+      }
+
+      printf(" MSE=%.6f\n", mse);
+
+      if (mse >= 0.0001) {
+        printf("MSE too large\n");
+        exit(-1);
+      }
+    }
+
+    srsran_ofdm_rx_batch_free(&batch);
+    srsran_ofdm_rx_free(&fft);
+    srsran_ofdm_tx_free(&ifft);
+
+    for (uint32_t sf = 0; sf < max_nof_sf; sf++) {
+      free(input[sf]);
+      free(outfft[sf]);
+    }
+    free(txbuf);
+    free(outifft);
+    free(outref);
+  }
+
+  srsran_random_free(random_gen);
+
+  exit(0);
+}
@@ -184,6 +184,17 @@ int main(int argc, char** argv)
       exit(-1);
     }
 
+    // Control region first, then the rest of the subframe from the same input
+    srsran_ofdm_tx_sf(&ifft);
+    srsran_ofdm_rx_sf_ctrl(&fft);
+    srsran_ofdm_rx_sf_complete(&fft);
+    srsran_vec_sub_ccc(input, outfft, outfft, n_re);
+    mse = sqrtf(srsran_vec_avg_power_cf(outfft, n_re));
+    if (mse >= 0.0001) {
+      printf("Control and complete MSE=%.6f too large\n", mse);
+      exit(-1);
+    }
+
     srsran_ofdm_rx_free(&fft);
     srsran_ofdm_tx_free(&ifft);
 
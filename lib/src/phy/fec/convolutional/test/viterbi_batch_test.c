@@ -0,0 +1,218 @@
+/**
+ * Copyright 2013-2023 Software Radio Systems Limited
+ *
+ * This file is part of srsRAN.
+ *
+ * srsRAN is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsRAN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "srsran/phy/utils/random.h"
+#include "srsran/srsran.h"
+#include "srsran/support/srsran_test.h"
+
+static uint32_t frame_length = 40;
+static uint32_t nof_batches  = 100;
+static float    ebno_db      = 2.0f;
+
+static void usage(char* prog)
+{
+  printf("Usage: %s [nle]\n", prog);
+  printf("\t-n nof_batches [Default %d]\n", nof_batches);
+  printf("\t-l frame_length [Default %d]\n", frame_length);
+  printf("\t-e ebno in dB [Default %.1f]\n", ebno_db);
+}
+
+static void parse_args(int argc, char** argv)
+{
+  int opt;
+  while ((opt = getopt(argc, argv, "nle")) != -1) {
+    switch (opt) {
+      case 'n':
+        nof_batches = (uint32_t)strtol(argv[optind], NULL, 10);
+        break;
+      case 'l':
+        frame_length = (uint32_t)strtol(argv[optind], NULL, 10);
+        break;
+      case 'e':
+        ebno_db = strtof(argv[optind], NULL);
+        break;
+      default:
+        usage(argv[0]);
+        exit(-1);
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  int                    ret              = SRSRAN_ERROR;
+  srsran_random_t        random_gen       = srsran_random_init(0x1234);
+  srsran_viterbi_t       dec              = {};
+  srsran_viterbi_batch_t dec_batch        = {};
+  srsran_convcoder_t     cod              = {};
+  uint8_t*               data_tx[SRSRAN_VITERBI_BATCH_MAX] = {};
+  uint8_t*               data_rx[SRSRAN_VITERBI_BATCH_MAX] = {};
+  float*                 llr[SRSRAN_VITERBI_BATCH_MAX]     = {};
+  uint8_t*               symbols          = NULL;
+  uint8_t*               data_ref         = NULL;
+  uint32_t               errors_batch     = 0;
+  uint32_t               errors_ref       = 0;
+  uint64_t               t_batch_us       = 0;
+  uint64_t               t_ref_us         = 0;
+  uint32_t               nof_cw_total     = 0;
+  struct timeval         t[3]             = {};
+
+  parse_args(argc, argv);
+
+  cod.poly[0]     = 0x6D;
+  cod.poly[1]     = 0x4F;
+  cod.poly[2]     = 0x57;
+  cod.K           = 7;
+  cod.R           = 3;
+  cod.tail_biting = true;
+
+  uint32_t coded_length = 3 * frame_length;
+  float    esno_db      = ebno_db + srsran_convert_power_to_dB(1.0f / 3.0f);
+  float    var          = srsran_convert_dB_to_power(-esno_db);
+
+  if (srsran_viterbi_init(&dec, SRSRAN_VITERBI_37, cod.poly, frame_length, true) ||
+      srsran_viterbi_batch_init(&dec_batch, cod.poly, frame_length)) {
+    ERROR("Error initiating Viterbi decoders");
+    goto clean_exit;
+  }
+
+  symbols  = srsran_vec_u8_malloc(coded_length);
+  data_ref = srsran_vec_u8_malloc(frame_length);
+  if (!symbols || !data_ref) {
+    goto clean_exit;
+  }
+  for (uint32_t i = 0; i < SRSRAN_VITERBI_BATCH_MAX; i++) {
+    data_tx[i] = srsran_vec_u8_malloc(frame_length);
+    data_rx[i] = srsran_vec_u8_malloc(frame_length);
+    llr[i]     = srsran_vec_f_malloc(coded_length);
+    if (!data_tx[i] || !data_rx[i] || !llr[i]) {
+      goto clean_exit;
+    }
+  }
+
+  for (uint32_t b = 0; b < nof_batches; b++) {
+    // Alternate full and partial batches
+    uint32_t nof_cw = (b % 2) ? SRSRAN_VITERBI_BATCH_MAX : 1 + b % SRSRAN_VITERBI_BATCH_MAX;
+
+    for (uint32_t i = 0; i < nof_cw; i++) {
+      for (uint32_t j = 0; j < frame_length; j++) {
+        data_tx[i][j] = (uint8_t)srsran_random_uniform_int_dist(random_gen, 0, 1);
+      }
+      srsran_convcoder_encode(&cod, data_tx[i], symbols, frame_length);
+      for (uint32_t j = 0; j < coded_length; j++) {
+        llr[i][j] = symbols[j] ? M_SQRT2 : -M_SQRT2;
+      }
+      srsran_ch_awgn_f(llr[i], llr[i], var, coded_length);
+    }
+
+    gettimeofday(&t[1], NULL);
+    TESTASSERT(srsran_viterbi_batch_decode_f(&dec_batch, llr, data_rx, nof_cw, frame_length) == SRSRAN_SUCCESS);
+    gettimeofday(&t[2], NULL);
+    get_time_interval(t);
+    t_batch_us += t[0].tv_sec * 1000000 + t[0].tv_usec;
+
+    for (uint32_t i = 0; i < nof_cw; i++) {
+      gettimeofday(&t[1], NULL);
+      srsran_viterbi_decode_f(&dec, llr[i], data_ref, frame_length);
+      gettimeofday(&t[2], NULL);
+      get_time_interval(t);
+      t_ref_us += t[0].tv_sec * 1000000 + t[0].tv_usec;
+
+      errors_batch += srsran_bit_diff(data_tx[i], data_rx[i], frame_length);
+      errors_ref += srsran_bit_diff(data_tx[i], data_ref, frame_length);
+    }
+    nof_cw_total += nof_cw;
+  }
+
+  printf("Frame length: %d; Eb/No: %.1f dB; %d codewords; batch BER: %.2e (%.2f us/cw); single BER: %.2e (%.2f us/cw)\n",
+         frame_length,
+         ebno_db,
+         nof_cw_total,
+         (double)errors_batch / (nof_cw_total * frame_length),
+         (double)t_batch_us / nof_cw_total,
+         (double)errors_ref / (nof_cw_total * frame_length),
+         (double)t_ref_us / nof_cw_total);
+
+  // Throughput against the number of lanes in use, the batch decoder costs the same for 1 or 16 codewords
+  printf("Lanes\tbatch us\tsingle us\n");
+  uint32_t break_even = 0;
+  for (uint32_t nof_cw = 1; nof_cw <= SRSRAN_VITERBI_BATCH_MAX; nof_cw++) {
+    uint64_t t_lanes_batch_us = 0;
+    uint64_t t_lanes_ref_us   = 0;
+    for (uint32_t b = 0; b < nof_batches; b++) {
+      gettimeofday(&t[1], NULL);
+      srsran_viterbi_batch_decode_f(&dec_batch, llr, data_rx, nof_cw, frame_length);
+      gettimeofday(&t[2], NULL);
+      get_time_interval(t);
+      t_lanes_batch_us += t[0].tv_sec * 1000000 + t[0].tv_usec;
+
+      gettimeofday(&t[1], NULL);
+      for (uint32_t i = 0; i < nof_cw; i++) {
+        srsran_viterbi_decode_f(&dec, llr[i], data_rx[i], frame_length);
+      }
+      gettimeofday(&t[2], NULL);
+      get_time_interval(t);
+      t_lanes_ref_us += t[0].tv_sec * 1000000 + t[0].tv_usec;
+    }
+    printf("%d\t%.2f\t\t%.2f\n",
+           nof_cw,
+           (double)t_lanes_batch_us / nof_batches,
+           (double)t_lanes_ref_us / nof_batches);
+    if (break_even == 0 && t_lanes_batch_us < t_lanes_ref_us) {
+      break_even = nof_cw;
+    }
+  }
+  printf("The batch decoder is faster from %d lanes\n", break_even);
+
+  // The batch decoder must perform as the single codeword decoder, up to quantization differences
+  ret = (errors_batch <= errors_ref + errors_ref / 4 + 10) ? SRSRAN_SUCCESS : SRSRAN_ERROR;
+
+clean_exit:
+  for (uint32_t i = 0; i < SRSRAN_VITERBI_BATCH_MAX; i++) {
+    if (data_tx[i]) {
+      free(data_tx[i]);
+    }
+    if (data_rx[i]) {
+      free(data_rx[i]);
+    }
+    if (llr[i]) {
+      free(llr[i]);
+    }
+  }
+  if (symbols) {
+    free(symbols);
+  }
+  if (data_ref) {
+    free(data_ref);
+  }
+  srsran_viterbi_free(&dec);
+  srsran_viterbi_batch_free(&dec_batch);
+  srsran_random_free(random_gen);
+
+  printf("%s!\n", ret == SRSRAN_SUCCESS ? "Ok" : "Failed");
+  return ret;
+}
@@ -0,0 +1,342 @@
+/**
+ * Copyright 2013-2023 Software Radio Systems Limited
+ *
+ * This file is part of srsRAN.
+ *
+ * srsRAN is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsRAN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+/* Tail-biting r=1/3 K=7 Viterbi decoder running several codewords of the same length in parallel.
+ *
+ * The single codeword decoders vectorise across the 64 trellis states, here every SIMD lane holds a different
+ * codeword and the states are unrolled, so all the lanes are busy and the setup is paid once per batch. The path
+ * metrics are 16-bit and renormalised every PATH_NORM_PERIOD steps.
+ *
+ * Tail biting is handled as in the single codeword decoders: the codeword is repeated so that the decoded copy has
+ * at least TB_DEPTH steps of trellis before and after it, and it is traced back from the best final state.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "parity.h"
+#include "srsran/phy/fec/convolutional/viterbi.h"
+#include "srsran/phy/utils/debug.h"
+#include "srsran/phy/utils/vector.h"
+
+#ifdef LV_HAVE_AVX2
+#include <immintrin.h>
+#elif defined(LV_HAVE_SSE)
+#include <emmintrin.h>
+#endif
+
+#define NOF_STATES 64
+#define NOF_LANES SRSRAN_VITERBI_BATCH_MAX
+#define TB_DEPTH 42 // 6 * K, enough to converge on both sides of the decoded copy
+#define PATH_NORM_PERIOD 8
+#define SYMBOL_MAX 127.0f // |symbol| after quantization, keeps the metrics of PATH_NORM_PERIOD steps in 16 bit
+
+/* Copies of the codeword before (and after) the decoded one */
+static inline uint32_t nof_tb_copies(uint32_t frame_length)
+{
+  return (TB_DEPTH + frame_length - 1) / frame_length;
+}
+
+int srsran_viterbi_batch_init(srsran_viterbi_batch_t* q, int poly[3], uint32_t max_frame_length)
+{
+  if (q == NULL || poly == NULL || max_frame_length == 0) {
+    return SRSRAN_ERROR_INVALID_INPUTS;
+  }
+  bzero(q, sizeof(srsran_viterbi_batch_t));
+
+  q->max_frame_length = max_frame_length;
+  q->max_nof_steps    = 2 * TB_DEPTH + 3 * max_frame_length;
+
+  // Register r holds the newest bit in its LSB, the state is the 6 newest bits
+  for (uint32_t r = 0; r < 2 * NOF_STATES; r++) {
+    q->outputs[r] = (uint8_t)(parity(r & poly[0]) | (parity(r & poly[1]) << 1) | (parity(r & poly[2]) << 2));
+  }
+
+  q->symbols   = srsran_vec_i16_malloc(3 * max_frame_length * NOF_LANES);
+  q->decisions = srsran_vec_u32_malloc(q->max_nof_steps * NOF_STATES);
+  q->metrics   = srsran_vec_i16_malloc(NOF_STATES * NOF_LANES);
+  q->tmp       = srsran_vec_i16_malloc(3 * max_frame_length);
+  if (!q->symbols || !q->decisions || !q->metrics || !q->tmp) {
+    srsran_viterbi_batch_free(q);
+    return SRSRAN_ERROR;
+  }
+  return SRSRAN_SUCCESS;
+}
+
+void srsran_viterbi_batch_free(srsran_viterbi_batch_t* q)
+{
+  if (q == NULL) {
+    return;
+  }
+  if (q->symbols) {
+    free(q->symbols);
+  }
+  if (q->decisions) {
+    free(q->decisions);
+  }
+  if (q->metrics) {
+    free(q->metrics);
+  }
+  if (q->tmp) {
+    free(q->tmp);
+  }
+  bzero(q, sizeof(srsran_viterbi_batch_t));
+}
+
+#ifdef LV_HAVE_AVX2
+static void update_batch_avx2(srsran_viterbi_batch_t* q, uint32_t frame_length, uint32_t nof_steps)
+{
+  __m256i  pm[NOF_STATES], nm[NOF_STATES], bm[8];
+  __m256i* old_m = pm;
+  __m256i* new_m = nm;
+  uint8_t  outputs[2 * NOF_STATES];
+
+  memcpy(outputs, q->outputs, sizeof(outputs));
+  for (uint32_t s = 0; s < NOF_STATES; s++) {
+    pm[s] = _mm256_setzero_si256();
+  }
+
+  for (uint32_t t = 0, k = 0; t < nof_steps; t++) {
+    const int16_t* sym = &q->symbols[3 * k * NOF_LANES];
+    __m256i        s0  = _mm256_load_si256((__m256i*)&sym[0]);
+    __m256i        s1  = _mm256_load_si256((__m256i*)&sym[NOF_LANES]);
+    __m256i        s2  = _mm256_load_si256((__m256i*)&sym[2 * NOF_LANES]);
+
+    // Branch metric of every output combination, correlation with the expected bits
+    __m256i n0 = _mm256_sub_epi16(_mm256_setzero_si256(), s0);
+    __m256i n1 = _mm256_sub_epi16(_mm256_setzero_si256(), s1);
+    __m256i n2 = _mm256_sub_epi16(_mm256_setzero_si256(), s2);
+    for (uint32_t o = 0; o < 8; o++) {
+      bm[o] = _mm256_add_epi16(_mm256_add_epi16((o & 1) ? s0 : n0, (o & 2) ? s1 : n1), (o & 4) ? s2 : n2);
+    }
+
+    // Butterflies: states i and i + 32 are the predecessors of states 2i and 2i + 1
+    uint32_t* dec = &q->decisions[t * NOF_STATES];
+    for (uint32_t i = 0; i < NOF_STATES / 2; i++) {
+      __m256i a = old_m[i];
+      __m256i b = old_m[i + NOF_STATES / 2];
+      for (uint32_t s = 2 * i; s < 2 * i + 2; s++) {
+        __m256i m0 = _mm256_add_epi16(a, bm[outputs[s]]);
+        __m256i m1 = _mm256_add_epi16(b, bm[outputs[NOF_STATES | s]]);
+        new_m[s]   = _mm256_max_epi16(m0, m1);
+        dec[s]     = (uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi16(m1, m0));
+      }
+    }
+
+    if (t % PATH_NORM_PERIOD == PATH_NORM_PERIOD - 1) {
+      __m256i ref = new_m[0];
+      for (uint32_t s = 0; s < NOF_STATES; s++) {
+        new_m[s] = _mm256_sub_epi16(new_m[s], ref);
+      }
+    }
+
+    __m256i* tmp = old_m;
+    old_m        = new_m;
+    new_m        = tmp;
+    k            = (k + 1 == frame_length) ? 0 : k + 1;
+  }
+
+  for (uint32_t s = 0; s < NOF_STATES; s++) {
+    _mm256_storeu_si256((__m256i*)&q->metrics[s * NOF_LANES], old_m[s]);
+  }
+}
+#elif defined(LV_HAVE_SSE)
+
+/* Same kernel on two halves of 8 lanes, lane l of the upper half lands on bit 2 * l of the decisions too */
+static void update_batch_sse(srsran_viterbi_batch_t* q, uint32_t frame_length, uint32_t nof_steps)
+{
+  __m128i  pm[NOF_STATES][2], nm[NOF_STATES][2], bm[8][2];
+  __m128i(*old_m)[2] = pm;
+  __m128i(*new_m)[2] = nm;
+  uint8_t outputs[2 * NOF_STATES];
+
+  memcpy(outputs, q->outputs, sizeof(outputs));
+  for (uint32_t s = 0; s < NOF_STATES; s++) {
+    pm[s][0] = _mm_setzero_si128();
+    pm[s][1] = _mm_setzero_si128();
+  }
+
+  for (uint32_t t = 0, k = 0; t < nof_steps; t++) {
+    const int16_t* sym = &q->symbols[3 * k * NOF_LANES];
+    for (uint32_t h = 0; h < 2; h++) {
+      __m128i s0 = _mm_load_si128((__m128i*)&sym[8 * h]);
+      __m128i s1 = _mm_load_si128((__m128i*)&sym[NOF_LANES + 8 * h]);
+      __m128i s2 = _mm_load_si128((__m128i*)&sym[2 * NOF_LANES + 8 * h]);
+      __m128i n0 = _mm_sub_epi16(_mm_setzero_si128(), s0);
+      __m128i n1 = _mm_sub_epi16(_mm_setzero_si128(), s1);
+      __m128i n2 = _mm_sub_epi16(_mm_setzero_si128(), s2);
+      for (uint32_t o = 0; o < 8; o++) {
+        bm[o][h] = _mm_add_epi16(_mm_add_epi16((o & 1) ? s0 : n0, (o & 2) ? s1 : n1), (o & 4) ? s2 : n2);
+      }
+    }
+
+    uint32_t* dec = &q->decisions[t * NOF_STATES];
+    for (uint32_t s = 0; s < NOF_STATES; s++) {
+      uint32_t d = 0;
+      for (uint32_t h = 0; h < 2; h++) {
+        __m128i m0  = _mm_add_epi16(old_m[s >> 1][h], bm[outputs[s]][h]);
+        __m128i m1  = _mm_add_epi16(old_m[(s >> 1) | 32][h], bm[outputs[NOF_STATES | s]][h]);
+        new_m[s][h] = _mm_max_epi16(m0, m1);
+        d |= (uint32_t)_mm_movemask_epi8(_mm_cmpgt_epi16(m1, m0)) << (16 * h);
+      }
+      dec[s] = d;
+    }
+
+    if (t % PATH_NORM_PERIOD == PATH_NORM_PERIOD - 1) {
+      __m128i ref[2] = {new_m[0][0], new_m[0][1]};
+      for (uint32_t s = 0; s < NOF_STATES; s++) {
+        new_m[s][0] = _mm_sub_epi16(new_m[s][0], ref[0]);
+        new_m[s][1] = _mm_sub_epi16(new_m[s][1], ref[1]);
+      }
+    }
+
+    __m128i(*tmp)[2] = old_m;
+    old_m            = new_m;
+    new_m            = tmp;
+    k                = (k + 1 == frame_length) ? 0 : k + 1;
+  }
+
+  for (uint32_t s = 0; s < NOF_STATES; s++) {
+    _mm_storeu_si128((__m128i*)&q->metrics[s * NOF_LANES], old_m[s][0]);
+    _mm_storeu_si128((__m128i*)&q->metrics[s * NOF_LANES + 8], old_m[s][1]);
+  }
+}
+#else /* LV_HAVE_SSE */
+
+static void update_batch_gen(srsran_viterbi_batch_t* q, uint32_t frame_length, uint32_t nof_steps)
+{
+  int16_t pm[NOF_STATES][NOF_LANES] = {}, nm[NOF_STATES][NOF_LANES];
+  int16_t bm[8][NOF_LANES];
+  int16_t(*old_m)[NOF_LANES] = pm;
+  int16_t(*new_m)[NOF_LANES] = nm;
+
+  for (uint32_t t = 0, k = 0; t < nof_steps; t++) {
+    const int16_t* sym = &q->symbols[3 * k * NOF_LANES];
+    for (uint32_t o = 0; o < 8; o++) {
+      for (uint32_t l = 0; l < NOF_LANES; l++) {
+        bm[o][l] = (int16_t)(((o & 1) ? sym[l] : -sym[l]) + ((o & 2) ? sym[NOF_LANES + l] : -sym[NOF_LANES + l]) +
+                             ((o & 4) ? sym[2 * NOF_LANES + l] : -sym[2 * NOF_LANES + l]));
+      }
+    }
+
+    uint32_t* dec = &q->decisions[t * NOF_STATES];
+    for (uint32_t s = 0; s < NOF_STATES; s++) {
+      const int16_t* b0 = bm[q->outputs[s]];
+      const int16_t* b1 = bm[q->outputs[NOF_STATES | s]];
+      uint32_t       d  = 0;
+      for (uint32_t l = 0; l < NOF_LANES; l++) {
+        int16_t m0  = (int16_t)(old_m[s >> 1][l] + b0[l]);
+        int16_t m1  = (int16_t)(old_m[(s >> 1) | 32][l] + b1[l]);
+        new_m[s][l] = (m1 > m0) ? m1 : m0;
+        d |= (uint32_t)(m1 > m0) << (2 * l);
+      }
+      dec[s] = d;
+    }
+
+    if (t % PATH_NORM_PERIOD == PATH_NORM_PERIOD - 1) {
+      int16_t ref[NOF_LANES];
+      memcpy(ref, new_m[0], sizeof(ref));
+      for (uint32_t s = 0; s < NOF_STATES; s++) {
+        for (uint32_t l = 0; l < NOF_LANES; l++) {
+          new_m[s][l] -= ref[l];
+        }
+      }
+    }
+
+    int16_t(*tmp)[NOF_LANES] = old_m;
+    old_m                    = new_m;
+    new_m                    = tmp;
+    k                        = (k + 1 == frame_length) ? 0 : k + 1;
+  }
+
+  memcpy(q->metrics, old_m, sizeof(pm));
+}
+#endif /* LV_HAVE_AVX2 */
+
+int srsran_viterbi_batch_decode_f(srsran_viterbi_batch_t* q,
+                                  float*                  symbols[SRSRAN_VITERBI_BATCH_MAX],
+                                  uint8_t*                data[SRSRAN_VITERBI_BATCH_MAX],
+                                  uint32_t                nof_cw,
+                                  uint32_t                frame_length)
+{
+  if (q == NULL || symbols == NULL || data == NULL || nof_cw > NOF_LANES) {
+    return SRSRAN_ERROR_INVALID_INPUTS;
+  }
+  if (frame_length == 0 || frame_length > q->max_frame_length) {
+    ERROR("Initialized batch decoder for max frame length %d bits", q->max_frame_length);
+    return SRSRAN_ERROR;
+  }
+  uint32_t nof_copies = nof_tb_copies(frame_length);
+  uint32_t nof_steps  = (2 * nof_copies + 1) * frame_length;
+  if (nof_steps > q->max_nof_steps) {
+    ERROR("Invalid number of trellis steps %d (max %d)", nof_steps, q->max_nof_steps);
+    return SRSRAN_ERROR;
+  }
+
+  // Quantize and interleave the codewords, the unused lanes decode zeros
+  uint32_t len = 3 * frame_length;
+  srsran_vec_i16_zero(q->symbols, len * NOF_LANES);
+  for (uint32_t l = 0; l < nof_cw; l++) {
+    float    gain  = 0.0f;
+    uint32_t max_i = srsran_vec_max_abs_fi(symbols[l], len);
+    if (max_i < len && isnormal(symbols[l][max_i])) {
+      gain = SYMBOL_MAX / fabsf(symbols[l][max_i]);
+    }
+    srsran_vec_convert_fi(symbols[l], gain, q->tmp, len);
+    for (uint32_t i = 0; i < len; i++) {
+      q->symbols[i * NOF_LANES + l] = q->tmp[i];
+    }
+  }
+
+#ifdef LV_HAVE_AVX2
+  update_batch_avx2(q, frame_length, nof_steps);
+#elif defined(LV_HAVE_SSE)
+  update_batch_sse(q, frame_length, nof_steps);
+#else
+  update_batch_gen(q, frame_length, nof_steps);
+#endif
+
+  // Trace every codeword back from its best final state and keep the middle copy
+  uint32_t first = nof_copies * frame_length;
+  for (uint32_t l = 0; l < nof_cw; l++) {
+    uint32_t state = 0;
+    int16_t  best  = q->metrics[l];
+    for (uint32_t s = 1; s < NOF_STATES; s++) {
+      if (q->metrics[s * NOF_LANES + l] > best) {
+        best  = q->metrics[s * NOF_LANES + l];
+        state = s;
+      }
+    }
+    for (uint32_t t = nof_steps; t > first; t--) {
+      uint32_t h = (q->decisions[(t - 1) * NOF_STATES + state] >> (2 * l)) & 1;
+      if (t - 1 < first + frame_length) {
+        data[l][t - 1 - first] = (uint8_t)(state & 1);
+      }
+      state = (state >> 1) | (h << 5);
+    }
+  }
+
+  return SRSRAN_SUCCESS;
+}
@@ -45,6 +45,27 @@
 #define NOF_CCE(cfi) ((cfi > 0 && cfi < 4) ? q->nof_cce[cfi - 1] : 0)
 #define NOF_REGS(cfi) ((cfi > 0 && cfi < 4) ? q->nof_regs[cfi - 1] : 0)
 
+/* Adaptive LLR gate */
+#define PDCCH_LLR_GATE_WARMUP 50         // subframes learned before the gate replaces LLR_RATIO
+#define PDCCH_LLR_GATE_ALPHA 0.02f       // forgetting factor once the warm-up is over
+#define PDCCH_LLR_GATE_K 3.0f            // standard deviations of the idle CCEs above their mean
+#define PDCCH_LLR_GATE_MIN 0.1f          // never decode candidates under this mean |LLR|
+#define PDCCH_LLR_GATE_MAX 0.6f          // never skip candidates over this mean |LLR|
+#define PDCCH_LLR_GATE_NOISE_JUMP_DB 3.0f // noise change that restarts the learning
+
+/* Batch results: a table per DCI size, each one with the aligned candidates of every aggregation level */
+#define PDCCH_BATCH_NOF_RESULTS(q) (SRSRAN_PDCCH_BATCH_NOF_SIZES * 2 * (q)->max_cce)
+
+/* The batch Viterbi costs the same for 1 or 16 codewords, under this many lanes the candidates are decoded one by one
+ * (viterbi_batch_test: the batch decoder catches up with the single decoder between 4 and 9 lanes) */
+#define PDCCH_BATCH_MIN_LANES 8
+
+/* The one comparison against the LLR gate: candidates under it are not decoded, candidates at the gate are */
+static inline bool pdcch_llr_gate_below(float mean_llr, float gate)
+{
+  return mean_llr < gate;
+}
+
 float srsran_pdcch_coderate(uint32_t nof_bits, uint32_t l)
 {
   static const int nof_bits_x_symbol = 2; // QPSK
@@ -90,6 +111,36 @@ static int pdcch_init(srsran_pdcch_t* q, uint32_t max_prb, uint32_t nof_rx_anten
 
     srsran_vec_f_zero(q->llr, q->max_bits);
 
+    /* The map covers whole blocks of 8 CCEs */
+    q->max_cce = SRSRAN_CEIL(q->max_bits / 72, 8) * 8;
+    for (int l = 0; l < SRSRAN_PDCCH_NOF_AGGREGATION_LEVELS; l++) {
+      q->cce_energy[l] = srsran_vec_f_malloc(q->max_cce >> l);
+      if (!q->cce_energy[l]) {
+        goto clean;
+      }
+      srsran_vec_f_zero(q->cce_energy[l], q->max_cce >> l);
+    }
+    q->cce_used = srsran_vec_u8_malloc(q->max_cce);
+    if (!q->cce_used) {
+      goto clean;
+    }
+    srsran_pdcch_llr_gate_reset(&q->llr_gate_own);
+    srsran_pdcch_llr_gate_share(q, NULL, NULL);
+
+    if (srsran_viterbi_batch_init(&q->decoder_batch, poly, SRSRAN_DCI_MAX_BITS + 16)) {
+      goto clean;
+    }
+    q->rm_batch = srsran_vec_f_malloc(SRSRAN_VITERBI_BATCH_MAX * 3 * (SRSRAN_DCI_MAX_BITS + 16));
+    if (!q->rm_batch) {
+      goto clean;
+    }
+    q->batch_results = srsran_vec_malloc(sizeof(srsran_pdcch_batch_result_t) * PDCCH_BATCH_NOF_RESULTS(q));
+    if (!q->batch_results) {
+      goto clean;
+    }
+    memset(q->batch_results, 0, sizeof(srsran_pdcch_batch_result_t) * PDCCH_BATCH_NOF_RESULTS(q));
+    q->batch_gen = 1;
+
     q->d = srsran_vec_cf_malloc(q->max_bits / 2);
     if (!q->d) {
       goto clean;
@@ -141,6 +192,20 @@ void srsran_pdcch_free(srsran_pdcch_t* q)
   if (q->llr) {
     free(q->llr);
   }
+  for (int l = 0; l < SRSRAN_PDCCH_NOF_AGGREGATION_LEVELS; l++) {
+    if (q->cce_energy[l]) {
+      free(q->cce_energy[l]);
+    }
+  }
+  if (q->cce_used) {
+    free(q->cce_used);
+  }
+  if (q->rm_batch) {
+    free(q->rm_batch);
+  }
+  if (q->batch_results) {
+    free(q->batch_results);
+  }
   if (q->d) {
     free(q->d);
   }
@@ -165,6 +230,7 @@ void srsran_pdcch_free(srsran_pdcch_t* q)
 
   srsran_modem_table_free(&q->mod);
   srsran_viterbi_free(&q->decoder);
+  srsran_viterbi_batch_free(&q->decoder_batch);
 
   bzero(q, sizeof(srsran_pdcch_t));
 }
@@ -384,11 +450,10 @@ int srsran_pdcch_dci_decode(srsran_pdcch_t* q, float* e, uint8_t* data, uint32_t
   }
 }
 
-int srsran_pdcch_dci_decode_yx(srsran_pdcch_t* q, float* e, uint8_t* data, uint32_t E, uint32_t nof_bits, uint16_t* crc, float* prob)
+/* Re-encodes the decoded message with its CRC remainder as RNTI and returns the percentage of hard decisions of e
+ * that match the re-encoded bits */
+static float pdcch_dci_parcheck(srsran_pdcch_t* q, float* e, uint8_t* data, uint32_t E, uint32_t nof_bits, uint16_t rnti)
 {
-  uint16_t p_bits, crc_res;
-  uint8_t* x;
-
   uint8_t tmp[3 * (SRSRAN_DCI_MAX_BITS + 16)];
   uint8_t tmp2[10 * (SRSRAN_DCI_MAX_BITS + 16)];
   uint8_t check[(SRSRAN_DCI_MAX_BITS + 16)];
@@ -396,6 +461,32 @@ int srsran_pdcch_dci_decode_yx(srsran_pdcch_t* q, float* e, uint8_t* data, uint3
   int poly[3] = {0x6D, 0x4F, 0x57};
   srsran_convcoder_t encoder;
 
+  encoder.K           = 7;
+  encoder.R           = 3;
+  encoder.tail_biting = true;
+  memcpy(encoder.poly, poly, 3 * sizeof(int));
+
+  memcpy(check, data, nof_bits);
+
+  srsran_crc_attach(&q->crc, check, nof_bits);
+  crc_set_mask_rnti(&check[nof_bits], rnti);
+
+  srsran_convcoder_encode(&encoder, check, tmp, nof_bits + 16);
+  srsran_rm_conv_tx(tmp, 3 * (nof_bits + 16), tmp2, E);
+
+  float parcheck = 0.0;
+  for (int i = 0; i < E; i++) {
+    parcheck += ((((e[i] * 32 + 127.5) > 127.5) ? 1 : 0) == tmp2[i]);
+    // parcheck += (((e[i]>0)?1:0)==tmp2[i]);
+  }
+  return 100 * parcheck / E;
+}
+
+int srsran_pdcch_dci_decode_yx(srsran_pdcch_t* q, float* e, uint8_t* data, uint32_t E, uint32_t nof_bits, uint16_t* crc, float* prob)
+{
+  uint16_t p_bits, crc_res;
+  uint8_t* x;
+
   if (q != NULL) {
     if (data != NULL && E <= q->max_bits && nof_bits <= SRSRAN_DCI_MAX_BITS) {
       srsran_vec_f_zero(q->rm_f, 3 * (SRSRAN_DCI_MAX_BITS + 16));
@@ -415,30 +506,8 @@ int srsran_pdcch_dci_decode_yx(srsran_pdcch_t* q, float* e, uint8_t* data, uint3
       if (crc) {
         *crc = p_bits ^ crc_res;
       }
-      uint16_t c_rnti = *crc;
-
-      encoder.K = 7;
-      encoder.R = 3;
-      encoder.tail_biting = true;
-          
-      memcpy(encoder.poly, poly, 3 * sizeof(int));
 
-      memcpy(check,data,nof_bits);
-
-      srsran_crc_attach(&q->crc, check, nof_bits);
-      crc_set_mask_rnti(&check[nof_bits], c_rnti);
-
-      srsran_convcoder_encode(&encoder, check, tmp, nof_bits + 16);
-      srsran_rm_conv_tx(tmp, 3 * (nof_bits + 16), tmp2, E);
-
-      float parcheck = 0.0;
-      for (int i=0;i<E;i++) {
-        parcheck += ((((e[i]*32+127.5)>127.5)?1:0)==tmp2[i]);
-        //parcheck += (((e[i]>0)?1:0)==tmp2[i]);
-      }
-      parcheck = 100*parcheck/E;
- 
-      *prob = parcheck;
+      *prob = pdcch_dci_parcheck(q, e, data, E, nof_bits, p_bits ^ crc_res);
       return SRSRAN_SUCCESS;
     } else {
       ERROR("Invalid parameters: E: %d, max_bits: %d, nof_bits: %d", E, q->max_bits, nof_bits);
@@ -450,6 +519,140 @@ int srsran_pdcch_dci_decode_yx(srsran_pdcch_t* q, float* e, uint8_t* data, uint3
   }
 }
 
+/* Index of the results of a DCI size in the batch cache, a new table is taken if add is set */
+static int pdcch_batch_size_idx(srsran_pdcch_t* q, uint32_t nof_bits, bool add)
+{
+  for (uint32_t i = 0; i < q->nof_batch_sizes; i++) {
+    if (q->batch_sizes[i] == nof_bits) {
+      return i;
+    }
+  }
+  if (!add || q->nof_batch_sizes == SRSRAN_PDCCH_BATCH_NOF_SIZES) {
+    return SRSRAN_ERROR;
+  }
+  q->batch_sizes[q->nof_batch_sizes] = nof_bits;
+  return q->nof_batch_sizes++;
+}
+
+/* Cached result of an aligned candidate, the levels are stored one after the other: max_cce >> L entries each */
+static srsran_pdcch_batch_result_t*
+pdcch_batch_result(srsran_pdcch_t* q, uint32_t size_idx, const srsran_dci_location_t* location)
+{
+  if (location->L >= SRSRAN_PDCCH_NOF_AGGREGATION_LEVELS || location->ncce % (1U << location->L) != 0 ||
+      location->ncce >= q->max_cce) {
+    return NULL;
+  }
+  uint32_t offset = 2 * q->max_cce - ((2 * q->max_cce) >> location->L);
+  return &q->batch_results[size_idx * 2 * q->max_cce + offset + (location->ncce >> location->L)];
+}
+
+static const srsran_pdcch_batch_result_t*
+pdcch_batch_lookup(srsran_pdcch_t* q, const srsran_dci_location_t* location, uint32_t nof_bits)
+{
+  int size_idx = pdcch_batch_size_idx(q, nof_bits, false);
+  if (size_idx < 0) {
+    return NULL;
+  }
+  srsran_pdcch_batch_result_t* r = pdcch_batch_result(q, size_idx, location);
+  return (r != NULL && r->gen == q->batch_gen) ? r : NULL;
+}
+
+/* Decodes the candidates in the lanes of rm_batch and saves the results */
+static void pdcch_batch_flush(srsran_pdcch_t*               q,
+                              srsran_dci_location_t*        locations,
+                              srsran_pdcch_batch_result_t** results,
+                              uint32_t                      nof_cw,
+                              uint32_t                      nof_bits)
+{
+  uint8_t  data[SRSRAN_VITERBI_BATCH_MAX][SRSRAN_DCI_MAX_BITS + 16];
+  float*   symbols[SRSRAN_VITERBI_BATCH_MAX];
+  uint8_t* data_ptr[SRSRAN_VITERBI_BATCH_MAX];
+  uint32_t coded_len = 3 * (nof_bits + 16);
+
+  for (uint32_t i = 0; i < nof_cw; i++) {
+    symbols[i]  = &q->rm_batch[i * 3 * (SRSRAN_DCI_MAX_BITS + 16)];
+    data_ptr[i] = data[i];
+    srsran_vec_f_zero(symbols[i], coded_len);
+    srsran_rm_conv_rx(&q->llr[locations[i].ncce * 72], PDCCH_FORMAT_NOF_BITS(locations[i].L), symbols[i], coded_len);
+  }
+  srsran_viterbi_batch_decode_f(&q->decoder_batch, symbols, data_ptr, nof_cw, nof_bits + 16);
+
+  for (uint32_t i = 0; i < nof_cw; i++) {
+    uint8_t* x       = &data[i][nof_bits];
+    uint16_t p_bits  = (uint16_t)srsran_bit_pack(&x, 16);
+    uint16_t crc_res = ((uint16_t)srsran_crc_checksum(&q->crc, data[i], nof_bits) & 0xffff);
+    uint32_t E       = PDCCH_FORMAT_NOF_BITS(locations[i].L);
+
+    results[i]->crc  = p_bits ^ crc_res;
+    results[i]->prob = pdcch_dci_parcheck(q, &q->llr[locations[i].ncce * 72], data[i], E, nof_bits, results[i]->crc);
+    srsran_bit_pack_vector(data[i], results[i]->payload, nof_bits);
+    results[i]->gen = q->batch_gen;
+  }
+}
+
+int srsran_pdcch_decode_batch_yx(srsran_pdcch_t*              q,
+                                 srsran_dl_sf_cfg_t*          sf,
+                                 srsran_dci_cfg_t*            dci_cfg,
+                                 srsran_dci_format_t          format,
+                                 const srsran_dci_location_t* locations,
+                                 uint32_t                     nof_locations)
+{
+  if (q == NULL || sf == NULL || dci_cfg == NULL || (locations == NULL && nof_locations > 0)) {
+    return SRSRAN_ERROR_INVALID_INPUTS;
+  }
+
+#ifdef LV_HAVE_SSE
+  uint32_t nof_bits = srsran_dci_format_sizeof(&q->cell, sf, dci_cfg, format);
+  if (nof_bits == 0 || nof_bits > SRSRAN_DCI_MAX_BITS) {
+    return 0;
+  }
+  int size_idx = pdcch_batch_size_idx(q, nof_bits, true);
+  if (size_idx < 0) {
+    return 0;
+  }
+
+  srsran_dci_location_t        lane_loc[SRSRAN_VITERBI_BATCH_MAX];
+  srsran_pdcch_batch_result_t* lane_res[SRSRAN_VITERBI_BATCH_MAX];
+  uint32_t                     nof_lanes   = 0;
+  uint32_t                     nof_decoded = 0;
+  float                        gate        = srsran_pdcch_llr_gate(q);
+
+  for (uint32_t i = 0; i < nof_locations; i++) {
+    srsran_dci_location_t loc = locations[i];
+    if (!srsran_dci_location_isvalid(&loc) ||
+        loc.ncce * 72 + PDCCH_FORMAT_NOF_BITS(loc.L) > NOF_CCE(sf->cfi) * 72) {
+      continue;
+    }
+    srsran_pdcch_batch_result_t* r = pdcch_batch_result(q, size_idx, &loc);
+    if (r == NULL || r->gen == q->batch_gen) {
+      continue;
+    }
+    if (pdcch_llr_gate_below(srsran_pdcch_cce_mean_llr(q, loc.ncce, loc.L), gate)) {
+      continue;
+    }
+
+    lane_loc[nof_lanes] = loc;
+    lane_res[nof_lanes] = r;
+    nof_lanes++;
+
+    if (nof_lanes == SRSRAN_VITERBI_BATCH_MAX) {
+      pdcch_batch_flush(q, lane_loc, lane_res, nof_lanes, nof_bits);
+      nof_decoded += nof_lanes;
+      nof_lanes = 0;
+    }
+  }
+  // A few candidates left are faster decoded one by one by srsran_pdcch_decode_msg_yx
+  if (nof_lanes >= PDCCH_BATCH_MIN_LANES) {
+    pdcch_batch_flush(q, lane_loc, lane_res, nof_lanes, nof_bits);
+    nof_decoded += nof_lanes;
+  }
+
+  return nof_decoded;
+#else
+  // Without SIMD the batch decoder is slower than decoding the candidates one by one
+  return 0;
+#endif
+}
 
 int srsran_pdcch_get_nof_cce_yx(srsran_pdcch_t* q, uint32_t cfi){
     return NOF_CCE(cfi);
@@ -521,17 +724,23 @@ int srsran_pdcch_decode_msg_yx(srsran_pdcch_t* q, srsran_dl_sf_cfg_t* sf, srsran
       uint32_t nof_bits = srsran_dci_format_sizeof(&q->cell, sf, dci_cfg, msg->format);
       uint32_t e_bits   = PDCCH_FORMAT_NOF_BITS(msg->location.L);
 
-      // Compute absolute mean of the LLRs
-      double mean = 0;
-      for (int i = 0; i < e_bits; i++) {
-        mean += fabsf(q->llr[msg->location.ncce * 72 + i]);
-      }
-      mean /= e_bits;
+      // Absolute mean of the LLRs from the CCE energy map
+      float mean = srsran_pdcch_cce_mean_llr(q, msg->location.ncce, msg->location.L);
 
       //if (mean > 0.4f) {
-      if (mean > LLR_RATIO) {
+      if (!pdcch_llr_gate_below(mean, srsran_pdcch_llr_gate(q))) {
         float decode_prob = 0;
-        ret = srsran_pdcch_dci_decode_yx(q, &q->llr[msg->location.ncce * 72], msg->payload, e_bits, nof_bits, &msg->rnti, &decode_prob);
+
+        // Use the result of srsran_pdcch_decode_batch_yx if the candidate has been decoded ahead
+        const srsran_pdcch_batch_result_t* r = pdcch_batch_lookup(q, &msg->location, nof_bits);
+        if (r != NULL) {
+          srsran_bit_unpack_vector(r->payload, msg->payload, nof_bits);
+          msg->rnti   = r->crc;
+          decode_prob = r->prob;
+        } else {
+          ret = srsran_pdcch_dci_decode_yx(
+              q, &q->llr[msg->location.ncce * 72], msg->payload, e_bits, nof_bits, &msg->rnti, &decode_prob);
+        }
         if (ret == SRSRAN_SUCCESS) {
           *prob = decode_prob;
           msg->nof_bits = nof_bits;
@@ -581,6 +790,214 @@ float srsran_pdcch_msg_corr(srsran_pdcch_t* q, srsran_dci_msg_t* msg)
   return cabsf(corr / nof_llr) * (float)M_SQRT1_2;
 }
 
+/* Computes the sum of |LLR| of each CCE and builds the higher aggregation levels as sums of pairs of the level below */
+static void pdcch_cce_energy_compute(srsran_pdcch_t* q, uint32_t nof_cce)
+{
+  uint32_t nof_blk_cce = SRSRAN_MIN(SRSRAN_CEIL(nof_cce, 8) * 8, q->max_cce);
+
+  for (uint32_t i = 0; i < nof_cce; i++) {
+    q->cce_energy[0][i] = srsran_vec_abs_acc_ff(&q->llr[i * 72], 72);
+  }
+  srsran_vec_f_zero(&q->cce_energy[0][nof_cce], nof_blk_cce - nof_cce);
+
+  for (uint32_t l = 1; l < SRSRAN_PDCCH_NOF_AGGREGATION_LEVELS; l++) {
+    for (uint32_t i = 0; i < (nof_blk_cce >> l); i++) {
+      q->cce_energy[l][i] = q->cce_energy[l - 1][2 * i] + q->cce_energy[l - 1][2 * i + 1];
+    }
+  }
+  q->nof_cce_energy = nof_cce;
+}
+
+float srsran_pdcch_cce_mean_llr(srsran_pdcch_t* q, uint32_t ncce, uint32_t L)
+{
+  if (q == NULL || L >= SRSRAN_PDCCH_NOF_AGGREGATION_LEVELS || ncce + PDCCH_FORMAT_NOF_CCE(L) > q->max_cce) {
+    return 0.0f;
+  }
+
+  // Candidates are aligned to their aggregation level, otherwise add up the CCEs
+  if (ncce % PDCCH_FORMAT_NOF_CCE(L) == 0) {
+    return q->cce_energy[L][ncce >> L] / PDCCH_FORMAT_NOF_BITS(L);
+  }
+  float sum = 0.0f;
+  for (uint32_t i = 0; i < PDCCH_FORMAT_NOF_CCE(L); i++) {
+    sum += q->cce_energy[0][ncce + i];
+  }
+  return sum / PDCCH_FORMAT_NOF_BITS(L);
+}
+
+uint32_t srsran_pdcch_cce_energy(srsran_pdcch_t* q, float* energy, uint32_t max_nof_cce)
+{
+  if (q == NULL || energy == NULL) {
+    return 0;
+  }
+
+  uint32_t nof_cce = SRSRAN_MIN(q->nof_cce_energy, max_nof_cce);
+  srsran_vec_sc_prod_fff(q->cce_energy[0], 1.0f / PDCCH_FORMAT_NOF_BITS(0), energy, nof_cce);
+  return nof_cce;
+}
+
+static void pdcch_llr_gate_lock(srsran_pdcch_t* q)
+{
+  if (q->llr_gate_mutex != NULL) {
+    pthread_mutex_lock(q->llr_gate_mutex);
+  }
+}
+
+static void pdcch_llr_gate_unlock(srsran_pdcch_t* q)
+{
+  if (q->llr_gate_mutex != NULL) {
+    pthread_mutex_unlock(q->llr_gate_mutex);
+  }
+}
+
+void srsran_pdcch_llr_gate_reset(srsran_pdcch_llr_gate_t* gate)
+{
+  if (gate == NULL) {
+    return;
+  }
+  ZERO_OBJECT(*gate);
+  gate->mode      = SRSRAN_PDCCH_LLR_GATE_FIXED;
+  gate->threshold = LLR_RATIO;
+}
+
+void srsran_pdcch_llr_gate_set_mode(srsran_pdcch_t* q, srsran_pdcch_llr_gate_mode_t mode)
+{
+  if (q == NULL) {
+    return;
+  }
+  pdcch_llr_gate_lock(q);
+  q->llr_gate->mode = mode;
+  pdcch_llr_gate_unlock(q);
+}
+
+void srsran_pdcch_llr_gate_share(srsran_pdcch_t* q, srsran_pdcch_llr_gate_t* gate, pthread_mutex_t* mutex)
+{
+  if (q == NULL) {
+    return;
+  }
+  q->llr_gate       = gate != NULL ? gate : &q->llr_gate_own;
+  q->llr_gate_mutex = gate != NULL ? mutex : NULL;
+}
+
+float srsran_pdcch_llr_gate(srsran_pdcch_t* q)
+{
+  float gate = LLR_RATIO;
+  pdcch_llr_gate_lock(q);
+  if (q->llr_gate->mode == SRSRAN_PDCCH_LLR_GATE_ADAPTIVE && q->llr_gate->nof_updates >= PDCCH_LLR_GATE_WARMUP) {
+    gate = q->llr_gate->threshold;
+  }
+  pdcch_llr_gate_unlock(q);
+  return gate;
+}
+
+bool srsran_pdcch_llr_gate_pass(srsran_pdcch_t* q, float mean_llr)
+{
+  q->llr_gate_stats.nof_candidates++;
+  if (pdcch_llr_gate_below(mean_llr, srsran_pdcch_llr_gate(q))) {
+    q->llr_gate_stats.nof_gated++;
+    return false;
+  }
+  return true;
+}
+
+// Learns the gate from the mean |LLR| (and its mean square) of the idle CCEs of one subframe
+static void pdcch_llr_gate_learn(srsran_pdcch_llr_gate_t* g, float mean, float mean2, float noise)
+{
+  float var = SRSRAN_MAX(mean2 - mean * mean, 0.0f);
+
+  // Plain average during the warm-up, exponential average afterwards
+  float alpha = SRSRAN_MAX(1.0f / (g->nof_updates + 1), PDCCH_LLR_GATE_ALPHA);
+  g->idle_mean += alpha * (mean - g->idle_mean);
+  g->idle_var += alpha * (var - g->idle_var);
+  if (noise > 0.0f) {
+    g->noise = (g->noise > 0.0f && g->nof_updates > 0) ? g->noise + alpha * (noise - g->noise) : noise;
+  }
+  g->nof_updates++;
+
+  // The gate never goes under the expected mean |LLR| of noise
+  float threshold = g->idle_mean + PDCCH_LLR_GATE_K * sqrtf(g->idle_var);
+  if (g->noise > 0.0f) {
+    threshold = SRSRAN_MAX(threshold, sqrtf(2.0f * (float)M_1_PI * g->noise));
+  }
+  g->threshold = SRSRAN_MIN(SRSRAN_MAX(threshold, PDCCH_LLR_GATE_MIN), PDCCH_LLR_GATE_MAX);
+}
+
+int srsran_pdcch_llr_gate_update(srsran_pdcch_t*              q,
+                                 const srsran_chest_dl_res_t* channel,
+                                 const srsran_dci_location_t* locations,
+                                 uint32_t                     nof_locations)
+{
+  if (q == NULL || (locations == NULL && nof_locations > 0)) {
+    return SRSRAN_ERROR_INVALID_INPUTS;
+  }
+  srsran_pdcch_llr_gate_t* g = q->llr_gate;
+
+  q->llr_gate_stats.nof_sf++;
+  q->llr_gate_stats.nof_detected += nof_locations;
+
+  pdcch_llr_gate_lock(q);
+  bool adaptive = g->mode == SRSRAN_PDCCH_LLR_GATE_ADAPTIVE;
+  pdcch_llr_gate_unlock(q);
+
+  uint32_t nof_cce = q->nof_cce_energy;
+  if (!adaptive || nof_cce == 0) {
+    return SRSRAN_SUCCESS;
+  }
+
+  // Equalized noise variance. The LLRs of a CCE without DCI are noise only, their mean |LLR| is sqrt(2 / pi * noise)
+  float noise = 0.0f;
+  if (channel != NULL && isnormal(channel->noise_estimate) && isnormal(channel->rsrp)) {
+    noise = channel->noise_estimate / channel->rsrp;
+  }
+
+  // Mark the CCEs of the DCIs found
+  memset(q->cce_used, 0, nof_cce);
+  for (uint32_t i = 0; i < nof_locations; i++) {
+    for (uint32_t j = locations[i].ncce; j < locations[i].ncce + PDCCH_FORMAT_NOF_CCE(locations[i].L) && j < nof_cce;
+         j++) {
+      q->cce_used[j] = 1;
+    }
+  }
+
+  // Statistics of the remaining CCEs. CCEs over the maximum gate likely carry a DCI we could not decode
+  float    sum = 0.0f, sum2 = 0.0f;
+  uint32_t n   = 0;
+  for (uint32_t i = 0; i < nof_cce; i++) {
+    float e = q->cce_energy[0][i] / PDCCH_FORMAT_NOF_BITS(0);
+    if (!q->cce_used[i] && e < PDCCH_LLR_GATE_MAX) {
+      sum += e;
+      sum2 += e * e;
+      n++;
+    }
+  }
+
+  // The statistics above are ours, the gate may be shared with the other receivers of the cell
+  pdcch_llr_gate_lock(q);
+  if (noise > 0.0f && g->noise > 0.0f &&
+      fabsf(srsran_convert_power_to_dB(noise / g->noise)) > PDCCH_LLR_GATE_NOISE_JUMP_DB) {
+    g->nof_updates = 0;
+  }
+  if (n >= 2) {
+    pdcch_llr_gate_learn(g, sum / n, sum2 / n, noise);
+  }
+  pdcch_llr_gate_unlock(q);
+
+  return SRSRAN_SUCCESS;
+}
+
+void srsran_pdcch_llr_gate_stats(srsran_pdcch_t* q, srsran_pdcch_llr_gate_stats_t* stats, bool reset)
+{
+  if (q == NULL) {
+    return;
+  }
+  if (stats != NULL) {
+    *stats = q->llr_gate_stats;
+  }
+  if (reset) {
+    ZERO_OBJECT(q->llr_gate_stats);
+  }
+}
+
 /** Performs PDCCH receiver processing to extract LLR for all control region. LLR bits are stored in srsran_pdcch_t
  * object. DCI can be decoded from given locations in successive calls to srsran_pdcch_decode_msg()
  */
@@ -644,6 +1061,16 @@ int srsran_pdcch_extract_llr(srsran_pdcch_t*        q,
     /* descramble */
     srsran_scrambling_f_offset(&q->seq[sf->tti % 10], q->llr, 0, e_bits);
 
+    /* CCE energy map for the candidate screening */
+    pdcch_cce_energy_compute(q, NOF_CCE(sf->cfi));
+
+    /* Drop the batch results of the previous LLRs */
+    q->nof_batch_sizes = 0;
+    if (++q->batch_gen == 0) {
+      memset(q->batch_results, 0, sizeof(srsran_pdcch_batch_result_t) * PDCCH_BATCH_NOF_RESULTS(q));
+      q->batch_gen = 1;
+    }
+
     ret = SRSRAN_SUCCESS;
   }
   return ret;
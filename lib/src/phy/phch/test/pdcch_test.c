@@ -167,6 +167,59 @@ static int assert_payload_size(const srsran_cell_t* cell, srsran_dl_sf_cfg_t* dl
   return 0;
 }
 
+// The CCE energy map must match the mean |LLR| computed directly from the LLRs
+static int assert_cce_energy(srsran_pdcch_t* q, const srsran_dci_location_t* locations, uint32_t nof_locations)
+{
+  for (uint32_t i = 0; i < nof_locations; i++) {
+    uint32_t E    = 72U << locations[i].L;
+    float    gold = 0.0f;
+    for (uint32_t j = 0; j < E; j++) {
+      gold += fabsf(q->llr[locations[i].ncce * 72 + j]);
+    }
+    gold /= E;
+
+    float mean = srsran_pdcch_cce_mean_llr(q, locations[i].ncce, locations[i].L);
+    TESTASSERT(fabsf(mean - gold) <= 1e-4f * SRSRAN_MAX(gold, 1.0f));
+  }
+
+  float energy[SRSRAN_MAX_PRB] = {};
+  TESTASSERT(srsran_pdcch_cce_energy(q, energy, SRSRAN_MAX_PRB) == q->nof_cce[cfi - 1]);
+
+  return SRSRAN_SUCCESS;
+}
+
+// The adaptive LLR gate must keep the transmitted candidate while it learns from the CCEs left empty
+static int assert_llr_gate(srsran_pdcch_t* q, const srsran_dci_location_t* location)
+{
+  float gate = srsran_pdcch_llr_gate(q);
+  TESTASSERT(gate > 0.0f && gate < 1.0f);
+  TESTASSERT(srsran_pdcch_llr_gate_pass(q, srsran_pdcch_cce_mean_llr(q, location->ncce, location->L)));
+  TESTASSERT(srsran_pdcch_llr_gate_update(q, &chest_dl_res, location, 1) == SRSRAN_SUCCESS);
+
+  return SRSRAN_SUCCESS;
+}
+
+// The candidates decoded together must give back the transmitted DCI through srsran_pdcch_decode_msg_yx
+static int assert_decode_batch(srsran_pdcch_t*              q,
+                               srsran_dl_sf_cfg_t*          dl_sf,
+                               const srsran_dci_msg_t*      dci_tx,
+                               const srsran_dci_location_t* locations,
+                               uint32_t                     nof_locations)
+{
+  TESTASSERT(srsran_pdcch_decode_batch_yx(q, dl_sf, &dci_cfg, dci_tx->format, locations, nof_locations) >= 0);
+
+  srsran_dci_msg_t dci_rx = {};
+  float            prob   = 0.0f;
+  dci_rx.location         = dci_tx->location;
+  dci_rx.format           = dci_tx->format;
+  TESTASSERT(srsran_pdcch_decode_msg_yx(q, dl_sf, &dci_cfg, &dci_rx, &prob) == SRSRAN_SUCCESS);
+  TESTASSERT(dci_rx.rnti == dci_tx->rnti);
+  TESTASSERT(memcmp(dci_tx->payload, dci_rx.payload, dci_tx->nof_bits) == 0);
+  TESTASSERT(prob > 50.0f);
+
+  return SRSRAN_SUCCESS;
+}
+
 static const srsran_dci_format_t formats[] = {SRSRAN_DCI_FORMAT0,
                                               SRSRAN_DCI_FORMAT1A,
                                               SRSRAN_DCI_FORMAT1,
@@ -261,6 +314,10 @@ static int test_case1()
         get_time_interval(t);
         t_llr_us += (size_t)(t[0].tv_sec * 1e6 + t[0].tv_usec);
 
+        TESTASSERT(assert_cce_energy(&pdcch_rx, locations, locations_count) == SRSRAN_SUCCESS);
+        TESTASSERT(assert_llr_gate(&pdcch_rx, &locations[loc]) == SRSRAN_SUCCESS);
+        TESTASSERT(assert_decode_batch(&pdcch_rx, &dl_sf_cfg, &dci_tx, locations, locations_count) == SRSRAN_SUCCESS);
+
         // Try decoding the PDCCH in all possible locations
         for (uint32_t loc_rx = 0; loc_rx < locations_count; loc_rx++) {
           // Skip location if:
@@ -404,6 +461,7 @@ int main(int argc, char** argv)
     ERROR("Error setting cell in PDCCH object");
     goto quit;
   }
+  srsran_pdcch_llr_gate_set_mode(&pdcch_rx, SRSRAN_PDCCH_LLR_GATE_ADAPTIVE);
 
   if (srsran_channel_awgn_init(&awgn, 0x1234) < SRSRAN_SUCCESS) {
     ERROR("Error init AWGN");
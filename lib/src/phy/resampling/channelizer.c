@@ -0,0 +1,267 @@
+/**
+ * Copyright 2013-2023 Software Radio Systems Limited
+ *
+ * This file is part of srsRAN.
+ *
+ * srsRAN is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsRAN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <complex.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "srsran/phy/resampling/channelizer.h"
+#include "srsran/phy/utils/debug.h"
+#include "srsran/phy/utils/vector.h"
+
+/**
+ * Raised cosine mask edges relative to the output sampling rate. The pass band covers the occupied bandwidth of
+ * every LTE bandwidth at its srsRAN sampling rate (e.g. 18 MHz of 23.04 MHz), the transition band ends at the
+ * output Nyquist frequency. A smooth transition keeps the impulse response short enough for the 50% overlap.
+ */
+#define CHANNELIZER_PASS_BAND 0.40
+#define CHANNELIZER_STOP_BAND 0.50
+
+/**
+ * Smallest forward DFT size
+ */
+#define CHANNELIZER_FFT_SIZE_MIN 64
+
+int srsran_channelizer_init(srsran_channelizer_t* q, double srate, uint32_t fft_size)
+{
+  if (q == NULL || srate <= 0.0 || fft_size < CHANNELIZER_FFT_SIZE_MIN || fft_size % 2 != 0) {
+    return SRSRAN_ERROR_INVALID_INPUTS;
+  }
+
+  SRSRAN_MEM_ZERO(q, srsran_channelizer_t, 1);
+
+  q->srate    = srate;
+  q->fft_size = fft_size;
+  q->hop      = fft_size / 2;
+
+  q->in_buffer = srsran_vec_cf_malloc(fft_size);
+  if (q->in_buffer == NULL) {
+    return SRSRAN_ERROR;
+  }
+
+  q->spectrum = srsran_vec_cf_malloc(fft_size);
+  if (q->spectrum == NULL) {
+    return SRSRAN_ERROR;
+  }
+
+  if (srsran_dft_plan_guru_c(&q->fft, fft_size, SRSRAN_DFT_FORWARD, q->in_buffer, q->spectrum, 1, 1, 1, 1, 1) !=
+      SRSRAN_SUCCESS) {
+    ERROR("Initialising DFT");
+    return SRSRAN_ERROR;
+  }
+
+  return SRSRAN_SUCCESS;
+}
+
+static void channelizer_channel_free(srsran_channelizer_channel_t* ch)
+{
+  if (ch->filter) {
+    free(ch->filter);
+  }
+  if (ch->rotation) {
+    free(ch->rotation);
+  }
+  if (ch->in_buffer) {
+    free(ch->in_buffer);
+  }
+  if (ch->out_buffer) {
+    free(ch->out_buffer);
+  }
+  if (ch->ifft_size > 0) {
+    srsran_dft_plan_free(&ch->ifft);
+  }
+  SRSRAN_MEM_ZERO(ch, srsran_channelizer_channel_t, 1);
+}
+
+int srsran_channelizer_set_channel(srsran_channelizer_t* q, uint32_t ch_idx, double offset_hz, double srate)
+{
+  if (q == NULL || ch_idx >= SRSRAN_CHANNELIZER_MAX_CHANNELS || srate <= 0.0) {
+    return SRSRAN_ERROR_INVALID_INPUTS;
+  }
+
+  // The output rate must be a multiple of the bin spacing
+  double   bins      = (double)q->fft_size * srate / q->srate;
+  uint32_t ifft_size = (uint32_t)round(bins);
+  if (fabs(bins - (double)ifft_size) > 1e-6 || ifft_size < 2 || ifft_size % 2 != 0 || ifft_size > q->fft_size) {
+    ERROR("Output rate %.3f MHz does not fit in a %d point DFT at %.3f MHz",
+          srate / 1e6,
+          q->fft_size,
+          q->srate / 1e6);
+    return SRSRAN_ERROR_INVALID_INPUTS;
+  }
+
+  // The channel must be inside the captured band
+  if (fabs(offset_hz) + srate / 2.0 > q->srate / 2.0) {
+    ERROR("Channel at %+.3f MHz (%.3f MHz wide) is outside the captured %.3f MHz",
+          offset_hz / 1e6,
+          srate / 1e6,
+          q->srate / 1e6);
+    return SRSRAN_ERROR_INVALID_INPUTS;
+  }
+
+  srsran_channelizer_channel_t* ch = &q->channels[ch_idx];
+
+  // Reallocate only if the output rate changes
+  if (ch->ifft_size != ifft_size) {
+    channelizer_channel_free(ch);
+
+    ch->filter     = srsran_vec_f_malloc(ifft_size);
+    ch->rotation   = srsran_vec_cf_malloc(ifft_size / 2);
+    ch->in_buffer  = srsran_vec_cf_malloc(ifft_size);
+    ch->out_buffer = srsran_vec_cf_malloc(ifft_size);
+    if (ch->filter == NULL || ch->rotation == NULL || ch->in_buffer == NULL || ch->out_buffer == NULL) {
+      channelizer_channel_free(ch);
+      return SRSRAN_ERROR;
+    }
+
+    if (srsran_dft_plan_guru_c(
+            &ch->ifft, ifft_size, SRSRAN_DFT_BACKWARD, ch->in_buffer, ch->out_buffer, 1, 1, 1, 1, 1) !=
+        SRSRAN_SUCCESS) {
+      ERROR("Initialising DFT");
+      channelizer_channel_free(ch);
+      return SRSRAN_ERROR;
+    }
+    ch->ifft_size = ifft_size;
+
+    // Raised cosine mask in DFT order, the 1/fft_size normalisation of the forward DFT is folded in
+    double bin_hz = q->srate / (double)q->fft_size;
+    for (uint32_t i = 0; i < ifft_size; i++) {
+      int32_t k = (i < ifft_size / 2) ? (int32_t)i : (int32_t)i - (int32_t)ifft_size;
+      double  f = fabs((double)k * bin_hz) / srate;
+      double  h = 0.0;
+      if (f <= CHANNELIZER_PASS_BAND) {
+        h = 1.0;
+      } else if (f < CHANNELIZER_STOP_BAND) {
+        h = 0.5 * (1.0 + cos(M_PI * (f - CHANNELIZER_PASS_BAND) / (CHANNELIZER_STOP_BAND - CHANNELIZER_PASS_BAND)));
+      }
+      ch->filter[i] = (float)(h / (double)q->fft_size);
+    }
+  }
+
+  // Integer part of the shift in the forward DFT, the remainder is corrected on the output samples
+  ch->offset_hz  = offset_hz;
+  ch->srate      = srate;
+  ch->bin_offset = (int32_t)round(offset_hz * (double)q->fft_size / q->srate);
+  ch->residual   = (offset_hz - (double)ch->bin_offset * q->srate / (double)q->fft_size) / srate;
+  for (uint32_t i = 0; i < ifft_size / 2; i++) {
+    ch->rotation[i] = cexpf(-I * (float)(2.0 * M_PI * ch->residual * (double)i));
+  }
+  ch->enabled = true;
+
+  return SRSRAN_SUCCESS;
+}
+
+void srsran_channelizer_disable_channel(srsran_channelizer_t* q, uint32_t ch_idx)
+{
+  if (q != NULL && ch_idx < SRSRAN_CHANNELIZER_MAX_CHANNELS) {
+    q->channels[ch_idx].enabled = false;
+  }
+}
+
+uint32_t srsran_channelizer_block_out(const srsran_channelizer_t* q, uint32_t ch_idx)
+{
+  if (q == NULL || ch_idx >= SRSRAN_CHANNELIZER_MAX_CHANNELS || !q->channels[ch_idx].enabled) {
+    return 0;
+  }
+  return q->channels[ch_idx].ifft_size / 2;
+}
+
+// Copies len bins starting at start (it can be negative) from a circular spectrum of size n
+static void channelizer_copy_bins(cf_t* dst, const cf_t* spectrum, uint32_t n, int32_t start, uint32_t len)
+{
+  uint32_t idx = (uint32_t)(((start % (int32_t)n) + (int32_t)n) % (int32_t)n);
+  while (len > 0) {
+    uint32_t count = SRSRAN_MIN(len, n - idx);
+    srsran_vec_cf_copy(dst, &spectrum[idx], count);
+    dst += count;
+    len -= count;
+    idx = 0;
+  }
+}
+
+static void channelizer_run_channel(srsran_channelizer_t* q, srsran_channelizer_channel_t* ch, uint64_t block, cf_t* out)
+{
+  uint32_t half = ch->ifft_size / 2;
+
+  // Move the channel center to DC: positive frequencies first, then the negative ones
+  channelizer_copy_bins(&ch->in_buffer[0], q->spectrum, q->fft_size, ch->bin_offset, half);
+  channelizer_copy_bins(&ch->in_buffer[half], q->spectrum, q->fft_size, ch->bin_offset - (int32_t)half, half);
+
+  srsran_vec_prod_cfc(ch->in_buffer, ch->filter, ch->in_buffer, ch->ifft_size);
+  srsran_dft_run_guru_c(&ch->ifft);
+
+  // Phase of the block: the bin shift turns by pi * bin_offset every hop, the residual by its own frequency
+  double cycles = ch->residual * (double)(block * half);
+  cycles -= floor(cycles);
+  cf_t phase = cexpf(-I * (float)(2.0 * M_PI * cycles));
+  if ((ch->bin_offset & 1) && (block & 1)) {
+    phase = -phase;
+  }
+
+  // The zero phase mask spreads both ways, keep the middle half of the circular output
+  srsran_vec_prod_ccc(&ch->out_buffer[half / 2], ch->rotation, out, half);
+  srsran_vec_sc_prod_ccc(out, phase, out, half);
+}
+
+void srsran_channelizer_run(srsran_channelizer_t* q,
+                            const cf_t*           input,
+                            uint32_t              nof_blocks,
+                            uint64_t              first_block,
+                            cf_t*                 output[SRSRAN_CHANNELIZER_MAX_CHANNELS])
+{
+  if (q == NULL || input == NULL || output == NULL) {
+    return;
+  }
+
+  for (uint32_t b = 0; b < nof_blocks; b++) {
+    srsran_vec_cf_copy(q->in_buffer, &input[b * q->hop], q->fft_size);
+    srsran_dft_run_guru_c(&q->fft);
+
+    for (uint32_t c = 0; c < SRSRAN_CHANNELIZER_MAX_CHANNELS; c++) {
+      srsran_channelizer_channel_t* ch = &q->channels[c];
+      if (ch->enabled && output[c] != NULL) {
+        channelizer_run_channel(q, ch, first_block + b, &output[c][b * (ch->ifft_size / 2)]);
+      }
+    }
+  }
+}
+
+void srsran_channelizer_free(srsran_channelizer_t* q)
+{
+  if (q == NULL) {
+    return;
+  }
+
+  for (uint32_t c = 0; c < SRSRAN_CHANNELIZER_MAX_CHANNELS; c++) {
+    channelizer_channel_free(&q->channels[c]);
+  }
+  if (q->in_buffer) {
+    free(q->in_buffer);
+  }
+  if (q->spectrum) {
+    free(q->spectrum);
+  }
+  if (q->fft_size > 0) {
+    srsran_dft_plan_free(&q->fft);
+  }
+  SRSRAN_MEM_ZERO(q, srsran_channelizer_t, 1);
+}
@@ -0,0 +1,215 @@
+/**
+ * Copyright 2013-2023 Software Radio Systems Limited
+ *
+ * This file is part of srsRAN.
+ *
+ * srsRAN is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsRAN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include "srsran/phy/io/filesink.h"
+#include "srsran/phy/resampling/channelizer.h"
+#include "srsran/phy/utils/debug.h"
+#include "srsran/phy/utils/vector.h"
+#include <complex.h>
+#include <getopt.h>
+#include <math.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#define NOF_CHANNELS 3
+
+static double   srate      = 30.72e6;
+static uint32_t fft_size   = 4096;
+static double   srate_out  = 1.92e6;
+static uint32_t nof_blocks = 200;
+static char*    output_file = NULL;
+
+// Channel centers (not on the bin grid) and one test tone inside each channel
+static const double channel_offset[NOF_CHANNELS] = {-10.0e6, 0.3e6, 9.95e6};
+static const double tone_offset[NOF_CHANNELS]    = {100e3, -250e3, 420e3};
+static const float  tone_amplitude[NOF_CHANNELS] = {1.0f, 0.5f, 0.1f};
+
+static void usage(char* prog)
+{
+  printf("Usage: %s [sfbo]\n", prog);
+  printf("\t-s Input sampling rate [Default %.2f MHz]\n", srate / 1e6);
+  printf("\t-f Forward DFT size [Default %d]\n", fft_size);
+  printf("\t-r Output sampling rate [Default %.2f MHz]\n", srate_out / 1e6);
+  printf("\t-b Number of blocks [Default %d]\n", nof_blocks);
+  printf("\t-o Write the synthetic multi-carrier input to this file [Default none]\n");
+}
+
+static void parse_args(int argc, char** argv)
+{
+  int opt;
+  while ((opt = getopt(argc, argv, "sfrbov")) != -1) {
+    switch (opt) {
+      case 's':
+        srate = strtod(argv[optind], NULL);
+        break;
+      case 'f':
+        fft_size = (uint32_t)strtol(argv[optind], NULL, 10);
+        break;
+      case 'r':
+        srate_out = strtod(argv[optind], NULL);
+        break;
+      case 'b':
+        nof_blocks = (uint32_t)strtol(argv[optind], NULL, 10);
+        break;
+      case 'o':
+        output_file = argv[optind];
+        break;
+      case 'v':
+        increase_srsran_verbose_level();
+        break;
+      default:
+        usage(argv[0]);
+        exit(-1);
+    }
+  }
+}
+
+// Returns the SNR in dB of the output of one channel against its tone
+static float check_channel(const cf_t* out, uint32_t nsamples, uint32_t ch)
+{
+  // Estimate the complex gain of the tone
+  cf_t   gain = 0;
+  double freq = tone_offset[ch] / srate_out;
+  for (uint32_t i = 0; i < nsamples; i++) {
+    gain += out[i] * cexpf(-I * (float)(2.0 * M_PI * fmod(freq * (double)i, 1.0)));
+  }
+  gain /= (float)nsamples;
+
+  // Everything else is error: discontinuities, leakage of the other channels, wrong frequency
+  double err = 0;
+  for (uint32_t i = 0; i < nsamples; i++) {
+    cf_t e = out[i] - gain * cexpf(I * (float)(2.0 * M_PI * fmod(freq * (double)i, 1.0)));
+    err += crealf(e) * crealf(e) + cimagf(e) * cimagf(e);
+  }
+  err /= (double)nsamples;
+
+  float snr = srsran_convert_power_to_dB(cabsf(gain) * cabsf(gain) / (float)err);
+  printf("channel %d: %+.3f MHz amplitude %.3f (expected %.3f) snr %.1f dB\n",
+         ch,
+         channel_offset[ch] / 1e6,
+         cabsf(gain),
+         tone_amplitude[ch],
+         snr);
+
+  if (fabsf(cabsf(gain) - tone_amplitude[ch]) > 0.01f * tone_amplitude[ch]) {
+    return 0;
+  }
+  return snr;
+}
+
+int main(int argc, char** argv)
+{
+  int                  ret = SRSRAN_ERROR;
+  srsran_channelizer_t chan[2];
+  struct timeval       t[3] = {};
+
+  parse_args(argc, argv);
+
+  if (srsran_channelizer_init(&chan[0], srate, fft_size) || srsran_channelizer_init(&chan[1], srate, fft_size)) {
+    ERROR("Initialising channelizer");
+    return SRSRAN_ERROR;
+  }
+  for (uint32_t c = 0; c < NOF_CHANNELS; c++) {
+    if (srsran_channelizer_set_channel(&chan[0], c, channel_offset[c], srate_out) ||
+        srsran_channelizer_set_channel(&chan[1], c, channel_offset[c], srate_out)) {
+      ERROR("Setting channel %d", c);
+      return SRSRAN_ERROR;
+    }
+  }
+
+  uint32_t hop       = chan[0].hop;
+  uint32_t block_out = srsran_channelizer_block_out(&chan[0], 0);
+  uint32_t nsamples  = (nof_blocks + 1) * hop;
+  uint32_t nof_out   = nof_blocks * block_out;
+
+  // Synthetic capture: one tone in each channel
+  cf_t* input = srsran_vec_cf_malloc(nsamples);
+  srsran_vec_cf_zero(input, nsamples);
+  for (uint32_t c = 0; c < NOF_CHANNELS; c++) {
+    double f = (channel_offset[c] + tone_offset[c]) / srate;
+    for (uint32_t i = 0; i < nsamples; i++) {
+      input[i] += tone_amplitude[c] * cexpf(I * (float)(2.0 * M_PI * fmod(f * (double)i, 1.0)));
+    }
+  }
+
+  if (output_file) {
+    srsran_filesink_t sink = {};
+    if (srsran_filesink_init(&sink, output_file, SRSRAN_COMPLEX_FLOAT_BIN) == SRSRAN_SUCCESS) {
+      srsran_filesink_write(&sink, input, (int)nsamples);
+      srsran_filesink_free(&sink);
+      printf("Wrote %d samples at %.2f MHz to %s\n", nsamples, srate / 1e6, output_file);
+    }
+  }
+
+  cf_t* output[2][SRSRAN_CHANNELIZER_MAX_CHANNELS] = {};
+  for (uint32_t c = 0; c < NOF_CHANNELS; c++) {
+    output[0][c] = srsran_vec_cf_malloc(nof_out);
+    output[1][c] = srsran_vec_cf_malloc(nof_out);
+  }
+
+  // Whole stream at once
+  gettimeofday(&t[1], NULL);
+  srsran_channelizer_run(&chan[0], input, nof_blocks, 0, output[0]);
+  gettimeofday(&t[2], NULL);
+  get_time_interval(t);
+  printf("Channelized %d samples in %ld us (%.1f Msps)\n",
+         nsamples,
+         t[0].tv_sec * 1000000 + t[0].tv_usec,
+         (double)nsamples / (double)(t[0].tv_sec * 1000000 + t[0].tv_usec));
+
+  // Same stream in two chunks by another channelizer, as done by parallel workers
+  uint32_t split = nof_blocks / 2;
+  cf_t*    out_second[SRSRAN_CHANNELIZER_MAX_CHANNELS] = {};
+  for (uint32_t c = 0; c < NOF_CHANNELS; c++) {
+    out_second[c] = &output[1][c][split * block_out];
+  }
+  srsran_channelizer_run(&chan[1], input, split, 0, output[1]);
+  srsran_channelizer_run(&chan[1], &input[split * hop], nof_blocks - split, split, out_second);
+
+  bool pass = true;
+  for (uint32_t c = 0; c < NOF_CHANNELS; c++) {
+    // The first block only sees the zero history
+    float snr = check_channel(&output[0][c][block_out], nof_out - block_out, c);
+    if (snr < 40.0f) {
+      pass = false;
+    }
+    float mse = srsran_vec_avg_power_cf(output[0][c], nof_out);
+    srsran_vec_sub_ccc(output[0][c], output[1][c], output[1][c], nof_out);
+    float diff = srsran_vec_avg_power_cf(output[1][c], nof_out);
+    if (diff > 1e-9f * mse) {
+      printf("channel %d: chunked output differs (%e)\n", c, diff);
+      pass = false;
+    }
+  }
+
+  ret = pass ? SRSRAN_SUCCESS : SRSRAN_ERROR;
+  printf("%s\n", pass ? "Ok" : "Failed");
+
+  for (uint32_t c = 0; c < NOF_CHANNELS; c++) {
+    free(output[0][c]);
+    free(output[1][c]);
+  }
+  free(input);
+  srsran_channelizer_free(&chan[0]);
+  srsran_channelizer_free(&chan[1]);
+
+  return ret;
+}
@@ -62,6 +62,10 @@ static srsran_rf_plugin_t plugin_zmq   = {"", NULL, &srsran_rf_dev_zmq};
 #endif
 #endif
 
+/* Define implementation for the wideband capture, it only opens with a wideband= argument */
+#include "rf_wideband_imp.h"
+static srsran_rf_plugin_t plugin_wideband = {"", NULL, &srsran_rf_dev_wideband};
+
 /* Define implementation for file-based RF */
 #include "rf_file_imp.h"
 static srsran_rf_plugin_t plugin_file = {"", NULL, &srsran_rf_dev_file};
@@ -99,6 +103,7 @@ static srsran_rf_plugin_t plugin_dummy = {"", NULL, &srsran_rf_dev_dummy};
  */
 static srsran_rf_plugin_t* rf_plugins[] = {
 
+    &plugin_wideband,
 #ifdef ENABLE_UHD
     &plugin_uhd,
 #endif
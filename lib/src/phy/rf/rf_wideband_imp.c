@@ -0,0 +1,965 @@
+/**
+ * Copyright 2013-2023 Software Radio Systems Limited
+ *
+ * This file is part of srsRAN.
+ *
+ * srsRAN is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsRAN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include "rf_wideband_imp.h"
+#include "rf_helper.h"
+#include <math.h>
+#include <pthread.h>
+#include <srsran/phy/common/timestamp.h>
+#include <srsran/phy/io/filesource.h>
+#include <srsran/phy/resampling/channelizer.h>
+#include <srsran/phy/utils/debug.h>
+#include <srsran/phy/utils/ringbuffer.h>
+#include <srsran/phy/utils/vector.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define WIDEBAND_MAX_GROUPS 4
+#define WIDEBAND_MAX_WORKERS 16
+#define WIDEBAND_FFT_SIZE 4096
+#define WIDEBAND_NOF_WORKERS 2
+// DFT blocks handed to a worker at once
+#define WIDEBAND_BLOCKS_PER_CHUNK 16
+// Buffering of each carrier, at the highest LTE sampling rate
+#define WIDEBAND_RING_MS 50
+#define WIDEBAND_MAX_CARRIER_SRATE 30.72e6
+#define WIDEBAND_RECV_TIMEOUT_MS 1000
+// Overflow gaps the receive side has not reached yet
+#define WIDEBAND_MAX_GAPS 16
+
+typedef struct rf_wideband_group_s rf_wideband_group_t;
+
+typedef struct {
+  rf_wideband_group_t* group;
+  uint32_t             ch; // channel of the channelizer
+
+  // Carrier configuration, protected by the group mutex. Any change increments gen and drops the buffered samples
+  double   rx_freq;
+  double   srate;
+  uint32_t gen;
+  bool     streaming;
+
+  // Receive side
+  srsran_ringbuffer_t ring;
+  srsran_timestamp_t  ts_start; // time of the first buffered sample after a (re)configuration
+  bool                ts_valid;
+  uint64_t            nof_read;
+  uint32_t            nof_overflow;
+
+  // Samples dropped on overflow, the timestamps of the samples after a gap skip its length. Protected by the
+  // group mutex, the position of a gap is the number of samples written to the ring before it
+  uint64_t nof_written;
+  uint64_t nof_skipped;
+  uint64_t gap_pos[WIDEBAND_MAX_GAPS];
+  uint64_t gap_len[WIDEBAND_MAX_GAPS];
+  uint32_t nof_gaps;
+
+  srsran_rf_info_t          info;
+  srsran_rf_error_handler_t error_handler;
+  void*                     error_handler_arg;
+} rf_wideband_handler_t;
+
+typedef struct {
+  rf_wideband_group_t* group;
+  pthread_t            thread;
+  srsran_channelizer_t chan;
+  uint32_t             gen[SRSRAN_CHANNELIZER_MAX_CHANNELS]; // generation configured in chan, 0 if none
+  cf_t*                input;                                // history + chunk
+  cf_t*                output[SRSRAN_CHANNELIZER_MAX_CHANNELS];
+  uint64_t             chunk;
+  srsran_timestamp_t   ts; // time of the first new sample of the chunk
+  bool                 full;
+} rf_wideband_worker_t;
+
+struct rf_wideband_group_s {
+  char     name[RF_PARAM_LEN];
+  uint32_t nof_users;
+  double   center_freq;
+  double   srate;
+  double   gain;
+  bool     fixed_gain; // the AGC of the carriers is ignored
+  uint32_t fft_size;
+  uint32_t nof_workers;
+  uint32_t blocks_per_chunk;
+
+  // Source of the capture
+  bool                from_file;
+  srsran_rf_t         rf;
+  srsran_filesource_t file;
+
+  rf_wideband_handler_t* channels[SRSRAN_CHANNELIZER_MAX_CHANNELS];
+
+  pthread_mutex_t      mutex;
+  pthread_cond_t       cvar;
+  bool                 running;
+  bool                 eof;
+  pthread_t            capture_thread;
+  rf_wideband_worker_t workers[WIDEBAND_MAX_WORKERS];
+  uint64_t             next_write; // chunk whose outputs are written next
+};
+
+static rf_wideband_group_t* groups[WIDEBAND_MAX_GROUPS] = {};
+static pthread_mutex_t      groups_mutex                = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Capture and channelization
+ */
+
+static void* wideband_capture_thread(void* arg)
+{
+  rf_wideband_group_t* g         = (rf_wideband_group_t*)arg;
+  uint32_t             hop       = g->fft_size / 2;
+  uint32_t             chunk_len = g->blocks_per_chunk * hop;
+  cf_t*                history   = srsran_vec_cf_malloc(hop);
+  uint64_t             chunk     = 0;
+
+  if (history == NULL) {
+    return NULL;
+  }
+  srsran_vec_cf_zero(history, hop);
+
+  while (true) {
+    rf_wideband_worker_t* w = &g->workers[chunk % g->nof_workers];
+
+    // Wait for the worker to be done with its previous chunk
+    pthread_mutex_lock(&g->mutex);
+    while (w->full && g->running) {
+      pthread_cond_wait(&g->cvar, &g->mutex);
+    }
+    bool running = g->running;
+    pthread_mutex_unlock(&g->mutex);
+    if (!running) {
+      break;
+    }
+
+    srsran_vec_cf_copy(w->input, history, hop);
+    cf_t* ptr = &w->input[hop];
+
+    srsran_timestamp_t ts = {};
+    bool               eof = false;
+    if (g->from_file) {
+      int n = srsran_filesource_read(&g->file, ptr, (int)chunk_len);
+      if (n < (int)chunk_len) {
+        srsran_vec_cf_zero(&ptr[SRSRAN_MAX(n, 0)], chunk_len - SRSRAN_MAX(n, 0));
+        eof = true;
+      }
+      srsran_timestamp_init_uint64(&ts, chunk * chunk_len, g->srate);
+    } else {
+      uint32_t count = 0;
+      while (count < chunk_len && g->running) {
+        time_t secs = 0;
+        double frac = 0;
+        int    n    = srsran_rf_recv_with_time(&g->rf, &ptr[count], chunk_len - count, true, &secs, &frac);
+        if (n < 0) {
+          ERROR("[wideband] Error receiving from the radio");
+          eof = true;
+          break;
+        }
+        if (count == 0) {
+          srsran_timestamp_init(&ts, secs, frac);
+        }
+        count += (uint32_t)n;
+      }
+      if (srsran_timestamp_iszero(&ts)) {
+        // radios without time keep a sample count
+        srsran_timestamp_init_uint64(&ts, chunk * chunk_len, g->srate);
+      }
+    }
+    srsran_vec_cf_copy(history, &ptr[chunk_len - hop], hop);
+
+    pthread_mutex_lock(&g->mutex);
+    w->chunk = chunk;
+    w->ts    = ts;
+    w->full  = true;
+    if (eof) {
+      g->eof = true;
+    }
+    pthread_cond_broadcast(&g->cvar);
+    pthread_mutex_unlock(&g->mutex);
+
+    chunk++;
+    if (eof) {
+      printf("[wideband] %s: end of the capture after %" PRIu64 " chunks\n", g->name, chunk);
+      break;
+    }
+  }
+
+  free(history);
+  return NULL;
+}
+
+// Brings the channelizer of the worker to the configuration of the carriers, called without the group mutex
+static void wideband_worker_configure(rf_wideband_worker_t* w,
+                                      const bool            enabled[SRSRAN_CHANNELIZER_MAX_CHANNELS],
+                                      const double          offset[SRSRAN_CHANNELIZER_MAX_CHANNELS],
+                                      const double          srate[SRSRAN_CHANNELIZER_MAX_CHANNELS],
+                                      const uint32_t        gen[SRSRAN_CHANNELIZER_MAX_CHANNELS])
+{
+  uint32_t hop = w->group->fft_size / 2;
+
+  for (uint32_t c = 0; c < SRSRAN_CHANNELIZER_MAX_CHANNELS; c++) {
+    if (!enabled[c]) {
+      srsran_channelizer_disable_channel(&w->chan, c);
+      w->gen[c] = 0;
+      continue;
+    }
+    if (w->gen[c] == gen[c]) {
+      continue;
+    }
+    w->gen[c] = gen[c];
+    if (srsran_channelizer_set_channel(&w->chan, c, offset[c], srate[c]) != SRSRAN_SUCCESS) {
+      // the carrier stays silent until it is configured again
+      srsran_channelizer_disable_channel(&w->chan, c);
+      continue;
+    }
+    if (w->output[c] == NULL) {
+      w->output[c] = srsran_vec_cf_malloc(w->group->blocks_per_chunk * hop);
+      if (w->output[c] == NULL) {
+        srsran_channelizer_disable_channel(&w->chan, c);
+      }
+    }
+  }
+}
+
+// Drops the buffered samples, the next chunk written anchors the timestamps again. Called with the group mutex
+static void wideband_handler_reset(rf_wideband_handler_t* h)
+{
+  srsran_ringbuffer_reset(&h->ring);
+  h->ts_valid    = false;
+  h->nof_read    = 0;
+  h->nof_written = 0;
+  h->nof_skipped = 0;
+  h->nof_gaps    = 0;
+}
+
+// Called with the group mutex, in chunk order
+static void wideband_worker_write(rf_wideband_worker_t* w)
+{
+  rf_wideband_group_t* g = w->group;
+
+  for (uint32_t c = 0; c < SRSRAN_CHANNELIZER_MAX_CHANNELS; c++) {
+    rf_wideband_handler_t* h         = g->channels[c];
+    uint32_t               block_out = srsran_channelizer_block_out(&w->chan, c);
+    if (h == NULL || !h->streaming || h->gen != w->gen[c] || block_out == 0) {
+      continue;
+    }
+
+    int nbytes = (int)(g->blocks_per_chunk * block_out * sizeof(cf_t));
+
+    // A file has no deadline, wait for the carrier to catch up
+    while (g->from_file && srsran_ringbuffer_space(&h->ring) < nbytes && g->running && h->streaming &&
+           h->gen == w->gen[c]) {
+      pthread_mutex_unlock(&g->mutex);
+      usleep(100);
+      pthread_mutex_lock(&g->mutex);
+    }
+    if (!h->streaming || h->gen != w->gen[c]) {
+      continue;
+    }
+
+    if (srsran_ringbuffer_space(&h->ring) < nbytes) {
+      h->nof_overflow++;
+      if (h->error_handler) {
+        srsran_rf_error_t error = {};
+        error.type              = SRSRAN_RF_ERROR_OVERFLOW;
+        h->error_handler(h->error_handler_arg, error);
+      }
+      // Successive drops make one gap. With no room left the gap is merged into the last one, the timestamps
+      // of the samples in between are then off until the receive side passes it
+      uint64_t nof_dropped = (uint64_t)g->blocks_per_chunk * block_out;
+      if (h->ts_valid) {
+        if (h->nof_gaps > 0 && (h->gap_pos[h->nof_gaps - 1] == h->nof_written || h->nof_gaps == WIDEBAND_MAX_GAPS)) {
+          h->gap_len[h->nof_gaps - 1] += nof_dropped;
+        } else {
+          h->gap_pos[h->nof_gaps] = h->nof_written;
+          h->gap_len[h->nof_gaps] = nof_dropped;
+          h->nof_gaps++;
+        }
+      }
+      continue;
+    }
+
+    if (!h->ts_valid) {
+      h->ts_start = w->ts;
+      h->ts_valid = true;
+    }
+    srsran_ringbuffer_write(&h->ring, w->output[c], nbytes);
+    h->nof_written += (uint64_t)g->blocks_per_chunk * block_out;
+  }
+}
+
+static void* wideband_worker_thread(void* arg)
+{
+  rf_wideband_worker_t* w = (rf_wideband_worker_t*)arg;
+  rf_wideband_group_t*  g = w->group;
+
+  bool     enabled[SRSRAN_CHANNELIZER_MAX_CHANNELS];
+  double   offset[SRSRAN_CHANNELIZER_MAX_CHANNELS];
+  double   srate[SRSRAN_CHANNELIZER_MAX_CHANNELS];
+  uint32_t gen[SRSRAN_CHANNELIZER_MAX_CHANNELS];
+
+  while (true) {
+    pthread_mutex_lock(&g->mutex);
+    while (!w->full && g->running) {
+      pthread_cond_wait(&g->cvar, &g->mutex);
+    }
+    if (!w->full) {
+      pthread_mutex_unlock(&g->mutex);
+      break;
+    }
+
+    // Snapshot of the carriers for this chunk
+    for (uint32_t c = 0; c < SRSRAN_CHANNELIZER_MAX_CHANNELS; c++) {
+      rf_wideband_handler_t* h = g->channels[c];
+      enabled[c]               = h != NULL && h->streaming && h->srate > 0 && h->rx_freq > 0;
+      offset[c]                = enabled[c] ? h->rx_freq - g->center_freq : 0;
+      srate[c]                 = enabled[c] ? h->srate : 0;
+      gen[c]                   = enabled[c] ? h->gen : 0;
+    }
+    pthread_mutex_unlock(&g->mutex);
+
+    wideband_worker_configure(w, enabled, offset, srate, gen);
+    srsran_channelizer_run(&w->chan, w->input, g->blocks_per_chunk, w->chunk * g->blocks_per_chunk, w->output);
+
+    // Outputs are written in the order of the capture
+    pthread_mutex_lock(&g->mutex);
+    while (g->next_write != w->chunk && g->running) {
+      pthread_cond_wait(&g->cvar, &g->mutex);
+    }
+    if (g->running) {
+      wideband_worker_write(w);
+    }
+    g->next_write = w->chunk + 1;
+    w->full       = false;
+    pthread_cond_broadcast(&g->cvar);
+    pthread_mutex_unlock(&g->mutex);
+  }
+
+  return NULL;
+}
+
+/*
+ * Groups
+ */
+
+static void wideband_group_free(rf_wideband_group_t* g)
+{
+  for (uint32_t i = 0; i < g->nof_workers; i++) {
+    rf_wideband_worker_t* w = &g->workers[i];
+    srsran_channelizer_free(&w->chan);
+    if (w->input) {
+      free(w->input);
+    }
+    for (uint32_t c = 0; c < SRSRAN_CHANNELIZER_MAX_CHANNELS; c++) {
+      if (w->output[c]) {
+        free(w->output[c]);
+      }
+    }
+  }
+  if (g->from_file) {
+    srsran_filesource_free(&g->file);
+  } else if (g->rf.handler) {
+    srsran_rf_close(&g->rf);
+  }
+  pthread_mutex_destroy(&g->mutex);
+  pthread_cond_destroy(&g->cvar);
+  free(g);
+}
+
+static rf_wideband_group_t* wideband_group_create(const char* name,
+                                                  double      center_freq,
+                                                  double      srate,
+                                                  double      gain,
+                                                  uint32_t    fft_size,
+                                                  uint32_t    nof_workers,
+                                                  const char* file,
+                                                  const char* device,
+                                                  char*       device_args)
+{
+  if (center_freq <= 0 || srate <= 0) {
+    ERROR("[wideband] Group %s: center_freq and srate are required", name);
+    return NULL;
+  }
+
+  rf_wideband_group_t* g = calloc(1, sizeof(rf_wideband_group_t));
+  if (g == NULL) {
+    return NULL;
+  }
+  strncpy(g->name, name, RF_PARAM_LEN - 1);
+  g->center_freq      = center_freq;
+  g->srate            = srate;
+  g->gain             = gain;
+  g->fixed_gain       = gain >= 0;
+  g->fft_size         = fft_size;
+  g->nof_workers      = SRSRAN_MAX(1, SRSRAN_MIN(nof_workers, WIDEBAND_MAX_WORKERS));
+  g->blocks_per_chunk = WIDEBAND_BLOCKS_PER_CHUNK;
+  pthread_mutex_init(&g->mutex, NULL);
+  pthread_cond_init(&g->cvar, NULL);
+
+  uint32_t hop = fft_size / 2;
+  for (uint32_t i = 0; i < g->nof_workers; i++) {
+    rf_wideband_worker_t* w = &g->workers[i];
+    w->group                = g;
+    w->input                = srsran_vec_cf_malloc((g->blocks_per_chunk + 1) * hop);
+    if (w->input == NULL || srsran_channelizer_init(&w->chan, srate, fft_size) != SRSRAN_SUCCESS) {
+      ERROR("[wideband] Group %s: error initialising the channelizer", name);
+      wideband_group_free(g);
+      return NULL;
+    }
+  }
+
+  // Open the source of the capture
+  if (file[0] != '\0') {
+    if (srsran_filesource_init(&g->file, file, SRSRAN_COMPLEX_FLOAT_BIN) != SRSRAN_SUCCESS) {
+      ERROR("[wideband] Group %s: error opening %s", name, file);
+      wideband_group_free(g);
+      return NULL;
+    }
+    g->from_file = true;
+  } else {
+    if (srsran_rf_open_devname(&g->rf, device, device_args, 1) != SRSRAN_SUCCESS) {
+      ERROR("[wideband] Group %s: error opening the radio", name);
+      g->rf.handler = NULL;
+      wideband_group_free(g);
+      return NULL;
+    }
+    double srate_rf = srsran_rf_set_rx_srate(&g->rf, srate);
+    if (srate_rf != srate) {
+      ERROR("[wideband] Group %s: the radio runs at %.3f MHz instead of %.3f MHz", name, srate_rf / 1e6, srate / 1e6);
+      wideband_group_free(g);
+      return NULL;
+    }
+    srsran_rf_set_rx_freq(&g->rf, 0, center_freq);
+    if (gain >= 0) {
+      srsran_rf_set_rx_gain(&g->rf, gain);
+    }
+  }
+
+  printf("[wideband] Group %s: %.3f MHz at %.3f MHz, %d point DFT (%.1f kHz grid), %d workers\n",
+         name,
+         srate / 1e6,
+         center_freq / 1e6,
+         fft_size,
+         srate / fft_size / 1e3,
+         g->nof_workers);
+  return g;
+}
+
+// Called with the group mutex
+static int wideband_group_start(rf_wideband_group_t* g)
+{
+  if (g->running) {
+    return SRSRAN_SUCCESS;
+  }
+  if (!g->from_file && srsran_rf_start_rx_stream(&g->rf, false) != SRSRAN_SUCCESS) {
+    return SRSRAN_ERROR;
+  }
+  g->running    = true;
+  g->next_write = 0;
+  for (uint32_t i = 0; i < g->nof_workers; i++) {
+    if (pthread_create(&g->workers[i].thread, NULL, wideband_worker_thread, &g->workers[i])) {
+      ERROR("[wideband] Error creating the worker threads");
+      return SRSRAN_ERROR;
+    }
+  }
+  if (pthread_create(&g->capture_thread, NULL, wideband_capture_thread, g)) {
+    ERROR("[wideband] Error creating the capture thread");
+    return SRSRAN_ERROR;
+  }
+  return SRSRAN_SUCCESS;
+}
+
+static void wideband_group_stop(rf_wideband_group_t* g)
+{
+  pthread_mutex_lock(&g->mutex);
+  bool running = g->running;
+  g->running   = false;
+  pthread_cond_broadcast(&g->cvar);
+  pthread_mutex_unlock(&g->mutex);
+
+  if (running) {
+    pthread_join(g->capture_thread, NULL);
+    for (uint32_t i = 0; i < g->nof_workers; i++) {
+      pthread_join(g->workers[i].thread, NULL);
+    }
+    if (!g->from_file) {
+      srsran_rf_stop_rx_stream(&g->rf);
+    }
+  }
+}
+
+/*
+ * Public methods
+ */
+
+const char* rf_wideband_devname(void* h)
+{
+  return DEVNAME_WIDEBAND;
+}
+
+int rf_wideband_start_rx_stream(void* h, bool now)
+{
+  rf_wideband_handler_t* handler = (rf_wideband_handler_t*)h;
+  rf_wideband_group_t*   g       = handler->group;
+
+  pthread_mutex_lock(&g->mutex);
+  wideband_handler_reset(handler);
+  handler->streaming = true;
+  handler->gen++;
+  int ret = wideband_group_start(g);
+  pthread_mutex_unlock(&g->mutex);
+
+  return ret;
+}
+
+int rf_wideband_stop_rx_stream(void* h)
+{
+  rf_wideband_handler_t* handler = (rf_wideband_handler_t*)h;
+
+  // The capture keeps running for the other carriers
+  pthread_mutex_lock(&handler->group->mutex);
+  handler->streaming = false;
+  pthread_mutex_unlock(&handler->group->mutex);
+  return SRSRAN_SUCCESS;
+}
+
+void rf_wideband_flush_buffer(void* h)
+{
+  rf_wideband_handler_t* handler = (rf_wideband_handler_t*)h;
+
+  pthread_mutex_lock(&handler->group->mutex);
+  wideband_handler_reset(handler);
+  pthread_mutex_unlock(&handler->group->mutex);
+}
+
+bool rf_wideband_has_rssi(void* h)
+{
+  return false;
+}
+
+float rf_wideband_get_rssi(void* h)
+{
+  return 0.0f;
+}
+
+void rf_wideband_suppress_stdout(void* h)
+{
+  // do nothing
+}
+
+void rf_wideband_register_error_handler(void* h, srsran_rf_error_handler_t error_handler, void* arg)
+{
+  rf_wideband_handler_t* handler = (rf_wideband_handler_t*)h;
+  handler->error_handler         = error_handler;
+  handler->error_handler_arg     = arg;
+}
+
+int rf_wideband_open(char* args, void** h)
+{
+  return rf_wideband_open_multi(args, h, 1);
+}
+
+int rf_wideband_open_multi(char* args, void** h, uint32_t nof_channels)
+{
+  // Only claim the devices meant for us, the auto mode tries every driver
+  if (h == NULL || args == NULL || strstr(args, DEVNAME_WIDEBAND "=") == NULL) {
+    return SRSRAN_ERROR;
+  }
+  if (nof_channels != 1) {
+    ERROR("[wideband] Only one antenna is supported, %d requested", nof_channels);
+    return SRSRAN_ERROR;
+  }
+
+  char buf[RF_PARAM_LEN * 4] = {};
+  strncpy(buf, args, sizeof(buf) - 1);
+
+  // The radio arguments take the rest of the string
+  char  device_args[RF_PARAM_LEN * 4] = {};
+  char* ptr                           = strstr(buf, "device_args=");
+  if (ptr != NULL) {
+    strncpy(device_args, ptr + strlen("device_args="), sizeof(device_args) - 1);
+    *ptr = '\0';
+  }
+
+  char     name[RF_PARAM_LEN]   = {};
+  char     file[RF_PARAM_LEN]   = {};
+  char     device[RF_PARAM_LEN] = {};
+  double   center_freq          = 0;
+  double   srate                = 0;
+  double   gain                 = -1;
+  uint32_t fft_size             = WIDEBAND_FFT_SIZE;
+  uint32_t nof_workers          = WIDEBAND_NOF_WORKERS;
+  parse_string(buf, DEVNAME_WIDEBAND, -1, name);
+  parse_string(buf, "file", -1, file);
+  parse_string(buf, "device", -1, device);
+  parse_double(buf, "center_freq", -1, &center_freq);
+  parse_double(buf, "srate", -1, &srate);
+  parse_double(buf, "gain", -1, &gain);
+  parse_uint32(buf, "fft_size", -1, &fft_size);
+  parse_uint32(buf, "workers", -1, &nof_workers);
+
+  pthread_mutex_lock(&groups_mutex);
+
+  // Find the group or create it
+  rf_wideband_group_t* g = NULL;
+  int                  free_idx = -1;
+  for (int i = 0; i < WIDEBAND_MAX_GROUPS; i++) {
+    if (groups[i] != NULL && strcmp(groups[i]->name, name) == 0) {
+      g = groups[i];
+      break;
+    }
+    if (groups[i] == NULL && free_idx < 0) {
+      free_idx = i;
+    }
+  }
+  if (g == NULL) {
+    if (free_idx < 0) {
+      ERROR("[wideband] Too many groups");
+      pthread_mutex_unlock(&groups_mutex);
+      return SRSRAN_ERROR;
+    }
+    g = wideband_group_create(name, center_freq, srate, gain, fft_size, nof_workers, file, device, device_args);
+    if (g == NULL) {
+      pthread_mutex_unlock(&groups_mutex);
+      return SRSRAN_ERROR;
+    }
+    groups[free_idx] = g;
+  }
+
+  rf_wideband_handler_t* handler = calloc(1, sizeof(rf_wideband_handler_t));
+  if (handler == NULL) {
+    pthread_mutex_unlock(&groups_mutex);
+    return SRSRAN_ERROR;
+  }
+  handler->group = g;
+
+  // Receive buffer for the widest carrier
+  double ring_srate = SRSRAN_MIN(g->srate, WIDEBAND_MAX_CARRIER_SRATE);
+  if (srsran_ringbuffer_init(&handler->ring, (int)(ring_srate * WIDEBAND_RING_MS / 1000) * sizeof(cf_t))) {
+    free(handler);
+    pthread_mutex_unlock(&groups_mutex);
+    return SRSRAN_ERROR;
+  }
+  if (!g->from_file) {
+    srsran_rf_info_t* info = srsran_rf_get_info(&g->rf);
+    if (info != NULL) {
+      handler->info = *info;
+    }
+  }
+
+  pthread_mutex_lock(&g->mutex);
+  int ch = -1;
+  for (int c = 0; c < SRSRAN_CHANNELIZER_MAX_CHANNELS; c++) {
+    if (g->channels[c] == NULL) {
+      ch = c;
+      break;
+    }
+  }
+  if (ch >= 0) {
+    handler->ch      = (uint32_t)ch;
+    g->channels[ch]  = handler;
+    g->nof_users++;
+  }
+  pthread_mutex_unlock(&g->mutex);
+  pthread_mutex_unlock(&groups_mutex);
+
+  if (ch < 0) {
+    ERROR("[wideband] Group %s: no channel left", g->name);
+    srsran_ringbuffer_free(&handler->ring);
+    free(handler);
+    return SRSRAN_ERROR;
+  }
+
+  printf("[wideband] Group %s: carrier %d attached\n", g->name, ch);
+  *h = handler;
+  return SRSRAN_SUCCESS;
+}
+
+int rf_wideband_close(void* h)
+{
+  rf_wideband_handler_t* handler = (rf_wideband_handler_t*)h;
+  rf_wideband_group_t*   g       = handler->group;
+
+  // Wake up a blocked receiver
+  srsran_ringbuffer_stop(&handler->ring);
+
+  pthread_mutex_lock(&groups_mutex);
+  pthread_mutex_lock(&g->mutex);
+  g->channels[handler->ch] = NULL;
+  bool last                = --g->nof_users == 0;
+  pthread_mutex_unlock(&g->mutex);
+
+  if (last) {
+    wideband_group_stop(g);
+    for (int i = 0; i < WIDEBAND_MAX_GROUPS; i++) {
+      if (groups[i] == g) {
+        groups[i] = NULL;
+      }
+    }
+    wideband_group_free(g);
+  }
+  pthread_mutex_unlock(&groups_mutex);
+
+  if (handler->nof_overflow > 0) {
+    printf("[wideband] carrier %d: %d overflows\n", handler->ch, handler->nof_overflow);
+  }
+  srsran_ringbuffer_free(&handler->ring);
+  free(handler);
+  return SRSRAN_SUCCESS;
+}
+
+double rf_wideband_set_rx_srate(void* h, double srate)
+{
+  rf_wideband_handler_t* handler = (rf_wideband_handler_t*)h;
+  rf_wideband_group_t*   g       = handler->group;
+
+  // The output rate must be on the grid of the channelizer
+  double bins = (double)g->fft_size * srate / g->srate;
+  if (srate > WIDEBAND_MAX_CARRIER_SRATE || fabs(bins - round(bins)) > 1e-6 || ((uint32_t)round(bins)) % 2 != 0) {
+    ERROR("[wideband] %.3f MHz is not a multiple of the %.3f kHz grid",
+          srate / 1e6,
+          2 * g->srate / g->fft_size / 1e3);
+    return handler->srate;
+  }
+
+  pthread_mutex_lock(&g->mutex);
+  handler->srate = srate;
+  handler->gen++;
+  wideband_handler_reset(handler);
+  pthread_mutex_unlock(&g->mutex);
+
+  return srate;
+}
+
+int rf_wideband_set_rx_gain(void* h, double gain)
+{
+  rf_wideband_handler_t* handler = (rf_wideband_handler_t*)h;
+  rf_wideband_group_t*   g       = handler->group;
+
+  // The gain is shared by all the carriers of the capture, a gain given in the arguments is kept
+  if (g->fixed_gain) {
+    return SRSRAN_SUCCESS;
+  }
+  g->gain = gain;
+  if (!g->from_file) {
+    return srsran_rf_set_rx_gain(&g->rf, gain);
+  }
+  return SRSRAN_SUCCESS;
+}
+
+int rf_wideband_set_rx_gain_ch(void* h, uint32_t ch, double gain)
+{
+  return rf_wideband_set_rx_gain(h, gain);
+}
+
+int rf_wideband_set_tx_gain(void* h, double gain)
+{
+  return SRSRAN_SUCCESS;
+}
+
+int rf_wideband_set_tx_gain_ch(void* h, uint32_t ch, double gain)
+{
+  return SRSRAN_SUCCESS;
+}
+
+double rf_wideband_get_rx_gain(void* h)
+{
+  rf_wideband_handler_t* handler = (rf_wideband_handler_t*)h;
+  rf_wideband_group_t*   g       = handler->group;
+
+  if (!g->from_file) {
+    return srsran_rf_get_rx_gain(&g->rf);
+  }
+  return g->gain;
+}
+
+double rf_wideband_get_tx_gain(void* h)
+{
+  return 0.0;
+}
+
+srsran_rf_info_t* rf_wideband_get_info(void* h)
+{
+  rf_wideband_handler_t* handler = (rf_wideband_handler_t*)h;
+  return &handler->info;
+}
+
+double rf_wideband_set_rx_freq(void* h, uint32_t ch, double freq)
+{
+  rf_wideband_handler_t* handler = (rf_wideband_handler_t*)h;
+  rf_wideband_group_t*   g       = handler->group;
+
+  if (fabs(freq - g->center_freq) > g->srate / 2) {
+    ERROR("[wideband] %.3f MHz is outside the capture %.3f MHz +/- %.3f MHz",
+          freq / 1e6,
+          g->center_freq / 1e6,
+          g->srate / 2e6);
+    return SRSRAN_ERROR;
+  }
+
+  pthread_mutex_lock(&g->mutex);
+  handler->rx_freq = freq;
+  handler->gen++;
+  wideband_handler_reset(handler);
+  pthread_mutex_unlock(&g->mutex);
+
+  return freq;
+}
+
+double rf_wideband_set_tx_srate(void* h, double srate)
+{
+  return srate;
+}
+
+double rf_wideband_set_tx_freq(void* h, uint32_t ch, double freq)
+{
+  return freq;
+}
+
+void rf_wideband_get_time(void* h, time_t* secs, double* frac_secs)
+{
+  rf_wideband_handler_t* handler = (rf_wideband_handler_t*)h;
+  rf_wideband_group_t*   g       = handler->group;
+
+  if (!g->from_file) {
+    srsran_rf_get_time(&g->rf, secs, frac_secs);
+    return;
+  }
+  if (secs) {
+    *secs = 0;
+  }
+  if (frac_secs) {
+    *frac_secs = 0;
+  }
+}
+
+int rf_wideband_recv_with_time(void* h, void* data, uint32_t nsamples, bool blocking, time_t* secs, double* frac_secs)
+{
+  rf_wideband_handler_t* handler = (rf_wideband_handler_t*)h;
+  rf_wideband_group_t*   g       = handler->group;
+  int                    nbytes  = (int)(nsamples * sizeof(cf_t));
+
+  if (!blocking && srsran_ringbuffer_status(&handler->ring) < nbytes) {
+    return 0;
+  }
+
+  int ret;
+  do {
+    ret = srsran_ringbuffer_read_timed(&handler->ring, data, nbytes, WIDEBAND_RECV_TIMEOUT_MS);
+  } while (ret == SRSRAN_ERROR_TIMEOUT && handler->streaming && !g->eof);
+
+  if (ret != nbytes) {
+    return SRSRAN_ERROR;
+  }
+
+  // Sample count since the first buffered sample, plus the samples dropped before the ones just read
+  pthread_mutex_lock(&g->mutex);
+  uint32_t nof_passed = 0;
+  while (nof_passed < handler->nof_gaps && handler->gap_pos[nof_passed] <= handler->nof_read) {
+    handler->nof_skipped += handler->gap_len[nof_passed];
+    nof_passed++;
+  }
+  if (nof_passed > 0) {
+    handler->nof_gaps -= nof_passed;
+    memmove(handler->gap_pos, &handler->gap_pos[nof_passed], handler->nof_gaps * sizeof(uint64_t));
+    memmove(handler->gap_len, &handler->gap_len[nof_passed], handler->nof_gaps * sizeof(uint64_t));
+  }
+  srsran_timestamp_t ts = handler->ts_start;
+  srsran_timestamp_add(&ts, 0, (double)(handler->nof_read + handler->nof_skipped) / handler->srate);
+  handler->nof_read += nsamples;
+  pthread_mutex_unlock(&g->mutex);
+  if (secs) {
+    *secs = ts.full_secs;
+  }
+  if (frac_secs) {
+    *frac_secs = ts.frac_secs;
+  }
+
+  return (int)nsamples;
+}
+
+int rf_wideband_recv_with_time_multi(void*    h,
+                                     void**   data,
+                                     uint32_t nsamples,
+                                     bool     blocking,
+                                     time_t*  secs,
+                                     double*  frac_secs)
+{
+  return rf_wideband_recv_with_time(h, data[0], nsamples, blocking, secs, frac_secs);
+}
+
+int rf_wideband_send_timed(void*  h,
+                           void*  data,
+                           int    nsamples,
+                           time_t secs,
+                           double frac_secs,
+                           bool   has_time_spec,
+                           bool   blocking,
+                           bool   is_start_of_burst,
+                           bool   is_end_of_burst)
+{
+  // receive only
+  return SRSRAN_ERROR;
+}
+
+int rf_wideband_send_timed_multi(void*  h,
+                                 void*  data[4],
+                                 int    nsamples,
+                                 time_t secs,
+                                 double frac_secs,
+                                 bool   has_time_spec,
+                                 bool   blocking,
+                                 bool   is_start_of_burst,
+                                 bool   is_end_of_burst)
+{
+  return SRSRAN_ERROR;
+}
+
+rf_dev_t srsran_rf_dev_wideband = {DEVNAME_WIDEBAND,
+                                   rf_wideband_devname,
+                                   rf_wideband_start_rx_stream,
+                                   rf_wideband_stop_rx_stream,
+                                   rf_wideband_flush_buffer,
+                                   rf_wideband_has_rssi,
+                                   rf_wideband_get_rssi,
+                                   rf_wideband_suppress_stdout,
+                                   rf_wideband_register_error_handler,
+                                   rf_wideband_open,
+                                   .srsran_rf_open_multi = rf_wideband_open_multi,
+                                   rf_wideband_close,
+                                   rf_wideband_set_rx_srate,
+                                   rf_wideband_set_rx_gain,
+                                   rf_wideband_set_rx_gain_ch,
+                                   rf_wideband_set_tx_gain,
+                                   rf_wideband_set_tx_gain_ch,
+                                   rf_wideband_get_rx_gain,
+                                   rf_wideband_get_tx_gain,
+                                   rf_wideband_get_info,
+                                   rf_wideband_set_rx_freq,
+                                   rf_wideband_set_tx_srate,
+                                   rf_wideband_set_tx_freq,
+                                   rf_wideband_get_time,
+                                   NULL,
+                                   rf_wideband_recv_with_time,
+                                   rf_wideband_recv_with_time_multi,
+                                   rf_wideband_send_timed,
+                                   .srsran_rf_send_timed_multi = rf_wideband_send_timed_multi};
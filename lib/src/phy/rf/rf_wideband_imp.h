@@ -0,0 +1,129 @@
+/**
+ * Copyright 2013-2023 Software Radio Systems Limited
+ *
+ * This file is part of srsRAN.
+ *
+ * srsRAN is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsRAN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#ifndef SRSRAN_RF_WIDEBAND_IMP_H
+#define SRSRAN_RF_WIDEBAND_IMP_H
+
+#include <inttypes.h>
+
+#include "srsran/config.h"
+#include "srsran/phy/common/phy_common.h"
+#include "srsran/phy/rf/rf.h"
+
+/**
+ * In-process RF device that serves several carriers from one wideband capture.
+ *
+ * Every carrier opens its own "wideband" device. The devices that name the same group share one capture: the first
+ * one opens the real radio (or an IQ file) at the group center frequency and sampling rate, a pool of workers
+ * channelizes the stream (see srsran/phy/resampling/channelizer.h) and each device receives its own carrier at the
+ * sampling rate it sets, as if it were a separate radio. Receive only, one antenna.
+ *
+ * Arguments, the group ones are taken from the first device of the group:
+ *   wideband=<group>      group name, required
+ *   center_freq=<Hz>      capture center frequency
+ *   srate=<Hz>            capture sampling rate
+ *   fft_size=<n>          channelizer DFT size, the carrier rates must be multiples of 2 * srate / fft_size
+ *   workers=<n>           channelizer threads
+ *   gain=<dB>             capture gain, the gain requests of the carriers (AGC) are then ignored
+ *   file=<path>           read the capture from a complex float IQ file instead of a radio
+ *   device=<name>         radio driver, auto if not given
+ *   device_args=<args>    radio arguments, must be the last argument since it takes the rest of the string
+ *
+ * e.g. "wideband=band3,center_freq=1842.5e6,srate=61.44e6,device=uhd,device_args=type=x300"
+ */
+
+#define DEVNAME_WIDEBAND "wideband"
+
+extern rf_dev_t srsran_rf_dev_wideband;
+
+SRSRAN_API const char* rf_wideband_devname(void* h);
+
+SRSRAN_API int rf_wideband_start_rx_stream(void* h, bool now);
+
+SRSRAN_API int rf_wideband_stop_rx_stream(void* h);
+
+SRSRAN_API void rf_wideband_flush_buffer(void* h);
+
+SRSRAN_API bool rf_wideband_has_rssi(void* h);
+
+SRSRAN_API float rf_wideband_get_rssi(void* h);
+
+SRSRAN_API void rf_wideband_suppress_stdout(void* h);
+
+SRSRAN_API void rf_wideband_register_error_handler(void* h, srsran_rf_error_handler_t error_handler, void* arg);
+
+SRSRAN_API int rf_wideband_open(char* args, void** h);
+
+SRSRAN_API int rf_wideband_open_multi(char* args, void** h, uint32_t nof_channels);
+
+SRSRAN_API int rf_wideband_close(void* h);
+
+SRSRAN_API double rf_wideband_set_rx_srate(void* h, double srate);
+
+SRSRAN_API int rf_wideband_set_rx_gain(void* h, double gain);
+
+SRSRAN_API int rf_wideband_set_rx_gain_ch(void* h, uint32_t ch, double gain);
+
+SRSRAN_API int rf_wideband_set_tx_gain(void* h, double gain);
+
+SRSRAN_API int rf_wideband_set_tx_gain_ch(void* h, uint32_t ch, double gain);
+
+SRSRAN_API double rf_wideband_get_rx_gain(void* h);
+
+SRSRAN_API double rf_wideband_get_tx_gain(void* h);
+
+SRSRAN_API srsran_rf_info_t* rf_wideband_get_info(void* h);
+
+SRSRAN_API double rf_wideband_set_rx_freq(void* h, uint32_t ch, double freq);
+
+SRSRAN_API double rf_wideband_set_tx_srate(void* h, double srate);
+
+SRSRAN_API double rf_wideband_set_tx_freq(void* h, uint32_t ch, double freq);
+
+SRSRAN_API void rf_wideband_get_time(void* h, time_t* secs, double* frac_secs);
+
+SRSRAN_API int
+rf_wideband_recv_with_time(void* h, void* data, uint32_t nsamples, bool blocking, time_t* secs, double* frac_secs);
+
+SRSRAN_API int
+rf_wideband_recv_with_time_multi(void* h, void** data, uint32_t nsamples, bool blocking, time_t* secs, double* frac_secs);
+
+SRSRAN_API int rf_wideband_send_timed(void*  h,
+                                      void*  data,
+                                      int    nsamples,
+                                      time_t secs,
+                                      double frac_secs,
+                                      bool   has_time_spec,
+                                      bool   blocking,
+                                      bool   is_start_of_burst,
+                                      bool   is_end_of_burst);
+
+SRSRAN_API int rf_wideband_send_timed_multi(void*  h,
+                                            void*  data[4],
+                                            int    nsamples,
+                                            time_t secs,
+                                            double frac_secs,
+                                            bool   has_time_spec,
+                                            bool   blocking,
+                                            bool   is_start_of_burst,
+                                            bool   is_end_of_burst);
+
+#endif // SRSRAN_RF_WIDEBAND_IMP_H
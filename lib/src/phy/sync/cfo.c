@@ -107,6 +107,46 @@ void srsran_cfo_correct(srsran_cfo_t* h, const cf_t* input, cf_t* output, float
 #endif /* SRSRAN_CFO_USE_EXP_TABLE */
 }
 
+void srsran_cfo_correct_multi(srsran_cfo_t* h,
+                              cf_t*         input[SRSRAN_MAX_CHANNELS],
+                              cf_t*         output[SRSRAN_MAX_CHANNELS],
+                              uint32_t      nof_channels,
+                              float         freq)
+{
+  // Keep only the active channels
+  cf_t*    x[SRSRAN_MAX_CHANNELS] = {};
+  cf_t*    z[SRSRAN_MAX_CHANNELS] = {};
+  uint32_t n                      = 0;
+  for (uint32_t i = 0; i < nof_channels && i < SRSRAN_MAX_CHANNELS; i++) {
+    if (input[i] != NULL && output[i] != NULL) {
+      x[n] = input[i];
+      z[n] = output[i];
+      n++;
+    }
+  }
+
+#if SRSRAN_CFO_USE_EXP_TABLE
+  if (fabs(h->last_freq - freq) > h->tol) {
+    h->last_freq = freq;
+    srsran_cexptab_gen(&h->tab, h->cur_cexp, h->last_freq, h->nsamples);
+    DEBUG("CFO generating new table for frequency %.4fe-6", freq * 1e6);
+  }
+  for (uint32_t i = 0; i < n; i++) {
+    srsran_vec_prod_ccc(h->cur_cexp, x[i], z[i], h->nsamples);
+  }
+#else  /* SRSRAN_CFO_USE_EXP_TABLE */
+  srsran_vec_apply_cfo_multi(x, freq, z, n, h->nsamples);
+#endif /* SRSRAN_CFO_USE_EXP_TABLE */
+}
+
+void srsran_cfo_correct_multi_inplace(srsran_cfo_t* h,
+                                      cf_t*         buffer[SRSRAN_MAX_CHANNELS],
+                                      uint32_t      nof_channels,
+                                      float         freq)
+{
+  srsran_cfo_correct_multi(h, buffer, buffer, nof_channels, freq);
+}
+
 /* CFO correction which allows to specify the offset within the correction
  * table to allow phase-continuity across multi-subframe transmissions (NB-IoT)
  * Note that when correction table needs to be regenerated, the regeneration
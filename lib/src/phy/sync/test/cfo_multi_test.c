@@ -0,0 +1,166 @@
+/**
+ * Copyright 2013-2023 Software Radio Systems Limited
+ *
+ * This file is part of srsRAN.
+ *
+ * srsRAN is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsRAN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <complex.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "srsran/srsran.h"
+
+#define MAX_ERROR 1e-3
+
+static uint32_t nof_repetitions = 100;
+static float    freq            = 0.001f;
+
+static void usage(char* prog)
+{
+  printf("Usage: %s [rf]\n", prog);
+  printf("\t-r Number of repetitions for the benchmark [Default %d]\n", nof_repetitions);
+  printf("\t-f Normalized frequency offset [Default %f]\n", freq);
+}
+
+static void parse_args(int argc, char** argv)
+{
+  int opt;
+  while ((opt = getopt(argc, argv, "rf")) != -1) {
+    switch (opt) {
+      case 'r':
+        nof_repetitions = (uint32_t)strtol(argv[optind], NULL, 10);
+        break;
+      case 'f':
+        freq = strtof(argv[optind], NULL);
+        break;
+      default:
+        usage(argv[0]);
+        exit(-1);
+    }
+  }
+}
+
+static int test_multi(uint32_t nof_prb, uint32_t nof_channels)
+{
+  int            ret                            = SRSRAN_ERROR;
+  uint32_t       nof_samples                    = SRSRAN_SF_LEN_PRB(nof_prb);
+  cf_t*          input[SRSRAN_MAX_CHANNELS]     = {};
+  cf_t*          ref[SRSRAN_MAX_CHANNELS]       = {};
+  cf_t*          output[SRSRAN_MAX_CHANNELS]    = {};
+  srsran_cfo_t   cfocorr                        = {};
+  struct timeval t[3];
+
+  for (uint32_t ch = 0; ch < nof_channels; ch++) {
+    input[ch]  = srsran_vec_cf_malloc(nof_samples);
+    ref[ch]    = srsran_vec_cf_malloc(nof_samples);
+    output[ch] = srsran_vec_cf_malloc(nof_samples);
+    if (!input[ch] || !ref[ch] || !output[ch]) {
+      perror("malloc");
+      goto clean_exit;
+    }
+    for (uint32_t i = 0; i < nof_samples; i++) {
+      input[ch][i] = (float)rand() / RAND_MAX - 0.5f + I * ((float)rand() / RAND_MAX - 0.5f);
+    }
+  }
+
+  if (srsran_cfo_init(&cfocorr, nof_samples)) {
+    ERROR("Error initiating CFO");
+    goto clean_exit;
+  }
+
+  // Reference: one correction per channel
+  gettimeofday(&t[1], NULL);
+  for (uint32_t r = 0; r < nof_repetitions; r++) {
+    for (uint32_t ch = 0; ch < nof_channels; ch++) {
+      srsran_cfo_correct(&cfocorr, input[ch], ref[ch], freq);
+    }
+  }
+  gettimeofday(&t[2], NULL);
+  get_time_interval(t);
+  double t_single = (double)(t[0].tv_sec * 1000000 + t[0].tv_usec) / nof_repetitions;
+
+  // Fused correction of all channels
+  gettimeofday(&t[1], NULL);
+  for (uint32_t r = 0; r < nof_repetitions; r++) {
+    srsran_cfo_correct_multi(&cfocorr, input, output, nof_channels, freq);
+  }
+  gettimeofday(&t[2], NULL);
+  get_time_interval(t);
+  double t_multi = (double)(t[0].tv_sec * 1000000 + t[0].tv_usec) / nof_repetitions;
+
+  // The in-place version must give the same result
+  srsran_cfo_correct_multi_inplace(&cfocorr, input, nof_channels, freq);
+
+  float max_err = 0;
+  for (uint32_t ch = 0; ch < nof_channels; ch++) {
+    for (uint32_t i = 0; i < nof_samples; i++) {
+      max_err = SRSRAN_MAX(max_err, cabsf(ref[ch][i] - output[ch][i]));
+      max_err = SRSRAN_MAX(max_err, cabsf(ref[ch][i] - input[ch][i]));
+    }
+  }
+
+  printf("nof_prb=%3d; nof_channels=%d; single=%7.1f us; multi=%7.1f us; max_err=%.2e\n",
+         nof_prb,
+         nof_channels,
+         t_single,
+         t_multi,
+         max_err);
+
+  if (max_err > MAX_ERROR) {
+    ERROR("Error too large");
+  } else {
+    ret = SRSRAN_SUCCESS;
+  }
+
+clean_exit:
+  srsran_cfo_free(&cfocorr);
+  for (uint32_t ch = 0; ch < nof_channels; ch++) {
+    if (input[ch]) {
+      free(input[ch]);
+    }
+    if (ref[ch]) {
+      free(ref[ch]);
+    }
+    if (output[ch]) {
+      free(output[ch]);
+    }
+  }
+  return ret;
+}
+
+int main(int argc, char** argv)
+{
+  const uint32_t prb_list[]      = {6, 15, 25, 50, 75, 100};
+  const uint32_t channel_list[]  = {1, 2, 4};
+
+  parse_args(argc, argv);
+
+  for (uint32_t c = 0; c < sizeof(channel_list) / sizeof(uint32_t); c++) {
+    for (uint32_t p = 0; p < sizeof(prb_list) / sizeof(uint32_t); p++) {
+      if (test_multi(prb_list[p], channel_list[c])) {
+        return SRSRAN_ERROR;
+      }
+    }
+  }
+
+  printf("Ok\n");
+  return SRSRAN_SUCCESS;
+}
@@ -8,6 +8,11 @@
 #include "srsran/phy/ue/ngscope_tree.h"
 #include "srsran/phy/ue/ngscope_dci.h"
 #include "srsran/phy/ue/ngscope_search_space.h"
+
+// Unexplained CCEs over the llr gate that trigger the full search of the hybrid search. A single one
+// is as likely an idle CCE over the gate as a dci of aggregation level 1
+#define HYBRID_MIN_UNEXPLAINED_CCE 2
+
 /*  Container of the DCI messages
  *  Format   loc
  */
@@ -115,8 +120,84 @@ int child_parent_match(ngscope_tree_t* 	   tree,
 	}
 	return found_dci;
 }
-/* Yaxiong's dci search function */
-int srsran_ngscope_search_all_space_array_yx(srsran_ue_dl_t*        q,
+/* Feed the locations of the dci found in the subframe to the llr gate of the pdcch,
+ * the CCEs not covered by them are used to learn the gate */
+static void update_llr_gate(srsran_ue_dl_t* q, ngscope_dci_per_sub_t* dci_per_sub)
+{
+	srsran_dci_location_t loc[2 * MAX_DCI_PER_SUB];
+	uint32_t nof_loc = 0;
+
+	for(uint32_t i=0; i<dci_per_sub->nof_dl_dci && i<MAX_DCI_PER_SUB; i++){
+		loc[nof_loc++] = dci_per_sub->dl_msg[i].loc;
+	}
+	for(uint32_t i=0; i<dci_per_sub->nof_ul_dci && i<MAX_DCI_PER_SUB; i++){
+		loc[nof_loc++] = dci_per_sub->ul_msg[i].loc;
+	}
+	srsran_pdcch_llr_gate_update(&q->pdcch, &q->chest_res, loc, nof_loc);
+	return;
+}
+
+/* Decode ahead the candidates [first, last) of the tree that pass the llr gate and are not checked yet.
+ * Every format of the search space runs its candidates through the batch viterbi decoder, the pdcch
+ * keeps the results for the search_in_space calls of the tree walk */
+static void decode_batch(srsran_ue_dl_t*     q,
+						srsran_dl_sf_cfg_t*  sf,
+						srsran_dci_cfg_t*    dci_cfg,
+						dci_blind_search_t*  search_space,
+						ngscope_tree_t*      tree,
+						int first, int last)
+{
+	srsran_dci_location_t loc[MAX_CANDIDATES_ALL];
+	uint32_t nof_loc = 0;
+	float    gate    = srsran_pdcch_llr_gate(&q->pdcch);
+
+	for(int i=first; i<last && i<tree->nof_location && i<MAX_CANDIDATES_ALL; i++){
+		if(!tree->dci_location[i].checked && tree->dci_location[i].mean_llr >= gate){
+			loc[nof_loc++] = tree->dci_location[i];
+		}
+	}
+	if(nof_loc == 0){
+		return;
+	}
+	for(uint32_t f=0; f<search_space->nof_formats; f++){
+		srsran_pdcch_decode_batch_yx(&q->pdcch, sf, dci_cfg, search_space->formats[f], loc, nof_loc);
+	}
+	return;
+}
+
+/* Demodulate and estimate the control region of the subframe, it sets sf->cfi */
+static int estimate_control(srsran_ue_dl_t* q, srsran_dl_sf_cfg_t* sf, srsran_ue_dl_cfg_t* cfg)
+{
+  int ret = 0;
+
+  /* For TDD, when searching for SIB1, the ul/dl configuration is unknown and need to do blind search over
+   * the possible mi values
+   */  
+  uint32_t mi_set_len;
+  if (q->cell.frame_type == SRSRAN_TDD && !sf->tdd_config.configured) {
+    mi_set_len = 3;
+  } else {
+    mi_set_len = 1;
+  }
+    
+  // Blind search PHICH mi value
+  for (uint32_t i = 0; i < mi_set_len && !ret; i++) {
+    if (mi_set_len == 1) {
+      srsran_ue_dl_set_mi_auto(q);
+    } else {
+      srsran_ue_dl_set_mi_manual(q, i);
+    }
+
+    if ((ret = srsran_ue_dl_decode_fft_estimate(q, sf, cfg)) < 0) {
+      ERROR("ERROR decode FFT\n");
+      return ret;
+    }
+  }
+  return ret;
+}
+
+/* Blind search over all the locations of the tree */
+static int search_all_space(srsran_ue_dl_t*        q,
                                              srsran_dl_sf_cfg_t*    sf,
                                              srsran_ue_dl_cfg_t*    cfg,
                                              srsran_pdsch_cfg_t*    pdsch_cfg,
@@ -124,10 +205,9 @@ int srsran_ngscope_search_all_space_array_yx(srsran_ue_dl_t*        q,
                                              //srsran_dci_location_t  dci_location[MAX_CANDIDATES_ALL],
                                              ngscope_dci_per_sub_t* dci_per_sub,
   											 ngscope_tree_t* 		tree,
-											 uint16_t targetRNTI)
+											 uint16_t targetRNTI,
+											 bool estimate)
 {
-  int ret = SRSRAN_ERROR;
-
   dci_per_sub->nof_dl_dci = 0;
   dci_per_sub->nof_ul_dci = 0;
 
@@ -158,30 +238,9 @@ int srsran_ngscope_search_all_space_array_yx(srsran_ue_dl_t*        q,
     search_space.nof_formats = MAX_NOF_FORMAT;
   }
 
-  /* For TDD, when searching for SIB1, the ul/dl configuration is unknown and need to do blind search over
-   * the possible mi values
-   */  
-  uint32_t mi_set_len;
-  if (q->cell.frame_type == SRSRAN_TDD && !sf->tdd_config.configured) {
-    mi_set_len = 3;
-  } else {
-    mi_set_len = 1;
-  }
-    
-  // Blind search PHICH mi value
   // Remeber that sf->cfi is set only after calling srsran_ue_dl_decode_fft_estimate
-  ret = 0;
-  for (uint32_t i = 0; i < mi_set_len && !ret; i++) {
-    if (mi_set_len == 1) {
-      srsran_ue_dl_set_mi_auto(q);
-    } else {
-      srsran_ue_dl_set_mi_manual(q, i);
-    }
-
-    if ((ret = srsran_ue_dl_decode_fft_estimate(q, sf, cfg)) < 0) {
-      ERROR("ERROR decode FFT\n");
-      return 0;
-    }
+  if(estimate && estimate_control(q, sf, cfg) < 0){
+    return 0;
   }
   
 
@@ -202,13 +261,24 @@ int srsran_ngscope_search_all_space_array_yx(srsran_ue_dl_t*        q,
   int loc_idx = 0, blk_idx = 0, cnt = 0;
 
   int found_dci = 0;
+
+  dci_cfg.multiple_csi_request_enabled 	= false;
+
   //printf("enter while!\n");
   while(loc_idx < tree->nof_location){
 	//printf("inside while!\n");
 	for(int i=0;i<15;i++){
 		if(loc_idx > tree->nof_location) break; 
+
+		// A tree of 15 locations has the levels [0], [1,2], [3,6], [7,14]. The candidates of a level
+		// are decoded together when the walk gets to it, so the ones pruned by the levels above are not.
+		// The pdcch leaves the levels with too few candidates to the single codeword decoder
+		int idx_in_tree = loc_idx % 15;
+		if(idx_in_tree == 0 || idx_in_tree == 1 || idx_in_tree == 3 || idx_in_tree == 7){
+			decode_batch(q, sf, &dci_cfg, &search_space, tree, loc_idx, loc_idx + idx_in_tree + 1);
+		}
 	
-		if(tree->dci_location[loc_idx].checked || tree->dci_location[loc_idx].mean_llr < LLR_RATIO){
+		if(tree->dci_location[loc_idx].checked || !srsran_pdcch_llr_gate_pass(&q->pdcch, tree->dci_location[loc_idx].mean_llr)){
 			//skip the location, if 1) it has been checked 2) its llr ratio is too small
 			//printf("check:%d mean_llr::%f\n",dci_location[loc_idx].checked, dci_location[loc_idx].mean_llr);
 			loc_idx++;
@@ -283,6 +353,9 @@ int srsran_ngscope_search_all_space_array_yx(srsran_ue_dl_t*        q,
 
   srsran_ngscope_dci_prune(tree, sf->tti % 10);
 
+  // learn the llr gate from the CCEs left empty in this subframe
+  update_llr_gate(q, dci_per_sub);
+
   //int nof_node = srsran_ngscope_tree_non_empty_nodes(tree);
   //printf("TTI:%d Searching %d location, found %d dci, left %d non-empty nodes!\n",\
   		sf->tti, cnt, found_dci, nof_node);
@@ -311,6 +384,116 @@ int srsran_ngscope_search_all_space_array_yx(srsran_ue_dl_t*        q,
   return found_dci;
 }
 
+/* Yaxiong's dci search function */
+int srsran_ngscope_search_all_space_array_yx(srsran_ue_dl_t*        q,
+                                             srsran_dl_sf_cfg_t*    sf,
+                                             srsran_ue_dl_cfg_t*    cfg,
+                                             srsran_pdsch_cfg_t*    pdsch_cfg,
+                                             ngscope_dci_per_sub_t* dci_per_sub,
+  											 ngscope_tree_t* 		tree,
+											 uint16_t targetRNTI)
+{
+	return search_all_space(q, sf, cfg, pdsch_cfg, dci_per_sub, tree, targetRNTI, true);
+}
+
+/* CCEs of the subframe whose mean llr passes the gate but that no dci found covers */
+static uint32_t nof_unexplained_cce(srsran_ue_dl_t* q, const srsran_dci_location_t* loc, uint32_t nof_loc)
+{
+	float   energy[SRSRAN_MAX_PRB];
+	bool    used[SRSRAN_MAX_PRB] = {false};
+	uint32_t nof_cce = srsran_pdcch_cce_energy(&q->pdcch, energy, SRSRAN_MAX_PRB);
+	float   gate     = srsran_pdcch_llr_gate(&q->pdcch);
+
+	for(uint32_t i=0; i<nof_loc; i++){
+		for(uint32_t c=loc[i].ncce; c<loc[i].ncce + (1U << loc[i].L) && c<nof_cce; c++){
+			used[c] = true;
+		}
+	}
+
+	uint32_t nof_unexplained = 0;
+	for(uint32_t c=0; c<nof_cce; c++){
+		if(!used[c] && energy[c] >= gate){
+			nof_unexplained++;
+		}
+	}
+	return nof_unexplained;
+}
+
+/* Locations of the paging (and, if search_si is set, the SI) dci of the common search space, they explain their
+ * CCEs but are not reported */
+static uint32_t find_common_dci(srsran_ue_dl_t* q, srsran_dl_sf_cfg_t* sf, srsran_ue_dl_cfg_t* cfg, bool search_si,
+								srsran_dci_location_t* loc, uint32_t max_loc)
+{
+	const uint16_t common_rnti[2] = {SRSRAN_PRNTI, SRSRAN_SIRNTI};
+	uint32_t nof_rnti = search_si ? 2 : 1;
+	uint32_t nof_loc  = 0;
+
+	for(uint32_t i=0; i<nof_rnti; i++){
+		srsran_dci_dl_t dci_dl[SRSRAN_MAX_DCI_MSG] = {};
+		int nof_dci = srsran_ue_dl_find_dl_dci(q, sf, cfg, common_rnti[i], dci_dl);
+		for(int j=0; j<nof_dci && nof_loc<max_loc; j++){
+			loc[nof_loc++] = dci_dl[j].location;
+		}
+	}
+	return nof_loc;
+}
+
+/* Hybrid search: only the search spaces of the target RNTIs (and the SI and paging dci of the common space) are
+ * decoded, the full tree search runs when full_search is set or when the CCE energy map shows at least
+ * HYBRID_MIN_UNEXPLAINED_CCE occupied CCEs that none of these dci explain.
+ * The SI dci are only searched here if the caller did not (nof_si_loc < 0).
+ * Returns 1 if the full search ran (and the tree is valid), 0 otherwise */
+int srsran_ngscope_search_hybrid_yx(srsran_ue_dl_t*        q,
+                                    srsran_dl_sf_cfg_t*    sf,
+                                    srsran_ue_dl_cfg_t*    cfg,
+                                    srsran_pdsch_cfg_t*    pdsch_cfg,
+                                    ngscope_dci_per_sub_t* dci_per_sub,
+                                    ngscope_tree_t*        tree,
+                                    const uint16_t*        rnti_list,
+                                    uint32_t               nof_rnti,
+                                    const srsran_dci_location_t* si_loc,
+                                    int                    nof_si_loc,
+                                    bool                   full_search,
+                                    uint16_t               targetRNTI)
+{
+	dci_per_sub->nof_dl_dci = 0;
+	dci_per_sub->nof_ul_dci = 0;
+
+	if(estimate_control(q, sf, cfg) < 0){
+		return 0;
+	}
+
+	if(!full_search){
+		for(uint32_t i=0; i<nof_rnti; i++){
+			srsran_ue_decode_dci_target_yx(q, sf, cfg, pdsch_cfg, dci_per_sub, rnti_list[i]);
+		}
+
+		srsran_dci_location_t loc[2 * MAX_DCI_PER_SUB + 2 * SRSRAN_MAX_DCI_MSG];
+		uint32_t nof_loc = 0;
+		for(uint32_t i=0; i<dci_per_sub->nof_dl_dci && i<MAX_DCI_PER_SUB; i++){
+			loc[nof_loc++] = dci_per_sub->dl_msg[i].loc;
+		}
+		for(uint32_t i=0; i<dci_per_sub->nof_ul_dci && i<MAX_DCI_PER_SUB; i++){
+			loc[nof_loc++] = dci_per_sub->ul_msg[i].loc;
+		}
+		uint32_t nof_si = 0;
+		for(int i=0; i<nof_si_loc && i<SRSRAN_MAX_DCI_MSG; i++){
+			loc[nof_loc++] = si_loc[i];
+			nof_si++;
+		}
+		nof_loc += find_common_dci(q, sf, cfg, nof_si_loc < 0, &loc[nof_loc], 2 * SRSRAN_MAX_DCI_MSG - nof_si);
+
+		// The llr gate only learns from the full search: here the CCEs of the other UEs would count as idle
+		if(nof_unexplained_cce(q, loc, nof_loc) < HYBRID_MIN_UNEXPLAINED_CCE){
+			return 0;
+		}
+	}
+
+	// the full search finds the target RNTIs again, and feeds the llr gate
+	search_all_space(q, sf, cfg, pdsch_cfg, dci_per_sub, tree, targetRNTI, false);
+	return 1;
+}
+
 /* Yaxiong's dci search function */
 int srsran_ngscope_search_all_space_array_signleUE_yx(srsran_ue_dl_t*        q,
                                              srsran_dl_sf_cfg_t*    sf,
@@ -408,7 +591,7 @@ int srsran_ngscope_search_all_space_array_signleUE_yx(srsran_ue_dl_t*        q,
         //printf("%d-th ncce:%d L:%d | ", i, dci_location[i].ncce, dci_location[i].L);
         if(loc_idx > tree.nof_location) break; 
         //if(dci_location[loc_idx].checked){
-        if(tree.dci_location[loc_idx].checked || tree.dci_location[loc_idx].mean_llr < LLR_RATIO){
+        if(tree.dci_location[loc_idx].checked || !srsran_pdcch_llr_gate_pass(&q->pdcch, tree.dci_location[loc_idx].mean_llr)){
 			//skip the location, if 1) it has been checked 2) its llr ratio is too small
 			//printf("check:%d mean_llr::%f\n",dci_location[loc_idx].checked, dci_location[loc_idx].mean_llr);
             loc_idx++;
@@ -455,6 +638,7 @@ int srsran_ngscope_search_all_space_array_signleUE_yx(srsran_ue_dl_t*        q,
   }//end of while 
 
   	srsran_ngscope_tree_copy_rnti(&tree, dci_per_sub, targetRNTI);
+	update_llr_gate(q, dci_per_sub);
 	return ret;
 }
 
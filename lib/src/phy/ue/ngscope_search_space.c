@@ -30,26 +30,22 @@ uint32_t srsran_ngscope_search_space_all_yx(srsran_pdcch_t* q, uint32_t cfi, srs
     return k;
 }
 
-/*calculate the mean llr */
+/* mean llr of the location, read from the CCE energy map of the pdcch
+ * (computed once per subframe when the llrs are extracted) */
 static float mean_llr(srsran_pdcch_t* q, int ncce, int l){
-    float mean = 0;
-    for (int j=0;j<PDCCH_FORMAT_NOF_BITS(l);j++) {
-        mean += fabsf(q->llr[ncce * 72 + j]);
-    }
-    mean /= PDCCH_FORMAT_NOF_BITS(l);
-    return mean;
+    return srsran_pdcch_cce_mean_llr(q, ncce, l);
 }
 
 
 void check_node_based_on_llr(srsran_dci_location_t dci_location[MAX_CANDIDATES_ALL],
-                                        int nof_location)
+                                        int nof_location, float llr_gate)
 {
     int nof_blk     = nof_location / 15;
     for(int i=0; i<nof_blk; i++){
         int start_idx = i * 15;
         for(int j=7; j<15; j++){
             // let's first check all the leaf nodes inside a tree
-            if(dci_location[start_idx+j].mean_llr < LLR_RATIO){ 
+            if(dci_location[start_idx+j].mean_llr < llr_gate){ 
                 // we skip the location if the llr is too small
                 dci_location[start_idx+j].checked = true; 
             }
@@ -163,7 +159,7 @@ uint32_t srsran_ngscope_search_space_block_yx(srsran_pdcch_t* q, uint32_t cfi, s
            }
        }
     }
-    //check_node_based_on_llr(c, nof_blk * 15);
+    //check_node_based_on_llr(c, nof_blk * 15, srsran_pdcch_llr_gate(q));
     return nof_blk * 15; 
 }
 
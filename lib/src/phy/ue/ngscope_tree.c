@@ -352,8 +352,8 @@ int srsran_ngscope_tree_prune_tree(ngscope_tree_t* q){
 }
 
 bool is_empty_node_regarding_llr(srsran_dci_location_t dci_location[MAX_CANDIDATES_ALL],
-                                    int index){
-    if(dci_location[index].mean_llr < LLR_RATIO){
+                                    int index, float llr_gate){
+    if(dci_location[index].mean_llr < llr_gate){
         return true;
     }else{
         return false;
@@ -363,10 +363,11 @@ bool is_empty_node_regarding_llr(srsran_dci_location_t dci_location[MAX_CANDIDAT
 
 bool is_solo_leaf_node(ngscope_dci_msg_t        dci_array[][MAX_CANDIDATES_ALL], 
                         srsran_dci_location_t   dci_location[MAX_CANDIDATES_ALL],
-                        int                     index){
+                        int                     index,
+                        float                   llr_gate){
     int idx_in_tree = index % 15;
     
-    if(is_empty_node_regarding_llr(dci_location, index) ||
+    if(is_empty_node_regarding_llr(dci_location, index, llr_gate) ||
                     is_empty_node(dci_array, index) ){
         // empty node cannot be solo node
         return false;
@@ -374,13 +375,13 @@ bool is_solo_leaf_node(ngscope_dci_msg_t        dci_array[][MAX_CANDIDATES_ALL],
         
     if( (idx_in_tree % 2) == 0){
         // node with even index
-        if(is_empty_node_regarding_llr(dci_location, index-1)){
+        if(is_empty_node_regarding_llr(dci_location, index-1, llr_gate)){
             // its left silbing is empty
             return true;
         }
     }else{
         // node with odd index
-        if(is_empty_node_regarding_llr(dci_location, index+1)){
+        if(is_empty_node_regarding_llr(dci_location, index+1, llr_gate)){
             // its right silbing is empty
             return true;
         }
@@ -402,7 +403,7 @@ int srsran_ngscope_tree_solo_nodes(ngscope_tree_t* q, ngscope_dci_per_sub_t*  dc
         int idx_in_tree = i % 15;
         // we only check for leaf node 
         if( (idx_in_tree >= 7) && (idx_in_tree <= 14)){
-            if(is_solo_leaf_node(q->dci_array, q->dci_location, i)){
+            if(is_solo_leaf_node(q->dci_array, q->dci_location, i, q->llr_gate)){
                 printf("Find one solo leaf node inside the tree!\n");
                 
                 // copy the matched dci message to the results
@@ -462,12 +463,14 @@ int ngscope_tree_init(ngscope_tree_t* q){
 	}
 	q->nof_location = 0;
 	q->nof_cce 		= 0;
+	q->llr_gate 	= LLR_RATIO;
 	return 0;
 }
 
 // set the searching space
 int ngscope_tree_set_locations(ngscope_tree_t* q, srsran_pdcch_t* pdcch, uint32_t cfi){
 	q->nof_location = srsran_ngscope_search_space_block_yx(pdcch, cfi, q->dci_location);
+	q->llr_gate 	= srsran_pdcch_llr_gate(pdcch);
 	return q->nof_location;
 }
 
@@ -63,7 +63,11 @@ const static uint32_t mi_tdd_table[7][10] = {{2, 1, 0, 0, 0, 2, 1, 0, 0, 0},  //
         ? 3                                                                                                            \
         : 0))
 
-int srsran_ue_dl_init(srsran_ue_dl_t* q, cf_t* in_buffer[SRSRAN_MAX_PORTS], uint32_t max_prb, uint32_t nof_rx_antennas)
+static int ue_dl_init(srsran_ue_dl_t* q,
+                      cf_t*           in_buffer[SRSRAN_MAX_PORTS],
+                      uint32_t        max_prb,
+                      uint32_t        nof_rx_antennas,
+                      bool            pdsch_enable)
 {
   int ret = SRSRAN_ERROR_INVALID_INPUTS;
 
@@ -76,8 +80,11 @@ int srsran_ue_dl_init(srsran_ue_dl_t* q, cf_t* in_buffer[SRSRAN_MAX_PORTS], uint
     q->nof_rx_antennas      = nof_rx_antennas;
     q->mi_auto              = true;
     q->mi_manual_index      = 0;
+    q->pdsch_enable         = pdsch_enable;
 
-    for (int j = 0; j < SRSRAN_MAX_PORTS; j++) {
+    // The control channels only read the symbols of the receive antennas
+    uint32_t nof_symbol_buffers = pdsch_enable ? SRSRAN_MAX_PORTS : nof_rx_antennas;
+    for (int j = 0; j < nof_symbol_buffers; j++) {
       q->sf_symbols[j] = srsran_vec_cf_malloc(MAX_SFLEN_RE);
       if (!q->sf_symbols[j]) {
         perror("malloc");
@@ -132,14 +139,16 @@ int srsran_ue_dl_init(srsran_ue_dl_t* q, cf_t* in_buffer[SRSRAN_MAX_PORTS], uint
       goto clean_exit;
     }
 
-    if (srsran_pdsch_init_ue(&q->pdsch, max_prb, nof_rx_antennas)) {
-      ERROR("Error creating PDSCH object");
-      goto clean_exit;
-    }
+    if (pdsch_enable) {
+      if (srsran_pdsch_init_ue(&q->pdsch, max_prb, nof_rx_antennas)) {
+        ERROR("Error creating PDSCH object");
+        goto clean_exit;
+      }
 
-    if (srsran_pmch_init(&q->pmch, max_prb, nof_rx_antennas)) {
-      ERROR("Error creating PMCH object");
-      goto clean_exit;
+      if (srsran_pmch_init(&q->pmch, max_prb, nof_rx_antennas)) {
+        ERROR("Error creating PMCH object");
+        goto clean_exit;
+      }
     }
 
     ret = SRSRAN_SUCCESS;
@@ -154,9 +163,23 @@ clean_exit:
   return ret;
 }
 
+int srsran_ue_dl_init(srsran_ue_dl_t* q, cf_t* in_buffer[SRSRAN_MAX_PORTS], uint32_t max_prb, uint32_t nof_rx_antennas)
+{
+  return ue_dl_init(q, in_buffer, max_prb, nof_rx_antennas, true);
+}
+
+int srsran_ue_dl_init_ctrl(srsran_ue_dl_t* q,
+                           cf_t*           in_buffer[SRSRAN_MAX_PORTS],
+                           uint32_t        max_prb,
+                           uint32_t        nof_rx_antennas)
+{
+  return ue_dl_init(q, in_buffer, max_prb, nof_rx_antennas, false);
+}
+
 void srsran_ue_dl_free(srsran_ue_dl_t* q)
 {
   if (q) {
+    srsran_ue_dl_batch_free(q);
     for (int port = 0; port < SRSRAN_MAX_PORTS; port++) {
       srsran_ofdm_rx_free(&q->fft[port]);
     }
@@ -169,8 +192,10 @@ void srsran_ue_dl_free(srsran_ue_dl_t* q)
     srsran_pcfich_free(&q->pcfich);
     srsran_phich_free(&q->phich);
     srsran_pdcch_free(&q->pdcch);
-    srsran_pdsch_free(&q->pdsch);
-    srsran_pmch_free(&q->pmch);
+    if (q->pdsch_enable) {
+      srsran_pdsch_free(&q->pdsch);
+      srsran_pmch_free(&q->pmch);
+    }
     for (int j = 0; j < SRSRAN_MAX_PORTS; j++) {
       if (q->sf_symbols[j]) {
         free(q->sf_symbols[j]);
@@ -238,14 +263,16 @@ int srsran_ue_dl_set_cell(srsran_ue_dl_t* q, srsran_cell_t cell)
         return SRSRAN_ERROR;
       }
 
-      if (srsran_pdsch_set_cell(&q->pdsch, q->cell)) {
-        ERROR("Error resizing PDSCH object");
-        return SRSRAN_ERROR;
-      }
+      if (q->pdsch_enable) {
+        if (srsran_pdsch_set_cell(&q->pdsch, q->cell)) {
+          ERROR("Error resizing PDSCH object");
+          return SRSRAN_ERROR;
+        }
 
-      if (srsran_pmch_set_cell(&q->pmch, q->cell)) {
-        ERROR("Error resizing PMCH object");
-        return SRSRAN_ERROR;
+        if (srsran_pmch_set_cell(&q->pmch, q->cell)) {
+          ERROR("Error resizing PMCH object");
+          return SRSRAN_ERROR;
+        }
       }
     }
     ret = SRSRAN_SUCCESS;
@@ -283,7 +310,7 @@ int srsran_ue_dl_set_mbsfn_area_id(srsran_ue_dl_t* q, uint16_t mbsfn_area_id)
       ERROR("Error setting MBSFN area ID ");
       return ret;
     }
-    if (srsran_pmch_set_area_id(&q->pmch, mbsfn_area_id)) {
+    if (q->pdsch_enable && srsran_pmch_set_area_id(&q->pmch, mbsfn_area_id)) {
       ERROR("Error setting MBSFN area ID ");
       return ret;
     }
@@ -312,15 +339,20 @@ static void set_mi_value(srsran_ue_dl_t* q, srsran_dl_sf_cfg_t* sf, srsran_ue_dl
   }
 }
 
-static int estimate_pdcch_pcfich(srsran_ue_dl_t* q, srsran_dl_sf_cfg_t* sf, srsran_ue_dl_cfg_t* cfg)
+static int
+estimate_pdcch_pcfich(srsran_ue_dl_t* q, srsran_dl_sf_cfg_t* sf, srsran_ue_dl_cfg_t* cfg, uint32_t nof_symbols)
 {
   if (q) {
     float cfi_corr = 0;
 
     set_mi_value(q, sf, cfg);
 
-    /* Get channel estimates for each port */
-    srsran_chest_dl_estimate_cfg(&q->chest, sf, &cfg->chest_cfg, q->sf_symbols, &q->chest_res);
+    /* Get channel estimates for each port, only in the control region if nof_symbols is given */
+    if (nof_symbols) {
+      srsran_chest_dl_estimate_ctrl(&q->chest, sf, &cfg->chest_cfg, q->sf_symbols, &q->chest_res, nof_symbols);
+    } else {
+      srsran_chest_dl_estimate_cfg(&q->chest, sf, &cfg->chest_cfg, q->sf_symbols, &q->chest_res);
+    }
 
     /* First decode PCFICH and obtain CFI */
     if (srsran_pcfich_decode(&q->pcfich, sf, &q->chest_res, q->sf_symbols, &cfi_corr) < 0) {
@@ -346,9 +378,192 @@ static int estimate_pdcch_pcfich(srsran_ue_dl_t* q, srsran_dl_sf_cfg_t* sf, srsr
   }
 }
 
+int srsran_ue_dl_batch_init(srsran_ue_dl_t* q, uint32_t max_nof_sf)
+{
+  if (q == NULL || q->cell.nof_prb == 0 || max_nof_sf == 0 || max_nof_sf > SRSRAN_OFDM_BATCH_MAX_SF) {
+    return SRSRAN_ERROR_INVALID_INPUTS;
+  }
+
+  srsran_ue_dl_batch_free(q);
+
+  for (int j = 0; j < q->nof_rx_antennas; j++) {
+    if (srsran_ofdm_rx_batch_init(&q->fft_batch[j], &q->fft[j], max_nof_sf)) {
+      ERROR("Error initiating batch FFT");
+      goto clean_exit;
+    }
+    for (uint32_t k = 0; k < max_nof_sf; k++) {
+      q->batch_symbols[k][j] = srsran_vec_cf_malloc(SRSRAN_SF_LEN_RE(q->cell.nof_prb, q->cell.cp));
+      if (!q->batch_symbols[k][j]) {
+        perror("malloc");
+        goto clean_exit;
+      }
+    }
+  }
+  q->batch_max_sf = max_nof_sf;
+
+  return SRSRAN_SUCCESS;
+
+clean_exit:
+  srsran_ue_dl_batch_free(q);
+  return SRSRAN_ERROR;
+}
+
+void srsran_ue_dl_batch_free(srsran_ue_dl_t* q)
+{
+  if (q == NULL) {
+    return;
+  }
+  srsran_ue_dl_batch_reset(q);
+  for (int j = 0; j < SRSRAN_MAX_PORTS; j++) {
+    srsran_ofdm_rx_batch_free(&q->fft_batch[j]);
+    for (uint32_t k = 0; k < SRSRAN_OFDM_BATCH_MAX_SF; k++) {
+      if (q->batch_symbols[k][j]) {
+        free(q->batch_symbols[k][j]);
+        q->batch_symbols[k][j] = NULL;
+      }
+    }
+  }
+  q->batch_max_sf = 0;
+}
+
+cf_t* srsran_ue_dl_batch_input(srsran_ue_dl_t* q, uint32_t sf_idx, uint32_t port)
+{
+  if (q == NULL || port >= q->nof_rx_antennas || sf_idx >= q->batch_max_sf) {
+    return NULL;
+  }
+  return srsran_ofdm_rx_batch_input(&q->fft_batch[port], sf_idx);
+}
+
+int srsran_ue_dl_batch_fft(srsran_ue_dl_t* q, const uint32_t* tti, uint32_t nof_sf)
+{
+  if (q == NULL || tti == NULL || nof_sf == 0 || nof_sf > q->batch_max_sf) {
+    return SRSRAN_ERROR_INVALID_INPUTS;
+  }
+
+  srsran_ue_dl_batch_reset(q);
+
+  for (int j = 0; j < q->nof_rx_antennas; j++) {
+    cf_t* output[SRSRAN_OFDM_BATCH_MAX_SF] = {};
+    for (uint32_t k = 0; k < nof_sf; k++) {
+      output[k] = q->batch_symbols[k][j];
+    }
+    if (srsran_ofdm_rx_batch_run(&q->fft_batch[j], output, nof_sf)) {
+      ERROR("Error running batch FFT");
+      return SRSRAN_ERROR;
+    }
+  }
+
+  for (uint32_t k = 0; k < nof_sf; k++) {
+    q->batch_tti[k] = tti[k];
+  }
+  q->batch_nof_sf = nof_sf;
+
+  return SRSRAN_SUCCESS;
+}
+
+void srsran_ue_dl_batch_reset(srsran_ue_dl_t* q)
+{
+  if (q == NULL) {
+    return;
+  }
+  q->batch_nof_sf = 0;
+
+  // Point the symbols back to the buffers owned by the object
+  for (int j = 0; j < q->nof_rx_antennas; j++) {
+    if (q->fft[j].cfg.out_buffer) {
+      q->sf_symbols[j] = q->fft[j].cfg.out_buffer;
+    }
+  }
+}
+
+/* Points the demodulated symbols to the batch output, if the TTI was demodulated in the current batch */
+static bool batch_set_symbols(srsran_ue_dl_t* q, srsran_dl_sf_cfg_t* sf)
+{
+  for (uint32_t k = 0; k < q->batch_nof_sf; k++) {
+    if (q->batch_tti[k] == sf->tti && sf->sf_type != SRSRAN_SF_MBSFN) {
+      for (int j = 0; j < q->nof_rx_antennas; j++) {
+        q->sf_symbols[j] = q->batch_symbols[k][j];
+      }
+      return true;
+    }
+  }
+  for (int j = 0; j < q->nof_rx_antennas; j++) {
+    q->sf_symbols[j] = q->fft[j].cfg.out_buffer;
+  }
+  return false;
+}
+
+cf_t* srsran_ue_dl_ctrl_symbols(srsran_ue_dl_t* q, uint32_t port)
+{
+  if (q == NULL || port >= q->nof_rx_antennas) {
+    return NULL;
+  }
+  return q->fft[port].cfg.out_buffer;
+}
+
+int srsran_ue_dl_set_ctrl_symbols(srsran_ue_dl_t* q, uint32_t tti, uint32_t nof_symbols)
+{
+  if (q == NULL || nof_symbols > SRSRAN_CP_NSYMB(q->cell.cp)) {
+    return SRSRAN_ERROR_INVALID_INPUTS;
+  }
+  q->ctrl_symbols_tti = tti;
+  q->ctrl_symbols_nof = nof_symbols;
+  return SRSRAN_SUCCESS;
+}
+
+void srsran_ue_dl_set_control_only(srsran_ue_dl_t* q, bool enable)
+{
+  if (q) {
+    q->ctrl_only_enable  = enable;
+    q->ctrl_only_pending = false;
+  }
+}
+
+/* Completes the demodulation and channel estimation of a subframe processed in control-only mode */
+static int ue_dl_complete_fft_estimate(srsran_ue_dl_t* q)
+{
+  if (!q->ctrl_only_pending) {
+    return SRSRAN_SUCCESS;
+  }
+  q->ctrl_only_pending = false;
+
+  for (int j = 0; j < q->nof_rx_antennas; j++) {
+    srsran_ofdm_rx_sf_complete(&q->fft[j]);
+  }
+  return srsran_chest_dl_estimate_cfg(
+      &q->chest, &q->ctrl_only_sf, &q->ctrl_only_chest_cfg, q->sf_symbols, &q->chest_res);
+}
+
 int srsran_ue_dl_decode_fft_estimate(srsran_ue_dl_t* q, srsran_dl_sf_cfg_t* sf, srsran_ue_dl_cfg_t* cfg)
 {
   if (q) {
+    q->ctrl_only_pending = false;
+
+    // The control region is already demodulated, there is nothing else to complete
+    if (q->ctrl_symbols_nof > 0 && q->ctrl_symbols_tti == sf->tti && sf->sf_type == SRSRAN_SF_NORM) {
+      for (int j = 0; j < q->nof_rx_antennas; j++) {
+        q->sf_symbols[j] = q->fft[j].cfg.out_buffer;
+      }
+      return estimate_pdcch_pcfich(q, sf, cfg, q->ctrl_symbols_nof);
+    }
+
+    // Batched subframes are already demodulated, the full estimate corrects the sync error once for all symbols
+    if (q->batch_nof_sf > 0 && batch_set_symbols(q, sf)) {
+      return estimate_pdcch_pcfich(q, sf, cfg, 0);
+    }
+
+    /* Run FFT for the control region only, the rest is demodulated if PDSCH is decoded */
+    if (q->ctrl_only_enable && sf->sf_type == SRSRAN_SF_NORM) {
+      uint32_t nof_symbols = 0;
+      for (int j = 0; j < q->nof_rx_antennas; j++) {
+        nof_symbols = srsran_ofdm_rx_sf_ctrl(&q->fft[j]);
+      }
+      q->ctrl_only_pending   = true;
+      q->ctrl_only_sf        = *sf;
+      q->ctrl_only_chest_cfg = cfg->chest_cfg;
+      return estimate_pdcch_pcfich(q, sf, cfg, nof_symbols);
+    }
+
     /* Run FFT for all subframe data */
     for (int j = 0; j < q->nof_rx_antennas; j++) {
       if (sf->sf_type == SRSRAN_SF_MBSFN) {
@@ -357,7 +572,7 @@ int srsran_ue_dl_decode_fft_estimate(srsran_ue_dl_t* q, srsran_dl_sf_cfg_t* sf,
         srsran_ofdm_rx_sf(&q->fft[j]);
       }
     }
-    return estimate_pdcch_pcfich(q, sf, cfg);
+    return estimate_pdcch_pcfich(q, sf, cfg, 0);
   } else {
     return SRSRAN_ERROR_INVALID_INPUTS;
   }
@@ -369,6 +584,8 @@ int srsran_ue_dl_decode_fft_estimate_noguru(srsran_ue_dl_t*     q,
                                             cf_t*               input[SRSRAN_MAX_PORTS])
 {
   if (q && input) {
+    q->ctrl_only_pending = false;
+
     /* Run FFT for all subframe data */
     for (int j = 0; j < q->nof_rx_antennas; j++) {
       if (sf->sf_type == SRSRAN_SF_MBSFN) {
@@ -377,7 +594,7 @@ int srsran_ue_dl_decode_fft_estimate_noguru(srsran_ue_dl_t*     q,
         srsran_ofdm_rx_sf_ng(&q->fft[j], input[j], q->sf_symbols[j]);
       }
     }
-    return estimate_pdcch_pcfich(q, sf, cfg);
+    return estimate_pdcch_pcfich(q, sf, cfg, 0);
   } else {
     return SRSRAN_ERROR_INVALID_INPUTS;
   }
@@ -986,6 +1203,13 @@ int srsran_ue_dl_decode_pdsch(srsran_ue_dl_t*     q,
                               srsran_pdsch_cfg_t* pdsch_cfg,
                               srsran_pdsch_res_t  data[SRSRAN_MAX_CODEWORDS])
 {
+  if (!q->pdsch_enable) {
+    ERROR("PDSCH is not available in a control-only ue_dl");
+    return SRSRAN_ERROR;
+  }
+  if (ue_dl_complete_fft_estimate(q)) {
+    return SRSRAN_ERROR;
+  }
   return srsran_pdsch_decode(&q->pdsch, sf, pdsch_cfg, &q->chest_res, q->sf_symbols, data);
 }
 
@@ -994,6 +1218,10 @@ int srsran_ue_dl_decode_pmch(srsran_ue_dl_t*     q,
                              srsran_pmch_cfg_t*  pmch_cfg,
                              srsran_pdsch_res_t  data[SRSRAN_MAX_CODEWORDS])
 {
+  if (!q->pdsch_enable) {
+    ERROR("PMCH is not available in a control-only ue_dl");
+    return SRSRAN_ERROR;
+  }
   return srsran_pmch_decode(&q->pmch, sf, pmch_cfg, &q->chest_res, q->sf_symbols, &data[0]);
 }
 
@@ -1036,6 +1264,15 @@ static int select_pmi(srsran_ue_dl_t* q, uint32_t ri, uint32_t* pmi, float* sinr
   uint32_t best_pmi = 0;
   float    sinr_list[SRSRAN_MAX_CODEBOOKS];
 
+  if (!q->pdsch_enable) {
+    return SRSRAN_ERROR;
+  }
+
+  // The PMI selection uses the channel estimates of the whole subframe
+  if (ue_dl_complete_fft_estimate(q)) {
+    return SRSRAN_ERROR;
+  }
+
   if (q->cell.nof_ports < 2) {
     /* Do nothing */
     return SRSRAN_SUCCESS;
@@ -1109,7 +1346,13 @@ static int select_ri_pmi(srsran_ue_dl_t* q, uint32_t* ri, uint32_t* pmi, float*
 int srsran_ue_dl_select_ri(srsran_ue_dl_t* q, uint32_t* ri, float* cn)
 {
   float _cn = INFINITY;
-  int   ret = srsran_pdsch_compute_cn(&q->pdsch, &q->chest_res, &_cn);
+  if (!q->pdsch_enable) {
+    return SRSRAN_ERROR;
+  }
+  if (ue_dl_complete_fft_estimate(q)) {
+    return SRSRAN_ERROR;
+  }
+  int ret = srsran_pdsch_compute_cn(&q->pdsch, &q->chest_res, &_cn);
 
   if (ret == SRSRAN_SUCCESS) {
     /* Set Condition number */
@@ -1879,10 +2122,6 @@ int srsran_ue_decode_dci_yx(srsran_ue_dl_t*     q,
 		//printf("rnti=0\n");
 		return 0;
 	}
-	srsran_dci_dl_t    dci_dl[SRSRAN_MAX_DCI_MSG] = {};
-	srsran_dci_ul_t    dci_ul[SRSRAN_MAX_DCI_MSG] = {};
-	//srsran_pusch_grant_t ul_grant;
-
 	srsran_pmch_cfg_t  pmch_cfg;
 
 	// Use default values for PDSCH decoder
@@ -1904,7 +2143,23 @@ int srsran_ue_decode_dci_yx(srsran_ue_dl_t*     q,
 		return ret; 
 	}
 
-	srsran_dci_location_t 	loc = {};
+	return srsran_ue_decode_dci_target_yx(q, sf, cfg, pdsch_cfg, dci_res, targetRNTI);
+}
+
+int srsran_ue_decode_dci_target_yx(srsran_ue_dl_t*        q,
+                                   srsran_dl_sf_cfg_t*    sf,
+                                   srsran_ue_dl_cfg_t*    cfg,
+                                   srsran_pdsch_cfg_t*    pdsch_cfg,
+                                   ngscope_dci_per_sub_t* dci_res,
+                                   uint16_t               targetRNTI)
+{
+	int ret = SRSRAN_ERROR;
+	if(targetRNTI == 0){
+		return 0;
+	}
+	srsran_dci_dl_t    dci_dl[SRSRAN_MAX_DCI_MSG] = {};
+	srsran_dci_ul_t    dci_ul[SRSRAN_MAX_DCI_MSG] = {};
+
 	/* Downlink dci decoding unpack and translation to grant*/
 	ret = srsran_ue_dl_find_dl_dci(q, sf, cfg, targetRNTI, dci_dl);
 	if (ret == 1) {
@@ -1916,8 +2171,10 @@ int srsran_ue_decode_dci_yx(srsran_ue_dl_t*     q,
 			//printf("FOUND DL DCI: tti:%d\tnof_prb:%d\tnof_tb:%d\ttbs1:%d\ttbs2:%d\tmcs1:%d\tmcs2:%d\n", sf->tti, pdsch_cfg->grant.nof_prb, 
 		//		pdsch_cfg->grant.nof_tb, pdsch_cfg->grant.tb[0].tbs, pdsch_cfg->grant.tb[1].tbs, pdsch_cfg->grant.tb[0].mcs_idx, pdsch_cfg->grant.tb[1].mcs_idx);
 			/* Copy single dci message */
-			copy_single_dl_dci(&dci_res->dl_msg[dci_res->nof_dl_dci], loc, 0, 0, &dci_dl[0], &pdsch_cfg->grant);
-			dci_res->nof_dl_dci += 1; 
+			if(dci_res->nof_dl_dci < MAX_DCI_PER_SUB){
+				copy_single_dl_dci(&dci_res->dl_msg[dci_res->nof_dl_dci], dci_dl[0].location, 0, 0, &dci_dl[0], &pdsch_cfg->grant);
+				dci_res->nof_dl_dci += 1; 
+			}
 		}
 	}else{
 		//printf("NO DCI found in dl!\n");
@@ -1938,8 +2195,10 @@ int srsran_ue_decode_dci_yx(srsran_ue_dl_t*     q,
 			//ERROR("Translate UL DCI to uplink grant");
 			return SRSRAN_ERROR;
 		}else{
-			copy_single_ul_dci(&dci_res->ul_msg[dci_res->nof_ul_dci], loc, 0, 0, &dci_ul[0], &dci_ul_grant);
-			dci_res->nof_ul_dci += 1; 
+			if(dci_res->nof_ul_dci < MAX_DCI_PER_SUB){
+				copy_single_ul_dci(&dci_res->ul_msg[dci_res->nof_ul_dci], dci_ul[0].location, 0, 0, &dci_ul[0], &dci_ul_grant);
+				dci_res->nof_ul_dci += 1; 
+			}
 		}
 		//printf("FOUND UL DCI: tti:%d\tnof_prb:%d\tnof_tb:%d\ttbs1:%d\ttbs2:%d\tmcs1:%d\tmcs2:%d\n", sf->tti, dci_res->ul_msg[0].prb, 
 	//		dci_res->ul_msg[0].nof_tb, dci_res->ul_msg[0].tb[0].tbs, dci_res->ul_msg[0].tb[1].tbs, dci_res->ul_msg[0].tb[0].mcs, dci_res->ul_msg[0].tb[1].tbs);
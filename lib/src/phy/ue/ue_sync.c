@@ -757,9 +757,8 @@ int srsran_ue_sync_zerocopy(srsran_ue_sync_t* q,
         }
       }
       if (q->cfo_correct_enable_track) {
-        for (int i = 0; i < q->nof_rx_antennas; i++) {
-          srsran_cfo_correct(&q->file_cfo_correct, input_buffer[i], input_buffer[i], q->file_cfo / 15000 / q->fft_size);
-        }
+        srsran_cfo_correct_multi_inplace(
+            &q->file_cfo_correct, input_buffer, q->nof_rx_antennas, q->file_cfo / 15000 / q->fft_size);
       }
       q->sf_idx++;
       if (q->sf_idx == 10) {
@@ -777,12 +776,8 @@ int srsran_ue_sync_zerocopy(srsran_ue_sync_t* q,
         case SF_FIND:
           // Correct CFO before PSS/SSS find using the sync object corrector (initialized for 1 ms)
           if (q->cfo_correct_enable_find) {
-            for (int i = 0; i < q->nof_rx_antennas; i++) {
-              if (input_buffer[i]) {
-                srsran_cfo_correct(
-                    &q->strack.cfo_corr_frame, input_buffer[i], input_buffer[i], -q->cfo_current_value / q->fft_size);
-              }
-            }
+            srsran_cfo_correct_multi_inplace(
+                &q->strack.cfo_corr_frame, input_buffer, q->nof_rx_antennas, -q->cfo_current_value / q->fft_size);
           }
 
           // Run mode-specific find operation
@@ -809,12 +804,8 @@ int srsran_ue_sync_zerocopy(srsran_ue_sync_t* q,
 
           // Correct CFO before PSS/SSS tracking using the sync object corrector (initialized for 1 ms)
           if (q->cfo_correct_enable_track) {
-            for (int i = 0; i < q->nof_rx_antennas; i++) {
-              if (input_buffer[i]) {
-                srsran_cfo_correct(
-                    &q->strack.cfo_corr_frame, input_buffer[i], input_buffer[i], -q->cfo_current_value / q->fft_size);
-              }
-            }
+            srsran_cfo_correct_multi_inplace(
+                &q->strack.cfo_corr_frame, input_buffer, q->nof_rx_antennas, -q->cfo_current_value / q->fft_size);
           }
 
           if (q->mode == SYNC_MODE_PSS) {
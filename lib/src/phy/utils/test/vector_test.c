@@ -120,6 +120,20 @@ TEST(
 
     free(x);)
 
+TEST(
+    srsran_vec_abs_acc_ff, MALLOC(float, x); float z = 0;
+
+    float gold = 0.0f;
+    for (int i = 0; i < block_size; i++) { x[i] = RANDOM_F(); }
+
+    TEST_CALL(z = srsran_vec_abs_acc_ff(x, block_size))
+
+        for (int i = 0; i < block_size; i++) { gold += fabsf(x[i]); }
+
+    mse += fabsf(gold - z) / gold;
+
+    free(x);)
+
 TEST(
     srsran_vec_dot_prod_sss, MALLOC(int16_t, x); MALLOC(int16_t, y); int16_t z = 0;
 
@@ -903,6 +917,10 @@ int main(int argc, char** argv)
         test_srsran_vec_acc_ff(func_names[func_count], &timmings[func_count][size_count], block_size);
     func_count++;
 
+    passed[func_count][size_count] =
+        test_srsran_vec_abs_acc_ff(func_names[func_count], &timmings[func_count][size_count], block_size);
+    func_count++;
+
     passed[func_count][size_count] =
         test_srsran_vec_dot_prod_sss(func_names[func_count], &timmings[func_count][size_count], block_size);
     func_count++;
@@ -42,6 +42,12 @@ float srsran_vec_acc_ff(const float* x, const uint32_t len)
   return srsran_vec_acc_ff_simd(x, len);
 }
 
+// Used in PDCCH for the CCE energy
+float srsran_vec_abs_acc_ff(const float* x, const uint32_t len)
+{
+  return srsran_vec_abs_acc_ff_simd(x, len);
+}
+
 cf_t srsran_vec_acc_cc(const cf_t* x, const uint32_t len)
 {
   return srsran_vec_acc_cc_simd(x, len);
@@ -857,6 +863,11 @@ void srsran_vec_apply_cfo(const cf_t* x, float cfo, cf_t* z, int len)
   srsran_vec_apply_cfo_simd(x, cfo, z, len);
 }
 
+void srsran_vec_apply_cfo_multi(cf_t** x, float cfo, cf_t** z, int nof_channels, int len)
+{
+  srsran_vec_apply_cfo_multi_simd(x, cfo, z, nof_channels, len);
+}
+
 float srsran_vec_estimate_frequency(const cf_t* x, int len)
 {
   return srsran_vec_estimate_frequency_simd(x, len);
@@ -624,6 +624,42 @@ float srsran_vec_acc_ff_simd(const float* x, const int len)
   return acc_sum;
 }
 
+float srsran_vec_abs_acc_ff_simd(const float* x, const int len)
+{
+  int   i       = 0;
+  float acc_sum = 0.0f;
+
+#if SRSRAN_SIMD_F_SIZE
+  simd_f_t simd_sum = srsran_simd_f_zero();
+
+  if (SRSRAN_IS_ALIGNED(x)) {
+    for (; i < len - SRSRAN_SIMD_F_SIZE + 1; i += SRSRAN_SIMD_F_SIZE) {
+      simd_f_t a = srsran_simd_f_abs(srsran_simd_f_load(&x[i]));
+
+      simd_sum = srsran_simd_f_add(simd_sum, a);
+    }
+  } else {
+    for (; i < len - SRSRAN_SIMD_F_SIZE + 1; i += SRSRAN_SIMD_F_SIZE) {
+      simd_f_t a = srsran_simd_f_abs(srsran_simd_f_loadu(&x[i]));
+
+      simd_sum = srsran_simd_f_add(simd_sum, a);
+    }
+  }
+
+  srsran_simd_aligned float sum[SRSRAN_SIMD_F_SIZE];
+  srsran_simd_f_store(sum, simd_sum);
+  for (int k = 0; k < SRSRAN_SIMD_F_SIZE; k++) {
+    acc_sum += sum[k];
+  }
+#endif
+
+  for (; i < len; i++) {
+    acc_sum += fabsf(x[i]);
+  }
+
+  return acc_sum;
+}
+
 cf_t srsran_vec_acc_cc_simd(const cf_t* x, const int len)
 {
   int  i       = 0;
@@ -1773,6 +1809,69 @@ void srsran_vec_apply_cfo_simd(const cf_t* x, float cfo, cf_t* z, int len)
   }
 }
 
+/* Samples after which the oscillator is re-seeded with the exact phase, bounds the drift of the incremental rotation
+ * and keeps the working set of all channels within the L1/L2 caches */
+#define APPLY_CFO_MULTI_BLOCK_LEN 2048
+
+void srsran_vec_apply_cfo_multi_simd(cf_t** x, float cfo, cf_t** z, int nof_channels, int len)
+{
+  const double TWOPI   = 2.0 * M_PI;
+  cf_t         osc     = cexpf(_Complex_I * (float)(TWOPI * cfo));
+  bool         aligned = true;
+
+  for (int ch = 0; ch < nof_channels; ch++) {
+    aligned &= SRSRAN_IS_ALIGNED(x[ch]) && SRSRAN_IS_ALIGNED(z[ch]);
+  }
+
+  for (int i0 = 0; i0 < len; i0 += APPLY_CFO_MULTI_BLOCK_LEN) {
+    int  i     = i0;
+    int  end   = (i0 + APPLY_CFO_MULTI_BLOCK_LEN < len) ? (i0 + APPLY_CFO_MULTI_BLOCK_LEN) : len;
+    cf_t phase = (cf_t)cexp(_Complex_I * fmod(TWOPI * cfo * i0, TWOPI));
+
+#if SRSRAN_SIMD_CF_SIZE
+    // Load initial phases and oscillator, they are generated once for all channels
+    srsran_simd_aligned cf_t _phase[SRSRAN_SIMD_CF_SIZE];
+    cf_t                     osc_n = osc;
+    _phase[0]                      = phase;
+    for (int k = 1; k < SRSRAN_SIMD_CF_SIZE; k++) {
+      _phase[k] = _phase[k - 1] * osc;
+      osc_n *= osc;
+    }
+    simd_cf_t _simd_osc   = srsran_simd_cf_set1(osc_n);
+    simd_cf_t _simd_phase = srsran_simd_cfi_load(_phase);
+
+    if (aligned) {
+      for (; i < end - SRSRAN_SIMD_CF_SIZE + 1; i += SRSRAN_SIMD_CF_SIZE) {
+        for (int ch = 0; ch < nof_channels; ch++) {
+          simd_cf_t a = srsran_simd_cfi_load(&x[ch][i]);
+          srsran_simd_cfi_store(&z[ch][i], srsran_simd_cf_prod(a, _simd_phase));
+        }
+        _simd_phase = srsran_simd_cf_prod(_simd_phase, _simd_osc);
+      }
+    } else {
+      for (; i < end - SRSRAN_SIMD_CF_SIZE + 1; i += SRSRAN_SIMD_CF_SIZE) {
+        for (int ch = 0; ch < nof_channels; ch++) {
+          simd_cf_t a = srsran_simd_cfi_loadu(&x[ch][i]);
+          srsran_simd_cfi_storeu(&z[ch][i], srsran_simd_cf_prod(a, _simd_phase));
+        }
+        _simd_phase = srsran_simd_cf_prod(_simd_phase, _simd_osc);
+      }
+    }
+
+    // Stores the next phase
+    srsran_simd_cfi_store(_phase, _simd_phase);
+    phase = _phase[0];
+#endif
+
+    for (; i < end; i++) {
+      for (int ch = 0; ch < nof_channels; ch++) {
+        z[ch][i] = x[ch][i] * phase;
+      }
+      phase *= osc;
+    }
+  }
+}
+
 float srsran_vec_estimate_frequency_simd(const cf_t* x, int len)
 {
   cf_t sum = 0.0f;
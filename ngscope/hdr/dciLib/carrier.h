@@ -0,0 +1,121 @@
+#ifndef NGSCOPE_CARRIER_H
+#define NGSCOPE_CARRIER_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "srsran/srsran.h"
+#include "ngscope_def.h"
+#include "task_scheduler.h"
+#include "task_sf_ring_buffer.h"
+#include "skip_tti.h"
+#include "ue_tracker.h"
+#include "ue_list.h"
+#include "phich_decoder.h"
+#include "ue_stats.h"
+#include "iq_snapshot.h"
+#include "target_rnti.h"
+
+/* Everything that belongs to one carrier (RF device).
+ * The contexts are allocated at start-up, on the NUMA node of the carrier's threads
+ * if one is configured. The number of carriers and of decoders per carrier is only
+ * limited by the config */
+typedef struct{
+    int                 rf_idx;
+    int                 nof_decoder;
+    int                 numa_node;          // -1: no binding
+    size_t              alloc_size;         // bytes of the context and its arrays
+
+    srsran_cell_t       cell;               // protected by cell_mutex, nof_prb > 0 once the cell is found
+
+    // task scheduler <-> decoders
+    ngscope_sf_buffer_t* sf_buffer;         // [nof_decoder]
+    bool*               sf_token;           // [nof_decoder], true if the decoder is busy
+    bool*               decoder_up;         // [nof_decoder]
+    pthread_mutex_t     token_mutex;
+    pthread_mutex_t     decoder_ready_mutex;// the decoders report to the task scheduler once ready (or failed)
+    pthread_cond_t      decoder_ready_cond;
+    int                 nof_decoder_ready;
+    int                 nof_decoder_failed;
+    bool                scheduler_up;
+    bool                scheduler_closed;   // protected by scheduler_close_mutex
+
+    // subframes waiting for an idle decoder
+    task_tmp_buffer_t   tmp_buffer;
+    task_skip_tti_t     skip_tti;
+    pthread_mutex_t     tmp_buf_mutex;
+
+    ngscope_ue_tracker_t ue_tracker;
+    pthread_mutex_t     ue_tracker_mutex;
+
+    // RNTIs of the hybrid search of this cell, from the config and the dci sink clients
+    ngscope_target_rnti_t target_rnti;
+
+    // UL grants of the target RNTIs waiting for their PHICH, no lock (see phich_decoder.h)
+    ngscope_phich_state_t phich;
+
+    // ue list of the cell status thread
+    ngscope_ue_list_t   ue_list;
+
+    // per UE statistics of the cell status thread, queried by the dci sink server
+    ngscope_ue_stats_report_t ue_stats;
+
+    // pdcch and csi plot of the first decoder
+    pthread_mutex_t     plot_mutex;
+    pthread_cond_t      plot_cond;
+    cf_t*               pdcch_buf;
+    float*              csi_amp;
+
+    // adaptive llr gate of the cell, learned by all its decoders
+    srsran_pdcch_llr_gate_t llr_gate;
+    pthread_mutex_t     llr_gate_mutex;
+
+    // decoded dci, watched by the sync supervisor
+    uint64_t            nof_dci_decoded;
+
+    // ring of the last synced subframes, dumped on a trigger
+    ngscope_iq_snapshot_t iq_snapshot;
+}ngscope_carrier_t;
+
+int  ngscope_carrier_list_init(int nof_carrier);
+void ngscope_carrier_list_free();
+int  ngscope_nof_carrier();
+
+// allocate the context of one carrier, numa_node < 0 leaves the placement to the kernel
+ngscope_carrier_t* ngscope_carrier_create(int rf_idx, int nof_decoder, int numa_node);
+
+// NULL if the carrier does not exist
+ngscope_carrier_t* ngscope_carrier(int rf_idx);
+
+// nof_prb of the cell, 0 if it is not found yet
+uint32_t ngscope_carrier_nof_prb(int rf_idx);
+
+/* Start-up of the decoders: each one reports once, whether it is ready to decode or it failed.
+ * The task scheduler waits for nof_decoder reports, it gets SRSRAN_ERROR if any decoder failed */
+void ngscope_carrier_decoders_reset(ngscope_carrier_t* q);
+void ngscope_carrier_decoder_ready(ngscope_carrier_t* q, bool ready);
+int  ngscope_carrier_wait_decoders(ngscope_carrier_t* q, int nof_decoder);
+
+/* NUMA helpers, they fall back to the default policy if the node is not available */
+void* ngscope_numa_alloc(size_t size, int numa_node);
+void  ngscope_numa_free(void* p, size_t size);
+
+// huge pages if the system has them reserved, transparent huge pages otherwise.
+// size must be a multiple of NGSCOPE_HUGE_PAGE_SIZE, the memory is freed with ngscope_numa_free
+#define NGSCOPE_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+void* ngscope_numa_alloc_huge(size_t size, int numa_node);
+
+// pin the calling thread to the cpus of the node, the threads it creates inherit the mask
+int   ngscope_numa_bind_thread(int numa_node);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
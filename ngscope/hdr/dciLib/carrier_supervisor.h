@@ -0,0 +1,110 @@
+#ifndef NGSCOPE_CARRIER_SUPERVISOR_H
+#define NGSCOPE_CARRIER_SUPERVISOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ngscope_def.h"
+
+// consecutive calls without a tracked subframe before we declare the sync lost
+#define SUPERVISOR_NO_SF_LIMIT          200
+// the PSS peak (fast average) falls below this ratio of its baseline ...
+#define SUPERVISOR_PEAK_RATIO           0.25
+// ... for this number of subframes
+#define SUPERVISOR_LOW_PEAK_LIMIT       100
+// tracked subframes before the PSS peak baseline is trusted
+#define SUPERVISOR_PEAK_WARMUP          1000
+// SFN corrections of the MIB stage inside the window that indicate a bad timing
+#define SUPERVISOR_MAX_SFN_JUMP         3
+#define SUPERVISOR_SFN_JUMP_WINDOW_MS   10000
+// the decoded dci are counted over windows of this number of subframes
+#define SUPERVISOR_RATE_WINDOW          1000
+#define SUPERVISOR_RATE_WARMUP          5       // windows before the baseline is trusted
+#define SUPERVISOR_MIN_RATE             50      // dci per window, below that the cell is idle
+#define SUPERVISOR_RATE_RATIO           0.1
+// resync without success for this long -> search the cell again
+#define SUPERVISOR_RESYNC_TIMEOUT_MS    2000
+// wait between two failed cell searches
+#define SUPERVISOR_RESEARCH_BACKOFF_MS  1000
+
+typedef enum{
+    SUPERVISOR_INIT = 0,    // initial acquisition, nothing to supervise yet
+    SUPERVISOR_TRACKING,
+    SUPERVISOR_RESYNC,      // ue_sync is searching the PSS again
+    SUPERVISOR_RESEARCH,    // the cell is searched again, the radio is restarted
+}ngscope_supervisor_state_t;
+
+typedef enum{
+    SUPERVISOR_ACTION_NONE = 0,
+    SUPERVISOR_ACTION_RESYNC,
+    SUPERVISOR_ACTION_RESEARCH,
+}ngscope_supervisor_action_t;
+
+/* Per-carrier sync supervisor, driven by the sync stage of the task scheduler.
+ * It watches the loss indicators and tells the scheduler when to resync or
+ * to search the cell again. The recovery time (loss -> SFN locked again)
+ * is logged to supervisor_<rf_idx>.txt */
+typedef struct{
+    int                         rf_idx;
+    ngscope_supervisor_state_t  state;
+    int64_t                     t_state;        // ms, entering the current state
+    int64_t                     t_lost;         // ms, when the loss is detected
+    const char*                 reason;
+
+    // indicators
+    uint32_t    nof_no_sf;
+    uint32_t    nof_tracked;
+    float       peak_avg;
+    float       peak_baseline;
+    uint32_t    nof_low_peak;
+    int64_t     t_sfn_jump[SUPERVISOR_MAX_SFN_JUMP];
+    uint32_t    sfn_jump_idx;
+    uint32_t    nof_rate_sf;
+    uint64_t    last_nof_dci;
+    uint32_t    nof_rate_window;
+    float       rate_baseline;
+
+    // metrics
+    uint32_t    nof_loss;
+    uint32_t    nof_recovery;
+    uint32_t    nof_research;
+    int64_t     last_recovery_ms;
+    int64_t     max_recovery_ms;
+    int64_t     sum_recovery_ms;
+
+    FILE*       fd;
+}ngscope_supervisor_t;
+
+int  supervisor_init(ngscope_supervisor_t* q, int rf_idx);
+void supervisor_free(ngscope_supervisor_t* q);
+
+/* Called after every srsran_ue_sync_zerocopy call
+ * tracked:     a subframe is returned
+ * pss_peak:    peak value of the tracking sync
+ * sfn_locked:  the SFN is verified by the MIB stage
+ * sfn_jump:    the MIB stage corrected the SFN */
+ngscope_supervisor_action_t supervisor_update(ngscope_supervisor_t* q,
+                                                bool tracked,
+                                                float pss_peak,
+                                                bool sfn_locked,
+                                                bool sfn_jump);
+
+// the rx ring gave up on the radio (see rx_ring_failed), the radio is restarted by a cell search
+ngscope_supervisor_action_t supervisor_rf_failed(ngscope_supervisor_t* q);
+
+// result of a cell search triggered by SUPERVISOR_ACTION_RESEARCH
+void supervisor_research_done(ngscope_supervisor_t* q, bool found);
+
+// the dci decoders of the carrier report the number of decoded dci
+void supervisor_dci_decoded(int rf_idx, uint32_t nof_dci);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -26,7 +26,9 @@ typedef struct{
     int         nof_cell;
     int         remote_sock;
 	bool 		remote_enable;
-    int         cell_prb[MAX_NOF_RF_DEV];
+	int 		reorder_latency;
+	int 		stats_window;    // ms of the per UE statistics
+	int 		stats_interval;  // ms between two statistics reports to the sink, 0: only on query
 }cell_status_info_t;
 
 void* cell_status_thread(void* arg);
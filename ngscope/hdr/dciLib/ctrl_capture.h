@@ -0,0 +1,133 @@
+#ifndef NGSCOPE_CTRL_CAPTURE_H
+#define NGSCOPE_CTRL_CAPTURE_H
+
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ngscope_def.h"
+
+#define CTRL_CAPTURE_MAGIC      0x4c525443  // "CTRL"
+#define CTRL_CAPTURE_VERSION    1
+#define CTRL_CAPTURE_RING       128         // subframes between the sync thread and the writer
+#define CTRL_CAPTURE_MAX_SYMB   4
+
+/* Control region capture: instead of the IQ samples, every synced subframe
+ * is stored as the REs of the OFDM symbols that can carry the control
+ * channels (the PCFICH, PHICH, PDCCH and the CRS of the control region
+ * estimation, i.e., 3 symbols, 4 for 10 PRB or less). The REs of each
+ * symbol and antenna are quantised to 8 or 16 bit with their own scale.
+ * With 8 bit a 20 MHz cell takes ~7 kB per subframe and antenna, instead
+ * of the 123 kB of the 16 bit IQ samples.
+ *
+ * File: ctrl_capture_header_t, then one record per subframe:
+ *   ctrl_capture_record_t
+ *   float   scale[nof_rx_ant][nof_symbols]        value = code * scale
+ *   int8/16 re[nof_rx_ant][nof_symbols][2 * nof_re] I, Q interleaved
+ * The fields are laid out without padding, the file is little endian. */
+typedef struct{
+    uint32_t magic;
+    uint16_t version;
+    uint8_t  nof_bits;          // 8 or 16
+    uint8_t  nof_rx_ant;
+    uint8_t  nof_symbols;       // OFDM symbols per record
+    uint8_t  nof_ports;         // of the cell
+    uint8_t  cp;                // srsran_cp_t
+    uint8_t  frame_type;        // srsran_frame_type_t
+    uint8_t  phich_length;      // srsran_phich_length_t
+    uint8_t  phich_resources;   // srsran_phich_r_t
+    uint16_t cell_id;
+    uint32_t nof_prb;
+    uint32_t record_len;        // bytes, the record header included
+    double   rf_freq;           // Hz
+    int64_t  start_time_us;     // wall clock when the capture started
+}ctrl_capture_header_t;
+
+typedef struct{
+    uint32_t tti;
+    uint32_t nof_drop;          // subframes dropped since the previous record (writer too slow)
+    int64_t  air_time_us;
+}ctrl_capture_record_t;
+
+/* Writer, the sync thread hands over the synced subframes. It only copies
+ * the samples of the control region into a ring, the writer thread runs
+ * the FFT, the quantisation and the file IO. A full ring drops the subframe
+ * instead of blocking the sync thread */
+typedef struct{
+    ctrl_capture_header_t header;
+    int                 rf_idx;
+    FILE*               fd;
+    uint32_t            nof_re;         // per symbol
+    uint32_t            nof_samples;    // time samples of the control region per antenna
+
+    srsran_ofdm_t       fft[SRSRAN_MAX_PORTS];
+    cf_t*               fft_in[SRSRAN_MAX_PORTS];
+    cf_t*               fft_out[SRSRAN_MAX_PORTS];
+    uint8_t*            record;
+
+    // ring of control region samples [CTRL_CAPTURE_RING][nof_rx_ant][nof_samples]
+    cf_t*               ring;
+    uint32_t            ring_tti[CTRL_CAPTURE_RING];
+    int64_t             ring_air_time_us[CTRL_CAPTURE_RING];
+    uint32_t            ring_nof_drop[CTRL_CAPTURE_RING];
+    uint32_t            header_idx;     // next slot of the sync thread
+    uint32_t            tail_idx;       // next slot of the writer
+    uint32_t            nof_drop;       // since the last queued subframe
+
+    pthread_mutex_t     mutex;
+    pthread_cond_t      cond;
+    bool                running;
+    pthread_t           writer_thd;
+
+    uint64_t            nof_record;
+    uint64_t            nof_drop_total;
+}ngscope_ctrl_capture_t;
+
+int  ctrl_capture_init(ngscope_ctrl_capture_t* q, const char* path, srsran_cell_t* cell,
+                            uint32_t nof_rx_ant, int nof_bits, double rf_freq, int rf_idx);
+int  ctrl_capture_start(ngscope_ctrl_capture_t* q);
+// the queued subframes are written before the writer exits
+void ctrl_capture_stop(ngscope_ctrl_capture_t* q);
+void ctrl_capture_free(ngscope_ctrl_capture_t* q);
+
+/* Called by the sync thread for every synced subframe with a valid TTI, never blocks */
+void ctrl_capture_subframe(ngscope_ctrl_capture_t* q, cf_t* IQ_buffer[SRSRAN_MAX_PORTS], uint32_t tti, int64_t air_time_us);
+
+/* Reader of a capture. The REs are dequantised into the buffers of the
+ * caller, typically srsran_ue_dl_ctrl_symbols() of a decoder */
+typedef struct{
+    ctrl_capture_header_t header;
+    FILE*               fd;
+    uint32_t            nof_re;
+    uint8_t*            record;
+    uint64_t            nof_record;
+    uint64_t            nof_drop;
+}ngscope_ctrl_replay_t;
+
+int  ctrl_replay_open(ngscope_ctrl_replay_t* q, const char* path);
+void ctrl_replay_close(ngscope_ctrl_replay_t* q);
+
+// the cell of the capture
+void ctrl_replay_cell(ngscope_ctrl_replay_t* q, srsran_cell_t* cell);
+
+/* Read the next record, returns 1 if a subframe has been read, 0 at the end of the file, -1 on error */
+int  ctrl_replay_read(ngscope_ctrl_replay_t* q, cf_t* symbols[SRSRAN_MAX_PORTS], uint32_t* tti, int64_t* air_time_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
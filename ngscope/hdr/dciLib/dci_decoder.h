@@ -22,6 +22,7 @@ extern "C" {
 
 
 #include "radio.h"
+#include "sib_worker.h"
 
 typedef struct{
     srsran_ue_dl_t     ue_dl;
@@ -32,9 +33,12 @@ typedef struct{
     prog_args_t        prog_args;
     int                decoder_idx;
     ASNDecoder * decoder;
+    ngscope_sib_worker_t* sib_worker;    // shared by the decoders of the cell, NULL if we skip the SIBs
+    uint32_t           si_seq;           // the system information we have taken from the worker
 }ngscope_dci_decoder_t;
 
 typedef struct{
+	int rf_idx;
 	int decoder_idx;
 	int nof_pdcch_sample;
 	int nof_prb;
@@ -45,14 +49,14 @@ int dci_decoder_init(ngscope_dci_decoder_t*     dci_decoder,
                         prog_args_t             prog_args,
                         srsran_cell_t*          cell,
                         cf_t*                   sf_buffer[SRSRAN_MAX_PORTS],
-                        srsran_softbuffer_rx_t* rx_softbuffers,
+                        ngscope_sib_worker_t*   sib_worker,
                         int                     decoder_idx,
                         ASNDecoder * decoder);
 
 int dci_decoder_decode(ngscope_dci_decoder_t*       dci_decoder,
                             uint32_t                sf_idx,
                             uint32_t                sfn,
-							uint8_t*                data[SRSRAN_MAX_CODEWORDS],
+							cf_t*                   iq[SRSRAN_MAX_PORTS],
                             ngscope_dci_per_sub_t*  dci_per_sub);
 
 void* dci_decoder_thread(void* p);
@@ -25,7 +25,6 @@
 extern "C" {
 #endif
 typedef struct{
-    int         		cell_prb[MAX_NOF_RF_DEV];
 	ngscope_config_t 	config;
 
 }log_config_t;
@@ -34,26 +33,22 @@ typedef struct{
     int         nof_cell;
     uint16_t    targetRNTI;
 
-	FILE* 		fd_dl[MAX_NOF_RF_DEV];
-	FILE* 		fd_ul[MAX_NOF_RF_DEV];
-	FILE* 		fd_phich[MAX_NOF_RF_DEV];
-	bool  		log_dl[MAX_NOF_RF_DEV];
-	bool  		log_ul[MAX_NOF_RF_DEV];
-	bool  		log_phich[MAX_NOF_RF_DEV];
-
-	// recording the current header of the dci ring buffer 
-	int 		curr_header[MAX_NOF_RF_DEV];
-	// record whether the cell is ready or notr 
-	bool 		cell_ready[MAX_NOF_RF_DEV];
+	// all arrays are [nof_cell]
+	FILE** 		fd_dl;
+	FILE** 		fd_ul;
+	FILE** 		fd_phich;
+	bool*  		log_dl;
+	bool*  		log_ul;
+	bool*  		log_phich;
 
 	FILE* 		fd_log_cell;
 
 }ngscope_dci_log_config_t;
 
 
-void fill_file_descriptor(FILE* fd_dl[MAX_NOF_RF_DEV],
-							FILE* 	fd_ul[MAX_NOF_RF_DEV],
-							FILE* 	fd_phich[MAX_NOF_RF_DEV],
+void fill_file_descriptor(FILE** fd_dl,
+							FILE** 	fd_ul,
+							FILE** 	fd_phich,
 							ngscope_config_t* config);
 //
 //							bool 	log_dl, 
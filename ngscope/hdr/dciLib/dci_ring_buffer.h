@@ -16,6 +16,7 @@
 
 #include "srsran/srsran.h"
 #include "ngscope_def.h"
+#include "tti_reorder.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -26,7 +27,7 @@ extern "C" {
 typedef struct{
 	uint16_t 	tti;
 
-	bool 		filled;
+	bool 		gap;         // no result from the decoders within the latency bound
     uint8_t     cell_dl_prb; // total cell downlink prb
     uint8_t     cell_ul_prb; // total cell uplink prb
 
@@ -36,7 +37,8 @@ typedef struct{
     uint8_t     nof_dl_msg; 
     uint8_t     nof_ul_msg;
 
-    uint64_t    timestamp_us; // time stamp of the decode msg
+    uint64_t    timestamp_us; // air time of the subframe
+    uint64_t    decode_us;    // when the decoding of the subframe completed
 
 	ngscope_dci_msg_t dl_msg[MAX_DCI_PER_SUB];
     ngscope_dci_msg_t ul_msg[MAX_DCI_PER_SUB];
@@ -44,17 +46,15 @@ typedef struct{
 }sf_status_t;
 
 typedef struct{
-	uint16_t 	cell_header;
     uint16_t    targetRNTI;
 
 	int 		cell_idx;
 	bool 	 	cell_ready; //If the cell is ready
 
 	int 		cell_prb; 	//Total PRB the cell has
-	int 		nof_logged_dci;
-	int 		most_recent_sf;
 
 	int 		buf_size;
+	ngscope_tti_reorder_t reorder;  // releases the subframes in TTI order
 
 	//sf_status_t sub_stat[NOF_LOG_SUBF];
 	sf_status_t* sub_stat;
@@ -67,21 +67,35 @@ typedef struct{
     uint16_t    targetRNTI;
 	int 		buf_size;
 	int         nof_cell;
-    int         header;
-    int         cell_prb[MAX_NOF_RF_DEV];
     bool        all_cell_ready;
+    uint32_t    watermark;  // every cell is complete or timed out before this TTI
 }CA_status_t;
 
 /*Carrer Aggregation related */
-int CA_status_init(CA_status_t* q, int buf_size, uint16_t targetRNTI, int nof_cell, int cell_prb[MAX_NOF_RF_DEV]);
-void CA_status_update_header(CA_status_t* q, ngscope_cell_dci_ring_buffer_t  p[MAX_NOF_RF_DEV]);
+int CA_status_init(CA_status_t* q, int buf_size, uint16_t targetRNTI, int nof_cell);
+void CA_status_update_watermark(CA_status_t* q, ngscope_cell_dci_ring_buffer_t* p);
 
 
 /*Single Cell related */
-int dci_ring_buffer_init(ngscope_cell_dci_ring_buffer_t* q, uint16_t targetRNTI, int cell_prb, int cell_idx, int buf_size);
+int dci_ring_buffer_init(ngscope_cell_dci_ring_buffer_t* q,
+                         uint16_t                        targetRNTI,
+                         int                             cell_prb,
+                         int                             cell_idx,
+                         int                             buf_size,
+                         int                             max_latency);
 int dci_ring_buffer_delete(ngscope_cell_dci_ring_buffer_t* q);
-void dci_ring_buffer_put_dci(ngscope_cell_dci_ring_buffer_t* q, ngscope_status_buffer_t* dci_buffer, int remote_sock);
-void dci_ring_buffer_clear_cell_fill_flag(ngscope_cell_dci_ring_buffer_t* q, int cell_idx);
+
+/* Returns TTI_REORDER_JUMP if the subframe is too far ahead of the pending ones:
+ * release everything up to dci_ring_buffer_end, reset and put it again */
+int dci_ring_buffer_put_dci(ngscope_cell_dci_ring_buffer_t* q, ngscope_status_buffer_t* dci_buffer);
+void dci_ring_buffer_reset(ngscope_cell_dci_ring_buffer_t* q);
+
+/* Next subframe before limit in TTI order, NULL if there is none */
+sf_status_t* dci_ring_buffer_pop(ngscope_cell_dci_ring_buffer_t* q, uint32_t limit);
+uint32_t dci_ring_buffer_frontier(ngscope_cell_dci_ring_buffer_t* q);
+uint32_t dci_ring_buffer_end(ngscope_cell_dci_ring_buffer_t* q);
+
+int push_dci_to_remote(sf_status_t* q, int cell_idx, uint16_t targetRNTI, int remote_sock);
 #ifdef __cplusplus
 }
 #endif
@@ -17,4 +17,13 @@
 
 void* dci_sink_client_thread(void* p);
 
+// op is a target_rnti_op_t of dci_sink_def.h, cell_idx 0xFF edits the lists of all the cells
+int sock_send_target_rnti_udp(int sockfd, char serv_IP[40], int serv_port, uint8_t cell_idx, uint8_t op, uint16_t* rnti, int nof_rnti);
+
+// query the per UE statistics, the server replies with ue_stats messages (dci_sink_def.h)
+int sock_send_ue_stats_query_udp(int sockfd, char serv_IP[40], int serv_port, uint8_t cell_idx, uint16_t rnti);
+
+// dump the IQ snapshot ring of the cell (0xFF: all) at the server, see dci_sink_def.h
+int sock_send_iq_snapshot_request_udp(int sockfd, char serv_IP[40], int serv_port, uint8_t cell_idx);
+
 #endif
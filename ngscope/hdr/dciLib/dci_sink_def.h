@@ -18,6 +18,7 @@
 #include <stdbool.h>
 
 
+// cells of the sink protocol (cell_config_t), the extra carriers are not reported
 #define MAX_NOF_CELL 4
 #define NOF_LOG_DCI 1000
 #define MAX_CLIENT 5
@@ -43,6 +44,10 @@ typedef struct{
     uint32_t ul_tbs;
     uint8_t  ul_reTx;
 	bool 	 ul_rv_flag;
+
+	// time_stamp is the air time of the subframe, this one when NG-Scope decoded it
+	// (at the end so that the clients reading the fields above keep working)
+	uint64_t decode_time_stamp;
 }ue_dci_t;
 
 
@@ -54,5 +59,64 @@ typedef struct{
 	uint16_t rnti;
 }cell_config_t;
 
+// Per UE statistics of the analytics stage over its sliding window.
+// Sent with preamble 0xEE 0xEE 0xEE 0xEE | protocol version: 8 bits | ue_stats_header_t | ue_stats_t x nof_ue of the message,
+// every stats_interval ms and as the reply of a query of the client:
+// preamble 0xEE 0xEE 0xEE 0xEE | cell_idx: 8 bits (0xFF: all the cells) | rnti: 16 bits (0: all the UEs)
+#define UE_STATS_MCS_BINS 	8 	// MCS 0-3, 4-7, ..., 28-31
+#define UE_STATS_MAX_UE 	64 	// the UEs with the most traffic
+#define UE_STATS_PER_MSG 	10 	// UEs per UDP message
+
+typedef struct{
+	uint16_t rnti;
+
+	// goodput: a transport block is counted once, its retransmissions are not
+	float 	 dl_kbps;
+	float 	 ul_kbps;
+	uint32_t dl_bits;
+	uint32_t ul_bits;
+	uint32_t dl_reTx_bits;
+	uint32_t ul_reTx_bits;
+	uint32_t dl_nof_tb;
+	uint32_t ul_nof_tb;
+	uint32_t dl_nof_reTx;
+	uint32_t ul_nof_reTx;
+
+	// PRBs of the UE over the PRBs of the decoded subframes
+	float 	 dl_prb_share;
+	float 	 ul_prb_share;
+
+	// MCS of the new transport blocks
+	uint32_t dl_mcs_hist[UE_STATS_MCS_BINS];
+	uint32_t ul_mcs_hist[UE_STATS_MCS_BINS];
+}ue_stats_t;
+
+typedef struct{
+	uint8_t  cell_idx;
+	uint16_t tti; 				// last subframe of the window
+	uint64_t time_stamp; 		// its air time
+	uint16_t window_ms; 		// shorter than the configured window until it is filled
+	uint16_t nof_sf; 			// decoded subframes of the window, the ones the decoders missed are not counted
+	uint16_t nof_prb;
+	float 	 cell_dl_prb_share; // all the UEs
+	float 	 cell_ul_prb_share;
+	uint16_t nof_ue; 			// UEs of the report
+	uint8_t  msg_idx; 			// the report is split in messages of UE_STATS_PER_MSG UEs
+	uint8_t  nof_msg;
+}ue_stats_header_t;
+
+// Control message from a client that edits the RNTI list of the hybrid search:
+// preamble: 0xDD 0xDD 0xDD 0xDD | op: 8 bits | nof_rnti: 8 bits | rnti: 16 bits x nof_rnti | cell_idx: 8 bits
+// Every cell has its own list, cell_idx 0xFF (or a message without it) edits the lists of all the cells
+#define MAX_TARGET_RNTI 16
+typedef enum{
+	TARGET_RNTI_SET = 0,	// replace the list
+	TARGET_RNTI_ADD,		// add the RNTIs to the list
+	TARGET_RNTI_REMOVE,		// remove the RNTIs from the list
+}target_rnti_op_t;
+
+// Request of a client to dump the IQ snapshot ring of the cells (if configured), no reply:
+// preamble: 0x99 0x99 0x99 0x99 | cell_idx: 8 bits (0xFF: all the cells)
+
 
 #endif
@@ -44,5 +44,9 @@ void sock_update_client_list_addr(client_list_t* q, struct sockaddr_in* addr);
 int sock_send_config(ngscope_dci_sink_serv_t* q, cell_config_t* cell_config);
 int sock_send_single_dci(ngscope_dci_sink_serv_t* q, ue_dci_t* ue_dci, int proto_v);
 
+// header->nof_ue UEs of ue, to the addresses or to all the clients of the sink
+int sock_send_ue_stats(int sockfd, struct sockaddr_in* addr, int nof_addr, ue_stats_header_t* header, ue_stats_t* ue);
+int sock_send_ue_stats_to_clients(ngscope_dci_sink_serv_t* q, ue_stats_header_t* header, ue_stats_t* ue);
+
 struct sockaddr_in sock_create_serv_addr(char serv_IP[40], int serv_port);
 #endif
@@ -10,6 +10,30 @@
 extern "C" {
 #endif
 
+// DCI of the SI-RNTI only, the ue_dl may be a control-only one. Returns the number of DCIs found
+int srsran_ue_dl_find_sib_dci(srsran_ue_dl_t *q, srsran_dl_sf_cfg_t *sf, srsran_ue_dl_cfg_t *cfg, srsran_dci_dl_t dci_dl[SRSRAN_MAX_DCI_MSG]);
+
+// System information the decoders need, filled from the decoded SIBs
+typedef struct{
+    int     value_tag;      // systemInfoValueTag of SIB1, -1 if unknown
+    bool    tdd_present;    // TDD configuration of SIB1
+    int     sf_config;
+    int     tdd_special_sf;
+    bool    ul_bw_present;  // ul-Bandwidth of SIB2, absent if UL and DL have the same bandwidth
+    int     ul_nof_prb;
+}ngscope_si_params_t;
+
+// PDSCH of a SIB whose DCI is known, the subframe must have been estimated by the same ue_dl.
+// Returns the payload length in bytes, 0 if the CRC failed
+int srsran_ue_dl_decode_sib_pdsch(srsran_ue_dl_t *q, srsran_dl_sf_cfg_t *sf, srsran_ue_dl_cfg_t *cfg, srsran_pdsch_cfg_t *pdsch_cfg, srsran_dci_dl_t *dci_dl, uint8_t *data[SRSRAN_MAX_CODEWORDS], bool acks[SRSRAN_MAX_CODEWORDS], bool sib1);
+
+// ASN.1 decoding of a SIB payload (len in bytes): print it, log it and update params (may be NULL).
+// types gets the SIBs of the message, e.g. "sib1" or "sib3 sib5" (may be NULL)
+int ngscope_sib_parse(const uint8_t *payload, uint32_t len, bool sib1, ngscope_si_params_t *params, char *types, uint32_t types_len);
+
+// PDSCH and ASN.1 decoding of a SIB
+int srsran_ue_dl_decode_sib(srsran_ue_dl_t *q, srsran_dl_sf_cfg_t *sf, srsran_ue_dl_cfg_t *cfg, srsran_pdsch_cfg_t *pdsch_cfg, srsran_dci_dl_t *dci_dl, uint8_t *data[SRSRAN_MAX_CODEWORDS], bool acks[SRSRAN_MAX_CODEWORDS], bool sib1);
+
 int srsran_ue_dl_find_and_decode_sib1(srsran_ue_dl_t *q, srsran_dl_sf_cfg_t *sf, srsran_ue_dl_cfg_t *cfg, srsran_pdsch_cfg_t *pdsch_cfg, uint8_t *data[SRSRAN_MAX_CODEWORDS], bool acks[SRSRAN_MAX_CODEWORDS]);
 
 int srsran_ue_dl_find_and_decode_sib2(srsran_ue_dl_t *q, srsran_dl_sf_cfg_t *sf, srsran_ue_dl_cfg_t *cfg, srsran_pdsch_cfg_t *pdsch_cfg, uint8_t *data[SRSRAN_MAX_CODEWORDS], bool acks[SRSRAN_MAX_CODEWORDS]);
@@ -0,0 +1,121 @@
+#ifndef NGSCOPE_IQ_SNAPSHOT_H
+#define NGSCOPE_IQ_SNAPSHOT_H
+
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ngscope_def.h"
+
+#define IQ_SNAPSHOT_MAX_MS      60000
+#define IQ_SNAPSHOT_HOLDOFF_MS  10000   // between the start of two dumps
+#define IQ_SNAPSHOT_RATE_SF     1000    // subframes of the decode rate and the skip burst windows
+
+typedef enum{
+    IQ_SNAPSHOT_NONE = 0,
+    IQ_SNAPSHOT_API,            // request of a dci sink client
+    IQ_SNAPSHOT_SKIP,           // burst of subframes skipped because all the decoders were busy
+    IQ_SNAPSHOT_SYNC_LOSS,      // the supervisor lost the sync
+    IQ_SNAPSHOT_DECODE_RATE,    // fewer dci than configured in the last window
+    IQ_SNAPSHOT_NOF_REASON,
+}ngscope_iq_snapshot_reason_t;
+
+/* Post-mortem snapshots: the last nof_slot synced subframes of a carrier.
+ * The ring slots are the receive buffers of ue_sync: while the cell is
+ * tracked, the sync thread points ue_sync at the next slot, so that keeping
+ * the history costs no copy. A trigger (any thread) is taken by the sync
+ * thread, which hands the subframes of the ring to the dump thread. The
+ * slots of the dump are not reused until they are written, the sync thread
+ * falls back to its own buffer meanwhile instead of waiting.
+ *
+ * A dump is <path>_rf<idx>_<time ms>_<reason>.bin, the samples of the
+ * subframes in srsran_filesink format (complex float, antennas interleaved),
+ * readable by cellinspector and pdcch_file_test, and a .txt with the cell,
+ * the TTI of the first subframe and the TTI gaps of the file */
+typedef struct{
+    bool                enabled;
+    int                 rf_idx;
+    srsran_cell_t       cell;
+    double              rf_freq;
+    char                path[256];
+
+    // ring [nof_slot][nof_rx_ant][slot_len]
+    cf_t*               ring;
+    size_t              ring_size;      // bytes
+    uint32_t            nof_slot;
+    uint32_t            nof_rx_ant;
+    uint32_t            sf_len;         // samples of a subframe
+    uint32_t            slot_len;       // sf_len rounded up to the cache line
+    uint32_t*           slot_tti;
+    int64_t*            slot_air_time_us;
+    uint64_t            head_seq;       // sequence number of the next subframe, owned by the sync thread
+
+    // triggers
+    int                 pending;        // ngscope_iq_snapshot_reason_t, set by any thread
+    uint32_t            skip_limit;     // 0: off
+    uint32_t            nof_skip;
+    uint32_t            min_dci;        // 0: off
+    uint64_t*           nof_dci;        // counter of the decoders
+    uint64_t            last_nof_dci;
+    uint32_t            nof_rate_sf;
+
+    // the dump [dump_start, dump_end), the slots from dump_pos on are still to be written
+    bool                dumping;
+    uint64_t            dump_start;
+    uint64_t            dump_end;
+    uint64_t            dump_pos;
+    int                 dump_reason;
+    int64_t             t_last_dump;    // ms
+    sem_t               dump_sem;
+    bool                running;
+    pthread_t           dump_thd;
+
+    // metrics
+    uint32_t            nof_dump;
+    uint32_t            nof_ignored;    // triggers during a dump or the holdoff
+    uint64_t            nof_pinned;     // subframes not kept since their slot was being dumped
+}ngscope_iq_snapshot_t;
+
+/* nof_dci is the decoded dci counter for the decode rate trigger (min_dci per
+ * IQ_SNAPSHOT_RATE_SF subframes), skip_limit the skipped subframes per
+ * IQ_SNAPSHOT_RATE_SF subframes that trigger a dump. Run by the sync thread,
+ * the ring is placed on its NUMA node */
+int  iq_snapshot_init(ngscope_iq_snapshot_t* q, const char* path, int duration_ms, srsran_cell_t* cell,
+                        uint32_t nof_rx_ant, double rf_freq, int rf_idx, int numa_node,
+                        uint32_t skip_limit, uint32_t min_dci, uint64_t* nof_dci);
+int  iq_snapshot_start(ngscope_iq_snapshot_t* q);
+// a dump in progress is completed
+void iq_snapshot_stop(ngscope_iq_snapshot_t* q);
+void iq_snapshot_free(ngscope_iq_snapshot_t* q);
+
+/* Ask for a dump, from any thread. Ignored if the snapshots are not enabled */
+void iq_snapshot_trigger(ngscope_iq_snapshot_t* q, ngscope_iq_snapshot_reason_t reason);
+
+/* Sync thread only, none of them blocks */
+// start the dump of a pending trigger, called once per loop of the sync thread
+void iq_snapshot_poll(ngscope_iq_snapshot_t* q);
+// point buffers at the slot of the next subframe, false if the slot is still being dumped
+bool iq_snapshot_next(ngscope_iq_snapshot_t* q, cf_t* buffers[SRSRAN_MAX_PORTS]);
+// the subframe received into the slot of iq_snapshot_next is synced, keep it
+void iq_snapshot_commit(ngscope_iq_snapshot_t* q, uint32_t tti, int64_t air_time_us);
+// a subframe has been skipped, all the decoders were busy
+void iq_snapshot_skipped(ngscope_iq_snapshot_t* q);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
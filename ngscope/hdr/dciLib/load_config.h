@@ -2,6 +2,7 @@
 #define _CONFIG_H_
 #include <stdio.h>
 #include "task_scheduler.h"
+#include "dci_sink_def.h"
 
 typedef struct{
     long long   rf_freq;
@@ -12,6 +13,16 @@ typedef struct{
 	int 		log_dl;
 	int			log_ul;
     int         log_phich;
+    int         numa_node;  // optional, NUMA node of the carrier threads and buffers (-1: any)
+    char        ctrl_capture[256];  // optional, record the control region of the synced subframes
+    int         ctrl_capture_bits;  // 8 or 16
+    char        ctrl_replay[256];   // optional, decode a control region capture instead of the radio
+    int         iq_snapshot_ms;     // optional, keep the IQ of the last synced subframes for a dump (0: off)
+    char        iq_snapshot_path[256];
+    int         iq_snapshot_skip;   // dump after this many skipped subframes within a second (0: off)
+    int         iq_snapshot_min_dci;// dump if fewer dci are decoded within a second (0: off)
+    int         nof_target_rnti;    // optional, rnti list of the hybrid search (default: the global list)
+    uint16_t    target_rnti[MAX_TARGET_RNTI];
 }rf_dev_config_t;
 
 typedef struct{
@@ -30,11 +41,21 @@ typedef struct{
     int                 remote_enable;
 	int 				decode_single_ue;
 	int 				decode_SIB;
+	int 				adaptive_llr_gate;
+	int 				hybrid_search;
+	int 				full_search_interval;
+	int 				batch_max_sf;       // backlogged subframes demodulated together by one decoder
+	int 				batch_threshold;    // backlog that starts the batches
+	int 				reorder_latency;    // subframes a missing result is waited for before it is a gap
+	int 				stats_window;       // ms of the per UE statistics
+	int 				stats_interval;     // ms between two statistics reports to the sink, 0: only on query
+	int 				nof_target_rnti;
+	uint16_t 			target_rnti[MAX_TARGET_RNTI];
     const char *        dci_logs_path;
     const char *        sib_logs_path;
 
     dci_log_config_t    dci_log_config;
-    rf_dev_config_t     rf_config[MAX_NOF_RF_DEV];
+    rf_dev_config_t*    rf_config;  // [nof_rf_dev]
 }ngscope_config_t;
 
 int ngscope_read_config(ngscope_config_t* config, char * path);
@@ -0,0 +1,39 @@
+#ifndef NGSCOPE_MEM_REPORT_H
+#define NGSCOPE_MEM_REPORT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Memory held by each NG-Scope subsystem (the srsRAN objects are not counted)
+typedef enum{
+	NGSCOPE_MEM_DCI_BUFFER = 0, 	// dci buffers between the decoders and the status threads
+	NGSCOPE_MEM_IQ_BUFFER, 			// sync, decoder and tmp subframe buffers
+	NGSCOPE_MEM_UE_TRACKER, 		// rnti table of the decoders
+	NGSCOPE_MEM_UE_LIST, 			// rnti table of the cell status thread
+	NGSCOPE_MEM_CELL_STATUS, 		// dci ring buffers of the cell status and the logger
+	NGSCOPE_MEM_PLOT, 				// plotting buffers
+	NGSCOPE_MEM_UE_STATS, 			// per UE windows of the analytics stage
+	NGSCOPE_MEM_IQ_SNAPSHOT, 		// snapshot rings of the synced subframes
+	NGSCOPE_MEM_NOF_SUBSYS,
+}ngscope_mem_subsys_t;
+
+void ngscope_mem_report_enable(bool enable);
+bool ngscope_mem_report_enabled();
+
+// bytes is negative when the memory is released
+void ngscope_mem_report_add(ngscope_mem_subsys_t subsys, int64_t bytes);
+int64_t ngscope_mem_report_get(ngscope_mem_subsys_t subsys);
+
+// print the report if --mem-report is given
+void ngscope_mem_report_print(FILE* fd, const char* stage);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
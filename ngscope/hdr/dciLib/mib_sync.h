@@ -0,0 +1,79 @@
+#ifndef NGSCOPE_MIB_SYNC_H
+#define NGSCOPE_MIB_SYNC_H
+
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ngscope_def.h"
+#include "stage_slack.h"
+
+// Once the SFN is locked, re-verify it every MIB_VERIFY_PERIOD frames
+#define MIB_VERIFY_PERIOD 16
+
+/* Asynchronous MIB decoder.
+ * The sync thread hands over subframe 0 together with the SFN it believes
+ * that subframe has, and keeps going. The MIB thread decodes the PBCH and
+ * reports the offset between the decoded SFN and the believed one. */
+typedef struct{
+    srsran_ue_mib_t     ue_mib;
+    srsran_cell_t       cell;
+    int                 rf_idx;
+    uint32_t            sf_len;
+    cf_t*               sf_buffer[SRSRAN_MAX_PORTS];    // only antenna 0 is used
+
+    pthread_mutex_t     mutex;
+    pthread_cond_t      cond;
+    bool                running;
+    bool                busy;           // a subframe is waiting for / under decoding
+    bool                reset_decoder;  // start a new PBCH combining burst
+    uint32_t            tagged_sfn;     // SFN of the submitted subframe
+    uint32_t            generation;     // bumped by mib_sync_reset, older results are dropped
+
+    bool                new_result;
+    int                 sfn_delta;      // decoded SFN - tagged SFN
+
+    bool                verifying;      // we are inside a verification burst
+    uint32_t            nof_frame_since_verify;
+    uint32_t            nof_verified;
+    uint32_t            nof_mismatch;
+
+    pthread_t           mib_thd;
+    ngscope_stage_slack_t slack;
+}ngscope_mib_sync_t;
+
+int  mib_sync_init(ngscope_mib_sync_t* q, srsran_cell_t* cell, int rf_idx);
+int  mib_sync_start(ngscope_mib_sync_t* q);
+void mib_sync_stop(ngscope_mib_sync_t* q);
+void mib_sync_free(ngscope_mib_sync_t* q);
+
+/* Called by the sync thread on every subframe 0. Never blocks on the decoder:
+ * the subframe is only copied if a verification is due and the MIB thread is idle */
+void mib_sync_frame(ngscope_mib_sync_t* q, cf_t* IQ_buffer[SRSRAN_MAX_PORTS], uint32_t sfn, bool sfn_locked);
+
+/* The sync has been lost: drop the pending result and the PBCH combining,
+ * the next frames are decoded from scratch */
+void mib_sync_reset(ngscope_mib_sync_t* q);
+
+/* Fetch the latest result. Returns true (once) if a MIB has been decoded
+ * since the last call, and the SFN offset the caller has to apply. */
+bool mib_sync_get_result(ngscope_mib_sync_t* q, int* sfn_delta);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -20,8 +20,6 @@ extern "C" {
 
 #include "srsran/srsran.h"
 
-#define MAX_NOF_DCI_DECODER 6
-#define MAX_NOF_RF_DEV 4
 #define NOF_LOG_SF 32
 
 //#define NOF_LOG_SUBF (NOF_LOG_SF * 10)
@@ -44,6 +42,16 @@ extern "C" {
 
 #define DCI_DECODE_TIMEOUT 30
 
+// When the tmp buffer holds at least batch_threshold subframes, up to batch_max_sf
+// of them are handed to one decoder and demodulated together (config, these are the defaults).
+// DCI_BATCH_MAX_SF is the largest batch_max_sf, the prewarm builds the plans up to it
+#define DCI_BATCH_MAX_SF SRSRAN_OFDM_BATCH_MAX_SF
+#define DCI_BATCH_DEFAULT_SF 4
+#define DCI_BATCH_THRESHOLD 4
+
+// Hybrid search: subframes between two searches of all the locations
+#define FULL_SEARCH_INTERVAL 10
+
 /*     LOGGING Related  */
 #define LOG_DCI_RING_BUFFER
 #define LOG_DCI_LOGGER
@@ -15,5 +15,9 @@
 #include <stdint.h>
 
 #include "ngscope_def.h"
+#include "parse_args.h"
 int ngscope_main(ngscope_config_t* config);
+
+// Build the FFTW plans of all the LTE bandwidths and store the wisdom
+int ngscope_prewarm_fftw(prog_args_t prog_args);
 #endif
@@ -59,6 +59,8 @@ uint16_t max_tti_in_array(uint16_t* array, int array_size);
 
 int tti_distance(uint16_t start, uint16_t end);
 int tti_difference(uint16_t a, uint16_t b);
+// a - b in (-MAX_TTI/2, MAX_TTI/2], the short way around the wraparound
+int tti_offset(uint16_t a, uint16_t b);
 
 bool tti_a_l_b(uint16_t a, uint16_t b);
 bool tti_a_le_b(uint16_t a, uint16_t b);
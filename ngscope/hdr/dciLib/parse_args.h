@@ -43,12 +43,23 @@ typedef struct {
   uint32_t rf_nof_rx_ant;
   double   rf_freq;
 
-  long long  rf_freq_vec[MAX_NOF_RF_DEV];
-  uint32_t rx_nof_rx_ant_vec[MAX_NOF_RF_DEV];
-
   int      remote_enable;
   int 	   decode_single_ue;
   int 	   decode_SIB;
+  int 	   adaptive_llr_gate;
+  int 	   hybrid_search;
+  int 	   full_search_interval;
+  int 	   batch_max_sf;      // 1: no batch FFT
+  int 	   batch_threshold;
+
+  char*    ctrl_capture;      // NULL: no capture of the control region
+  int      ctrl_capture_bits;
+  char*    ctrl_replay;       // NULL: decode the radio
+
+  int      iq_snapshot_ms;    // 0: no IQ snapshot ring
+  char*    iq_snapshot_path;  // prefix of the dumps
+  int      iq_snapshot_skip;
+  int      iq_snapshot_min_dci;
 
   float    rf_gain;
   int      net_port;
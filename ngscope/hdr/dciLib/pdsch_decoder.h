@@ -0,0 +1,43 @@
+#ifndef NGSCOPE_PDSCH_DECODER_H
+#define NGSCOPE_PDSCH_DECODER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "srsran/srsran.h"
+#include "parse_args.h"
+
+/* The DCI decoders only hold the control channels. The PDSCH (SIB) of a cell is
+ * decoded by this single, full ue_dl, owned by the sib worker of the cell */
+typedef struct{
+    srsran_ue_dl_t          ue_dl;
+    srsran_ue_dl_cfg_t      ue_dl_cfg;
+    srsran_dl_sf_cfg_t      dl_sf;
+    srsran_pdsch_cfg_t      pdsch_cfg;
+    srsran_softbuffer_rx_t  softbuffers[SRSRAN_MAX_CODEWORDS];
+    cf_t*                   input[SRSRAN_MAX_PORTS];    // own copy of the subframe
+    uint8_t*                data[SRSRAN_MAX_CODEWORDS];
+    uint32_t                nof_rx_ant;
+    uint32_t                sf_len;
+}ngscope_pdsch_decoder_t;
+
+int  ngscope_pdsch_decoder_init(ngscope_pdsch_decoder_t* q, prog_args_t prog_args, srsran_cell_t* cell);
+void ngscope_pdsch_decoder_free(ngscope_pdsch_decoder_t* q);
+
+/* Decode the PDSCH of the SIB scheduled by dci (found on the SI-RNTI) inside the subframe iq.
+ * Returns the payload length in bytes (the payload is in data[0]), 0 if the CRC failed */
+int ngscope_pdsch_decoder_decode_sib(ngscope_pdsch_decoder_t*   q,
+                                        cf_t*                   iq[SRSRAN_MAX_PORTS],
+                                        srsran_dl_sf_cfg_t*     dl_sf,
+                                        srsran_dci_dl_t*        dci,
+                                        bool                    sib1);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -15,6 +15,7 @@
 #include <semaphore.h>
 
 #include "srsran/srsran.h"
+#include "dci_sink_def.h"
 
 #define HARQ_DELAY_MS   4
 #define MSG3_DELAY_MS   2 // Delay added to HARQ_DELAY_MS
@@ -25,34 +26,62 @@
 
 #define UL_PIDOF(tti)   (tti%(2*HARQ_DELAY_MS))
 
-#define TTIMOD_SZ       100
-#define TTIMOD(tti)     (tti%TTIMOD_SZ)
+// The pending ACKs are indexed by the TTI of the PHICH modulo the number of slots.
+// It covers the longest UL grant -> PHICH distance (8 subframes in FDD, up to 14 in TDD)
+// and divides 10240 so that the slots survive the TTI wraparound
+#define PHICH_NOF_SLOTS 16
+#define PHICH_SLOT(tti) (tti%PHICH_NOF_SLOTS)
+
+// One pending ACK per target RNTI and PHICH subframe
+#define PHICH_MAX_ACK   MAX_TARGET_RNTI
 
 typedef struct {
-  bool enabled;
+  uint16_t rnti;
   uint32_t I_lowest;
   uint32_t n_dmrs;
 } pending_ack_element;
 
+/* The ACKs expected in one PHICH subframe.
+ * The grants of a PHICH subframe come from a single earlier subframe (in TDD the
+ * PHICH and the UL grant share the subframe, so the NACKs re-armed by a PHICH go
+ * to the same slot as the new grants). The decoder of that subframe is the only
+ * writer of the slot: it writes all the ACKs at once and publishes them with seq,
+ * the decoder of the PHICH subframe reads them without any lock */
+typedef struct {
+  uint32_t seq;                             // tti + 1 of the PHICH subframe, 0 while it is written
+  int nof_ack;
+  pending_ack_element ack[PHICH_MAX_ACK];
+} phich_slot_t;
+
+// The pending ACKs of one cell
+typedef struct {
+  phich_slot_t slot[PHICH_NOF_SLOTS];
+} ngscope_phich_state_t;
+
 typedef struct {
-    pending_ack_element pending_ack[TTIMOD_SZ];
-} pend_ack_list;
+  uint16_t rnti;
+  uint32_t ack_value;
+} phich_ack_t;
 
 bool subframe_is_ulgrant_tdd(uint32_t tti, uint32_t sf_config);
 uint32_t get_phich_tti_tdd(uint32_t tti, uint32_t sf_config);
-void init_pending_ack(pend_ack_list* ack_list);
-void phich_reset_pending_ack(pend_ack_list* ack_list, uint32_t tti);
-void phich_set_pending_ack(pend_ack_list* ack_list, uint32_t tti, uint32_t I_lowest, uint32_t n_dmrs);
-bool phich_get_pending_ack(pend_ack_list* ack_list, uint32_t tti, uint32_t *I_lowest, uint32_t *n_dmrs);
-bool phich_is_ack_enabled(pend_ack_list* ack_list, uint32_t tti);
-bool phich_is_any_pending_ack(pend_ack_list* ack_list);
 
+// TTI of the PHICH that acknowledges the PUSCH granted at tti
+uint32_t phich_get_ack_tti(srsran_cell_t* cell, uint32_t sf_config, uint32_t tti);
+
+void phich_state_init(ngscope_phich_state_t* q);
+
+// Publish the ACKs expected at tti, also with nof_ack = 0 so that the slot does not keep old ACKs
+void phich_set_pending_ack(ngscope_phich_state_t* q, uint32_t tti, const pending_ack_element* ack, int nof_ack);
+
+// Copy the ACKs expected at tti, return their number (0 if the slot has not been published for this tti)
+int  phich_get_pending_ack(ngscope_phich_state_t* q, uint32_t tti, pending_ack_element ack[PHICH_MAX_ACK]);
 
+// Decode the PHICH of one pending ACK, false if the decoding fails
 bool decode_phich(srsran_ue_dl_t* ue_dl,
                   srsran_dl_sf_cfg_t* sf_cfg_dl,
                   srsran_ue_dl_cfg_t* ue_dl_cfg,
-                  srsran_cell_t* cell,
-                  pend_ack_list* ack_list,
+                  const pending_ack_element* ack,
                   srsran_phich_res_t* phich_res);
 
 #endif
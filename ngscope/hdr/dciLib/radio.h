@@ -22,6 +22,12 @@ extern "C" {
 
 #include "parse_args.h"
 //#include "rf_utils.h"
+int radio_search_cell(srsran_rf_t* rf, 
+                    srsran_cell_t* cell, 
+                    prog_args_t prog_args, 
+                    cell_search_cfg_t* cell_detect_config,
+                    float* search_cell_cfo);
+
 int radio_init_and_start(srsran_rf_t* rf, 
                     srsran_cell_t* cell, 
                     prog_args_t prog_args, 
@@ -0,0 +1,51 @@
+#ifndef NGSCOPE_RF_CLOCK_H
+#define NGSCOPE_RF_CLOCK_H
+
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "srsran/srsran.h"
+
+// Receptions per calibration window, i.e., about one second of 1 ms slots
+#define RF_CLOCK_WINDOW 1000
+
+/* Mapping of the RF timestamps of a radio to the wall clock (timestamp_us).
+ * Each reception gives wall clock - RF time of its last sample. The smallest
+ * value is the reception with the least delay between the radio and us, so
+ * the offset is the minimum over a window. A new window every second follows
+ * the drift between the two clocks.
+ * The RX thread is the only writer, the sync thread reads offset_us. */
+typedef struct{
+    int64_t     offset_us;      // wall clock - RF time, 0 until the first reception
+    int64_t     win_min_us;     // smallest offset of the current window
+    uint32_t    win_cnt;
+    uint64_t    nof_recv;
+}ngscope_rf_clock_t;
+
+void    rf_clock_init(ngscope_rf_clock_t* q);
+
+/* end: RF time of the sample after the last received one, now_us: wall clock at the return of recv */
+void    rf_clock_update(ngscope_rf_clock_t* q, srsran_timestamp_t* end, int64_t now_us);
+
+/* Wall clock of an RF timestamp in us, 0 if the radio gives no time */
+int64_t rf_clock_to_wall_us(ngscope_rf_clock_t* q, srsran_timestamp_t* t);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
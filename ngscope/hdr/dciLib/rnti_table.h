@@ -0,0 +1,58 @@
+#ifndef NGSCOPE_RNTI_TABLE_H
+#define NGSCOPE_RNTI_TABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "mem_report.h"
+
+// initial number of slots, the table doubles once it is 3/4 full
+#define RNTI_TABLE_INIT_SIZE 64
+
+// statistics of one rnti
+typedef struct{
+	uint16_t 	rnti;
+	bool 		used;
+	bool 		active;
+	uint32_t 	cnt;
+	uint32_t 	dl_cnt;
+	uint32_t 	ul_cnt;
+	uint32_t 	last_active;
+	uint32_t 	enter_time;
+}ngscope_rnti_entry_t;
+
+/* Sparse replacement of the 65536-entry rnti arrays: an open-addressing hash table
+ * (linear probing) that only holds the rnti we have observed.
+ * The slots are allocated when the first rnti is inserted */
+typedef struct{
+	ngscope_rnti_entry_t* 	entry;
+	uint32_t 				size; 		// number of slots, power of 2
+	uint32_t 				nof_entry;
+	ngscope_mem_subsys_t 	subsys; 	// the memory is accounted to this subsystem
+}ngscope_rnti_table_t;
+
+void ngscope_rnti_table_init(ngscope_rnti_table_t* q, ngscope_mem_subsys_t subsys);
+void ngscope_rnti_table_free(ngscope_rnti_table_t* q);
+
+// NULL if the rnti is not inside the table
+ngscope_rnti_entry_t* ngscope_rnti_table_find(ngscope_rnti_table_t* q, uint16_t rnti);
+
+// find the rnti or insert a zeroed entry, NULL if we run out of memory
+ngscope_rnti_entry_t* ngscope_rnti_table_insert(ngscope_rnti_table_t* q, uint16_t rnti);
+
+// the following entries may move backward by one slot,
+// callers that remove while iterating must check the same slot again
+void ngscope_rnti_table_remove(ngscope_rnti_table_t* q, uint16_t rnti);
+
+size_t ngscope_rnti_table_mem(ngscope_rnti_table_t* q);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
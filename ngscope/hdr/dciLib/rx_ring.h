@@ -0,0 +1,90 @@
+#ifndef NGSCOPE_RX_RING_H
+#define NGSCOPE_RX_RING_H
+
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ngscope_def.h"
+#include "radio.h"
+#include "stage_slack.h"
+#include "rf_clock.h"
+
+// Number of 1 ms slots between the RX thread and the sync thread
+#define RX_RING_NOF_SLOTS 16
+
+typedef struct{
+    cf_t*               IQ_buffer[SRSRAN_MAX_PORTS];
+    srsran_timestamp_t  timestamp;  // RF timestamp of the first sample
+}rx_ring_slot_t;
+
+/* Single-producer single-consumer ring of raw sample slots.
+ * The RX thread is the only writer of header and the sync thread
+ * (through rx_ring_recv_wrapper) the only writer of tail, so neither
+ * side takes a lock. The semaphore only wakes up the consumer. */
+typedef struct{
+    // the extra slot absorbs the samples we drop when the ring is full
+    rx_ring_slot_t      slot[RX_RING_NOF_SLOTS + 1];
+    srsran_rf_t*        rf;
+    int                 rf_idx;
+    uint32_t            nof_rx_ant;
+    uint32_t            slot_len;       // samples per slot
+    double              srate;
+
+    uint32_t            header;         // slots produced
+    uint32_t            tail;           // slots consumed
+    uint32_t            read_offset;    // consumer position inside the tail slot
+    sem_t               nof_filled;
+
+    bool                running;
+    pthread_t           rx_thd;
+
+    uint64_t            nof_overflow;   // slots dropped since the ring was full
+    uint64_t            nof_overflow_reported;  // the consumer reports the drops, not the RX thread
+    int64_t             t_overflow_report_us;
+    uint64_t            nof_skipped;    // subframes the consumer buffered since all the decoders were busy
+    uint64_t            nof_skipped_reported;
+    uint32_t            skipped_buf_len;// subframes in that buffer at the last skip
+    uint32_t            nof_recv_error; // consecutive receive errors, RX thread only
+    bool                failed;         // the RX thread gave up on the radio, cleared by rx_ring_start
+    uint64_t            wait_us;        // time the consumer spent waiting for samples
+    ngscope_rf_clock_t  clock;          // RF time -> wall clock, calibrated by the RX thread
+    ngscope_stage_slack_t slack;
+}ngscope_rx_ring_t;
+
+int  rx_ring_init(ngscope_rx_ring_t* q, srsran_rf_t* rf, int rf_idx, uint32_t nof_rx_ant, uint32_t nof_prb);
+int  rx_ring_start(ngscope_rx_ring_t* q);
+void rx_ring_stop(ngscope_rx_ring_t* q);
+void rx_ring_free(ngscope_rx_ring_t* q);
+void rx_ring_flush(ngscope_rx_ring_t* q);
+
+uint32_t rx_ring_len(ngscope_rx_ring_t* q);
+
+// true once the radio failed RX_RING_MAX_RECV_ERROR times in a row, the RX thread is gone
+bool rx_ring_failed(ngscope_rx_ring_t* q);
+
+/* The consumer could not hand a subframe to a decoder, buf_len subframes are waiting.
+ * It is reported together with the dropped slots */
+void rx_ring_skipped_sf(ngscope_rx_ring_t* q, uint32_t buf_len);
+
+/* Receive callback handed to srsran_ue_sync, h is the ngscope_rx_ring_t */
+int rx_ring_recv_wrapper(void* h, cf_t* data[SRSRAN_MAX_PORTS], uint32_t nsamples, srsran_timestamp_t* t);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef NGSCOPE_SIB_WORKER_H
+#define NGSCOPE_SIB_WORKER_H
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "srsran/srsran.h"
+#include "parse_args.h"
+#include "asn_decoder.h"
+#include "decode_sib.h"
+#include "pdsch_decoder.h"
+
+// number of subframes waiting for the worker, power of 2
+#define SIB_QUEUE_SIZE 		8
+
+// SIB1 is re-checked once per shortest modification period (640 ms)
+#define SIB1_CHECK_PERIOD 	640
+
+// number of SI grants we remember
+#define SIB_MAX_KNOWN 		32
+
+// "sib3 sib4 ..." of the SI message we decoded
+#define SIB_TYPES_LEN 		128
+
+// a subframe carrying a SIB, handed over by a dci decoder
+typedef struct{
+    uint32_t            seq;    // ticket of the bounded queue
+    bool                sib1;
+    srsran_dl_sf_cfg_t  dl_sf;
+    srsran_dci_dl_t     dci;
+    cf_t*               IQ_buffer[SRSRAN_MAX_PORTS];
+}ngscope_sib_job_t;
+
+// an SI grant and the payload it carried
+typedef struct{
+    uint64_t    dci_hash;
+    uint64_t    payload_hash;
+    uint32_t    hits;       // times we decoded the same payload with this grant
+    bool        conflict;   // the grant carried different payloads, always decode it
+}ngscope_sib_known_t;
+
+/* One per cell. The dci decoders push the subframes with a SIB on the SI-RNTI into a
+ * bounded lock-free queue, the worker decodes the PDSCH and runs the ASN.1 decoding
+ * only if the SI changed. The parameters we extract are published under params_mutex,
+ * params_seq lets the decoders check for new ones without taking the lock */
+typedef struct{
+    ngscope_pdsch_decoder_t pdsch_decoder;
+    ASNDecoder*             asn_decoder;
+    uint32_t                nof_rx_ant;
+    uint32_t                sf_len;
+
+    // bounded MPSC queue (multiple decoders, one worker)
+    ngscope_sib_job_t       job[SIB_QUEUE_SIZE];
+    uint32_t                head;
+    uint32_t                tail;
+    sem_t                   job_sem;
+    pthread_t               thd;
+    bool                    running;
+
+    // change detection, only touched by the worker
+    uint64_t                sib1_hash;
+    ngscope_sib_known_t     known[SIB_MAX_KNOWN];
+    uint32_t                nof_known;
+
+    // read by the decoders
+    int32_t                 last_sib1_tti;      // -1 before the first SIB1
+    uint64_t                skip_hash[SIB_MAX_KNOWN];
+    uint32_t                nof_skip;
+    uint32_t                params_seq;         // bumped after every publish
+    ngscope_si_params_t     params;             // protected by params_mutex
+    pthread_mutex_t         params_mutex;
+
+    // statistics
+    uint64_t                nof_push;
+    uint64_t                nof_drop;
+    uint64_t                nof_decoded;
+    uint64_t                nof_unchanged;
+}ngscope_sib_worker_t;
+
+int  ngscope_sib_worker_init(ngscope_sib_worker_t* q, prog_args_t prog_args, srsran_cell_t* cell, ASNDecoder* asn_decoder);
+void ngscope_sib_worker_free(ngscope_sib_worker_t* q);
+
+// false if the SIB of this grant is known and unchanged, so the subframe needs no PDSCH decoding
+bool ngscope_sib_worker_need_decode(ngscope_sib_worker_t* q, uint32_t tti, bool sib1, srsran_dci_dl_t* dci);
+
+// copy the subframe into the queue, -1 if the queue is full
+int ngscope_sib_worker_push(ngscope_sib_worker_t*   q,
+                            cf_t*                   iq[SRSRAN_MAX_PORTS],
+                            srsran_dl_sf_cfg_t*     dl_sf,
+                            srsran_dci_dl_t*        dci,
+                            bool                    sib1);
+
+// changes every time new parameters are published
+uint32_t ngscope_sib_worker_params_seq(ngscope_sib_worker_t* q);
+
+// consistent copy of the published parameters, returns their sequence number
+uint32_t ngscope_sib_worker_get_params(ngscope_sib_worker_t* q, ngscope_si_params_t* params);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef NGSCOPE_STAGE_SLACK_H
+#define NGSCOPE_STAGE_SLACK_H
+
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ngscope_def.h"
+
+/* Slack bookkeeping of one pipeline stage.
+ * The slack is the time left before a stage falls behind the air interface,
+ * i.e., budget - processing time. A negative slack means the stage overran. */
+typedef struct{
+    char        name[16];
+    int         rf_idx;
+    uint32_t    report_period;  // number of samples per report
+    uint32_t    nof_sample;
+    uint32_t    nof_overrun;    // samples with negative slack
+    int64_t     sum_slack_us;
+    int64_t     min_slack_us;
+}ngscope_stage_slack_t;
+
+void stage_slack_init(ngscope_stage_slack_t* q, const char* name, int rf_idx, uint32_t report_period);
+void stage_slack_update(ngscope_stage_slack_t* q, int64_t slack_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -42,10 +42,13 @@ typedef struct{
     uint16_t    targetRNTI;
     int         nof_cell;
     int         header;
-    int         cell_prb[MAX_NOF_RF_DEV];
-    ngscope_plot_cell_t plot_data_cell[MAX_NOF_RF_DEV];
+    int*        cell_prb;           // [nof_cell]
+    ngscope_plot_cell_t* plot_data_cell;    // [nof_cell]
 }ngscope_plot_t;
 
+// allocate the per cell plot data once the cells are found
+int   plot_data_init(ngscope_plot_t* q, int nof_cell, uint16_t targetRNTI);
+void  plot_data_free(ngscope_plot_t* q);
 
 
 void* plot_thread_run(void* arg);
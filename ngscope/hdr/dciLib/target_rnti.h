@@ -0,0 +1,41 @@
+#ifndef NGSCOPE_TARGET_RNTI_H
+#define NGSCOPE_TARGET_RNTI_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "dci_sink_def.h"
+
+// The RNTIs whose search spaces are decoded in every subframe by the hybrid search, one list per carrier.
+// The decoders read the list every subframe and the dci sink server edits it
+typedef struct{
+	uint16_t 		rnti[MAX_TARGET_RNTI];
+	int 			nof_rnti;
+	pthread_mutex_t mutex;
+}ngscope_target_rnti_t;
+
+void ngscope_target_rnti_set(ngscope_target_rnti_t* q, const uint16_t* rnti, int nof_rnti);
+bool ngscope_target_rnti_add(ngscope_target_rnti_t* q, uint16_t rnti);
+bool ngscope_target_rnti_remove(ngscope_target_rnti_t* q, uint16_t rnti);
+
+// copy the list, return the number of RNTIs
+int ngscope_target_rnti_get(ngscope_target_rnti_t* q, uint16_t rnti[MAX_TARGET_RNTI]);
+
+// the cell a control message of the dci sink is meant for, 0xFF for all the cells, -1 if it is malformed
+int ngscope_target_rnti_msg_cell(const char* buf, int len);
+
+// apply a control message (preamble included) received by the dci sink, return -1 if it is malformed
+int ngscope_target_rnti_handle_msg(ngscope_target_rnti_t* q, const char* buf, int len);
+
+void ngscope_target_rnti_print(ngscope_target_rnti_t* q);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -20,6 +20,10 @@ extern "C" {
 
 #include "ngscope_def.h"
 #include "radio.h"
+#include "rx_ring.h"
+#include "mib_sync.h"
+#include "carrier_supervisor.h"
+#include "ctrl_capture.h"
 
 #define MAX_TMP_BUFFER 15
 
@@ -28,8 +32,20 @@ typedef struct{
     uint32_t        sf_idx; // subframe index 0-9
     uint32_t        sfn;    // system frame index 0-1020
     cf_t*           IQ_buffer[SRSRAN_MAX_PORTS]; //IQ buffer that stores the IQ sample
+    int64_t         air_time_us; // wall clock of the first sample, from the RF timestamp
     pthread_mutex_t         sf_mutex;
     pthread_cond_t          sf_cond;
+
+    // Batch of backlogged subframes (nof_batch_sf > 0 overrides sf_idx/sfn/IQ_buffer)
+    uint32_t        nof_batch_sf;
+    uint32_t        batch_sf_idx[DCI_BATCH_MAX_SF];
+    uint32_t        batch_sfn[DCI_BATCH_MAX_SF];
+    int64_t         batch_air_time_us[DCI_BATCH_MAX_SF];
+    cf_t*           batch_IQ[DCI_BATCH_MAX_SF][SRSRAN_MAX_PORTS]; // point to the batch input of the decoder ue_dl
+
+    // Replayed control region (nof_ctrl_symbols > 0 overrides IQ_buffer)
+    uint32_t        nof_ctrl_symbols;
+    cf_t*           ctrl_RE[SRSRAN_MAX_PORTS]; // point to the control symbols of the decoder ue_dl
 }ngscope_sf_buffer_t;
 
 typedef struct{
@@ -37,6 +53,17 @@ typedef struct{
     srsran_cell_t       cell;
     srsran_ue_sync_t    ue_sync;
     prog_args_t         prog_args;
+    ngscope_rx_ring_t   rx_ring;    // RX stage -> sync stage
+    ngscope_mib_sync_t  mib_sync;   // asynchronous SFN verification
+    ngscope_supervisor_t supervisor; // sync loss detection and recovery
+
+    // kept for searching the cell again after a sync loss
+    cell_search_cfg_t   cell_detect_config;
+    float               search_cell_cfo;
+
+    // control region capture of the synced subframes, or its replay instead of the radio
+    ngscope_ctrl_capture_t ctrl_capture;
+    ngscope_ctrl_replay_t  ctrl_replay;
 }ngscope_task_scheduler_t;
 
 typedef struct{
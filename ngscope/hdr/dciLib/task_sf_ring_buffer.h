@@ -26,6 +26,7 @@ typedef struct{
     uint32_t        sf_idx; // subframe index 0-9
     uint32_t        sfn;    // system frame index 0-1020
     cf_t*           IQ_buffer[SRSRAN_MAX_PORTS]; //IQ buffer that stores the IQ sample
+    int64_t         air_time_us; // wall clock of the first sample
 }task_tmp_sf_buffer_t;
 
 typedef struct{
@@ -34,15 +35,19 @@ typedef struct{
     int   	tail;
 	int 	len;			
 	bool 	full;
+	int 	nof_rx_ant; 	// only the antennas we receive from have a buffer
+	int 	max_num_samples;
 }task_tmp_buffer_t;
 
 int task_sf_ring_buffer_init(task_tmp_buffer_t* q,
+								int nof_rx_ant,
 								int max_num_samples);
 int task_sf_ring_buffer_free(task_tmp_buffer_t* q);
 int task_sf_ring_buffer_put(task_tmp_buffer_t* q,
 								cf_t* buffers[SRSRAN_MAX_CHANNELS],
 								uint32_t sfn,
 								uint32_t sf_idx,
+								int64_t air_time_us,
 								int rf_nof_rx_ant,
 								int max_num_samples);
 
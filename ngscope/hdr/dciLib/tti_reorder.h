@@ -0,0 +1,74 @@
+#ifndef NGSCOPE_TTI_REORDER_H
+#define NGSCOPE_TTI_REORDER_H
+
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ngscope_def.h"
+
+// return values of tti_reorder_put
+#define TTI_REORDER_LATE    -1  // the TTI has already been released
+#define TTI_REORDER_JUMP    -2  // the TTI is beyond the buffer (e.g. resync), drain and reset first
+
+// return values of tti_reorder_pop
+#define TTI_REORDER_NONE    0   // nothing to release
+#define TTI_REORDER_DATA    1   // the result of the TTI
+#define TTI_REORDER_GAP     2   // no result for the TTI within the latency bound
+
+/* Releases the subframe results of the parallel decoders in TTI order.
+ * The buffer only keeps the order, the results stay in an array of the
+ * caller indexed by the slot put returns (tti % buf_size, buf_size must
+ * divide MAX_TTI so that the slots survive the wraparound).
+ * A missing TTI is released as a gap once a result max_latency subframes
+ * later has arrived. */
+typedef struct{
+    int         buf_size;
+    uint32_t    max_latency;    // subframes
+
+    bool        started;
+    uint32_t    next_tti;       // next TTI to release
+    uint32_t    newest_tti;     // most recent TTI put
+    bool*       filled;         // [buf_size]
+
+    uint64_t    nof_data;
+    uint64_t    nof_gap;
+    uint64_t    nof_late;
+    uint64_t    nof_jump;
+}ngscope_tti_reorder_t;
+
+int  tti_reorder_init(ngscope_tti_reorder_t* q, int buf_size, uint32_t max_latency);
+void tti_reorder_free(ngscope_tti_reorder_t* q);
+void tti_reorder_reset(ngscope_tti_reorder_t* q);
+
+/* Returns the slot of the TTI or TTI_REORDER_LATE/TTI_REORDER_JUMP */
+int  tti_reorder_put(ngscope_tti_reorder_t* q, uint32_t tti);
+
+/* The first TTI that cannot be released yet: everything before it is complete or timed out */
+uint32_t tti_reorder_frontier(ngscope_tti_reorder_t* q);
+
+/* The TTI after the newest one, releasing up to it drains the buffer */
+uint32_t tti_reorder_end(ngscope_tti_reorder_t* q);
+
+/* Release the next TTI if it comes before limit. Pass the frontier of the
+ * buffer, the low watermark of several buffers or the end to drain */
+int  tti_reorder_pop(ngscope_tti_reorder_t* q, uint32_t limit, uint32_t* tti, int* slot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -20,16 +20,11 @@ extern "C" {
 
 #include "srsran/srsran.h"
 #include "ngscope_def.h"
+#include "rnti_table.h"
 
 typedef struct{
-  // Yaxiong's Modification: RNTI list
-  bool      active_ue_list[65536];
-  uint32_t  ue_cnt[65536];
-  uint32_t  ue_dl_cnt[65536];
-  uint32_t  ue_ul_cnt[65536];
-
-  uint32_t  ue_last_active[65536];
-  uint32_t  ue_enter_time[65536];
+  // Yaxiong's Modification: RNTI list (only the observed rnti are stored)
+  ngscope_rnti_table_t ue;
 
   uint16_t  max_freq_ue;
   uint16_t  max_dl_freq_ue;
@@ -38,7 +33,10 @@ typedef struct{
 
 }ngscope_ue_list_t;
 
-void ngscope_ue_list_enqueue_rnti_per_sf_per_cell(ngscope_ue_list_t q[MAX_NOF_RF_DEV], ngscope_status_buffer_t* dci_buf);
+void ngscope_ue_list_init(ngscope_ue_list_t* q);
+void ngscope_ue_list_free(ngscope_ue_list_t* q);
+// q is the list of the cell of the dci
+void ngscope_ue_list_enqueue_rnti_per_sf(ngscope_ue_list_t* q, ngscope_status_buffer_t* dci_buf);
 int ngscope_ue_list_print_ue_freq(ngscope_ue_list_t* q);
 
 #ifdef __cplusplus
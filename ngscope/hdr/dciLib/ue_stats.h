@@ -0,0 +1,68 @@
+#ifndef NGSCOPE_UE_STATS_H
+#define NGSCOPE_UE_STATS_H
+
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <stdint.h>
+
+#include "dci_sink_def.h"
+#include "dci_ring_buffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The window slides by one radio frame
+#define UE_STATS_BUCKET_SF      10
+#define UE_STATS_MIN_WINDOW     UE_STATS_BUCKET_SF
+#define UE_STATS_MAX_WINDOW     10000
+#define UE_STATS_DEFAULT_WINDOW 1000    // ms
+
+/* Online analytics of the DCIs of one cell. It follows the subframes released
+ * by the cell status stage in TTI order and keeps, for every RNTI seen in the
+ * window, the goodput (each transport block is counted once: the NDI of the
+ * HARQ process tells the new transmissions from the retransmissions), the PRB
+ * share and the MCS distribution. The sums over the window are updated in O(1)
+ * per radio frame. Only the cell status thread uses it */
+typedef struct ngscope_ue_stats_s ngscope_ue_stats_t;
+
+// The last report of a cell, written by the cell status thread and read by the dci sink server
+typedef struct{
+    bool                valid;
+    ue_stats_header_t   header;
+    ue_stats_t          ue[UE_STATS_MAX_UE];  // most traffic first
+    pthread_mutex_t     mutex;
+}ngscope_ue_stats_report_t;
+
+ngscope_ue_stats_t* ngscope_ue_stats_create(int cell_idx, uint32_t nof_prb, bool tdd, int window_ms);
+void ngscope_ue_stats_free(ngscope_ue_stats_t* q);
+
+// forget the HARQ state and the windows, e.g., after a resync
+void ngscope_ue_stats_reset(ngscope_ue_stats_t* q);
+
+// the subframes in TTI order, the gaps included
+void ngscope_ue_stats_push_sf(ngscope_ue_stats_t* q, sf_status_t* sf);
+
+// copy the statistics into the report if a radio frame has completed since the last call
+bool ngscope_ue_stats_publish(ngscope_ue_stats_t* q, ngscope_ue_stats_report_t* report);
+
+void ngscope_ue_stats_report_init(ngscope_ue_stats_report_t* report);
+
+// copy the report, only the UE of rnti if it is not 0. Return the number of UEs, -1 if there is no report yet
+int  ngscope_ue_stats_report_get(ngscope_ue_stats_report_t* report, uint16_t rnti,
+                                    ue_stats_header_t* header, ue_stats_t ue[UE_STATS_MAX_UE]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
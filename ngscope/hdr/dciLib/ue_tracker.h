@@ -21,6 +21,7 @@ extern "C" {
 #include "srsran/srsran.h"
 #include "ngscope_def.h"
 #include "ngscope_util.h"
+#include "rnti_table.h"
 
 // we record the top N most frequently observed UE
 #define TOPN 10
@@ -36,14 +37,8 @@ extern "C" {
 #define ACTIVE_UE_THD_T 5000
 #define INACTIVE_UE_THD_T 500
 typedef struct{
-  // Yaxiong's Modification: RNTI list
-  bool      active_ue_list[65536];
-  uint32_t  ue_cnt[65536];
-  uint32_t  ue_dl_cnt[65536];
-  uint32_t  ue_ul_cnt[65536];
-
-  uint32_t  ue_last_active[65536];
-  uint32_t  ue_enter_time[65536];
+  // Yaxiong's Modification: RNTI list (only the observed rnti are stored)
+  ngscope_rnti_table_t ue;
 
 // the top 20 ue rnti and its frequency
   uint16_t  top_N_ue_rnti[TOPN];
@@ -56,7 +51,9 @@ typedef struct{
 
 }ngscope_ue_tracker_t;
 
-void ngscope_ue_tracker_update_per_tti(ngscope_ue_tracker_t* q, uint32_t tti);
+void ngscope_ue_tracker_init(ngscope_ue_tracker_t* q);
+void ngscope_ue_tracker_free(ngscope_ue_tracker_t* q);
+bool ngscope_ue_tracker_is_active(ngscope_ue_tracker_t* q, uint16_t rnti);
 void ngscope_ue_tracker_enqueue_ue_rnti(ngscope_ue_tracker_t* q, uint32_t tti, uint16_t rnti, bool dl);
 void ngscope_ue_tracker_update_per_tti(ngscope_ue_tracker_t* q, uint32_t tti);
 void ngscope_ue_tracker_info(ngscope_ue_tracker_t* q, uint32_t tti);
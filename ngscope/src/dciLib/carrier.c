@@ -0,0 +1,260 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/mempolicy.h>
+
+#include "ngscope/hdr/dciLib/carrier.h"
+#include "ngscope/hdr/dciLib/mem_report.h"
+
+extern pthread_mutex_t cell_mutex;
+
+static ngscope_carrier_t** carrier_list = NULL;
+static int                 nof_carrier  = 0;
+
+#define CARRIER_ALIGN(x) (((x) + 63) & ~(size_t)63)
+
+static void* numa_mmap(size_t size, int numa_node, int flags){
+    // mmap-ed memory is zeroed and only placed on a node when it is touched
+    void* p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+    if(p == MAP_FAILED){
+        return NULL;
+    }
+    if(numa_node >= 0 && numa_node < (int)(8 * sizeof(unsigned long))){
+        unsigned long mask = 1UL << numa_node;
+        // preferred instead of bind: the kernel falls back to other nodes if the node is full
+        if(syscall(SYS_mbind, p, size, MPOL_PREFERRED, &mask, 8 * sizeof(mask) + 1, 0) != 0){
+            printf("numa: cannot place %zu bytes on node %d, using the default policy\n", size, numa_node);
+        }
+    }
+    return p;
+}
+
+void* ngscope_numa_alloc(size_t size, int numa_node){
+    void* p = numa_mmap(size, numa_node, 0);
+    if(p == NULL){
+        printf("numa: failed to allocate %zu bytes\n", size);
+    }
+    return p;
+}
+
+void* ngscope_numa_alloc_huge(size_t size, int numa_node){
+    void* p = numa_mmap(size, numa_node, MAP_HUGETLB);
+    if(p != NULL){
+        return p;
+    }
+    // no huge pages reserved (vm.nr_hugepages), ask for transparent ones
+    p = ngscope_numa_alloc(size, numa_node);
+    if(p != NULL && madvise(p, size, MADV_HUGEPAGE) != 0){
+        printf("numa: no huge pages for %zu bytes\n", size);
+    }
+    return p;
+}
+
+void ngscope_numa_free(void* p, size_t size){
+    if(p != NULL){
+        munmap(p, size);
+    }
+}
+
+int ngscope_numa_bind_thread(int numa_node){
+    if(numa_node < 0){
+        return 0;
+    }
+    char path[64];
+    sprintf(path, "/sys/devices/system/node/node%d/cpulist", numa_node);
+    FILE* fd = fopen(path, "r");
+    if(fd == NULL){
+        printf("numa: node %d not found, the thread is not pinned\n", numa_node);
+        return -1;
+    }
+
+    // the list looks like 0-7,16-23
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    int first, last;
+    char sep;
+    while(fscanf(fd, "%d", &first) == 1){
+        last = first;
+        sep  = 0;
+        if(fscanf(fd, "%c", &sep) == 1 && sep == '-'){
+            if(fscanf(fd, "%d", &last) != 1){
+                break;
+            }
+            if(fscanf(fd, "%c", &sep) != 1){
+                sep = 0;
+            }
+        }
+        for(int cpu=first; cpu<=last && cpu<CPU_SETSIZE; cpu++){
+            CPU_SET(cpu, &cpu_set);
+        }
+        if(sep != ','){
+            break;
+        }
+    }
+    fclose(fd);
+
+    if(CPU_COUNT(&cpu_set) == 0 || pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set) != 0){
+        printf("numa: failed to pin the thread to node %d\n", numa_node);
+        return -1;
+    }
+    return 0;
+}
+
+int ngscope_carrier_list_init(int nof){
+    carrier_list = (ngscope_carrier_t**)calloc(nof, sizeof(ngscope_carrier_t*));
+    if(carrier_list == NULL){
+        printf("carrier: failed to allocate the list of %d carriers\n", nof);
+        return -1;
+    }
+    nof_carrier = nof;
+    return 0;
+}
+
+int ngscope_nof_carrier(){
+    return nof_carrier;
+}
+
+ngscope_carrier_t* ngscope_carrier(int rf_idx){
+    if(rf_idx < 0 || rf_idx >= nof_carrier){
+        return NULL;
+    }
+    return carrier_list[rf_idx];
+}
+
+uint32_t ngscope_carrier_nof_prb(int rf_idx){
+    ngscope_carrier_t* q = ngscope_carrier(rf_idx);
+    uint32_t nof_prb = 0;
+    if(q != NULL){
+        pthread_mutex_lock(&cell_mutex);
+        nof_prb = q->cell.nof_prb;
+        pthread_mutex_unlock(&cell_mutex);
+    }
+    return nof_prb;
+}
+
+ngscope_carrier_t* ngscope_carrier_create(int rf_idx, int nof_decoder, int numa_node){
+    if(rf_idx < 0 || rf_idx >= nof_carrier || nof_decoder <= 0){
+        printf("carrier: invalid carrier %d with %d decoders\n", rf_idx, nof_decoder);
+        return NULL;
+    }
+
+    // one block: the context, then the per decoder arrays
+    size_t off_sf_buffer = CARRIER_ALIGN(sizeof(ngscope_carrier_t));
+    size_t off_sf_token  = CARRIER_ALIGN(off_sf_buffer + nof_decoder * sizeof(ngscope_sf_buffer_t));
+    size_t off_up        = off_sf_token + nof_decoder * sizeof(bool);
+    size_t size          = off_up + nof_decoder * sizeof(bool);
+
+    uint8_t* block = (uint8_t*)ngscope_numa_alloc(size, numa_node);
+    if(block == NULL){
+        return NULL;
+    }
+    ngscope_carrier_t* q = (ngscope_carrier_t*)block;
+    q->rf_idx       = rf_idx;
+    q->nof_decoder  = nof_decoder;
+    q->numa_node    = numa_node;
+    q->alloc_size   = size;
+    q->sf_buffer    = (ngscope_sf_buffer_t*)(block + off_sf_buffer);
+    q->sf_token     = (bool*)(block + off_sf_token);
+    q->decoder_up   = (bool*)(block + off_up);
+
+    q->scheduler_up     = false;
+    q->scheduler_closed = true;
+
+    for(int i=0; i<nof_decoder; i++){
+        pthread_mutex_init(&q->sf_buffer[i].sf_mutex, NULL);
+        pthread_cond_init(&q->sf_buffer[i].sf_cond, NULL);
+    }
+    pthread_mutex_init(&q->token_mutex, NULL);
+    pthread_mutex_init(&q->tmp_buf_mutex, NULL);
+    pthread_mutex_init(&q->ue_tracker_mutex, NULL);
+    pthread_mutex_init(&q->plot_mutex, NULL);
+    pthread_mutex_init(&q->llr_gate_mutex, NULL);
+    pthread_mutex_init(&q->decoder_ready_mutex, NULL);
+    pthread_cond_init(&q->decoder_ready_cond, NULL);
+    pthread_mutex_init(&q->target_rnti.mutex, NULL);
+    // One gate per cell, the decoders only pick its mode. Restarting a decoder keeps what it learned
+    srsran_pdcch_llr_gate_reset(&q->llr_gate);
+    pthread_cond_init(&q->plot_cond, NULL);
+    phich_state_init(&q->phich);
+    ngscope_ue_stats_report_init(&q->ue_stats);
+
+    ngscope_mem_report_add(NGSCOPE_MEM_IQ_BUFFER, nof_decoder * sizeof(ngscope_sf_buffer_t) + sizeof(task_tmp_buffer_t));
+    ngscope_mem_report_add(NGSCOPE_MEM_UE_TRACKER, sizeof(ngscope_ue_tracker_t));
+    ngscope_mem_report_add(NGSCOPE_MEM_UE_LIST, sizeof(ngscope_ue_list_t));
+
+    carrier_list[rf_idx] = q;
+    return q;
+}
+
+static void carrier_free(ngscope_carrier_t* q){
+    for(int i=0; i<q->nof_decoder; i++){
+        pthread_mutex_destroy(&q->sf_buffer[i].sf_mutex);
+        pthread_cond_destroy(&q->sf_buffer[i].sf_cond);
+    }
+    pthread_mutex_destroy(&q->token_mutex);
+    pthread_mutex_destroy(&q->tmp_buf_mutex);
+    pthread_mutex_destroy(&q->ue_tracker_mutex);
+    pthread_mutex_destroy(&q->plot_mutex);
+    pthread_mutex_destroy(&q->llr_gate_mutex);
+    pthread_mutex_destroy(&q->decoder_ready_mutex);
+    pthread_cond_destroy(&q->decoder_ready_cond);
+    pthread_mutex_destroy(&q->target_rnti.mutex);
+    pthread_cond_destroy(&q->plot_cond);
+    pthread_mutex_destroy(&q->ue_stats.mutex);
+
+    ngscope_mem_report_add(NGSCOPE_MEM_IQ_BUFFER, -(int64_t)(q->nof_decoder * sizeof(ngscope_sf_buffer_t) + sizeof(task_tmp_buffer_t)));
+    ngscope_mem_report_add(NGSCOPE_MEM_UE_TRACKER, -(int64_t)sizeof(ngscope_ue_tracker_t));
+    ngscope_mem_report_add(NGSCOPE_MEM_UE_LIST, -(int64_t)sizeof(ngscope_ue_list_t));
+    ngscope_numa_free(q, q->alloc_size);
+}
+
+void ngscope_carrier_decoders_reset(ngscope_carrier_t* q){
+    pthread_mutex_lock(&q->decoder_ready_mutex);
+    q->nof_decoder_ready  = 0;
+    q->nof_decoder_failed = 0;
+    pthread_mutex_unlock(&q->decoder_ready_mutex);
+}
+
+void ngscope_carrier_decoder_ready(ngscope_carrier_t* q, bool ready){
+    pthread_mutex_lock(&q->decoder_ready_mutex);
+    if(ready){
+        q->nof_decoder_ready++;
+    }else{
+        q->nof_decoder_failed++;
+    }
+    pthread_cond_broadcast(&q->decoder_ready_cond);
+    pthread_mutex_unlock(&q->decoder_ready_mutex);
+}
+
+int ngscope_carrier_wait_decoders(ngscope_carrier_t* q, int nof_decoder){
+    pthread_mutex_lock(&q->decoder_ready_mutex);
+    while(q->nof_decoder_ready + q->nof_decoder_failed < nof_decoder){
+        pthread_cond_wait(&q->decoder_ready_cond, &q->decoder_ready_mutex);
+    }
+    int nof_failed = q->nof_decoder_failed;
+    pthread_mutex_unlock(&q->decoder_ready_mutex);
+
+    if(nof_failed > 0){
+        ERROR("RF:%d %d of %d decoders failed to start", q->rf_idx, nof_failed, nof_decoder);
+        return SRSRAN_ERROR;
+    }
+    return SRSRAN_SUCCESS;
+}
+
+void ngscope_carrier_list_free(){
+    for(int i=0; i<nof_carrier; i++){
+        if(carrier_list[i] != NULL){
+            carrier_free(carrier_list[i]);
+        }
+    }
+    free(carrier_list);
+    carrier_list = NULL;
+    nof_carrier  = 0;
+}
@@ -0,0 +1,222 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ngscope/hdr/dciLib/carrier_supervisor.h"
+#include "ngscope/hdr/dciLib/time_stamp.h"
+#include "ngscope/hdr/dciLib/carrier.h"
+
+static const char* state_name[] = {"INIT", "TRACKING", "RESYNC", "RESEARCH"};
+
+// the decoders of the carrier count on the carrier context
+void supervisor_dci_decoded(int rf_idx, uint32_t nof_dci){
+    ngscope_carrier_t* carrier = ngscope_carrier(rf_idx);
+    if(carrier == NULL || nof_dci == 0){
+        return;
+    }
+    __atomic_add_fetch(&carrier->nof_dci_decoded, nof_dci, __ATOMIC_RELAXED);
+}
+
+static uint64_t nof_dci_decoded(int rf_idx){
+    ngscope_carrier_t* carrier = ngscope_carrier(rf_idx);
+    return carrier == NULL ? 0 : __atomic_load_n(&carrier->nof_dci_decoded, __ATOMIC_RELAXED);
+}
+
+static void reset_indicators(ngscope_supervisor_t* q){
+    q->nof_no_sf        = 0;
+    q->nof_low_peak     = 0;
+    q->peak_avg         = q->peak_baseline;
+    memset(q->t_sfn_jump, 0, sizeof(q->t_sfn_jump));
+    q->sfn_jump_idx     = 0;
+    q->nof_rate_sf      = 0;
+    // start a new rate window, the dci decoded during the loss are not counted
+    q->last_nof_dci     = nof_dci_decoded(q->rf_idx);
+}
+
+static void set_state(ngscope_supervisor_t* q, ngscope_supervisor_state_t state, int64_t now){
+    if(q->fd != NULL){
+        fprintf(q->fd, "%ld\t%s\t->\t%s\t%s\n", now, state_name[q->state], state_name[state],
+                        state == SUPERVISOR_RESYNC && q->state == SUPERVISOR_TRACKING ? q->reason : "");
+        fflush(q->fd);
+    }
+    q->state    = state;
+    q->t_state  = now;
+}
+
+int supervisor_init(ngscope_supervisor_t* q, int rf_idx){
+    memset(q, 0, sizeof(ngscope_supervisor_t));
+    q->rf_idx   = rf_idx;
+    q->state    = SUPERVISOR_INIT;
+    q->t_state  = timestamp_ms();
+    q->reason   = "";
+
+    char file_name[64];
+    sprintf(file_name, "supervisor_%d.txt", rf_idx);
+    q->fd = fopen(file_name, "w+");
+    if(q->fd == NULL){
+        printf("supervisor: cannot open %s\n", file_name);
+        return -1;
+    }
+    return 0;
+}
+
+void supervisor_free(ngscope_supervisor_t* q){
+    printf("RF:%d supervisor: %d sync loss %d recovered %d cell search, recovery time last:%ld max:%ld avg:%ld (ms)\n",
+                q->rf_idx, q->nof_loss, q->nof_recovery, q->nof_research, q->last_recovery_ms, q->max_recovery_ms,
+                q->nof_recovery > 0 ? q->sum_recovery_ms / q->nof_recovery : 0);
+    if(q->fd != NULL){
+        fclose(q->fd);
+        q->fd = NULL;
+    }
+}
+
+// the PSS peak and the decoding rate are only judged on tracked subframes
+static const char* check_tracked(ngscope_supervisor_t* q, float pss_peak, bool sfn_jump, int64_t now){
+    q->nof_tracked++;
+
+    /* PSS peak: fast average against a slow baseline */
+    q->peak_avg = (q->nof_tracked == 1) ? pss_peak : 0.9 * q->peak_avg + 0.1 * pss_peak;
+    if(q->nof_tracked <= SUPERVISOR_PEAK_WARMUP){
+        q->peak_baseline = q->peak_avg;
+    }else if(q->peak_avg < SUPERVISOR_PEAK_RATIO * q->peak_baseline){
+        q->nof_low_peak++;
+        if(q->nof_low_peak >= SUPERVISOR_LOW_PEAK_LIMIT){
+            return "pss peak";
+        }
+    }else{
+        // the baseline follows slow fading only
+        q->nof_low_peak  = 0;
+        q->peak_baseline = 0.998 * q->peak_baseline + 0.002 * q->peak_avg;
+    }
+
+    /* SFN: repeated corrections of the MIB stage */
+    if(sfn_jump){
+        int64_t oldest = q->t_sfn_jump[q->sfn_jump_idx];
+        q->t_sfn_jump[q->sfn_jump_idx] = now;
+        q->sfn_jump_idx = (q->sfn_jump_idx + 1) % SUPERVISOR_MAX_SFN_JUMP;
+        if(oldest > 0 && now - oldest < SUPERVISOR_SFN_JUMP_WINDOW_MS){
+            return "sfn jump";
+        }
+    }
+
+    /* decoding rate: number of dci per window */
+    q->nof_rate_sf++;
+    if(q->nof_rate_sf >= SUPERVISOR_RATE_WINDOW){
+        uint64_t nof_dci = nof_dci_decoded(q->rf_idx);
+        float    rate    = (float)(nof_dci - q->last_nof_dci);
+        q->last_nof_dci  = nof_dci;
+        q->nof_rate_sf   = 0;
+        q->nof_rate_window++;
+        if(q->nof_rate_window > SUPERVISOR_RATE_WARMUP && q->rate_baseline >= SUPERVISOR_MIN_RATE &&
+                rate < SUPERVISOR_RATE_RATIO * q->rate_baseline){
+            return "decode rate";
+        }
+        q->rate_baseline = (q->nof_rate_window == 1) ? rate : 0.8 * q->rate_baseline + 0.2 * rate;
+    }
+    return NULL;
+}
+
+static void recovered(ngscope_supervisor_t* q, int64_t now){
+    int64_t t = now - q->t_lost;
+    q->nof_recovery++;
+    q->last_recovery_ms = t;
+    q->sum_recovery_ms += t;
+    if(t > q->max_recovery_ms){
+        q->max_recovery_ms = t;
+    }
+    printf("RF:%d sync recovered after %ld ms (%s)\n", q->rf_idx, t, q->reason);
+    if(q->fd != NULL){
+        fprintf(q->fd, "%ld\trecovery_ms:\t%ld\n", now, t);
+    }
+    reset_indicators(q);
+    set_state(q, SUPERVISOR_TRACKING, now);
+}
+
+ngscope_supervisor_action_t supervisor_update(ngscope_supervisor_t* q,
+                                                bool tracked,
+                                                float pss_peak,
+                                                bool sfn_locked,
+                                                bool sfn_jump)
+{
+    int64_t now = timestamp_ms();
+    const char* reason = NULL;
+
+    switch(q->state){
+        case SUPERVISOR_INIT:
+            if(tracked && sfn_locked){
+                reset_indicators(q);
+                set_state(q, SUPERVISOR_TRACKING, now);
+            }
+            break;
+        case SUPERVISOR_TRACKING:
+            if(!tracked){
+                q->nof_no_sf++;
+                if(q->nof_no_sf >= SUPERVISOR_NO_SF_LIMIT){
+                    reason = "no subframe";
+                }
+            }else{
+                q->nof_no_sf = 0;
+                reason = check_tracked(q, pss_peak, sfn_jump, now);
+            }
+            if(reason != NULL){
+                printf("RF:%d sync lost (%s), resync\n", q->rf_idx, reason);
+                q->reason = reason;
+                q->t_lost = now;
+                q->nof_loss++;
+                set_state(q, SUPERVISOR_RESYNC, now);
+                return SUPERVISOR_ACTION_RESYNC;
+            }
+            break;
+        case SUPERVISOR_RESYNC:
+            if(tracked && sfn_locked){
+                recovered(q, now);
+            }else if(now - q->t_state > SUPERVISOR_RESYNC_TIMEOUT_MS){
+                printf("RF:%d no sync after %d ms, searching the cell again\n", q->rf_idx, SUPERVISOR_RESYNC_TIMEOUT_MS);
+                q->nof_research++;
+                set_state(q, SUPERVISOR_RESEARCH, now);
+                return SUPERVISOR_ACTION_RESEARCH;
+            }
+            break;
+        case SUPERVISOR_RESEARCH:
+            // the last search failed, try again after a while
+            if(now - q->t_state > SUPERVISOR_RESEARCH_BACKOFF_MS){
+                q->nof_research++;
+                q->t_state = now;
+                return SUPERVISOR_ACTION_RESEARCH;
+            }
+            break;
+    }
+    return SUPERVISOR_ACTION_NONE;
+}
+
+ngscope_supervisor_action_t supervisor_rf_failed(ngscope_supervisor_t* q){
+    int64_t now = timestamp_ms();
+
+    // a failed search is retried after the backoff, as for a lost cell
+    if(q->state == SUPERVISOR_RESEARCH && now - q->t_state <= SUPERVISOR_RESEARCH_BACKOFF_MS){
+        return SUPERVISOR_ACTION_NONE;
+    }
+    printf("RF:%d the radio stopped delivering samples, searching the cell again\n", q->rf_idx);
+    if(q->fd != NULL){
+        fprintf(q->fd, "%ld\trf failed\n", now);
+    }
+    if(q->state == SUPERVISOR_TRACKING){
+        q->reason = "rf failed";
+        q->t_lost = now;
+        q->nof_loss++;
+    }
+    q->nof_research++;
+    set_state(q, SUPERVISOR_RESEARCH, now);
+    return SUPERVISOR_ACTION_RESEARCH;
+}
+
+void supervisor_research_done(ngscope_supervisor_t* q, bool found){
+    int64_t now = timestamp_ms();
+    if(found){
+        // the radio is back on the cell, ue_sync has to find the PSS again
+        set_state(q, SUPERVISOR_RESYNC, now);
+    }else{
+        q->t_state = now;
+    }
+}
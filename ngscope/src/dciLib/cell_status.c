@@ -22,8 +22,12 @@
 #include "ngscope/hdr/dciLib/cell_status.h"
 #include "ngscope/hdr/dciLib/thread_exit.h"
 #include "ngscope/hdr/dciLib/ue_list.h"
+#include "ngscope/hdr/dciLib/carrier.h"
+#include "ngscope/hdr/dciLib/ue_stats.h"
+#include "ngscope/hdr/dciLib/dci_sink_sock.h"
 
 extern bool go_exit;
+extern ngscope_dci_sink_serv_t dci_sink_serv;
 
 //  Status-Tracker <--- DCI buffer ---> (DCI-Ring-Buffer -- Cell-Status-Tracker)
 extern ngscope_status_buffer_t 	cell_stat_buffer[MAX_DCI_BUFFER];
@@ -34,10 +38,6 @@ extern dci_ready_t          	cell_stat_ready;
 //extern CA_status_t   		ca_status;
 //extern pthread_mutex_t 		cell_status_mutex;
 
-extern ngscope_ue_list_t 	ue_list[MAX_NOF_RF_DEV];
-
-extern bool task_scheduler_closed[MAX_NOF_RF_DEV];
-
 ///* init the ca status */
 //int init_CA_status(CA_status_t* q, uint16_t targetRNTI, int nof_cell, int cell_prb[MAX_NOF_RF_DEV]){
 //	q->targetRNTI 	= targetRNTI;
@@ -325,6 +325,32 @@ extern bool task_scheduler_closed[MAX_NOF_RF_DEV];
 //	return;
 //}
 
+/* Push the subframes of the cell to the remote and to the per UE statistics in TTI order, up to limit.
+ * The gaps carry no dci, there is nothing to push but the statistics count the time */
+static void cell_status_release(ngscope_cell_dci_ring_buffer_t* q, ngscope_ue_stats_t* stats, uint32_t limit, int remote_sock){
+	sf_status_t* sf;
+	while((sf = dci_ring_buffer_pop(q, limit)) != NULL){
+		ngscope_ue_stats_push_sf(stats, sf);
+		if(!sf->gap){
+			push_dci_to_remote(sf, q->cell_idx, q->targetRNTI, remote_sock);
+		}
+	}
+	return;
+}
+
+/* Send the last statistics report of the cells to the clients of the sink */
+static void cell_status_send_stats(int nof_cell){
+	ue_stats_header_t 	header;
+	ue_stats_t 			ue[UE_STATS_MAX_UE];
+	// the clients only know the cells of the cell config
+	for(int i=0; i<nof_cell && i<MAX_NOF_CELL; i++){
+		if(ngscope_ue_stats_report_get(&ngscope_carrier(i)->ue_stats, 0, &header, ue) >= 0){
+			sock_send_ue_stats_to_clients(&dci_sink_serv, &header, ue);
+		}
+	}
+	return;
+}
+
 void* cell_status_thread(void* arg){
 	// get the info 
 	cell_status_info_t info;
@@ -334,18 +360,36 @@ void* cell_status_thread(void* arg){
 	int buf_size = CELL_STATUS_RING_BUF_SIZE; 
 	int nof_dci;
 
-	ngscope_cell_dci_ring_buffer_t 		cell_status[MAX_NOF_RF_DEV];
+	ngscope_cell_dci_ring_buffer_t* 	cell_status;
 	CA_status_t   						ca_status;
+	ngscope_ue_stats_t** 				ue_stats;
+	uint64_t 							last_stats_us = timestamp_us();
 
 	ngscope_status_buffer_t dci_buf[MAX_DCI_BUFFER];
 
 	/* We now init two status buffer CA status and cell status */
 	// --> init the CA status
-	CA_status_init(&ca_status, buf_size, info.targetRNTI, info.nof_cell, info.cell_prb);
+	CA_status_init(&ca_status, buf_size, info.targetRNTI, info.nof_cell);
 
-	// --> init the cell status
+	// --> init the cell status and the ue list
+	cell_status = (ngscope_cell_dci_ring_buffer_t*)calloc(info.nof_cell, sizeof(ngscope_cell_dci_ring_buffer_t));
+	if(cell_status == NULL){
+		printf("cell status: failed to allocate %d ring buffers\n", info.nof_cell);
+		return NULL;
+	}
+	ue_stats = (ngscope_ue_stats_t**)calloc(info.nof_cell, sizeof(ngscope_ue_stats_t*));
+	if(ue_stats == NULL){
+		printf("cell status: failed to allocate %d ue statistics\n", info.nof_cell);
+		free(cell_status);
+		return NULL;
+	}
 	for(int i=0; i<info.nof_cell; i++){
-		dci_ring_buffer_init(&cell_status[i], info.targetRNTI, info.cell_prb[i], i, buf_size);
+		dci_ring_buffer_init(&cell_status[i], info.targetRNTI, ngscope_carrier_nof_prb(i), i, buf_size, info.reorder_latency);
+		ngscope_ue_list_init(&ngscope_carrier(i)->ue_list);
+
+		// the cell is known once the status threads are up
+		bool tdd = ngscope_carrier(i)->cell.frame_type == SRSRAN_TDD;
+		ue_stats[i] = ngscope_ue_stats_create(i, ngscope_carrier_nof_prb(i), tdd, info.stats_window);
 	}
 
 	FILE* fd = fopen("cell_status.txt","w+");
@@ -378,20 +422,35 @@ void* cell_status_thread(void* arg){
         //pthread_mutex_lock(&cell_status_mutex);
 		for(int i=0; i<nof_dci; i++){
 			int cell_idx = dci_buf[i].cell_idx;	
-  			fprintf(fd, "%d\t%d\t%d\t\n", dci_buf[i].tti, nof_dci, cell_status[cell_idx].cell_header);
+  			fprintf(fd, "%d\t%d\t%d\t\n", dci_buf[i].tti, nof_dci, cell_status[cell_idx].reorder.next_tti);
 			//fprintf(fd, "%d\t%d\n", dci_buf[i].tti, nof_dci);
 			//enqueue the dci to the according cell status buffer
-			dci_ring_buffer_put_dci(&(cell_status[cell_idx]), &(dci_buf[i]), remote_sock);
-			//int header = cell_status[cell_idx].cell_header;
-			//printf("cell status header:%d ready:%d\n", header, cell_status[cell_idx].cell_ready);
+			if(dci_ring_buffer_put_dci(&(cell_status[cell_idx]), &(dci_buf[i])) == TTI_REORDER_JUMP){
+				// the decoder resynced, what is pending belongs to the old timing
+				cell_status_release(&cell_status[cell_idx], ue_stats[cell_idx], dci_ring_buffer_end(&cell_status[cell_idx]), remote_sock);
+				dci_ring_buffer_reset(&cell_status[cell_idx]);
+				ngscope_ue_stats_reset(ue_stats[cell_idx]);
+				dci_ring_buffer_put_dci(&(cell_status[cell_idx]), &(dci_buf[i]));
+			}
+		}
+		for(int i=0; i<info.nof_cell; i++){
+			cell_status_release(&cell_status[i], ue_stats[i], dci_ring_buffer_frontier(&cell_status[i]), remote_sock);
+			ngscope_ue_stats_publish(ue_stats[i], &ngscope_carrier(i)->ue_stats);
+		}
+		CA_status_update_watermark(&ca_status, cell_status);
+
+		// the per UE statistics at the configured cadence
+		if(remote_sock > 0 && info.stats_interval > 0 && 
+				timestamp_us() - last_stats_us >= (uint64_t)info.stats_interval * 1000){
+			last_stats_us = timestamp_us();
+			cell_status_send_stats(info.nof_cell);
 		}
-		CA_status_update_header(&ca_status, cell_status);
         //pthread_mutex_unlock(&cell_status_mutex);
 
 		// update ue list
 		for(int i=0; i<nof_dci; i++){
 
-			ngscope_ue_list_enqueue_rnti_per_sf_per_cell(ue_list, &dci_buf[i]);
+			ngscope_ue_list_enqueue_rnti_per_sf(&ngscope_carrier(dci_buf[i].cell_idx)->ue_list, &dci_buf[i]);
 
 			//int cell_idx = dci_buf[i].cell_idx;	
 			//for(int j=0; j<dci_buf[i].dci_per_sub.nof_dl_dci; j++){
@@ -408,11 +467,15 @@ void* cell_status_thread(void* arg){
  	wait_for_ALL_RF_DEV_close();        
 	for(int i=0; i<info.nof_cell; i++){
 
-		ngscope_ue_list_print_ue_freq(&(ue_list[i]));
+		ngscope_ue_list_print_ue_freq(&ngscope_carrier(i)->ue_list);
+		ngscope_ue_list_free(&ngscope_carrier(i)->ue_list);
 
 		// delete the ring buffer
 		dci_ring_buffer_delete(&(cell_status[i]));
+		ngscope_ue_stats_free(ue_stats[i]);
 	}
+	free(cell_status);
+	free(ue_stats);
 	
 	fclose(fd);
 	//fclose(fd_log);
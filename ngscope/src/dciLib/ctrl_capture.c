@@ -0,0 +1,396 @@
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <stdint.h>
+
+#include "ngscope/hdr/dciLib/ctrl_capture.h"
+#include "ngscope/hdr/dciLib/time_stamp.h"
+#include "ngscope/hdr/dciLib/mem_report.h"
+
+// stdio buffer of the capture file, about 100 subframes of 20 MHz
+#define CTRL_CAPTURE_FILE_BUF (1 << 20)
+
+static uint32_t ctrl_capture_record_len(ctrl_capture_header_t* h){
+    uint32_t nof_re    = h->nof_prb * SRSRAN_NRE;
+    uint32_t nof_value = (uint32_t)h->nof_rx_ant * h->nof_symbols;
+    return sizeof(ctrl_capture_record_t) + nof_value * sizeof(float) + nof_value * 2 * nof_re * (h->nof_bits / 8);
+}
+
+/* Quantise the REs of one symbol with the largest I or Q as full scale, returns the scale of the codes */
+static float quantise_symbol(const cf_t* in, uint32_t nof_re, int nof_bits, void* out){
+    const float* x      = (const float*)in;
+    uint32_t     len    = 2 * nof_re;
+    float        max    = fabsf(x[srsran_vec_max_abs_fi(x, len)]);
+    float        full   = (nof_bits == 8) ? 127.0f : 32767.0f;
+
+    if(!isnormal(max)){
+        memset(out, 0, len * (nof_bits / 8));
+        return 0.0f;
+    }
+    // round to the nearest code, the truncation of srsran_vec_convert_fb costs 6 dB of SNR at 8 bit
+    float gain = full / max;
+    if(nof_bits == 8){
+        int8_t* z = (int8_t*)out;
+        for(uint32_t i=0; i<len; i++){
+            z[i] = (int8_t)lrintf(x[i] * gain);
+        }
+    }else{
+        int16_t* z = (int16_t*)out;
+        for(uint32_t i=0; i<len; i++){
+            z[i] = (int16_t)lrintf(x[i] * gain);
+        }
+    }
+    return max / full;
+}
+
+static void dequantise_symbol(const void* in, float scale, uint32_t nof_re, int nof_bits, cf_t* out){
+    float*   z   = (float*)out;
+    uint32_t len = 2 * nof_re;
+    if(nof_bits == 8){
+        const int8_t* x = (const int8_t*)in;
+        for(uint32_t i=0; i<len; i++){
+            z[i] = (float)x[i] * scale;
+        }
+    }else{
+        const int16_t* x = (const int16_t*)in;
+        for(uint32_t i=0; i<len; i++){
+            z[i] = (float)x[i] * scale;
+        }
+    }
+}
+
+int ctrl_capture_init(ngscope_ctrl_capture_t* q, const char* path, srsran_cell_t* cell,
+                            uint32_t nof_rx_ant, int nof_bits, double rf_freq, int rf_idx){
+    memset(q, 0, sizeof(ngscope_ctrl_capture_t));
+    q->rf_idx = rf_idx;
+
+    if(nof_bits != 8 && nof_bits != 16){
+        printf("ctrl capture: %d bit is not supported, using 8 bit\n", nof_bits);
+        nof_bits = 8;
+    }
+    if(nof_rx_ant == 0 || nof_rx_ant > SRSRAN_MAX_PORTS){
+        ERROR("ctrl capture: invalid number of antennas %d", nof_rx_ant);
+        return SRSRAN_ERROR;
+    }
+
+    // the FFT of the control region runs in the writer thread on a copy of the samples
+    uint32_t sf_len     = SRSRAN_SF_LEN_PRB(cell->nof_prb);
+    uint32_t symbol_sz  = srsran_symbol_sz(cell->nof_prb);
+    srsran_ofdm_cfg_t ofdm_cfg = {};
+    ofdm_cfg.nof_prb          = cell->nof_prb;
+    ofdm_cfg.cp               = cell->cp;
+    ofdm_cfg.rx_window_offset = 0.0f;
+    ofdm_cfg.normalize        = false;
+    ofdm_cfg.sf_type          = SRSRAN_SF_NORM;
+    for(uint32_t j=0; j<nof_rx_ant; j++){
+        q->fft_in[j]  = srsran_vec_cf_malloc(sf_len);
+        q->fft_out[j] = srsran_vec_cf_malloc(SRSRAN_SF_LEN_RE(cell->nof_prb, cell->cp));
+        if(q->fft_in[j] == NULL || q->fft_out[j] == NULL){
+            ERROR("Error allocating ctrl capture buffers");
+            goto clean_exit;
+        }
+        srsran_vec_cf_zero(q->fft_in[j], sf_len);
+        ofdm_cfg.in_buffer  = q->fft_in[j];
+        ofdm_cfg.out_buffer = q->fft_out[j];
+        if(srsran_ofdm_rx_init_cfg(&q->fft[j], &ofdm_cfg)){
+            ERROR("Error initiating ctrl capture FFT");
+            goto clean_exit;
+        }
+    }
+    uint32_t nof_symbols = q->fft[0].nof_symbols_ctrl;
+    for(uint32_t i=0; i<nof_symbols; i++){
+        q->nof_samples += symbol_sz + (SRSRAN_CP_ISNORM(cell->cp) ? SRSRAN_CP_LEN_NORM(i, symbol_sz) : SRSRAN_CP_LEN_EXT(symbol_sz));
+    }
+    q->nof_re = cell->nof_prb * SRSRAN_NRE;
+
+    ctrl_capture_header_t* h = &q->header;
+    h->magic            = CTRL_CAPTURE_MAGIC;
+    h->version          = CTRL_CAPTURE_VERSION;
+    h->nof_bits         = (uint8_t)nof_bits;
+    h->nof_rx_ant       = (uint8_t)nof_rx_ant;
+    h->nof_symbols      = (uint8_t)nof_symbols;
+    h->nof_ports        = (uint8_t)cell->nof_ports;
+    h->cp               = (uint8_t)cell->cp;
+    h->frame_type       = (uint8_t)cell->frame_type;
+    h->phich_length     = (uint8_t)cell->phich_length;
+    h->phich_resources  = (uint8_t)cell->phich_resources;
+    h->cell_id          = (uint16_t)cell->id;
+    h->nof_prb          = cell->nof_prb;
+    h->record_len       = ctrl_capture_record_len(h);
+    h->rf_freq          = rf_freq;
+
+    q->record = (uint8_t*)malloc(h->record_len);
+    q->ring   = srsran_vec_cf_malloc(CTRL_CAPTURE_RING * nof_rx_ant * q->nof_samples);
+    if(q->record == NULL || q->ring == NULL){
+        ERROR("Error allocating ctrl capture ring");
+        goto clean_exit;
+    }
+    ngscope_mem_report_add(NGSCOPE_MEM_IQ_BUFFER, (int64_t)CTRL_CAPTURE_RING * nof_rx_ant * q->nof_samples * sizeof(cf_t));
+
+    q->fd = fopen(path, "wb");
+    if(q->fd == NULL){
+        ERROR("Error opening ctrl capture file %s", path);
+        goto clean_exit;
+    }
+    setvbuf(q->fd, NULL, _IOFBF, CTRL_CAPTURE_FILE_BUF);
+
+    pthread_mutex_init(&q->mutex, NULL);
+    pthread_cond_init(&q->cond, NULL);
+
+    printf("RF:%d ctrl capture to %s: %d symbols %d bit, %d bytes per subframe\n",
+                rf_idx, path, nof_symbols, nof_bits, h->record_len);
+    return SRSRAN_SUCCESS;
+
+clean_exit:
+    for(uint32_t j=0; j<SRSRAN_MAX_PORTS; j++){
+        srsran_ofdm_rx_free(&q->fft[j]);
+        free(q->fft_in[j]);
+        free(q->fft_out[j]);
+    }
+    if(q->ring != NULL){
+        free(q->ring);
+        ngscope_mem_report_add(NGSCOPE_MEM_IQ_BUFFER, -(int64_t)CTRL_CAPTURE_RING * nof_rx_ant * q->nof_samples * sizeof(cf_t));
+    }
+    free(q->record);
+    memset(q, 0, sizeof(ngscope_ctrl_capture_t));
+    return SRSRAN_ERROR;
+}
+
+void ctrl_capture_free(ngscope_ctrl_capture_t* q){
+    if(q->fd == NULL){
+        return;
+    }
+    fclose(q->fd);
+    q->fd = NULL;
+    for(uint32_t j=0; j<q->header.nof_rx_ant; j++){
+        srsran_ofdm_rx_free(&q->fft[j]);
+        free(q->fft_in[j]);
+        free(q->fft_out[j]);
+    }
+    free(q->ring);
+    ngscope_mem_report_add(NGSCOPE_MEM_IQ_BUFFER, -(int64_t)CTRL_CAPTURE_RING * q->header.nof_rx_ant * q->nof_samples * sizeof(cf_t));
+    free(q->record);
+    pthread_mutex_destroy(&q->mutex);
+    pthread_cond_destroy(&q->cond);
+    return;
+}
+
+static inline cf_t* ring_slot(ngscope_ctrl_capture_t* q, uint32_t idx, uint32_t ant){
+    return &q->ring[((size_t)idx * q->header.nof_rx_ant + ant) * q->nof_samples];
+}
+
+static int ctrl_capture_write_record(ngscope_ctrl_capture_t* q, uint32_t idx){
+    ctrl_capture_header_t* h = &q->header;
+    uint32_t nof_value  = (uint32_t)h->nof_rx_ant * h->nof_symbols;
+    size_t   re_bytes   = 2 * q->nof_re * (h->nof_bits / 8);
+
+    ctrl_capture_record_t* rec = (ctrl_capture_record_t*)q->record;
+    float*   scale  = (float*)(q->record + sizeof(ctrl_capture_record_t));
+    uint8_t* re     = q->record + sizeof(ctrl_capture_record_t) + nof_value * sizeof(float);
+
+    rec->tti         = q->ring_tti[idx];
+    rec->nof_drop    = q->ring_nof_drop[idx];
+    rec->air_time_us = q->ring_air_time_us[idx];
+
+    for(uint32_t j=0; j<h->nof_rx_ant; j++){
+        memcpy(q->fft_in[j], ring_slot(q, idx, j), q->nof_samples * sizeof(cf_t));
+        srsran_ofdm_rx_sf_ctrl(&q->fft[j]);
+        for(uint32_t l=0; l<h->nof_symbols; l++){
+            uint32_t k = j * h->nof_symbols + l;
+            scale[k] = quantise_symbol(&q->fft_out[j][l * q->nof_re], q->nof_re, h->nof_bits, re + k * re_bytes);
+        }
+    }
+    if(fwrite(q->record, h->record_len, 1, q->fd) != 1){
+        ERROR("Error writing the ctrl capture");
+        return SRSRAN_ERROR;
+    }
+    q->nof_record++;
+    return SRSRAN_SUCCESS;
+}
+
+static void* ctrl_capture_thread(void* p){
+    ngscope_ctrl_capture_t* q = (ngscope_ctrl_capture_t*)p;
+    bool write_ok = true;
+
+    while(true){
+        pthread_mutex_lock(&q->mutex);
+        while(q->tail_idx == q->header_idx && q->running){
+            pthread_cond_wait(&q->cond, &q->mutex);
+        }
+        // drain the ring before we exit
+        if(q->tail_idx == q->header_idx){
+            pthread_mutex_unlock(&q->mutex);
+            break;
+        }
+        uint32_t idx = q->tail_idx;
+        pthread_mutex_unlock(&q->mutex);
+
+        // the slot is ours until the tail moves on
+        if(write_ok && ctrl_capture_write_record(q, idx)){
+            write_ok = false;
+        }
+
+        pthread_mutex_lock(&q->mutex);
+        q->tail_idx = (q->tail_idx + 1) % CTRL_CAPTURE_RING;
+        pthread_mutex_unlock(&q->mutex);
+    }
+    fflush(q->fd);
+    printf("RF:%d ctrl capture CLOSED! records:%lu dropped:%lu\n", q->rf_idx, q->nof_record, q->nof_drop_total);
+    return NULL;
+}
+
+int ctrl_capture_start(ngscope_ctrl_capture_t* q){
+    q->header.start_time_us = timestamp_us();
+    if(fwrite(&q->header, sizeof(ctrl_capture_header_t), 1, q->fd) != 1){
+        ERROR("Error writing the ctrl capture header");
+        return SRSRAN_ERROR;
+    }
+    q->running = true;
+    if(pthread_create(&q->writer_thd, NULL, ctrl_capture_thread, (void*)q) != 0){
+        ERROR("Error creating ctrl capture thread");
+        q->running = false;
+        return SRSRAN_ERROR;
+    }
+    return SRSRAN_SUCCESS;
+}
+
+void ctrl_capture_stop(ngscope_ctrl_capture_t* q){
+    pthread_mutex_lock(&q->mutex);
+    bool running = q->running;
+    q->running = false;
+    pthread_cond_signal(&q->cond);
+    pthread_mutex_unlock(&q->mutex);
+
+    if(running){
+        pthread_join(q->writer_thd, NULL);
+    }
+    return;
+}
+
+void ctrl_capture_subframe(ngscope_ctrl_capture_t* q, cf_t* IQ_buffer[SRSRAN_MAX_PORTS], uint32_t tti, int64_t air_time_us){
+    pthread_mutex_lock(&q->mutex);
+    uint32_t idx  = q->header_idx;
+    uint32_t next = (idx + 1) % CTRL_CAPTURE_RING;
+    bool     full = (next == q->tail_idx) || !q->running;
+    pthread_mutex_unlock(&q->mutex);
+
+    if(full){
+        q->nof_drop++;
+        q->nof_drop_total++;
+        return;
+    }
+    // only the sync thread writes the free slots
+    for(uint32_t j=0; j<q->header.nof_rx_ant; j++){
+        memcpy(ring_slot(q, idx, j), IQ_buffer[j], q->nof_samples * sizeof(cf_t));
+    }
+    q->ring_tti[idx]         = tti;
+    q->ring_air_time_us[idx] = air_time_us;
+    q->ring_nof_drop[idx]    = q->nof_drop;
+    q->nof_drop              = 0;
+
+    pthread_mutex_lock(&q->mutex);
+    q->header_idx = next;
+    pthread_cond_signal(&q->cond);
+    pthread_mutex_unlock(&q->mutex);
+    return;
+}
+
+int ctrl_replay_open(ngscope_ctrl_replay_t* q, const char* path){
+    memset(q, 0, sizeof(ngscope_ctrl_replay_t));
+
+    q->fd = fopen(path, "rb");
+    if(q->fd == NULL){
+        ERROR("Error opening ctrl capture file %s", path);
+        return SRSRAN_ERROR;
+    }
+    ctrl_capture_header_t* h = &q->header;
+    if(fread(h, sizeof(ctrl_capture_header_t), 1, q->fd) != 1 || h->magic != CTRL_CAPTURE_MAGIC){
+        ERROR("%s is not a ctrl capture", path);
+        goto clean_exit;
+    }
+    if(h->version != CTRL_CAPTURE_VERSION || (h->nof_bits != 8 && h->nof_bits != 16) ||
+            h->nof_rx_ant == 0 || h->nof_rx_ant > SRSRAN_MAX_PORTS ||
+            h->nof_symbols == 0 || h->nof_symbols > CTRL_CAPTURE_MAX_SYMB ||
+            h->nof_prb == 0 || h->nof_prb > SRSRAN_MAX_PRB || h->record_len != ctrl_capture_record_len(h)){
+        ERROR("Unsupported ctrl capture %s: version %d, %d bit, %d antennas, %d symbols, %d PRB",
+                    path, h->version, h->nof_bits, h->nof_rx_ant, h->nof_symbols, h->nof_prb);
+        goto clean_exit;
+    }
+    q->nof_re = h->nof_prb * SRSRAN_NRE;
+    q->record = (uint8_t*)malloc(h->record_len);
+    if(q->record == NULL){
+        goto clean_exit;
+    }
+    setvbuf(q->fd, NULL, _IOFBF, CTRL_CAPTURE_FILE_BUF);
+
+    printf("Replaying ctrl capture %s: cell id:%d prb:%d ports:%d, %d antennas, %d symbols %d bit, %.2f MHz\n",
+                path, h->cell_id, h->nof_prb, h->nof_ports, h->nof_rx_ant, h->nof_symbols, h->nof_bits, h->rf_freq / 1e6);
+    return SRSRAN_SUCCESS;
+
+clean_exit:
+    fclose(q->fd);
+    q->fd = NULL;
+    return SRSRAN_ERROR;
+}
+
+void ctrl_replay_close(ngscope_ctrl_replay_t* q){
+    if(q->fd != NULL){
+        fclose(q->fd);
+        q->fd = NULL;
+    }
+    free(q->record);
+    q->record = NULL;
+    return;
+}
+
+void ctrl_replay_cell(ngscope_ctrl_replay_t* q, srsran_cell_t* cell){
+    ctrl_capture_header_t* h = &q->header;
+    memset(cell, 0, sizeof(srsran_cell_t));
+    cell->id                = h->cell_id;
+    cell->nof_prb           = h->nof_prb;
+    cell->nof_ports         = h->nof_ports;
+    cell->cp                = (srsran_cp_t)h->cp;
+    cell->frame_type        = (srsran_frame_type_t)h->frame_type;
+    cell->phich_length      = (srsran_phich_length_t)h->phich_length;
+    cell->phich_resources   = (srsran_phich_r_t)h->phich_resources;
+    return;
+}
+
+int ctrl_replay_read(ngscope_ctrl_replay_t* q, cf_t* symbols[SRSRAN_MAX_PORTS], uint32_t* tti, int64_t* air_time_us){
+    ctrl_capture_header_t* h = &q->header;
+    size_t n = fread(q->record, 1, h->record_len, q->fd);
+    if(n == 0 && feof(q->fd)){
+        return 0;
+    }
+    if(n != h->record_len){
+        // a capture that was not closed properly ends with a partial record
+        printf("ctrl replay: truncated record after %lu subframes\n", q->nof_record);
+        return feof(q->fd) ? 0 : -1;
+    }
+    uint32_t nof_value  = (uint32_t)h->nof_rx_ant * h->nof_symbols;
+    size_t   re_bytes   = 2 * q->nof_re * (h->nof_bits / 8);
+
+    ctrl_capture_record_t* rec = (ctrl_capture_record_t*)q->record;
+    float*   scale  = (float*)(q->record + sizeof(ctrl_capture_record_t));
+    uint8_t* re     = q->record + sizeof(ctrl_capture_record_t) + nof_value * sizeof(float);
+
+    for(uint32_t j=0; j<h->nof_rx_ant; j++){
+        for(uint32_t l=0; l<h->nof_symbols; l++){
+            uint32_t k = j * h->nof_symbols + l;
+            dequantise_symbol(re + k * re_bytes, scale[k], q->nof_re, h->nof_bits, &symbols[j][l * q->nof_re]);
+        }
+    }
+    *tti         = rec->tti;
+    *air_time_us = rec->air_time_us;
+    q->nof_drop += rec->nof_drop;
+    q->nof_record++;
+    return 1;
+}
@@ -29,49 +29,37 @@
 #include "ngscope/hdr/dciLib/sib1_helper.h"
 
 #include "ngscope/hdr/dciLib/decode_sib.h"
+#include "ngscope/hdr/dciLib/sib_worker.h"
+#include "ngscope/hdr/dciLib/target_rnti.h"
+#include "ngscope/hdr/dciLib/mem_report.h"
+#include "ngscope/hdr/dciLib/carrier.h"
 
 
 extern bool                 go_exit;
 
-extern ngscope_sf_buffer_t  sf_buffer[MAX_NOF_RF_DEV][MAX_NOF_DCI_DECODER];
-extern bool                 sf_token[MAX_NOF_RF_DEV][MAX_NOF_DCI_DECODER];
-extern pthread_mutex_t      token_mutex[MAX_NOF_RF_DEV]; 
-
 extern dci_ready_t         dci_ready;
 extern ngscope_status_buffer_t    dci_buffer[MAX_DCI_BUFFER];
 
 // For decoding phich
-extern pend_ack_list       ack_list;
-extern pthread_mutex_t     ack_mutex;
-
-extern bool dci_decoder_up[MAX_NOF_RF_DEV][MAX_NOF_DCI_DECODER];
-extern bool task_scheduler_up[MAX_NOF_RF_DEV];
 
-// for ue tracking
-extern ngscope_ue_tracker_t ue_tracker[MAX_NOF_RF_DEV];
-extern pthread_mutex_t      ue_tracker_mutex[MAX_NOF_RF_DEV];
-	
-pthread_mutex_t dci_plot_mutex[MAX_NOF_RF_DEV] = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
-					 								PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER};
-pthread_cond_t 	dci_plot_cond[MAX_NOF_RF_DEV] = {PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER,
-													PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER};
-
-cf_t* pdcch_buf[MAX_NOF_RF_DEV];
-float csi_amp[MAX_NOF_RF_DEV][110 * 15 * 2048];
+// for the hybrid search
 
 int dci_decoder_init(ngscope_dci_decoder_t*     dci_decoder,
                         prog_args_t             prog_args,
                         srsran_cell_t*          cell,
                         cf_t*                   sf_buffer[SRSRAN_MAX_PORTS],
-                        srsran_softbuffer_rx_t* rx_softbuffers,
+                        ngscope_sib_worker_t*   sib_worker,
                         int                     decoder_idx,
 						ASNDecoder * 			decoder){
     // Init the args
     dci_decoder->prog_args  = prog_args;
     dci_decoder->cell       = *cell;
 	dci_decoder->decoder = decoder;
+	dci_decoder->sib_worker = sib_worker;
+	dci_decoder->si_seq 	= 0;
 
-    if (srsran_ue_dl_init(&dci_decoder->ue_dl, sf_buffer, cell->nof_prb, prog_args.rf_nof_rx_ant)) {
+    // Control channels only, the PDSCH of the SIBs is decoded by the sib worker of the cell
+    if (srsran_ue_dl_init_ctrl(&dci_decoder->ue_dl, sf_buffer, cell->nof_prb, prog_args.rf_nof_rx_ant)) {
         ERROR("Error initiating UE downlink processing module");
         exit(-1);
     }
@@ -79,6 +67,20 @@ int dci_decoder_init(ngscope_dci_decoder_t*     dci_decoder,
         ERROR("Error initiating UE downlink processing module");
         exit(-1);
     }
+    // Backlogged subframes are demodulated in batches of up to batch_max_sf
+    if (prog_args.batch_max_sf > 1 && srsran_ue_dl_batch_init(&dci_decoder->ue_dl, prog_args.batch_max_sf)) {
+        ERROR("Error initiating UE downlink batch FFT");
+        exit(-1);
+    }
+    // Only the control region is needed for the DCIs, SIB decoding demodulates the rest on demand
+    srsran_ue_dl_set_control_only(&dci_decoder->ue_dl, true);
+
+    // Candidate pruning: the fixed LLR_RATIO or a gate learned from the idle CCEs of the cell.
+    // The decoders of the carrier learn one gate (reset in ngscope_carrier_create), we only set its mode
+    ngscope_carrier_t* carrier = ngscope_carrier(prog_args.rf_index);
+    srsran_pdcch_llr_gate_share(&dci_decoder->ue_dl.pdcch, &carrier->llr_gate, &carrier->llr_gate_mutex);
+    srsran_pdcch_llr_gate_set_mode(&dci_decoder->ue_dl.pdcch, prog_args.adaptive_llr_gate ?
+                        SRSRAN_PDCCH_LLR_GATE_ADAPTIVE : SRSRAN_PDCCH_LLR_GATE_FIXED);
 
     ZERO_OBJECT(dci_decoder->ue_dl_cfg);
     ZERO_OBJECT(dci_decoder->dl_sf);
@@ -108,12 +110,6 @@ int dci_decoder_init(ngscope_dci_decoder_t*     dci_decoder,
 
     /************************* Init pdsch_cfg **************************/
     dci_decoder->pdsch_cfg.meas_evm_en = true;
-    // Allocate softbuffer buffers
-    //srsran_softbuffer_rx_t rx_softbuffers[SRSRAN_MAX_CODEWORDS];
-    for (uint32_t i = 0; i < SRSRAN_MAX_CODEWORDS; i++) {
-        dci_decoder->pdsch_cfg.softbuffers.rx[i] = &rx_softbuffers[i];
-        srsran_softbuffer_rx_init(dci_decoder->pdsch_cfg.softbuffers.rx[i], cell->nof_prb);
-    }
 
     dci_decoder->pdsch_cfg.rnti = prog_args.rnti;
     dci_decoder->decoder_idx    = decoder_idx;
@@ -163,7 +159,7 @@ void prune_based_on_activeUE(ngscope_tree_t* 		tree,
 		if(rnti <= 0){
 			continue;
 		}
-		if(ue_tracker->active_ue_list[rnti]){
+		if(ngscope_ue_tracker_is_active(ue_tracker, rnti)){
 			// push the dci message to the output
 			ngscope_push_dci_to_per_sub(dci_per_sub, &tree->dci_array[i][loc_idx]);
 
@@ -245,10 +241,69 @@ void update_ue_dci_per_tti(ngscope_tree_t* 			tree,
 	return;
 }
 
+/* Look for the SI-RNTI on the control channels of our own ue_dl and hand the subframe 
+ * to the sib worker of the cell only if a SIB is scheduled and we don't know it yet.
+ * Return the number of SI dci found, their locations go to si_loc for the hybrid search */
+static int dci_decoder_decode_sib(ngscope_dci_decoder_t*   dci_decoder,
+                                    uint32_t                sf_idx,
+                                    uint32_t                sfn,
+                                    cf_t*                   iq[SRSRAN_MAX_PORTS],
+                                    srsran_dci_location_t   si_loc[SRSRAN_MAX_DCI_MSG])
+{
+	srsran_dci_dl_t dci_dl[SRSRAN_MAX_DCI_MSG] = {};
+	uint32_t tti = sfn * 10 + sf_idx;
+
+	srsran_chest_dl_cfg_t chest_pdsch_cfg = {};
+    chest_pdsch_cfg.cfo_estimate_enable   = dci_decoder->prog_args.enable_cfo_ref;
+    chest_pdsch_cfg.cfo_estimate_sf_mask  = 1023;
+    chest_pdsch_cfg.estimator_alg         = srsran_chest_dl_str2estimator_alg(dci_decoder->prog_args.estimator_alg);
+    chest_pdsch_cfg.sync_error_enable     = true;
+
+	dci_decoder->dl_sf.tti = tti;
+    dci_decoder->dl_sf.sf_type = SRSRAN_SF_NORM;
+	dci_decoder->ue_dl_cfg.cfg.tm = (srsran_tm_t)1;
+	dci_decoder->pdsch_cfg.rnti = SRSRAN_SIRNTI;
+	dci_decoder->ue_dl_cfg.cfg.pdsch.use_tbs_index_alt = false;
+	dci_decoder->ue_dl_cfg.cfg.dci.multiple_csi_request_enabled = false;
+	dci_decoder->ue_dl_cfg.chest_cfg = chest_pdsch_cfg;
+
+	int nof_si = srsran_ue_dl_find_sib_dci(&dci_decoder->ue_dl, &dci_decoder->dl_sf, &dci_decoder->ue_dl_cfg, dci_dl);
+	nof_si = SRSRAN_MAX(0, SRSRAN_MIN(nof_si, SRSRAN_MAX_DCI_MSG));
+	for(int i=0; i<nof_si; i++){
+		si_loc[i] = dci_dl[i].location;
+	}
+	if(nof_si != 1){
+		return nof_si;
+	}
+
+	// SIB1 is sent in subframe 5 of the even frames, the other subframes carry the SI messages
+	bool sib1 = (sf_idx == 5 && (sfn % 2) == 0);
+	if(ngscope_sib_worker_need_decode(dci_decoder->sib_worker, tti, sib1, &dci_dl[0])){
+		ngscope_sib_worker_push(dci_decoder->sib_worker, iq, &dci_decoder->dl_sf, &dci_dl[0], sib1);
+	}
+	return nof_si;
+}
+
+/* Take the system information published by the sib worker */
+static void dci_decoder_update_si(ngscope_dci_decoder_t* dci_decoder)
+{
+	if(ngscope_sib_worker_params_seq(dci_decoder->sib_worker) == dci_decoder->si_seq){
+		return;
+	}
+	ngscope_si_params_t params;
+	dci_decoder->si_seq = ngscope_sib_worker_get_params(dci_decoder->sib_worker, &params);
+
+	if(dci_decoder->cell.frame_type == SRSRAN_TDD && params.tdd_present){
+		dci_decoder->dl_sf.tdd_config.sf_config  = params.sf_config;
+		dci_decoder->dl_sf.tdd_config.ss_config  = params.tdd_special_sf;
+		dci_decoder->dl_sf.tdd_config.configured = true;
+	}
+}
+
 int dci_decoder_decode(ngscope_dci_decoder_t*       dci_decoder,
                             uint32_t                sf_idx,
                             uint32_t                sfn,
-							uint8_t*                data[SRSRAN_MAX_CODEWORDS],
+							cf_t*                   iq[SRSRAN_MAX_PORTS],
                             //ngscope_dci_msg_t       dci_array[][MAX_CANDIDATES_ALL],
                             //srsran_dci_location_t   dci_location[MAX_CANDIDATES_ALL],
                             ngscope_dci_per_sub_t*  dci_per_sub)
@@ -261,44 +316,17 @@ int dci_decoder_decode(ngscope_dci_decoder_t*       dci_decoder,
 	bool decode_SIB 		= dci_decoder->prog_args.decode_SIB;
     uint16_t targetRNTI 	= dci_decoder->prog_args.rnti;  
 
-	int rf_idx 				= dci_decoder->prog_args.rf_index;
-	bool acks[SRSRAN_MAX_CODEWORDS] = {false};
-	int ret = 0;
+	ngscope_carrier_t* carrier = ngscope_carrier(dci_decoder->prog_args.rf_index);
 
-    for (int i = 0; i < SRSRAN_MAX_CODEWORDS; i++) {
-        data[i] = srsran_vec_u8_malloc(2000 * 8);
-    }
+	// The SI dci of this subframe, -1: not searched, the hybrid search looks for them itself then
+	srsran_dci_location_t si_loc[SRSRAN_MAX_DCI_MSG];
+	int nof_si_loc = -1;
 
 	//First, we decode SIB1 and SIB2
-	srsran_chest_dl_cfg_t chest_pdsch_cfg = {};
-    chest_pdsch_cfg.cfo_estimate_enable   = dci_decoder->prog_args.enable_cfo_ref;
-    chest_pdsch_cfg.cfo_estimate_sf_mask  = 1023;
-    chest_pdsch_cfg.estimator_alg         = srsran_chest_dl_str2estimator_alg(dci_decoder->prog_args.estimator_alg);
-    chest_pdsch_cfg.sync_error_enable     = true;
-
-	dci_decoder->dl_sf.tti = tti;
-    dci_decoder->dl_sf.sf_type = SRSRAN_SF_NORM;
-	dci_decoder->ue_dl_cfg.cfg.tm = (srsran_tm_t)1;
-	dci_decoder->pdsch_cfg.rnti = SRSRAN_SIRNTI;
-	dci_decoder->ue_dl_cfg.cfg.pdsch.use_tbs_index_alt = false;
-	dci_decoder->ue_dl_cfg.cfg.dci.multiple_csi_request_enabled = false;
-	dci_decoder->ue_dl_cfg.chest_cfg = chest_pdsch_cfg;
-
-	if ((sf_idx == 5 && (sfn % 2) == 0)) {
-		ret = 0;
-        ret = srsran_ue_dl_find_and_decode_sib1(&dci_decoder->ue_dl, &dci_decoder->dl_sf, \
-								&dci_decoder->ue_dl_cfg, &dci_decoder->pdsch_cfg, data, acks);
-		if (ret > 0) {
-			printf("Successfully decoded SIB1!\n");
-		}
-    } else { //SIB2 
-	    ret = 0;
-        ret = srsran_ue_dl_find_and_decode_sib2(&dci_decoder->ue_dl, &dci_decoder->dl_sf, \
-								&dci_decoder->ue_dl_cfg, &dci_decoder->pdsch_cfg, data, acks);
-		if (ret > 0) {
-			printf("Successfully decoded SIB2!\n");
-		}
-    }
+	if(decode_SIB && dci_decoder->sib_worker != NULL){
+		dci_decoder_update_si(dci_decoder);
+		nof_si_loc = dci_decoder_decode_sib(dci_decoder, sf_idx, sfn, iq, si_loc);
+	}
 
     // Shall we decode the PDSCH of the current subframe?
     if (dci_decoder->prog_args.rnti != SRSRAN_SIRNTI) {
@@ -329,23 +357,39 @@ int dci_decoder_decode(ngscope_dci_decoder_t*       dci_decoder,
 								&dci_decoder->ue_dl_cfg, &dci_decoder->pdsch_cfg, dci_per_sub, targetRNTI);
 		}else{
     		ngscope_tree_t tree;	
-			n = srsran_ngscope_search_all_space_array_yx(&dci_decoder->ue_dl, &dci_decoder->dl_sf, \
+			bool full_search = true;
+			if(dci_decoder->prog_args.hybrid_search){
+				// the target rnti every subframe, all the locations every full_search_interval subframes
+				// or when the CCEs are not explained by the target rnti
+				uint16_t rnti_list[MAX_TARGET_RNTI];
+				int nof_rnti 	 = ngscope_target_rnti_get(&carrier->target_rnti, rnti_list);
+				int interval 	 = dci_decoder->prog_args.full_search_interval;
+				full_search 	 = (interval <= 1) || (tti % interval == 0);
+				full_search 	 = srsran_ngscope_search_hybrid_yx(&dci_decoder->ue_dl, &dci_decoder->dl_sf, \
+								&dci_decoder->ue_dl_cfg, &dci_decoder->pdsch_cfg, dci_per_sub, &tree, \
+								rnti_list, nof_rnti, si_loc, nof_si_loc, full_search, targetRNTI) == 1;
+			}else{
+				n = srsran_ngscope_search_all_space_array_yx(&dci_decoder->ue_dl, &dci_decoder->dl_sf, \
 								&dci_decoder->ue_dl_cfg, &dci_decoder->pdsch_cfg, dci_per_sub, &tree, targetRNTI);
-           	pthread_mutex_lock(&ue_tracker_mutex[rf_idx]);
+			}
+           	pthread_mutex_lock(&carrier->ue_tracker_mutex);
 
-			// filter the dci 
-			filter_dci_from_tree(&tree, &ue_tracker[rf_idx], dci_per_sub);
+			// the tree is only filled by the full search
+			if(full_search){
+				// filter the dci 
+				filter_dci_from_tree(&tree, &carrier->ue_tracker, dci_per_sub);
 
-			// update the dci per subframe--> mainly decrease the tti
-			update_ue_dci_per_tti(&tree, &ue_tracker[rf_idx], dci_per_sub, tti);
+				// update the dci per subframe--> mainly decrease the tti
+				update_ue_dci_per_tti(&tree, &carrier->ue_tracker, dci_per_sub, tti);
+			}
 
 			// update the ue_tracker at subframe level, mainly remove those inactive UE
-			ngscope_ue_tracker_update_per_tti(&ue_tracker[rf_idx], tti);
+			ngscope_ue_tracker_update_per_tti(&carrier->ue_tracker, tti);
 
 			// print the tracker info
-			//ngscope_ue_tracker_info(&ue_tracker[rf_idx], tti);
+			//ngscope_ue_tracker_info(&carrier->ue_tracker, tti);
 
-           	pthread_mutex_unlock(&ue_tracker_mutex[rf_idx]);
+           	pthread_mutex_unlock(&carrier->ue_tracker_mutex);
 
 			/*********************   Print decoding result  **********************/
 
@@ -370,41 +414,81 @@ int get_target_dci(ngscope_dci_msg_t* msg, int nof_msg, uint16_t targetRNTI){
 }
 
 
-bool dci_decoder_phich_decode(ngscope_dci_decoder_t*      dci_decoder,
+// the UL grants of these RNTIs are followed on the PHICH: the target RNTIs and the RNTI of the config
+static bool phich_is_target_rnti(uint16_t rnti, uint16_t* rnti_list, int nof_rnti, uint16_t targetRNTI){
+	if(rnti == 0 || rnti == SRSRAN_SIRNTI){
+		return false;
+	}
+	if(rnti == targetRNTI){
+		return true;
+	}
+	for(int i=0; i<nof_rnti; i++){
+		if(rnti_list[i] == rnti){
+			return true;
+		}
+	}
+	return false;
+}
+
+/* Decode the ACKs expected in this subframe and arm the ones of its UL grants
+ * and NACKs. Return the number of decoded ACKs */
+int dci_decoder_phich_decode(ngscope_dci_decoder_t*      dci_decoder,
                                   uint32_t                tti,
                                   ngscope_dci_per_sub_t*  dci_per_sub, 
-        						  srsran_phich_res_t*  	  phich_res)
+        						  phich_ack_t  	  		  ack_res[PHICH_MAX_ACK])
 {
-    uint16_t targetRNTI = dci_decoder->prog_args.rnti;
-    bool ack_available = false;
-    if(targetRNTI > 0){
-        if(dci_per_sub->nof_ul_dci > 0){
-			//printf("dci_ul_msg: tti:%d, rnti:%d, mcs:%d, rv:%d\n", tti, dci_per_sub->ul_msg[0].rnti, dci_per_sub->ul_msg[0].tb[0].mcs, dci_per_sub->ul_msg[0].tb[0].rv);
-            int idx = get_target_dci(dci_per_sub->ul_msg, dci_per_sub->nof_ul_dci, targetRNTI);
-            if(idx >= 0){
-                uint32_t n_dmrs         = dci_per_sub->ul_msg[idx].phich.n_dmrs;
-                uint32_t n_prb_tilde    = dci_per_sub->ul_msg[idx].phich.n_prb_tilde;
-				uint32_t tti_phich 		= 0;
-
-				if(dci_decoder->cell.frame_type == SRSRAN_FDD){
-					tti_phich = TTI_RX_ACK(tti);
-				} else if(dci_decoder->cell.frame_type == SRSRAN_TDD){
-					tti_phich = get_phich_tti_tdd(tti, dci_decoder->dl_sf.tdd_config.sf_config);
-				}
+	ngscope_carrier_t* carrier 	= ngscope_carrier(dci_decoder->prog_args.rf_index);
+    uint16_t targetRNTI 		= dci_decoder->prog_args.rnti;
+	uint32_t sf_config 			= dci_decoder->dl_sf.tdd_config.sf_config;
+
+	pending_ack_element pending[PHICH_MAX_ACK];
+	pending_ack_element next[PHICH_MAX_ACK];
+	int nof_res 	= 0;
+	int nof_next 	= 0;
+
+	// Most subframes carry no ACK of the target RNTIs, nothing to decode then
+	int nof_pending = phich_get_pending_ack(&carrier->phich, tti, pending);
+	for(int i=0; i<nof_pending; i++){
+		// A new UL DCI of the RNTI in this subframe replaces its PHICH
+		if(ngscope_rnti_inside_dci_per_sub_ul(dci_per_sub, pending[i].rnti) >= 0){
+			continue;
+		}
+		srsran_phich_res_t phich_res;
+		if(!decode_phich(&dci_decoder->ue_dl, &dci_decoder->dl_sf, &dci_decoder->ue_dl_cfg, &pending[i], &phich_res)){
+			continue;
+		}
+		ack_res[nof_res].rnti 		= pending[i].rnti;
+		ack_res[nof_res].ack_value 	= phich_res.ack_value;
+		nof_res++;
 
-				// printf("tti:%d, tti_phich:%d, tti_dl_sf:%d\n", tti, tti_phich, dci_decoder->dl_sf.tti);
+		// A NACK triggers a non-adaptive retransmission on the same resources, expect its PHICH too
+		if(phich_res.ack_value == 0){
+			next[nof_next++] = pending[i];
+		}
+	}
 
-                pthread_mutex_lock(&ack_mutex);
-                phich_set_pending_ack(&ack_list, tti_phich, n_prb_tilde, n_dmrs);
-                pthread_mutex_unlock(&ack_mutex);
+	if(dci_per_sub->nof_ul_dci > 0){
+		//printf("dci_ul_msg: tti:%d, rnti:%d, mcs:%d, rv:%d\n", tti, dci_per_sub->ul_msg[0].rnti, dci_per_sub->ul_msg[0].tb[0].mcs, dci_per_sub->ul_msg[0].tb[0].rv);
+		uint16_t rnti_list[MAX_TARGET_RNTI];
+		int nof_rnti = ngscope_target_rnti_get(&carrier->target_rnti, rnti_list);
+		for(int i=0; i<dci_per_sub->nof_ul_dci && nof_next < PHICH_MAX_ACK; i++){
+			ngscope_dci_msg_t* msg = &dci_per_sub->ul_msg[i];
+			if(!phich_is_target_rnti(msg->rnti, rnti_list, nof_rnti, targetRNTI)){
+				continue;
+			}
+			next[nof_next].rnti 	= msg->rnti;
+			next[nof_next].I_lowest = msg->phich.n_prb_tilde;
+			next[nof_next].n_dmrs 	= msg->phich.n_dmrs;
+			nof_next++;
+		}
+	}
 
-				// If there is dci0 for the targetRNTI at current tti, reset PHICH for current tti.
-				phich_reset_pending_ack(&ack_list, tti);
-            }
-        }
-        ack_available = decode_phich(&dci_decoder->ue_dl, &dci_decoder->dl_sf, &dci_decoder->ue_dl_cfg, &dci_decoder->cell, &ack_list, phich_res);
-    }
-    return ack_available;
+	// Publish even without ACK, it clears what the slot had from an earlier subframe
+	uint32_t tti_phich = phich_get_ack_tti(&dci_decoder->cell, sf_config, tti);
+	// printf("tti:%d, tti_phich:%d, tti_dl_sf:%d\n", tti, tti_phich, dci_decoder->dl_sf.tti);
+	phich_set_pending_ack(&carrier->phich, tti_phich, next, nof_next);
+
+    return nof_res;
 }
 
 
@@ -437,38 +521,148 @@ void empty_dci_persub(ngscope_dci_per_sub_t*  dci_per_sub){
         ZERO_OBJECT(dci_per_sub->dl_msg[i]); 
         ZERO_OBJECT(dci_per_sub->ul_msg[i]); 
     }
+    dci_per_sub->timestamp          = 0;
+    dci_per_sub->decode_timestamp   = 0;
     return;
 }
     
+/* Decode the PHICH of the subframe and hand the DCIs to the status tracker */
+static void dci_decoder_push_result(ngscope_dci_decoder_t* 	dci_decoder,
+									uint32_t 				tti,
+									ngscope_dci_per_sub_t* 	dci_per_sub)
+{
+    int rf_idx     	= dci_decoder->prog_args.rf_index;
+    ngscope_status_buffer_t dci_ret;
+
+	uint32_t sf_config 	= dci_decoder->dl_sf.tdd_config.sf_config;
+	bool tdd_configured = dci_decoder->dl_sf.tdd_config.configured;
+	if(dci_decoder->cell.frame_type == SRSRAN_FDD || (subframe_is_ulgrant_tdd(tti, sf_config) && tdd_configured)){
+		phich_ack_t ack_res[PHICH_MAX_ACK];
+		int nof_ack = dci_decoder_phich_decode(dci_decoder, tti, dci_per_sub, ack_res);
+		for(int i=0; i<nof_ack; i++){
+			if(ack_res[i].ack_value != 0){
+				continue;
+			}
+			printf("TTI:%d We insert one ul reTx dci msg of rnti:%d before: %d, ", tti, ack_res[i].rnti, dci_per_sub->nof_ul_dci);
+			ngscope_enqueue_ul_reTx_dci_msg(dci_per_sub, ack_res[i].rnti);
+			printf("after: %d | \n", dci_per_sub->nof_ul_dci);
+		}
+	}
+
+    // the supervisor of the carrier watches the decoding rate
+    supervisor_dci_decoded(rf_idx, dci_per_sub->nof_dl_dci + dci_per_sub->nof_ul_dci);
+
+    dci_ret.dci_per_sub  = *dci_per_sub;
+    dci_ret.tti          = tti;
+    dci_ret.cell_idx     = rf_idx;
+
+    // put the dci into the dci buffer
+    pthread_mutex_lock(&dci_ready.mutex);
+    dci_buffer[dci_ready.header] = dci_ret;
+    dci_ready.header = (dci_ready.header + 1) % MAX_DCI_BUFFER;
+    if(dci_ready.nof_dci < MAX_DCI_BUFFER){
+        dci_ready.nof_dci++;
+    }else{
+		printf("DCI-buffer between decoder and status tracker is full! Considering increase its side!\n");
+	}
+    pthread_cond_signal(&dci_ready.cond);
+    pthread_mutex_unlock(&dci_ready.mutex);
+}
+
+/* Decode a batch of backlogged subframes: one FFT run for all of them, 
+ * then the usual per-subframe estimation and blind search */
+static void dci_decoder_decode_batch(ngscope_dci_decoder_t* dci_decoder,
+										ngscope_sf_buffer_t* 	sf_buf,
+										FILE* 					fd)
+{
+    ngscope_dci_per_sub_t   dci_per_sub; 
+	uint32_t nof_sf = sf_buf->nof_batch_sf;
+	uint32_t batch_tti[DCI_BATCH_MAX_SF];
+
+	for(uint32_t k=0; k<nof_sf; k++){
+		batch_tti[k] = sf_buf->batch_sfn[k] * 10 + sf_buf->batch_sf_idx[k];
+	}
+
+	uint64_t t1 = timestamp_us();        
+	if(srsran_ue_dl_batch_fft(&dci_decoder->ue_dl, batch_tti, nof_sf)){
+		ERROR("Error running the batch FFT");
+	}
+	uint64_t t2 = timestamp_us();        
+
+	for(uint32_t k=0; k<nof_sf; k++){
+		empty_dci_persub(&dci_per_sub);
+		dci_per_sub.timestamp 	= sf_buf->batch_air_time_us[k];
+
+		dci_decoder_decode(dci_decoder, sf_buf->batch_sf_idx[k], sf_buf->batch_sfn[k], sf_buf->batch_IQ[k], &dci_per_sub);
+		uint64_t t3 = timestamp_us();        
+		dci_per_sub.decode_timestamp = t3;
+		// the batch FFT time is shared among the subframes
+		fprintf(fd,"%d\t%ld\t\n", batch_tti[k], t3 - t2 + (t2 - t1) / nof_sf);
+		t2 = t3;
+
+		dci_decoder_push_result(dci_decoder, batch_tti[k], &dci_per_sub);
+	}
+
+	srsran_ue_dl_batch_reset(&dci_decoder->ue_dl);
+	sf_buf->nof_batch_sf = 0;
+}
+
 void* dci_decoder_thread(void* p){
 	ngscope_dci_decoder_t* dci_decoder 	= (ngscope_dci_decoder_t* )p;
 
 	int decoder_idx = dci_decoder->decoder_idx;
     int rf_idx     	= dci_decoder->prog_args.rf_index;
-    uint16_t targetRNTI 	= dci_decoder->prog_args.rnti;
-	
+	ngscope_carrier_t* carrier = ngscope_carrier(rf_idx);
 
 	printf("decoder idx :%d \n", decoder_idx);
     ngscope_dci_per_sub_t   dci_per_sub; 
-    ngscope_status_buffer_t dci_ret;
 //
 //    pthread_mutex_lock(&sf_buffer[decoder_idx].sf_mutex);
 //	dci_decoder_init(&dci_decoder, prog_args, &cell, \
 //                           sf_buffer[decoder_idx].IQ_buffer, rx_softbuffers, decoder_idx);
 //    pthread_mutex_unlock(&sf_buffer[decoder_idx].sf_mutex);
 
+	char fileName[100];
+	sprintf(fileName,"decoder_%d.txt", decoder_idx);
+	FILE* fd = fopen(fileName,"w+");
+	if(fd == NULL){
+		// the task scheduler must not wait for us
+		ERROR("RF:%d decoder %d: error opening %s", rf_idx, decoder_idx, fileName);
+		carrier->decoder_up[decoder_idx] = false;
+		ngscope_carrier_decoder_ready(carrier, false);
+		return NULL;
+	}
+
 #ifdef ENABLE_GUI
 	int nof_pdcch_sample = 36 * dci_decoder->ue_dl.pdcch.nof_cce[0];
+	// the plot buffer holds the largest control region of the cell (any CFI)
+	uint32_t* nof_cce = dci_decoder->ue_dl.pdcch.nof_cce;
+	int pdcch_buf_len = 36 * SRSRAN_MAX(nof_cce[0], SRSRAN_MAX(nof_cce[1], nof_cce[2]));
 	int nof_prb = dci_decoder->cell.nof_prb;
 	int sz = srsran_symbol_sz(nof_prb);
 	bool enable_plot = !dci_decoder->prog_args.disable_plots;	
     pthread_t plot_thread;
 	if(enable_plot){
 		if(decoder_idx == 0){
-			pdcch_buf[rf_idx] = srsran_vec_cf_malloc(36*80);
-			srsran_vec_cf_zero(pdcch_buf[rf_idx], nof_pdcch_sample);
+			carrier->pdcch_buf = srsran_vec_cf_malloc(pdcch_buf_len);
+			carrier->csi_amp = srsran_vec_f_malloc(sz);
+			if(carrier->pdcch_buf == NULL || carrier->csi_amp == NULL){
+				ERROR("RF:%d error allocating the plot buffers", rf_idx);
+				free(carrier->pdcch_buf);
+				free(carrier->csi_amp);
+				carrier->pdcch_buf 	= NULL;
+				carrier->csi_amp 	= NULL;
+				fclose(fd);
+				carrier->decoder_up[decoder_idx] = false;
+				ngscope_carrier_decoder_ready(carrier, false);
+				return NULL;
+			}
+			srsran_vec_cf_zero(carrier->pdcch_buf, pdcch_buf_len);
+			srsran_vec_f_zero(carrier->csi_amp, sz);
+			ngscope_mem_report_add(NGSCOPE_MEM_PLOT, pdcch_buf_len * sizeof(cf_t) + sz * sizeof(float));
 
 			decoder_plot_t decoder_plot;
+			decoder_plot.rf_idx 			= rf_idx;
 			decoder_plot.decoder_idx 		= decoder_idx;
 			decoder_plot.nof_pdcch_sample 	= nof_pdcch_sample;
 			decoder_plot.nof_prb 			= nof_prb;
@@ -477,21 +671,10 @@ void* dci_decoder_thread(void* p){
 		}
 	}
 #endif
-//    uint64_t t1=0, t2=0, t3=0, t4=0;  
-	char fileName[100];
-	sprintf(fileName,"decoder_%d.txt", decoder_idx);
-	FILE* fd = fopen(fileName,"w+");
-
     printf("Decoder thread idx:%d\n\n\n",decoder_idx);
 
-	uint8_t* data[SRSRAN_MAX_CODEWORDS];
-  	for (int i = 0; i < SRSRAN_MAX_CODEWORDS; i++) {
-		data[i] = srsran_vec_u8_malloc(2000 * 8);
-		if (!data[i]) {
-			ERROR("Allocating data");
-			go_exit = true;
-		}
-    }
+	// Tell the task scheduler we are ready
+	ngscope_carrier_decoder_ready(carrier, true);
 	
     while(!go_exit){
                 
@@ -499,63 +682,76 @@ void* dci_decoder_thread(void* p){
 		empty_dci_persub(&dci_per_sub);
 
 //--->  Lock the buffer
-        pthread_mutex_lock(&sf_buffer[rf_idx][decoder_idx].sf_mutex);
+        pthread_mutex_lock(&carrier->sf_buffer[decoder_idx].sf_mutex);
     
         // We release the token in the last minute just before the waiting of the condition signal 
-        pthread_mutex_lock(&token_mutex[rf_idx]);
-        if(sf_token[rf_idx][decoder_idx] == true){
-            sf_token[rf_idx][decoder_idx] = false;
+        pthread_mutex_lock(&carrier->token_mutex);
+        if(carrier->sf_token[decoder_idx] == true){
+            carrier->sf_token[decoder_idx] = false;
         }
-        pthread_mutex_unlock(&token_mutex[rf_idx]);
+        pthread_mutex_unlock(&carrier->token_mutex);
 
 //--->  Wait the signal 
         //printf("%d-th decoder is waiting for conditional signal!\n", dci_decoder->decoder_idx);
 		//t1 = timestamp_us();        
-        pthread_cond_wait(&sf_buffer[rf_idx][decoder_idx].sf_cond, 
-                          &sf_buffer[rf_idx][decoder_idx].sf_mutex);
+        pthread_cond_wait(&carrier->sf_buffer[decoder_idx].sf_cond, 
+                          &carrier->sf_buffer[decoder_idx].sf_mutex);
     
-        uint32_t sfn    = sf_buffer[rf_idx][decoder_idx].sfn;
-        uint32_t sf_idx = sf_buffer[rf_idx][decoder_idx].sf_idx;
+        uint32_t sfn    = carrier->sf_buffer[decoder_idx].sfn;
+        uint32_t sf_idx = carrier->sf_buffer[decoder_idx].sf_idx;
 
         uint32_t tti    = sfn * 10 + sf_idx;
-		bool   empty_sf = sf_buffer[rf_idx][decoder_idx].empty_sf;
+		bool   empty_sf = carrier->sf_buffer[decoder_idx].empty_sf;
+
+		// A batch of backlogged subframes
+		if(carrier->sf_buffer[decoder_idx].nof_batch_sf > 0){
+			dci_decoder_decode_batch(dci_decoder, &carrier->sf_buffer[decoder_idx], fd);
+			pthread_mutex_unlock(&carrier->sf_buffer[decoder_idx].sf_mutex);	
+			continue;
+		}
         //printf("%d-th decoder Get the conditional signal! empty:%d\n", dci_decoder->decoder_idx, empty_sf);
 		//fprintf(fd,"%d\n", tti);
 
         //printf("decoder:%d Get the signal! sfn:%d sf_idx:%d tti:%d\n", decoder_idx, sfn, sf_idx, sfn * 10 + sf_idx);
 		// We only decode when the subframe is not empty
 		if(empty_sf){
-			pthread_mutex_unlock(&sf_buffer[rf_idx][decoder_idx].sf_mutex);	
+			pthread_mutex_unlock(&carrier->sf_buffer[decoder_idx].sf_mutex);	
 			fprintf(fd,"%d\t%d\t\n", tti, 0);
+			// skipped subframe, there is no air time
+			dci_per_sub.decode_timestamp = timestamp_us();
 		}else{
 			//usleep(1000);
-    		dci_per_sub.timestamp 	= timestamp_us();
+    		dci_per_sub.timestamp 	= carrier->sf_buffer[decoder_idx].air_time_us;
 
 			uint64_t t1 = timestamp_us();        
+
+			// a replayed subframe, the control region is already in the control symbols of the ue_dl
+			srsran_ue_dl_set_ctrl_symbols(&dci_decoder->ue_dl, tti, carrier->sf_buffer[decoder_idx].nof_ctrl_symbols);
 			
-			dci_decoder_decode(dci_decoder, sf_idx,  sfn, data, &dci_per_sub);
+			dci_decoder_decode(dci_decoder, sf_idx,  sfn, carrier->sf_buffer[decoder_idx].IQ_buffer, &dci_per_sub);
 			uint64_t t2 = timestamp_us();        
+			dci_per_sub.decode_timestamp = t2;
 			fprintf(fd,"%d\t%ld\t\n", tti, t2-t1);
 	//--->  Unlock the buffer
-			pthread_mutex_unlock(&sf_buffer[rf_idx][decoder_idx].sf_mutex);	
+			pthread_mutex_unlock(&carrier->sf_buffer[decoder_idx].sf_mutex);	
 #ifdef ENABLE_GUI
 			if(enable_plot){
 				if(decoder_idx == 0){
-					pthread_mutex_lock(&dci_plot_mutex[rf_idx]);    
-					srsran_vec_cf_copy(pdcch_buf[rf_idx], dci_decoder->ue_dl.pdcch.d, nof_pdcch_sample);
+					pthread_mutex_lock(&carrier->plot_mutex);    
+					srsran_vec_cf_copy(carrier->pdcch_buf, dci_decoder->ue_dl.pdcch.d, SRSRAN_MIN(nof_pdcch_sample, pdcch_buf_len));
 
 					if (sz > 0) {
-						srsran_vec_f_zero(&(csi_amp[rf_idx][0]), sz);
+						srsran_vec_f_zero(carrier->csi_amp, sz);
 					}
 					int g = (sz - 12 * nof_prb) / 2;
 					for (int i = 0; i < 12 * nof_prb; i++) {
-						csi_amp[rf_idx][g + i] = srsran_convert_amplitude_to_dB(cabsf(dci_decoder->ue_dl.chest_res.ce[0][0][i]));
-						if (isinf(csi_amp[rf_idx][g + i])) {
-							csi_amp[rf_idx][g + i] = -80;
+						carrier->csi_amp[g + i] = srsran_convert_amplitude_to_dB(cabsf(dci_decoder->ue_dl.chest_res.ce[0][0][i]));
+						if (isinf(carrier->csi_amp[g + i])) {
+							carrier->csi_amp[g + i] = -80;
 						}
 					}
-					pthread_cond_signal(&dci_plot_cond[rf_idx]);
-					pthread_mutex_unlock(&dci_plot_mutex[rf_idx]);    
+					pthread_cond_signal(&carrier->plot_cond);
+					pthread_mutex_unlock(&carrier->plot_mutex);    
 				}
 			}
 #endif
@@ -565,41 +761,7 @@ void* dci_decoder_thread(void* p){
 		// 	printf("after:: frequency hopping: %d\n", dci_per_sub.ul_msg[0].phich.freq_hopping);
 		// }
 
-		uint32_t sf_config 	= dci_decoder->dl_sf.tdd_config.sf_config;
-		bool tdd_configured = dci_decoder->dl_sf.tdd_config.configured;
-		if(dci_decoder->cell.frame_type == SRSRAN_FDD || (subframe_is_ulgrant_tdd(tti, sf_config) && tdd_configured)){
-			srsran_phich_res_t  	  phich_res;
-			bool ack_available = dci_decoder_phich_decode(dci_decoder, tti, &dci_per_sub, &phich_res);
-			if(ack_available && phich_res.ack_value==0){
-				if(ngscope_rnti_inside_dci_per_sub_ul(&dci_per_sub,targetRNTI) >= 0){
-					printf("Conflict we have both ul dci and ul ack!\n");
-				}else{
-					printf("TTI:%d We insert one ul reTx dci msg: before: %d, ", tti, dci_per_sub.nof_ul_dci);
-					ngscope_enqueue_ul_reTx_dci_msg(&dci_per_sub, targetRNTI);
-					printf("after: %d | \n", dci_per_sub.nof_ul_dci);
-				}
-				//ngscope_push_dci_to_per_sub(dci_per_sub, &tree->dci_array[i][loc_idx]);
-			}
-		}
-
-        dci_ret.dci_per_sub  = dci_per_sub;
-        dci_ret.tti          = sfn *10 + sf_idx;
-        dci_ret.cell_idx     = rf_idx;
-
-        // put the dci into the dci buffer
-        pthread_mutex_lock(&dci_ready.mutex);
-        dci_buffer[dci_ready.header] = dci_ret;
-        dci_ready.header = (dci_ready.header + 1) % MAX_DCI_BUFFER;
-        if(dci_ready.nof_dci < MAX_DCI_BUFFER){
-            dci_ready.nof_dci++;
-        }else{
-			printf("DCI-buffer between decoder and status tracker is full! Considering increase its side!\n");
-		}
-
-        //printf("TTI :%d ul_dci: %d dl_dci:%d nof_dci:%d\n", dci_ret.tti, dci_per_sub.nof_ul_dci, 
-        //                                        dci_per_sub.nof_dl_dci, dci_ready.nof_dci);
-        pthread_cond_signal(&dci_ready.cond);
-        pthread_mutex_unlock(&dci_ready.mutex);
+		dci_decoder_push_result(dci_decoder, tti, &dci_per_sub);
 
 		//fprintf(fd, "%d\t%ld\t%ld\n",tti, t4-t1, t3-t2);
     }
@@ -616,20 +778,18 @@ void* dci_decoder_thread(void* p){
 #ifdef ENABLE_GUI
 	if(enable_plot){
 		if(decoder_idx == 0){
-			pthread_cond_signal(&dci_plot_cond[rf_idx]);
+			pthread_cond_signal(&carrier->plot_cond);
 			pthread_join(plot_thread, NULL);
-			free(pdcch_buf[rf_idx]);
+			free(carrier->pdcch_buf);
+			free(carrier->csi_amp);
+			carrier->pdcch_buf 	= NULL;
+			carrier->csi_amp 	= NULL;
+			ngscope_mem_report_add(NGSCOPE_MEM_PLOT, -(int64_t)(pdcch_buf_len * sizeof(cf_t) + sz * sizeof(float)));
 		}
 	}
 #endif
-  	for (int i = 0; i < SRSRAN_MAX_CODEWORDS; i++) {
-      if (data[i]) {
-        free(data[i]);
-      }
-    }
-
 	fclose(fd);
-	dci_decoder_up[rf_idx][decoder_idx] = false;
+	carrier->decoder_up[decoder_idx] = false;
 
     printf("%d-th RF-DEV %d-th DCI decoder CLOSED!\n",rf_idx, decoder_idx);
 
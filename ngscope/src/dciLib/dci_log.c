@@ -17,6 +17,7 @@
 #include "ngscope/hdr/dciLib/parse_args.h"
 #include "ngscope/hdr/dciLib/thread_exit.h"
 #include "ngscope/hdr/dciLib/time_stamp.h"
+#include "ngscope/hdr/dciLib/carrier.h"
 
 extern bool go_exit;
 //extern ngscope_cell_dci_ring_buffer_t 	cell_status[MAX_NOF_RF_DEV];
@@ -65,6 +66,7 @@ void log_dl_subframe(sf_status_t* q,
 			}else{
 				fprintf(fd_dl, "%d\t",  0);
 			}
+			fprintf(fd_dl, "%ld\t", q->decode_us);
 
 			fprintf(fd_dl, "\n");
 		}
@@ -78,6 +80,7 @@ void log_dl_subframe(sf_status_t* q,
 		for(int i=0; i<2;i++){
 			fprintf(fd_dl, "%d\t", 0);
 		}
+		fprintf(fd_dl, "%ld\t", q->decode_us);
 		fprintf(fd_dl, "\n");
 	}
 	return;
@@ -107,6 +110,7 @@ void log_ul_subframe(sf_status_t* q,
 				fprintf(fd_ul, "%d\t%d\t%d\t", 0, 0, 0);
 			}
 			fprintf(fd_ul, "%d\t%ld\t",  0, q->timestamp_us);
+			fprintf(fd_ul, "%ld\t", q->decode_us);
 			fprintf(fd_ul, "\n");
 		}
 	}else{
@@ -115,7 +119,7 @@ void log_ul_subframe(sf_status_t* q,
 		for(int i=0; i<10;i++){
 			fprintf(fd_ul, "%d\t", 0);
 		}
-		fprintf(fd_ul, "%ld\n", q->timestamp_us);
+		fprintf(fd_ul, "%ld\t%ld\n", q->timestamp_us, q->decode_us);
 	}
 
 	return;
@@ -137,7 +141,7 @@ void log_phich_subframe(sf_status_t* q,
 				fprintf(fd_phich, "%d\t%d\t", q->tti, q->ul_msg[i].rnti);	
 				// PHICH
 				fprintf(fd_phich, "%d\t", q->ul_msg[i].tb[0].rv);	
-				fprintf(fd_phich, "%ld\n", q->timestamp_us);							
+				fprintf(fd_phich, "%ld\t%ld\n", q->timestamp_us, q->decode_us);
 			}
 
 		}
@@ -149,7 +153,7 @@ void log_phich_subframe(sf_status_t* q,
 		for(int i=0; i<2; i++){
 			fprintf(fd_phich, "%d\t", 0);
 		}
-		fprintf(fd_phich, "%ld\n", q->timestamp_us);
+		fprintf(fd_phich, "%ld\t%ld\n", q->timestamp_us, q->decode_us);
 	}
 
 	return;
@@ -175,66 +179,44 @@ void log_per_subframe(sf_status_t* q, ngscope_dci_log_config_t* config, int cell
     return;
 }
 
-void log_per_cell(ngscope_cell_dci_ring_buffer_t* q, ngscope_dci_log_config_t* config, int cell_idx)
+/* Log the subframes of the cell in TTI order, up to limit. The gaps are logged
+ * as empty subframes without air time, like the subframes the decoders skipped */
+void log_per_cell(ngscope_cell_dci_ring_buffer_t* q, ngscope_dci_log_config_t* config, int cell_idx, uint32_t limit,
+					bool log)
 {
-	int start_idx = config->curr_header[cell_idx];
-	int end_idx   = q->cell_header;
+	sf_status_t* sf;
 
 #ifdef LOG_DCI_LOGGER
-	fprintf(config->fd_log_cell, "%d\t%d\t\n", start_idx, end_idx);
+	fprintf(config->fd_log_cell, "%d\t%d\t\n", q->reorder.next_tti, limit);
 #endif
-
-	if(q->cell_ready){
-		// we are not logging single dci 
-		if(start_idx == end_idx){
-			return;
-		}else if(start_idx > end_idx){
-			end_idx += q->buf_size;
-		}
-		for(int i=start_idx+1; i<=end_idx; i++){
-			if(go_exit) break;
-			// moving forward until we reach the current header
-			int idx = i % q->buf_size;
-			// log the dci
-			log_per_subframe(&q->sub_stat[idx], config, cell_idx);
+	while((sf = dci_ring_buffer_pop(q, limit)) != NULL){
+		if(log && !go_exit){
+			log_per_subframe(sf, config, cell_idx);
 		}
 	}
-	//fclose(fd);
     return;
 }
 
-void log_multi_cell(ngscope_cell_dci_ring_buffer_t* 	q, 
-					ngscope_dci_log_config_t* 			config,
-					ngscope_cell_dci_ring_buffer_t 		cell_status[MAX_NOF_RF_DEV],
+/* The cells are logged up to the CA watermark so that the logs of the cells
+ * stay aligned. Until all the cells are up, nothing is logged */
+void log_multi_cell(ngscope_dci_log_config_t* 			config,
+					ngscope_cell_dci_ring_buffer_t* 	cell_status,
 					CA_status_t*   						ca_status)
 {
-	if(ca_status->all_cell_ready){
-		for(int i=0; i<config->nof_cell; i++){
-			if(go_exit) break;
-			if(cell_status[i].cell_ready){
-				if(config->cell_ready[i] == false){
-					// The first time we log the dci messages
-					config->curr_header[i] = cell_status[i].cell_header;
-					config->cell_ready[i] = true;
-					dci_ring_buffer_clear_cell_fill_flag(q, i);
-				}else{
-					//int cur_head = curr_header[i];
-					//int cell_header = cell_status[i].cell_header;
-					log_per_cell(&cell_status[i], config, i);
-					if(config->curr_header[i] !=  cell_status[i].cell_header){
-						config->curr_header[i] =  cell_status[i].cell_header;
-					}
-					//fprintf(fd, "%d\t%d\t%d\t%d\t\n", cur_head, cell_header, curr_header[i], 
-								//cell_status[i].cell_header);
-				}
-			}		
+	CA_status_update_watermark(ca_status, cell_status);
+	for(int i=0; i<config->nof_cell; i++){
+		if(go_exit) break;
+		if(ca_status->all_cell_ready){
+			log_per_cell(&cell_status[i], config, i, ca_status->watermark, true);
+		}else{
+			log_per_cell(&cell_status[i], config, i, dci_ring_buffer_frontier(&cell_status[i]), false);
 		}
 	}
 	return;
 }
-void fill_file_descriptor(FILE* fd_dl[MAX_NOF_RF_DEV],
-                          FILE* fd_ul[MAX_NOF_RF_DEV],
-						  FILE* fd_phich[MAX_NOF_RF_DEV],
+void fill_file_descriptor(FILE** fd_dl,
+                          FILE** fd_ul,
+						  FILE** fd_phich,
 						  ngscope_config_t* config)
 {
 	int nof_rf_dev = config->nof_rf_dev;
@@ -295,14 +277,25 @@ void fill_file_descriptor(FILE* fd_dl[MAX_NOF_RF_DEV],
 void fill_dci_log_config(ngscope_dci_log_config_t* q, ngscope_config_t* config){
 	q->nof_cell 	= config->nof_rf_dev; 
 	q->targetRNTI 	= config->rnti; 
+
+	// calloc: the file descriptors must be NULL before the first fill_file_descriptor
+	q->fd_dl 		= (FILE**)calloc(q->nof_cell, sizeof(FILE*));
+	q->fd_ul 		= (FILE**)calloc(q->nof_cell, sizeof(FILE*));
+	q->fd_phich 	= (FILE**)calloc(q->nof_cell, sizeof(FILE*));
+	q->log_dl 		= (bool*)calloc(q->nof_cell, sizeof(bool));
+	q->log_ul 		= (bool*)calloc(q->nof_cell, sizeof(bool));
+	q->log_phich 	= (bool*)calloc(q->nof_cell, sizeof(bool));
+	if(q->fd_dl == NULL || q->fd_ul == NULL || q->fd_phich == NULL || q->log_dl == NULL ||
+			q->log_ul == NULL || q->log_phich == NULL){
+		printf("ERROR: fail to allocate the dci log config!\n");
+		exit(0);
+	}
+
 	for(int i=0; i<q->nof_cell; i++){
 		//q->cell_prb[i] 	= config.rf_config[i].
 		q->log_dl[i] 	= config->rf_config[i].log_dl;
 		q->log_ul[i] 	= config->rf_config[i].log_ul;
 		q->log_phich[i] 	= config->rf_config[i].log_phich;
-
-		q->curr_header[i] 	= 0;
-		q->cell_ready[i] 	= false;
 	}
 
 	fill_file_descriptor(q->fd_dl, q->fd_ul, q->fd_phich, config);
@@ -329,6 +322,12 @@ void clear_dci_log_config(ngscope_dci_log_config_t* q){
 			fclose(q->fd_phich[i]);
 		}
 	}
+	free(q->fd_dl);
+	free(q->fd_ul);
+	free(q->fd_phich);
+	free(q->log_dl);
+	free(q->log_ul);
+	free(q->log_phich);
 #ifdef LOG_DCI_LOGGER
 	fclose(q->fd_log_cell);
 #endif
@@ -343,7 +342,7 @@ void* dci_log_thread(void* p){
 
 	int log_interval = log_config->config.dci_log_config.log_interval;
 
-	ngscope_cell_dci_ring_buffer_t 		cell_status[MAX_NOF_RF_DEV];
+	ngscope_cell_dci_ring_buffer_t* 	cell_status;
 	CA_status_t   						ca_status;
 
 	ngscope_status_buffer_t dci_buf[MAX_DCI_BUFFER];
@@ -353,15 +352,21 @@ void* dci_log_thread(void* p){
 
 	/* We now init two status buffer CA status and cell status */
 	// --> init the CA status
-	CA_status_init(&ca_status, buf_size, dci_log_config.targetRNTI, dci_log_config.nof_cell, log_config->cell_prb);
+	CA_status_init(&ca_status, buf_size, dci_log_config.targetRNTI, dci_log_config.nof_cell);
 
 	FILE* fd = fopen("dci_log.txt", "w+");
 
 	printf("\n\n\n nof_cell:%d targetRNTI:%d \n\n\n", dci_log_config.nof_cell, dci_log_config.targetRNTI);
 
 	// --> init the cell status
+	cell_status = (ngscope_cell_dci_ring_buffer_t*)calloc(dci_log_config.nof_cell, sizeof(ngscope_cell_dci_ring_buffer_t));
+	if(cell_status == NULL){
+		printf("ERROR: fail to allocate the dci log ring buffers!\n");
+		exit(0);
+	}
 	for(int i=0; i<dci_log_config.nof_cell; i++){
-		dci_ring_buffer_init(&cell_status[i], dci_log_config.targetRNTI, log_config->cell_prb[i], i, buf_size);
+		dci_ring_buffer_init(&cell_status[i], dci_log_config.targetRNTI, ngscope_carrier_nof_prb(i), i, buf_size,
+								log_config->config.reorder_latency);
 	}
 	
 	uint64_t last_time = timestamp_ms();
@@ -392,10 +397,15 @@ void* dci_log_thread(void* p){
 			int cell_idx = dci_buf[i].cell_idx;	
 			//enqueue the dci to the according cell status buffer
 			//printf("LOGGER put dci!cell_idx:%d header:%d tti:%d\n", cell_idx, cell_status[cell_idx].cell_header, dci_buf[i].tti);
-			dci_ring_buffer_put_dci(&cell_status[cell_idx], &dci_buf[i], 0);
+			if(dci_ring_buffer_put_dci(&cell_status[cell_idx], &dci_buf[i]) == TTI_REORDER_JUMP){
+				// the decoder resynced, log what is pending before the new timing
+				log_per_cell(&cell_status[cell_idx], &dci_log_config, cell_idx, dci_ring_buffer_end(&cell_status[cell_idx]),
+								ca_status.all_cell_ready);
+				dci_ring_buffer_reset(&cell_status[cell_idx]);
+				dci_ring_buffer_put_dci(&cell_status[cell_idx], &dci_buf[i]);
+			}
 		}
-		CA_status_update_header(&ca_status, cell_status);
-		log_multi_cell(cell_status,  &dci_log_config, cell_status, &ca_status);
+		log_multi_cell(&dci_log_config, cell_status, &ca_status);
 
 		if(log_interval > 0){
 			curr_time = timestamp_ms();
@@ -406,7 +416,7 @@ void* dci_log_thread(void* p){
 				last_time = curr_time;
 			}
 		}
-		fprintf(fd, "%d\t%d\t\n", cell_status[0].cell_header, dci_log_config.curr_header[0]);
+		fprintf(fd, "%d\t%d\t\n", cell_status[0].reorder.next_tti, ca_status.watermark);
 	} 
 	fclose(fd);
 
@@ -418,6 +428,7 @@ void* dci_log_thread(void* p){
 		// delete the ring buffer
 		dci_ring_buffer_delete(&(cell_status[i]));
 	}
+	free(cell_status);
 	
 	printf("DCI-LOGGER IS CLOSED!\n");
 	return NULL;
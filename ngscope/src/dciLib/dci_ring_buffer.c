@@ -14,6 +14,8 @@
 #include "ngscope/hdr/dciLib/dci_ring_buffer.h"
 #include "ngscope/hdr/dciLib/dci_sink_def.h"
 #include "ngscope/hdr/dciLib/dci_sink_sock.h"
+#include "ngscope/hdr/dciLib/mem_report.h"
+#include "ngscope/hdr/dciLib/ngscope_util.h"
 #include "ngscope/hdr/dciLib/ngscope_def.h"
 #include "ngscope/hdr/dciLib/parse_args.h"
 #include "ngscope/hdr/dciLib/sync_dci_remote.h"
@@ -21,66 +23,40 @@
 
 extern ngscope_dci_sink_serv_t dci_sink_serv;
 
-/* Operator */
-bool a_larger_than_b(int a, int b, int buf_size)
-{
-  if ((a - b) >= 0) {
-    return true;
-  } else {
-    /* b --> 320 --> a
-       b 310   a 1 (a is larger then b in this case) */
-    if ((abs(buf_size - b) < buf_size / 8) && (a < buf_size / 8)) {
-      return true;
-    }
-  }
-  return false;
-}
-
 /* Carrier Aggregation Related Functions */
 /* init the ca status */
-int CA_status_init(CA_status_t* q, int buf_size, uint16_t targetRNTI, int nof_cell, int cell_prb[MAX_NOF_RF_DEV])
+int CA_status_init(CA_status_t* q, int buf_size, uint16_t targetRNTI, int nof_cell)
 {
   q->targetRNTI     = targetRNTI;
   q->buf_size       = buf_size;
   q->nof_cell       = nof_cell;
-  q->header         = 0;
   q->all_cell_ready = false;
-
-  memcpy(&q->cell_prb, cell_prb, MAX_NOF_RF_DEV * sizeof(int));
+  q->watermark      = 0;
   return 0;
 }
 
-int find_CA_header(int cell_header[MAX_NOF_RF_DEV], int nof_cell, int buf_size)
+/* The low watermark of all the cells: the smallest frontier.
+ * It moves with every batch of dci, once all the cells got their first dci */
+void CA_status_update_watermark(CA_status_t* q, ngscope_cell_dci_ring_buffer_t* p)
 {
-  int min_header = cell_header[0];
-  for (int i = 1; i < nof_cell; i++) {
-    if (a_larger_than_b(min_header, cell_header[i], buf_size)) {
-      min_header = cell_header[i];
+  for (int i = 0; i < q->nof_cell; i++) {
+    if (p[i].cell_ready == false) {
+      return;
     }
   }
-  return min_header;
-}
-
-void CA_status_update_header(CA_status_t* q, ngscope_cell_dci_ring_buffer_t p[MAX_NOF_RF_DEV])
-{
-  int nof_cell                    = q->nof_cell;
-  int cell_header[MAX_NOF_RF_DEV] = {0};
-
-  bool cell_ready = true;
   if (q->all_cell_ready == false) {
-    for (int i = 0; i < nof_cell; i++) {
-      if (p[i].cell_ready == false) {
-        cell_ready = false;
-      }
-      cell_header[i] = p[i].cell_header;
-    }
+    q->all_cell_ready = true;
+    printf("\n\n\n ALL %d CELLS ARE READY!!! \n\n\n", q->nof_cell);
+  }
 
-    if (cell_ready) {
-      q->all_cell_ready = true;
-      q->header         = find_CA_header(cell_header, nof_cell, q->buf_size);
-      printf("\n\n\n ALL THREE CELL ARE READY!!! \n\n\n");
+  uint32_t watermark = dci_ring_buffer_frontier(&p[0]);
+  for (int i = 1; i < q->nof_cell; i++) {
+    uint32_t frontier = dci_ring_buffer_frontier(&p[i]);
+    if (tti_offset(frontier, watermark) < 0) {
+      watermark = frontier;
     }
   }
+  q->watermark = watermark;
   return;
 }
 
@@ -100,6 +76,7 @@ void enqueue_dci_sf(sf_status_t* q, uint16_t targetRNTI, ngscope_status_buffer_t
   // Set the logging timestamp
   // q->timestamp_us 	= timestamp_us();
   q->timestamp_us = dci_buffer->dci_per_sub.timestamp;
+  q->decode_us    = dci_buffer->dci_per_sub.decode_timestamp;
 
   /* copy downlink and uplink messages
    * NOTE: we need to copy all MAX_DCI_PER_SUB dci message */
@@ -135,8 +112,7 @@ void enqueue_dci_sf(sf_status_t* q, uint16_t targetRNTI, ngscope_status_buffer_t
     q->cell_ul_prb = cell_prb;
   }
 
-  /* Mark this subframe as filed*/
-  q->filled = true;
+  q->gap = false;
   return;
 }
 
@@ -147,9 +123,14 @@ int push_dci_to_remote(sf_status_t* q, int cell_idx, uint16_t targetRNTI, int re
     // printf("ERROR: sock not set!\n\n");
     return -1;
   }
+  if (cell_idx >= MAX_NOF_CELL) {
+    // the clients only know the cells of the cell config
+    return -1;
+  }
   ue_dci_t ue_dci;
   ue_dci.cell_idx   = cell_idx;
   ue_dci.time_stamp = q->timestamp_us;
+  ue_dci.decode_time_stamp = q->decode_us;
   ue_dci.tti        = q->tti;
   ue_dci.rnti       = targetRNTI;
 
@@ -236,89 +217,25 @@ int push_dci_to_remote(sf_status_t* q, int cell_idx, uint16_t targetRNTI, int re
 //	return 0;
 // }
 
-// check if the dci message decoding has timed out
-// This is to prevent that in some cases the dci decoding of a specific
-// subframe takes too long to finish.
-// In that case, we cannot update the CA header for a long time.
-// To prevent that, we need to set a timer
-void check_dci_decoding_timeout(ngscope_cell_dci_ring_buffer_t* q)
-{
-  int header    = (q->cell_header + 1) % q->buf_size;
-  int recent_sf = q->most_recent_sf;
-  while (header != recent_sf) {
-    // printf("header:%d\n",header);
-    if (q->sub_stat[header].filled == false) {
-      int time_lag = (recent_sf - header + q->buf_size) % q->buf_size;
-      if (time_lag > DCI_DECODE_TIMEOUT) {
-        q->sub_stat[header].filled = true;
-      }
-    }
-    header = (header + 1) % q->buf_size;
-  }
-}
-
-void update_cell_status_header(ngscope_cell_dci_ring_buffer_t* q, int remote_sock)
-{
-  if (q->nof_logged_dci < (q->buf_size / 8)) {
-    return;
-  }
-  check_dci_decoding_timeout(q);
-
-  int index = (q->cell_header + 1) % q->buf_size;
-  while (q->sub_stat[index].filled) {
-    q->cell_header            = index;
-    q->sub_stat[index].filled = false;
-    push_dci_to_remote(&q->sub_stat[index], q->cell_idx, q->targetRNTI, remote_sock);
-    // fprintf(fd,"%d\t%d\t%d\t%d\t\n", q->sub_stat[index].tti, q->cell_header, index, tti);
-    // printf("push tti:%d index:%d\n", q->sub_stat[index].tti, index);
-    //  update the index
-    index = (index + 1) % q->buf_size;
-  }
-  return;
-}
-
-void update_most_recent_sf(ngscope_cell_dci_ring_buffer_t* q, int index)
-{
-  int recent_sf = q->most_recent_sf;
-  // if( abs(index - recent_sf)> 100 ){
-  //	printf("The most recent sf and the new sf seems jump too much! Take care!\n");
-  // }
-
-  if (index > recent_sf) {
-    // only valid if index and recent_sf doesn't cross boundry
-    // |-----------------------recent_sf  index --------------|
-    if (abs(index - recent_sf) < (q->buf_size / 8)) {
-      q->most_recent_sf = index;
-    }
-  } else if (index < recent_sf) {
-    // only valid if the index and recent sf across the boundry
-    // |--index -----------------------------------recent_sf---|
-    if (abs(index - recent_sf) > ((6 * q->buf_size) / 8)) {
-      q->most_recent_sf = index;
-    }
-  }
-
-  return;
-}
-
 /* Init the cell status */
 int dci_ring_buffer_init(ngscope_cell_dci_ring_buffer_t* q,
                          uint16_t                        targetRNTI,
                          int                             cell_prb,
                          int                             cell_idx,
-                         int                             buf_size)
+                         int                             buf_size,
+                         int                             max_latency)
 {
-  q->targetRNTI  = targetRNTI;
-  q->cell_prb    = cell_prb;
-  q->cell_ready  = false;
-  q->cell_header = 0;
-  q->cell_idx    = cell_idx;
-
-  q->nof_logged_dci = 0;
-  q->most_recent_sf = 0;
-  q->buf_size       = buf_size;
+  q->targetRNTI = targetRNTI;
+  q->cell_prb   = cell_prb;
+  q->cell_ready = false;
+  q->cell_idx   = cell_idx;
+  q->buf_size   = buf_size;
 
+  if (tti_reorder_init(&q->reorder, buf_size, max_latency) < 0) {
+    return -1;
+  }
   q->sub_stat = (sf_status_t*)calloc(buf_size, sizeof(sf_status_t));
+  ngscope_mem_report_add(NGSCOPE_MEM_CELL_STATUS, buf_size * sizeof(sf_status_t));
 
 #ifdef LOG_DCI_RING_BUFFER
   q->fd_log = fopen("dci_ring_buffer.txt", "w+");
@@ -330,7 +247,11 @@ int dci_ring_buffer_init(ngscope_cell_dci_ring_buffer_t* q,
 
 int dci_ring_buffer_delete(ngscope_cell_dci_ring_buffer_t* q)
 {
+  printf("Cell %d: %ld subframes released in order, %ld gaps, %ld late, %ld jumps\n", q->cell_idx,
+         q->reorder.nof_data, q->reorder.nof_gap, q->reorder.nof_late, q->reorder.nof_jump);
+  tti_reorder_free(&q->reorder);
   free(q->sub_stat);
+  ngscope_mem_report_add(NGSCOPE_MEM_CELL_STATUS, -(int64_t)(q->buf_size * sizeof(sf_status_t)));
 
 #ifdef LOG_DCI_RING_BUFFER
   fclose(q->fd_log);
@@ -341,62 +262,69 @@ int dci_ring_buffer_delete(ngscope_cell_dci_ring_buffer_t* q)
 int dci_ring_buffer_log(ngscope_cell_dci_ring_buffer_t* q, int cell_idx, uint16_t tti)
 {
   if (q->cell_idx == cell_idx) {
-    fprintf(q->fd_log, "%d\t%d\t%d\t", tti, q->cell_header, q->most_recent_sf);
-    for (int i = 0; i < q->buf_size; i++) {
-      fprintf(q->fd_log, "%d", q->sub_stat[i].filled);
-      if (i % 40 == 0) {
-        fprintf(q->fd_log, " ");
-      }
-    }
-    fprintf(q->fd_log, "\n");
+    fprintf(q->fd_log, "%d\t%d\t%d\t%d\n", tti, q->reorder.next_tti, q->reorder.newest_tti,
+            tti_reorder_frontier(&q->reorder));
   }
   return 0;
 }
 
-void dci_ring_buffer_clear_cell_fill_flag(ngscope_cell_dci_ring_buffer_t* q, int cell_idx)
+void dci_ring_buffer_reset(ngscope_cell_dci_ring_buffer_t* q)
 {
-  for (int i = 0; i < q->buf_size; i++) {
-    q->sub_stat[cell_idx].filled = false;
-  }
+  tti_reorder_reset(&q->reorder);
   return;
 }
 
 /* insert the dci into the cell status */
-void dci_ring_buffer_put_dci(ngscope_cell_dci_ring_buffer_t* q, ngscope_status_buffer_t* dci_buffer, int remote_sock)
+int dci_ring_buffer_put_dci(ngscope_cell_dci_ring_buffer_t* q, ngscope_status_buffer_t* dci_buffer)
 {
-  uint32_t tti   = dci_buffer->tti;
-  int      index = tti % q->buf_size;
-
-  // printf("enqueue dci_buffer tti:%d index:%d\n", tti, index);
-
-  /* if the cell is not ready (the first enqueued dci)
-   * set the header to (current index - 1) */
-  if (q->cell_ready == false) {
-    q->cell_ready = true;
-    // in case index-1 is negative
-    q->cell_header    = (index - 1 + q->buf_size) % q->buf_size;
-    q->most_recent_sf = q->cell_header;
-  }
-
-  /* Enqueue the dci into the cell */
-  enqueue_dci_sf(&(q->sub_stat[index]), q->targetRNTI, dci_buffer);
+  uint32_t tti  = dci_buffer->tti;
+  int      slot = tti_reorder_put(&q->reorder, tti);
 
-  // increase the number logged dci (we enqueue only 1 dci)
-  if (q->nof_logged_dci < q->buf_size) {
-    q->nof_logged_dci++;
+  // printf("enqueue dci_buffer tti:%d slot:%d\n", tti, slot);
+  if (slot == TTI_REORDER_JUMP) {
+    printf("Cell %d: tti %d jumps from %d, restarting the order\n", q->cell_idx, tti, q->reorder.newest_tti);
+    return slot;
+  }
+  if (slot == TTI_REORDER_LATE) {
+    // released already (as a gap), too late
+    return slot;
   }
+  q->cell_ready = true;
 
-  update_most_recent_sf(q, index);
+  /* Enqueue the dci into the cell */
+  enqueue_dci_sf(&(q->sub_stat[slot]), q->targetRNTI, dci_buffer);
 
 #ifdef LOG_DCI_RING_BUFFER
   dci_ring_buffer_log(q, 0, tti);
 #endif
-  /* update the header */
-  uint16_t last_header = q->cell_header;
-  update_cell_status_header(q, remote_sock);
+  return slot;
+}
 
-  if (last_header != q->cell_header) {
-    /* Header has been updated */
+sf_status_t* dci_ring_buffer_pop(ngscope_cell_dci_ring_buffer_t* q, uint32_t limit)
+{
+  uint32_t tti;
+  int      slot;
+  int      ret = tti_reorder_pop(&q->reorder, limit, &tti, &slot);
+
+  if (ret == TTI_REORDER_NONE) {
+    return NULL;
   }
-  return;
+  sf_status_t* sf = &q->sub_stat[slot];
+  if (ret == TTI_REORDER_GAP) {
+    // the slot may hold an older subframe, the gap record is empty
+    bzero(sf, sizeof(sf_status_t));
+    sf->tti = tti;
+    sf->gap = true;
+  }
+  return sf;
+}
+
+uint32_t dci_ring_buffer_frontier(ngscope_cell_dci_ring_buffer_t* q)
+{
+  return tti_reorder_frontier(&q->reorder);
+}
+
+uint32_t dci_ring_buffer_end(ngscope_cell_dci_ring_buffer_t* q)
+{
+  return tti_reorder_end(&q->reorder);
 }
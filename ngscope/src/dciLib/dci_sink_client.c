@@ -103,6 +103,60 @@ int sock_close_and_notify_udp(int sockfd)
   return 0;
 }
 
+// edit the target rnti list of the hybrid search of a cell at the server, cell_idx 0xFF for all the cells
+int sock_send_target_rnti_udp(int sockfd, char serv_IP[40], int serv_port, uint8_t cell_idx, uint8_t op, uint16_t* rnti, int nof_rnti)
+{
+  char               buffer[7 + 2 * MAX_TARGET_RNTI];
+  struct sockaddr_in servaddr = sock_create_serv_addr(serv_IP, serv_port);
+
+  if (nof_rnti < 0 || nof_rnti > MAX_TARGET_RNTI) {
+    printf("At most %d target rnti!\n", MAX_TARGET_RNTI);
+    return -1;
+  }
+
+  buffer[0] = (char)0xDD;
+  buffer[1] = (char)0xDD;
+  buffer[2] = (char)0xDD;
+  buffer[3] = (char)0xDD;
+  buffer[4] = (char)op;
+  buffer[5] = (char)nof_rnti;
+  memcpy(&buffer[6], rnti, nof_rnti * sizeof(uint16_t));
+  buffer[6 + 2 * nof_rnti] = (char)cell_idx;
+
+  return sendto(sockfd, (char*)buffer, 7 + 2 * nof_rnti, 0, (const struct sockaddr*)&servaddr, sizeof(servaddr));
+}
+
+// ask the server for the per UE statistics, cell_idx 0xFF for all the cells, rnti 0 for all the UEs
+int sock_send_ue_stats_query_udp(int sockfd, char serv_IP[40], int serv_port, uint8_t cell_idx, uint16_t rnti)
+{
+  char               buffer[7];
+  struct sockaddr_in servaddr = sock_create_serv_addr(serv_IP, serv_port);
+
+  buffer[0] = (char)0xEE;
+  buffer[1] = (char)0xEE;
+  buffer[2] = (char)0xEE;
+  buffer[3] = (char)0xEE;
+  buffer[4] = (char)cell_idx;
+  memcpy(&buffer[5], &rnti, sizeof(uint16_t));
+
+  return sendto(sockfd, (char*)buffer, 7, 0, (const struct sockaddr*)&servaddr, sizeof(servaddr));
+}
+
+// ask the server to dump the IQ snapshot ring, cell_idx 0xFF for all the cells
+int sock_send_iq_snapshot_request_udp(int sockfd, char serv_IP[40], int serv_port, uint8_t cell_idx)
+{
+  char               buffer[5];
+  struct sockaddr_in servaddr = sock_create_serv_addr(serv_IP, serv_port);
+
+  buffer[0] = (char)0x99;
+  buffer[1] = (char)0x99;
+  buffer[2] = (char)0x99;
+  buffer[3] = (char)0x99;
+  buffer[4] = (char)cell_idx;
+
+  return sendto(sockfd, (char*)buffer, 5, 0, (const struct sockaddr*)&servaddr, sizeof(servaddr));
+}
+
 void* dci_sink_client_thread(void* p)
 {
   char               serv_IP[40] = "127.0.0.1";
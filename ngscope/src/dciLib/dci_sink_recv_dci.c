@@ -76,6 +76,41 @@ int recv_dci(char* recvBuf, ue_dci_t* ue_dci, int buf_idx, int recvLen){
 	return buf_idx;
 }
 
+void print_ue_stats(ue_stats_header_t* header, ue_stats_t* ue){
+	printf("Cell_idx:%d tti:%d window:%d ms cell dl_prb:%.2f ul_prb:%.2f\n", 
+			header->cell_idx, header->tti, header->window_ms, header->cell_dl_prb_share, header->cell_ul_prb_share);
+	for(int i=0; i<header->nof_ue; i++){
+		printf("  rnti:%d dl:%.1f kbps (reTx %d/%d) ul:%.1f kbps (reTx %d/%d) dl_prb:%.2f ul_prb:%.2f\n", 
+				ue[i].rnti, ue[i].dl_kbps, ue[i].dl_nof_reTx, ue[i].dl_nof_tb, 
+				ue[i].ul_kbps, ue[i].ul_nof_reTx, ue[i].ul_nof_tb, ue[i].dl_prb_share, ue[i].ul_prb_share);
+	}
+	return;
+}
+
+// One message of a statistics report, the UEs are stored inside ue
+int recv_ue_stats(char* recvBuf, ue_stats_header_t* header, ue_stats_t ue[UE_STATS_PER_MSG], int buf_idx, int recvLen){
+	if(buf_idx + 1 + (int)sizeof(ue_stats_header_t) > recvLen){
+		printf("recv_ue_stats: not enough bytes!\n");
+		return buf_idx;
+	}
+	uint8_t 	proto_v;
+	memcpy(&proto_v, &recvBuf[buf_idx], sizeof(uint8_t));
+	if(proto_v != 0){
+		printf("ERROR: unknown protocol version!\n");
+		return buf_idx;
+	}
+	memcpy(header, &recvBuf[buf_idx + 1], sizeof(ue_stats_header_t));
+
+	int nof_ue = header->nof_ue;
+	int end 	= buf_idx + 1 + sizeof(ue_stats_header_t) + nof_ue * sizeof(ue_stats_t);
+	if(nof_ue > UE_STATS_PER_MSG || end > recvLen){
+		printf("recv_ue_stats: not enough bytes!\n");
+		return buf_idx;
+	}
+	memcpy(ue, &recvBuf[buf_idx + 1 + sizeof(ue_stats_header_t)], nof_ue * sizeof(ue_stats_t));
+	print_ue_stats(header, ue);
+	return end;
+}
 
 // We receve the data inside the buffer
 int ngscope_dci_sink_recv_buffer(ngscope_dci_sink_CA_t* q, char* recvBuf, int idx, int recvLen){
@@ -117,6 +152,18 @@ int ngscope_dci_sink_recv_buffer(ngscope_dci_sink_CA_t* q, char* recvBuf, int id
 		}else{
 			ngscope_dciSink_ringBuf_update_config(q, &cell_config);	
 		}
+	}else if( recvBuf[buf_idx] == (char)0xEE && recvBuf[buf_idx+1] == (char)0xEE && \
+		recvBuf[buf_idx+2] == (char)0xEE && recvBuf[buf_idx+3] == (char)0xEE ){
+
+		ue_stats_header_t 	header;
+		ue_stats_t 			ue[UE_STATS_PER_MSG];
+		buf_idx	+= 4;
+		int buf_idx_before = buf_idx;
+		buf_idx = recv_ue_stats(recvBuf, &header, ue, buf_idx, recvLen);
+		if(buf_idx_before == buf_idx){
+			buf_idx -= 4;
+			return -1;
+		}
 	}else if( recvBuf[buf_idx] == (char)0xFF && recvBuf[buf_idx+1] == (char)0xFF && \
 		recvBuf[buf_idx+2] == (char)0xFF && recvBuf[buf_idx+3] == (char)0xFF ){
 		printf("EXIT!\n");
@@ -20,12 +20,80 @@
 #include "ngscope/hdr/dciLib/dci_sink_serv.h"
 #include "ngscope/hdr/dciLib/dci_sink_sock.h"
 #include "ngscope/hdr/dciLib/dci_sink_recv_dci.h"
+#include "ngscope/hdr/dciLib/target_rnti.h"
+#include "ngscope/hdr/dciLib/carrier.h"
+#include "ngscope/hdr/dciLib/ue_stats.h"
 
 extern bool go_exit;
 //extern client_list_t client_list;
 
 extern ngscope_dci_sink_serv_t dci_sink_serv;
 
+// reply to a statistics query: cell_idx: 8 bits (0xFF: all the cells) | rnti: 16 bits (0: all the UEs)
+static void reply_ue_stats_query(int sockfd, struct sockaddr_in* cliaddr, const char* buf, int len){
+	if(len < 7){
+		printf("Malformed ue stats query!\n");
+		return;
+	}
+	uint8_t  cell_idx = (uint8_t)buf[4];
+	uint16_t rnti;
+	memcpy(&rnti, &buf[5], sizeof(uint16_t));
+
+	ue_stats_header_t 	header;
+	ue_stats_t 			ue[UE_STATS_MAX_UE];
+	// the clients only know the cells of the cell config
+	for(int i=0; i<ngscope_nof_carrier() && i<MAX_NOF_CELL; i++){
+		if(cell_idx != 0xFF && cell_idx != i){
+			continue;
+		}
+		ngscope_carrier_t* carrier = ngscope_carrier(i);
+		if(carrier == NULL || ngscope_ue_stats_report_get(&carrier->ue_stats, rnti, &header, ue) < 0){
+			continue;
+		}
+		sock_send_ue_stats(sockfd, cliaddr, 1, &header, ue);
+	}
+	return;
+}
+
+// dump the IQ snapshot ring: cell_idx: 8 bits (0xFF: all the cells)
+static void handle_iq_snapshot_request(const char* buf, int len){
+	if(len < 5){
+		printf("Malformed iq snapshot request!\n");
+		return;
+	}
+	uint8_t cell_idx = (uint8_t)buf[4];
+	for(int i=0; i<ngscope_nof_carrier() && i<MAX_NOF_CELL; i++){
+		ngscope_carrier_t* carrier = ngscope_carrier(i);
+		if(carrier == NULL || (cell_idx != 0xFF && cell_idx != i)){
+			continue;
+		}
+		iq_snapshot_trigger(&carrier->iq_snapshot, IQ_SNAPSHOT_API);
+	}
+	return;
+}
+
+// edit the target rnti list of one cell or of all of them
+static void handle_target_rnti_msg(const char* buf, int len){
+	int cell_idx = ngscope_target_rnti_msg_cell(buf, len);
+	if(cell_idx < 0){
+		printf("Malformed target rnti message!\n");
+		return;
+	}
+	for(int i=0; i<ngscope_nof_carrier(); i++){
+		ngscope_carrier_t* carrier = ngscope_carrier(i);
+		if(carrier == NULL || (cell_idx != 0xFF && cell_idx != i)){
+			continue;
+		}
+		if(ngscope_target_rnti_handle_msg(&carrier->target_rnti, buf, len) < 0){
+			printf("Malformed target rnti message!\n");
+			return;
+		}
+		printf("RF:%d ", i);
+		ngscope_target_rnti_print(&carrier->target_rnti);
+	}
+	return;
+}
+
 int push_client_to_vec(struct sockaddr_in client_addr[MAX_CLIENT], struct sockaddr_in* addr, int nof_client){
 	// if the vectoris full, return
 	if(nof_client >= MAX_CLIENT){
@@ -113,6 +181,21 @@ void* dci_sink_server_thread(void* p){
 					sock_send_config(&dci_sink_serv, &cell_config);
 				}
 			}
+			// the client edits the rnti list of the hybrid search
+			if( recvBuf[0] == (char)0xDD && recvBuf[1] == (char)0xDD && recvBuf[2] == (char)0xDD 
+							 && recvBuf[3] == (char)0xDD ){
+				handle_target_rnti_msg(recvBuf, n);
+			}
+			// the client asks for the per UE statistics
+			if( recvBuf[0] == (char)0xEE && recvBuf[1] == (char)0xEE && recvBuf[2] == (char)0xEE 
+							 && recvBuf[3] == (char)0xEE ){
+				reply_ue_stats_query(sockfd, &cliaddr, recvBuf, n);
+			}
+			// the client asks for a dump of the last subframes
+			if( recvBuf[0] == (char)0x99 && recvBuf[1] == (char)0x99 && recvBuf[2] == (char)0x99 
+							 && recvBuf[3] == (char)0x99 ){
+				handle_iq_snapshot_request(recvBuf, n);
+			}
 			// we receive the request to close the connection  
 			if( recvBuf[0] == (char)0xFF && recvBuf[1] == (char)0xFF && recvBuf[2] == (char)0xFF 
 							 && recvBuf[3] == (char)0xFF ){
@@ -206,6 +206,58 @@ int sock_send_config(ngscope_dci_sink_serv_t* q, cell_config_t* cell_config)
   return 1;
 }
 
+/* Send a statistics report, split in messages of UE_STATS_PER_MSG UEs */
+int sock_send_ue_stats(int sockfd, struct sockaddr_in* addr, int nof_addr, ue_stats_header_t* header, ue_stats_t* ue)
+{
+  char              buf[5 + sizeof(ue_stats_header_t) + UE_STATS_PER_MSG * sizeof(ue_stats_t)];
+  ue_stats_header_t msg_header = *header;
+  int               nof_ue     = header->nof_ue;
+  // a report without UE is still sent, it carries the cell statistics
+  int nof_msg = nof_ue > 0 ? (nof_ue + UE_STATS_PER_MSG - 1) / UE_STATS_PER_MSG : 1;
+
+  msg_header.nof_msg = nof_msg;
+  for (int m = 0; m < nof_msg; m++) {
+    int first  = m * UE_STATS_PER_MSG;
+    int nof_tx = nof_ue - first < UE_STATS_PER_MSG ? nof_ue - first : UE_STATS_PER_MSG;
+    /**********************************************
+    preamble: 			0xEE 0xEE 0xEE 0xEE
+    protocol version:  	8 bits
+    ue_stats_header_t, nof_ue: UEs of this message
+    ue_stats_t x nof_ue
+    **********************************************/
+    buf[0]      = 0xEE;
+    buf[1]      = 0xEE;
+    buf[2]      = 0xEE;
+    buf[3]      = 0xEE;
+    buf[4]      = 0;
+    int buf_idx = 5;
+
+    msg_header.msg_idx = m;
+    msg_header.nof_ue  = nof_tx;
+    memcpy(&buf[buf_idx], &msg_header, sizeof(ue_stats_header_t));
+    buf_idx += sizeof(ue_stats_header_t);
+
+    memcpy(&buf[buf_idx], &ue[first], nof_tx * sizeof(ue_stats_t));
+    buf_idx += nof_tx * sizeof(ue_stats_t);
+
+    for (int i = 0; i < nof_addr; i++) {
+      int ret = sendto(sockfd, (char*)buf, buf_idx, MSG_CONFIRM, (const struct sockaddr*)&addr[i], sizeof(struct sockaddr));
+      if (ret < 0) {
+        printf("ERROR in sending via socket!\n");
+      }
+    }
+  }
+  return nof_msg;
+}
+
+int sock_send_ue_stats_to_clients(ngscope_dci_sink_serv_t* q, ue_stats_header_t* header, ue_stats_t* ue)
+{
+  pthread_mutex_lock(&q->client_list.mutex);
+  int ret = sock_send_ue_stats(q->sink_sockfd, q->client_list.client_addr, q->client_list.nof_client, header, ue);
+  pthread_mutex_unlock(&q->client_list.mutex);
+  return ret;
+}
+
 struct sockaddr_in sock_create_serv_addr(char serv_IP[40], int serv_port)
 {
   struct sockaddr_in servaddr;
@@ -0,0 +1,269 @@
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <stdint.h>
+
+#include "ngscope/hdr/dciLib/iq_snapshot.h"
+#include "ngscope/hdr/dciLib/carrier.h"
+#include "ngscope/hdr/dciLib/time_stamp.h"
+#include "ngscope/hdr/dciLib/mem_report.h"
+
+static const char* reason_name[] = {"none", "api", "skip", "sync_loss", "decode_rate"};
+
+static inline cf_t* ring_slot(ngscope_iq_snapshot_t* q, uint32_t slot, uint32_t ant){
+    return &q->ring[((size_t)slot * q->nof_rx_ant + ant) * q->slot_len];
+}
+
+int iq_snapshot_init(ngscope_iq_snapshot_t* q, const char* path, int duration_ms, srsran_cell_t* cell,
+                        uint32_t nof_rx_ant, double rf_freq, int rf_idx, int numa_node,
+                        uint32_t skip_limit, uint32_t min_dci, uint64_t* nof_dci)
+{
+    memset(q, 0, sizeof(ngscope_iq_snapshot_t));
+    if(duration_ms <= 0 || duration_ms > IQ_SNAPSHOT_MAX_MS){
+        ERROR("IQ snapshot of %d ms, it has to be within 1-%d ms", duration_ms, IQ_SNAPSHOT_MAX_MS);
+        return SRSRAN_ERROR;
+    }
+    q->rf_idx       = rf_idx;
+    q->cell         = *cell;
+    q->rf_freq      = rf_freq;
+    snprintf(q->path, sizeof(q->path), "%s", path);
+    q->nof_slot     = duration_ms;  // one slot per subframe
+    q->nof_rx_ant   = nof_rx_ant;
+    q->sf_len       = SRSRAN_SF_LEN_PRB(cell->nof_prb);
+    q->slot_len     = (q->sf_len + 7) & ~7u;
+    q->skip_limit   = skip_limit;
+    q->min_dci      = min_dci;
+    q->nof_dci      = nof_dci;
+
+    if(sem_init(&q->dump_sem, 0, 0) != 0){
+        ERROR("Error initializing the IQ snapshot semaphore");
+        return SRSRAN_ERROR;
+    }
+    size_t size     = (size_t)q->nof_slot * nof_rx_ant * q->slot_len * sizeof(cf_t);
+    q->ring_size    = (size + NGSCOPE_HUGE_PAGE_SIZE - 1) / NGSCOPE_HUGE_PAGE_SIZE * NGSCOPE_HUGE_PAGE_SIZE;
+    q->ring         = (cf_t*)ngscope_numa_alloc_huge(q->ring_size, numa_node);
+    q->slot_tti     = (uint32_t*)calloc(q->nof_slot, sizeof(uint32_t));
+    q->slot_air_time_us = (int64_t*)calloc(q->nof_slot, sizeof(int64_t));
+    if(q->ring == NULL || q->slot_tti == NULL || q->slot_air_time_us == NULL){
+        ERROR("Error allocating the IQ snapshot ring of %zu bytes", q->ring_size);
+        ngscope_numa_free(q->ring, q->ring_size);
+        free(q->slot_tti);
+        free(q->slot_air_time_us);
+        sem_destroy(&q->dump_sem);
+        q->ring = NULL;
+        return SRSRAN_ERROR;
+    }
+    // fault the pages in now, not in the sync thread
+    memset(q->ring, 0, q->ring_size);
+    ngscope_mem_report_add(NGSCOPE_MEM_IQ_SNAPSHOT, (int64_t)q->ring_size);
+
+    printf("RF:%d IQ snapshot of the last %d ms, %.1f MB\n", rf_idx, duration_ms, q->ring_size / 1048576.0);
+    return SRSRAN_SUCCESS;
+}
+
+void iq_snapshot_free(ngscope_iq_snapshot_t* q){
+    if(q->ring == NULL){
+        return;
+    }
+    printf("RF:%d IQ snapshot: %d dumps, %d triggers ignored, %lu subframes not kept during the dumps\n",
+                q->rf_idx, q->nof_dump, q->nof_ignored, q->nof_pinned);
+    ngscope_numa_free(q->ring, q->ring_size);
+    ngscope_mem_report_add(NGSCOPE_MEM_IQ_SNAPSHOT, -(int64_t)q->ring_size);
+    q->ring = NULL;
+    free(q->slot_tti);
+    free(q->slot_air_time_us);
+    sem_destroy(&q->dump_sem);
+    return;
+}
+
+/* The cell and the first TTI of the dump, the TTIs are needed to decode the file again */
+static FILE* open_dump_info(ngscope_iq_snapshot_t* q, const char* file_name){
+    char name[300];
+    snprintf(name, sizeof(name), "%s.txt", file_name);
+    FILE* fd = fopen(name, "w");
+    if(fd == NULL){
+        printf("IQ snapshot: cannot open %s\n", name);
+        return NULL;
+    }
+    uint32_t first = q->dump_start % q->nof_slot;
+    fprintf(fd, "reason\t%s\n", reason_name[q->dump_reason]);
+    fprintf(fd, "rf_idx\t%d\n", q->rf_idx);
+    fprintf(fd, "rf_freq\t%.0f\n", q->rf_freq);
+    fprintf(fd, "srate\t%d\n", srsran_sampling_freq_hz(q->cell.nof_prb));
+    fprintf(fd, "nof_rx_ant\t%d\n", q->nof_rx_ant);
+    fprintf(fd, "cell_id\t%d\n", q->cell.id);
+    fprintf(fd, "nof_prb\t%d\n", q->cell.nof_prb);
+    fprintf(fd, "nof_ports\t%d\n", q->cell.nof_ports);
+    fprintf(fd, "cp\t%s\n", srsran_cp_string(q->cell.cp));
+    fprintf(fd, "frame_type\t%s\n", q->cell.frame_type == SRSRAN_TDD ? "TDD" : "FDD");
+    fprintf(fd, "first_tti\t%d\n", q->slot_tti[first]);
+    fprintf(fd, "first_air_time_us\t%ld\n", q->slot_air_time_us[first]);
+    return fd;
+}
+
+static void iq_snapshot_dump(ngscope_iq_snapshot_t* q){
+    char name[300];
+    int64_t t_start = timestamp_ms();
+    snprintf(name, sizeof(name), "%s_rf%d_%ld_%s.bin", q->path, q->rf_idx, t_start, reason_name[q->dump_reason]);
+
+    srsran_filesink_t sink;
+    FILE* info = NULL;
+    bool  ok   = srsran_filesink_init(&sink, name, SRSRAN_COMPLEX_FLOAT_BIN) == SRSRAN_SUCCESS;
+    if(ok){
+        info = open_dump_info(q, name);
+    }else{
+        printf("IQ snapshot: cannot open %s\n", name);
+    }
+    uint64_t nof_sf   = 0;
+    uint32_t last_tti = 0;
+    for(uint64_t seq = q->dump_start; seq < q->dump_end; seq++){
+        uint32_t slot = seq % q->nof_slot;
+        if(ok){
+            cf_t* buffers[SRSRAN_MAX_PORTS] = {NULL};
+            for(uint32_t j=0; j<q->nof_rx_ant; j++){
+                buffers[j] = ring_slot(q, slot, j);
+            }
+            srsran_filesink_write_multi(&sink, (void**)buffers, q->sf_len, q->nof_rx_ant);
+            // subframe of the file -> tti, where the tti does not follow the previous one (sync loss)
+            if(info != NULL && nof_sf > 0 && q->slot_tti[slot] != (last_tti + 1) % 10240){
+                fprintf(info, "gap\t%lu\t%d\n", nof_sf, q->slot_tti[slot]);
+            }
+            last_tti = q->slot_tti[slot];
+            nof_sf++;
+        }
+        // the slot can be reused by the sync thread
+        __atomic_store_n(&q->dump_pos, seq + 1, __ATOMIC_RELEASE);
+    }
+    if(ok){
+        srsran_filesink_free(&sink);
+        if(info != NULL){
+            fprintf(info, "nof_sf\t%lu\n", nof_sf);
+            fclose(info);
+        }
+        printf("RF:%d IQ snapshot (%s): %lu subframes written to %s in %ld ms\n", q->rf_idx,
+                    reason_name[q->dump_reason], nof_sf, name, timestamp_ms() - t_start);
+    }
+    __atomic_store_n(&q->dumping, false, __ATOMIC_RELEASE);
+    return;
+}
+
+static void* iq_snapshot_thread(void* p){
+    ngscope_iq_snapshot_t* q = (ngscope_iq_snapshot_t*)p;
+    while(true){
+        sem_wait(&q->dump_sem);
+        if(__atomic_load_n(&q->dumping, __ATOMIC_ACQUIRE)){
+            iq_snapshot_dump(q);
+        }
+        if(!__atomic_load_n(&q->running, __ATOMIC_ACQUIRE)){
+            break;
+        }
+    }
+    return NULL;
+}
+
+int iq_snapshot_start(ngscope_iq_snapshot_t* q){
+    q->running = true;
+    if(pthread_create(&q->dump_thd, NULL, iq_snapshot_thread, (void*)q) != 0){
+        ERROR("Error creating the IQ snapshot thread");
+        q->running = false;
+        return SRSRAN_ERROR;
+    }
+    __atomic_store_n(&q->enabled, true, __ATOMIC_RELEASE);
+    return SRSRAN_SUCCESS;
+}
+
+void iq_snapshot_stop(ngscope_iq_snapshot_t* q){
+    __atomic_store_n(&q->enabled, false, __ATOMIC_RELEASE);
+    if(!q->running){
+        return;
+    }
+    __atomic_store_n(&q->running, false, __ATOMIC_RELEASE);
+    sem_post(&q->dump_sem);
+    pthread_join(q->dump_thd, NULL);
+    return;
+}
+
+void iq_snapshot_trigger(ngscope_iq_snapshot_t* q, ngscope_iq_snapshot_reason_t reason){
+    if(!__atomic_load_n(&q->enabled, __ATOMIC_ACQUIRE)){
+        return;
+    }
+    // the first reason wins until the sync thread takes it
+    int none = IQ_SNAPSHOT_NONE;
+    __atomic_compare_exchange_n(&q->pending, &none, (int)reason, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+}
+
+void iq_snapshot_poll(ngscope_iq_snapshot_t* q){
+    int reason = __atomic_exchange_n(&q->pending, IQ_SNAPSHOT_NONE, __ATOMIC_ACQUIRE);
+    if(reason == IQ_SNAPSHOT_NONE){
+        return;
+    }
+    int64_t now = timestamp_ms();
+    if(q->head_seq == 0 || __atomic_load_n(&q->dumping, __ATOMIC_ACQUIRE) ||
+            (q->nof_dump > 0 && now - q->t_last_dump < IQ_SNAPSHOT_HOLDOFF_MS)){
+        q->nof_ignored++;
+        return;
+    }
+    // the whole ring, or what has been received so far
+    q->dump_end     = q->head_seq;
+    q->dump_start   = q->head_seq > q->nof_slot ? q->head_seq - q->nof_slot : 0;
+    q->dump_reason  = reason;
+    q->t_last_dump  = now;
+    q->nof_dump++;
+    __atomic_store_n(&q->dump_pos, q->dump_start, __ATOMIC_RELAXED);
+    __atomic_store_n(&q->dumping, true, __ATOMIC_RELEASE);
+    sem_post(&q->dump_sem);
+    printf("RF:%d IQ snapshot triggered (%s)\n", q->rf_idx, reason_name[reason]);
+}
+
+bool iq_snapshot_next(ngscope_iq_snapshot_t* q, cf_t* buffers[SRSRAN_MAX_PORTS]){
+    uint64_t seq = q->head_seq;
+    // the slot still holds a subframe of the dump
+    if(seq >= q->nof_slot && __atomic_load_n(&q->dumping, __ATOMIC_ACQUIRE) &&
+            seq - q->nof_slot >= __atomic_load_n(&q->dump_pos, __ATOMIC_ACQUIRE)){
+        q->nof_pinned++;
+        return false;
+    }
+    for(uint32_t j=0; j<q->nof_rx_ant; j++){
+        buffers[j] = ring_slot(q, seq % q->nof_slot, j);
+    }
+    return true;
+}
+
+void iq_snapshot_commit(ngscope_iq_snapshot_t* q, uint32_t tti, int64_t air_time_us){
+    uint32_t slot = q->head_seq % q->nof_slot;
+    q->slot_tti[slot]           = tti;
+    q->slot_air_time_us[slot]   = air_time_us;
+    q->head_seq++;
+
+    // the windows of the skip and decode rate triggers
+    q->nof_rate_sf++;
+    if(q->nof_rate_sf >= IQ_SNAPSHOT_RATE_SF){
+        q->nof_rate_sf = 0;
+        q->nof_skip    = 0;
+        if(q->min_dci > 0 && q->nof_dci != NULL){
+            uint64_t nof_dci = __atomic_load_n(q->nof_dci, __ATOMIC_RELAXED);
+            if(q->head_seq > IQ_SNAPSHOT_RATE_SF && nof_dci - q->last_nof_dci < q->min_dci){
+                iq_snapshot_trigger(q, IQ_SNAPSHOT_DECODE_RATE);
+            }
+            q->last_nof_dci = nof_dci;
+        }
+    }
+}
+
+void iq_snapshot_skipped(ngscope_iq_snapshot_t* q){
+    if(q->skip_limit == 0){
+        return;
+    }
+    q->nof_skip++;
+    if(q->nof_skip == q->skip_limit){
+        iq_snapshot_trigger(q, IQ_SNAPSHOT_SKIP);
+    }
+}
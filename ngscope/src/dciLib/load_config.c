@@ -4,6 +4,7 @@
 #include <string.h>
 #include <libconfig.h>
 #include "ngscope/hdr/dciLib/load_config.h"
+#include "ngscope/hdr/dciLib/ue_stats.h"
 
 int compar(const void* a,const void* b)
 {
@@ -44,6 +45,10 @@ int ngscope_read_config(ngscope_config_t* config, char * path){
         printf("ERROR: reading nof_rf_dev\n");
     }
     printf("read nof rf_dev:%d\n", config->nof_rf_dev);
+    if(config->nof_rf_dev <= 0){
+        printf("ERROR: nof_rf_dev must be positive\n");
+        exit(0);
+    }
     
     if(! config_lookup_int(cfg, "rnti", &config->rnti)){
         printf("ERROR: reading rnti\n");
@@ -65,8 +70,81 @@ int ngscope_read_config(ngscope_config_t* config, char * path){
     }
     printf("read decode_SIB:%d\n", config->decode_SIB);
 
+	// optional, the fixed llr gate is used if it is not set
+	if(! config_lookup_bool(cfg, "adaptive_llr_gate", &config->adaptive_llr_gate)){
+		config->adaptive_llr_gate = false;
+    }
+    printf("read adaptive_llr_gate:%d\n", config->adaptive_llr_gate);
+
+	// optional, hybrid search: decode the target rnti list every subframe and all the locations
+	// every full_search_interval subframes
+	if(! config_lookup_bool(cfg, "hybrid_search", &config->hybrid_search)){
+		config->hybrid_search = false;
+    }
+	if(! config_lookup_int(cfg, "full_search_interval", &config->full_search_interval)){
+		config->full_search_interval = FULL_SEARCH_INTERVAL;
+    }
+    printf("read hybrid_search:%d full_search_interval:%d\n", config->hybrid_search, config->full_search_interval);
+
+	// optional, the batch FFT of the backlogged subframes
+	if(! config_lookup_int(cfg, "batch_max_sf", &config->batch_max_sf)){
+		config->batch_max_sf = DCI_BATCH_DEFAULT_SF;
+    }
+	if(config->batch_max_sf < 1 || config->batch_max_sf > DCI_BATCH_MAX_SF){
+		printf("batch_max_sf:%d out of range, using %d\n", config->batch_max_sf, DCI_BATCH_DEFAULT_SF);
+		config->batch_max_sf = DCI_BATCH_DEFAULT_SF;
+	}
+	if(! config_lookup_int(cfg, "batch_threshold", &config->batch_threshold)){
+		config->batch_threshold = DCI_BATCH_THRESHOLD;
+    }
+	if(config->batch_threshold < 1){
+		printf("batch_threshold:%d out of range, using %d\n", config->batch_threshold, DCI_BATCH_THRESHOLD);
+		config->batch_threshold = DCI_BATCH_THRESHOLD;
+	}
+	printf("read batch_max_sf:%d batch_threshold:%d\n", config->batch_max_sf, config->batch_threshold);
+
+	// optional, how long the cell status and the logger wait for a late subframe
+	if(! config_lookup_int(cfg, "reorder_latency", &config->reorder_latency)){
+		config->reorder_latency = DCI_DECODE_TIMEOUT;
+    }
+	if(config->reorder_latency < 1 || config->reorder_latency >= CELL_STATUS_RING_BUF_SIZE ||
+			config->reorder_latency >= DCI_LOGGER_RING_BUF_SIZE){
+		printf("reorder_latency:%d out of range, using %d\n", config->reorder_latency, DCI_DECODE_TIMEOUT);
+		config->reorder_latency = DCI_DECODE_TIMEOUT;
+	}
+
+	// optional, the sliding window of the per UE statistics and how often they are sent to the sink
+	if(! config_lookup_int(cfg, "stats_window", &config->stats_window)){
+		config->stats_window = UE_STATS_DEFAULT_WINDOW;
+    }
+	if(config->stats_window < UE_STATS_MIN_WINDOW || config->stats_window > UE_STATS_MAX_WINDOW){
+		printf("stats_window:%d out of range, using %d\n", config->stats_window, UE_STATS_DEFAULT_WINDOW);
+		config->stats_window = UE_STATS_DEFAULT_WINDOW;
+	}
+	if(! config_lookup_int(cfg, "stats_interval", &config->stats_interval)){
+		config->stats_interval = UE_STATS_DEFAULT_WINDOW;
+    }
+	if(config->stats_interval < 0){
+		config->stats_interval = 0;
+	}
+	printf("read stats_window:%d stats_interval:%d\n", config->stats_window, config->stats_interval);
+
+	// optional, the default rnti list of the hybrid search of the carriers. The rnti above is used if it is not set
+	config->nof_target_rnti = 0;
+	config_setting_t* rnti_list = config_lookup(cfg, "target_rnti");
+	if(rnti_list != NULL){
+		int len = config_setting_length(rnti_list);
+		for(int i=0; i<len && config->nof_target_rnti < MAX_TARGET_RNTI; i++){
+			config->target_rnti[config->nof_target_rnti++] = (uint16_t)config_setting_get_int_elem(rnti_list, i);
+		}
+	}else if(config->rnti > 0){
+		config->target_rnti[config->nof_target_rnti++] = (uint16_t)config->rnti;
+	}
+    printf("read %d target rnti\n", config->nof_target_rnti);
+
 
 	long long* freq_vec = (long long*) malloc(config->nof_rf_dev * sizeof(long long));
+	config->rf_config 	= (rf_dev_config_t*) calloc(config->nof_rf_dev, sizeof(rf_dev_config_t));
 
 //    if(! config_lookup_int(cfg, "con_time_s", &config->con_time_s)){
 //        printf("ERROR: reading con_time_s\n");
@@ -138,6 +216,73 @@ int ngscope_read_config(ngscope_config_t* config, char * path){
             printf("log phich: %d\n", config->rf_config[i].log_phich);
         }        
 
+        // optional, the carrier is not bound to a NUMA node if it is not set
+        sprintf(name, "rf_config%d.numa_node",i);
+		if(! config_lookup_int(cfg, name, &config->rf_config[i].numa_node)){
+            config->rf_config[i].numa_node = -1;
+        }else{
+            printf("numa node: %d\n", config->rf_config[i].numa_node);
+        }
+
+        // optional, the control region capture and its replay
+        const char* ctrl_path;
+        sprintf(name, "rf_config%d.ctrl_capture",i);
+        if(config_lookup_string(cfg, name, &ctrl_path)){
+            snprintf(config->rf_config[i].ctrl_capture, sizeof(config->rf_config[i].ctrl_capture), "%s", ctrl_path);
+            printf("ctrl capture: %s\n", config->rf_config[i].ctrl_capture);
+        }else{
+            config->rf_config[i].ctrl_capture[0] = '\0';
+        }
+        sprintf(name, "rf_config%d.ctrl_capture_bits",i);
+        if(! config_lookup_int(cfg, name, &config->rf_config[i].ctrl_capture_bits)){
+            config->rf_config[i].ctrl_capture_bits = 8;
+        }
+        sprintf(name, "rf_config%d.ctrl_replay",i);
+        if(config_lookup_string(cfg, name, &ctrl_path)){
+            snprintf(config->rf_config[i].ctrl_replay, sizeof(config->rf_config[i].ctrl_replay), "%s", ctrl_path);
+            printf("ctrl replay: %s\n", config->rf_config[i].ctrl_replay);
+        }else{
+            config->rf_config[i].ctrl_replay[0] = '\0';
+        }
+
+        // optional, the IQ snapshot ring and its triggers
+        sprintf(name, "rf_config%d.iq_snapshot_ms",i);
+        if(config_lookup_int(cfg, name, &config->rf_config[i].iq_snapshot_ms)){
+            printf("iq snapshot: %d ms\n", config->rf_config[i].iq_snapshot_ms);
+        }else{
+            config->rf_config[i].iq_snapshot_ms = 0;
+        }
+        sprintf(name, "rf_config%d.iq_snapshot_path",i);
+        if(config_lookup_string(cfg, name, &ctrl_path)){
+            snprintf(config->rf_config[i].iq_snapshot_path, sizeof(config->rf_config[i].iq_snapshot_path), "%s", ctrl_path);
+        }else{
+            sprintf(config->rf_config[i].iq_snapshot_path, "iq_snapshot");
+        }
+        sprintf(name, "rf_config%d.iq_snapshot_skip",i);
+        if(! config_lookup_int(cfg, name, &config->rf_config[i].iq_snapshot_skip)){
+            config->rf_config[i].iq_snapshot_skip = 0;
+        }
+        sprintf(name, "rf_config%d.iq_snapshot_min_dci",i);
+        if(! config_lookup_int(cfg, name, &config->rf_config[i].iq_snapshot_min_dci)){
+            config->rf_config[i].iq_snapshot_min_dci = 0;
+        }
+
+        // optional, the rnti list of the hybrid search of this carrier, the global one if it is not set
+        sprintf(name, "rf_config%d.target_rnti",i);
+        config_setting_t* rf_rnti_list = config_lookup(cfg, name);
+        if(rf_rnti_list != NULL){
+            int len = config_setting_length(rf_rnti_list);
+            config->rf_config[i].nof_target_rnti = 0;
+            for(int j=0; j<len && config->rf_config[i].nof_target_rnti < MAX_TARGET_RNTI; j++){
+                config->rf_config[i].target_rnti[config->rf_config[i].nof_target_rnti++] =
+                                (uint16_t)config_setting_get_int_elem(rf_rnti_list, j);
+            }
+            printf("read %d target rnti\n", config->rf_config[i].nof_target_rnti);
+        }else{
+            config->rf_config[i].nof_target_rnti = config->nof_target_rnti;
+            memcpy(config->rf_config[i].target_rnti, config->target_rnti, config->nof_target_rnti * sizeof(uint16_t));
+        }
+
     }
 
 	if(containsDuplicate(freq_vec, config->nof_rf_dev)){
@@ -145,6 +290,7 @@ int ngscope_read_config(ngscope_config_t* config, char * path){
 		So, we currently doesn't support it! Please check your configuration files to fix it.\n");
 		exit(0);
 	}
+	free(freq_vec);
 
     // DCI log config
     config->dci_log_config.nof_cell = config->nof_rf_dev;
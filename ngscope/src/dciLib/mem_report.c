@@ -0,0 +1,49 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "ngscope/hdr/dciLib/mem_report.h"
+
+static bool    mem_report_on = false;
+static int64_t mem_bytes[NGSCOPE_MEM_NOF_SUBSYS] = {0};
+
+static const char* subsys_name[NGSCOPE_MEM_NOF_SUBSYS] = {
+	"dci buffer", "iq buffer", "ue tracker", "ue list", "cell status", "plot", "ue stats", "iq snapshot"
+};
+
+void ngscope_mem_report_enable(bool enable){
+	mem_report_on = enable;
+}
+
+bool ngscope_mem_report_enabled(){
+	return mem_report_on;
+}
+
+// the buffers are allocated by different threads
+void ngscope_mem_report_add(ngscope_mem_subsys_t subsys, int64_t bytes){
+	if(subsys < 0 || subsys >= NGSCOPE_MEM_NOF_SUBSYS){
+		return;
+	}
+	__atomic_add_fetch(&mem_bytes[subsys], bytes, __ATOMIC_RELAXED);
+}
+
+int64_t ngscope_mem_report_get(ngscope_mem_subsys_t subsys){
+	if(subsys < 0 || subsys >= NGSCOPE_MEM_NOF_SUBSYS){
+		return 0;
+	}
+	return __atomic_load_n(&mem_bytes[subsys], __ATOMIC_RELAXED);
+}
+
+void ngscope_mem_report_print(FILE* fd, const char* stage){
+	if(!mem_report_on){
+		return;
+	}
+	int64_t total = 0;
+	fprintf(fd, "Memory report (%s):\n", stage);
+	for(int i=0; i<NGSCOPE_MEM_NOF_SUBSYS; i++){
+		int64_t bytes = ngscope_mem_report_get(i);
+		total += bytes;
+		fprintf(fd, "  %-12s %10.1f KB\n", subsys_name[i], bytes / 1024.0);
+	}
+	fprintf(fd, "  %-12s %10.1f KB\n", "total", total / 1024.0);
+}
@@ -0,0 +1,187 @@
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <stdint.h>
+
+#include "ngscope/hdr/dciLib/mib_sync.h"
+#include "ngscope/hdr/dciLib/time_stamp.h"
+
+extern bool go_exit;
+
+int mib_sync_init(ngscope_mib_sync_t* q, srsran_cell_t* cell, int rf_idx){
+    memset(q, 0, sizeof(ngscope_mib_sync_t));
+    q->cell     = *cell;
+    q->rf_idx   = rf_idx;
+    q->sf_len   = SRSRAN_SF_LEN_PRB(cell->nof_prb);
+
+    q->sf_buffer[0] = srsran_vec_cf_malloc(q->sf_len);
+    if(q->sf_buffer[0] == NULL){
+        ERROR("Error allocating MIB buffer");
+        return SRSRAN_ERROR;
+    }
+    if (srsran_ue_mib_init(&q->ue_mib, q->sf_buffer[0], cell->nof_prb)) {
+        ERROR("Error initaiting UE MIB decoder");
+        return SRSRAN_ERROR;
+    }
+    if (srsran_ue_mib_set_cell(&q->ue_mib, *cell)) {
+        ERROR("Error initaiting UE MIB decoder");
+        return SRSRAN_ERROR;
+    }
+    pthread_mutex_init(&q->mutex, NULL);
+    pthread_cond_init(&q->cond, NULL);
+
+    // the budget of the MIB stage is one frame, report every ~10 seconds
+    stage_slack_init(&q->slack, "MIB", rf_idx, 100);
+    return SRSRAN_SUCCESS;
+}
+
+void mib_sync_free(ngscope_mib_sync_t* q){
+    srsran_ue_mib_free(&q->ue_mib);
+    if(q->sf_buffer[0] != NULL){
+        free(q->sf_buffer[0]);
+        q->sf_buffer[0] = NULL;
+    }
+    pthread_mutex_destroy(&q->mutex);
+    pthread_cond_destroy(&q->cond);
+    return;
+}
+
+static void* mib_sync_thread(void* p){
+    ngscope_mib_sync_t* q = (ngscope_mib_sync_t*)p;
+    uint8_t bch_payload[SRSRAN_BCH_PAYLOAD_LEN];
+
+    while(true){
+        pthread_mutex_lock(&q->mutex);
+        while(!q->busy && q->running && !go_exit){
+            pthread_cond_wait(&q->cond, &q->mutex);
+        }
+        if(!q->running || go_exit){
+            pthread_mutex_unlock(&q->mutex);
+            break;
+        }
+        uint32_t tagged_sfn = q->tagged_sfn;
+        uint32_t generation = q->generation;
+        bool     reset      = q->reset_decoder;
+        q->reset_decoder    = false;
+        pthread_mutex_unlock(&q->mutex);
+
+        int64_t t1 = timestamp_us();
+        if(reset){
+            srsran_ue_mib_reset(&q->ue_mib);
+        }
+
+        int sfn_offset = 0;
+        int n = srsran_ue_mib_decode(&q->ue_mib, bch_payload, NULL, &sfn_offset);
+        if(n < 0){
+            ERROR("Error decoding UE MIB");
+        }else if(n == SRSRAN_UE_MIB_FOUND){
+            uint32_t sfn = 0;
+            srsran_cell_t cell = q->cell;
+            srsran_pbch_mib_unpack(bch_payload, &cell, &sfn);
+            sfn = (sfn + sfn_offset) % 1024;
+
+            // wrap the offset into [-512, 511]
+            int delta = ((int)sfn - (int)tagged_sfn + 1024 + 512) % 1024 - 512;
+
+            pthread_mutex_lock(&q->mutex);
+            // the sync was reset while we were decoding, the result is stale
+            if(generation != q->generation){
+                pthread_mutex_unlock(&q->mutex);
+                goto done;
+            }
+            q->sfn_delta    = delta;
+            q->new_result   = true;
+            q->verifying    = false;
+            q->nof_frame_since_verify = 0;
+            q->nof_verified++;
+            if(delta != 0){
+                q->nof_mismatch++;
+            }
+            pthread_mutex_unlock(&q->mutex);
+        }
+done:
+        stage_slack_update(&q->slack, 10000 - (timestamp_us() - t1));
+
+        pthread_mutex_lock(&q->mutex);
+        q->busy = false;
+        pthread_mutex_unlock(&q->mutex);
+    }
+    printf("RF:%d MIB thread CLOSED! verified:%d mismatch:%d\n", q->rf_idx, q->nof_verified, q->nof_mismatch);
+    return NULL;
+}
+
+int mib_sync_start(ngscope_mib_sync_t* q){
+    q->running = true;
+    if(pthread_create(&q->mib_thd, NULL, mib_sync_thread, (void*)q) != 0){
+        ERROR("Error creating MIB thread");
+        q->running = false;
+        return SRSRAN_ERROR;
+    }
+    return SRSRAN_SUCCESS;
+}
+
+void mib_sync_stop(ngscope_mib_sync_t* q){
+    pthread_mutex_lock(&q->mutex);
+    bool running = q->running;
+    q->running = false;
+    pthread_cond_signal(&q->cond);
+    pthread_mutex_unlock(&q->mutex);
+
+    if(running){
+        pthread_join(q->mib_thd, NULL);
+    }
+    return;
+}
+
+void mib_sync_frame(ngscope_mib_sync_t* q, cf_t* IQ_buffer[SRSRAN_MAX_PORTS], uint32_t sfn, bool sfn_locked){
+    pthread_mutex_lock(&q->mutex);
+    q->nof_frame_since_verify++;
+
+    // Before the SFN is locked we try every frame. Afterwards we only
+    // start a verification burst every MIB_VERIFY_PERIOD frames, which
+    // lasts until the PBCH has been decoded once.
+    if(sfn_locked && !q->verifying && q->nof_frame_since_verify >= MIB_VERIFY_PERIOD){
+        q->verifying        = true;
+        q->reset_decoder    = true;
+    }
+
+    if((!sfn_locked || q->verifying) && !q->busy){
+        memcpy(q->sf_buffer[0], IQ_buffer[0], q->sf_len * sizeof(cf_t));
+        q->tagged_sfn   = sfn;
+        q->busy         = true;
+        pthread_cond_signal(&q->cond);
+    }
+    pthread_mutex_unlock(&q->mutex);
+    return;
+}
+
+void mib_sync_reset(ngscope_mib_sync_t* q){
+    pthread_mutex_lock(&q->mutex);
+    q->generation++;
+    q->reset_decoder    = true;
+    q->verifying        = false;
+    q->new_result       = false;
+    q->nof_frame_since_verify = 0;
+    pthread_mutex_unlock(&q->mutex);
+    return;
+}
+
+bool mib_sync_get_result(ngscope_mib_sync_t* q, int* sfn_delta){
+    bool ret = false;
+    pthread_mutex_lock(&q->mutex);
+    if(q->new_result){
+        *sfn_delta      = q->sfn_delta;
+        q->new_result   = false;
+        ret = true;
+    }
+    pthread_mutex_unlock(&q->mutex);
+    return ret;
+}
@@ -20,9 +20,16 @@
 #include "ngscope/hdr/dciLib/status_tracker.h"
 #include "ngscope/hdr/dciLib/cell_status.h"
 #include "ngscope/hdr/dciLib/ue_list.h"
+#include "ngscope/hdr/dciLib/target_rnti.h"
+#include "ngscope/hdr/dciLib/ue_tracker.h"
+#include "ngscope/hdr/dciLib/task_sf_ring_buffer.h"
+#include "ngscope/hdr/dciLib/status_plot.h"
+#include "ngscope/hdr/dciLib/mem_report.h"
+#include "ngscope/hdr/dciLib/carrier.h"
 
 pthread_mutex_t     cell_mutex = PTHREAD_MUTEX_INITIALIZER;
-srsran_cell_t       cell_vec[MAX_NOF_RF_DEV];
+
+// RNTI list of the hybrid search, the dci sink server edits it at runtime
 
 //  DCI-Decoder <--- DCI buffer ---> Status-Tracker
 ngscope_status_buffer_t dci_buffer[MAX_DCI_BUFFER];
@@ -35,51 +42,119 @@ dci_ready_t          	cell_stat_ready = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND
 //  Status-Tracker <--- DCI buffer ---> (DCI-Ring-Buffer -- DCI-Logger)
 ngscope_status_buffer_t log_stat_buffer[MAX_DCI_BUFFER];
 dci_ready_t          	log_stat_ready = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0};
-//
-//// DCI status container for Cell-Status-Tracker
-//ngscope_cell_dci_ring_buffer_t 		cell_status[MAX_NOF_RF_DEV];
-//CA_status_t   						ca_status;
-//pthread_mutex_t     cell_status_mutex = PTHREAD_MUTEX_INITIALIZER;
-//
-//// DCI status container for DCI-Logger 
-//ngscope_cell_dci_ring_buffer_t 		log_cell_status[MAX_NOF_RF_DEV];
-//CA_status_t   						log_ca_status;
-//
-// UE list
-ngscope_ue_list_t 	ue_list[MAX_NOF_RF_DEV];
-
-// dci decoder status
-bool dci_decoder_up[MAX_NOF_RF_DEV][MAX_NOF_DCI_DECODER] = {{false}};
-bool task_scheduler_up[MAX_NOF_RF_DEV] = {false};
-
-//bool dci_decoder_closed[MAX_NOF_RF_DEV][MAX_NOF_DCI_DECODER] = {{true}};
-bool task_scheduler_closed[MAX_NOF_RF_DEV] = {true, true, true, true};
+
 pthread_mutex_t     scheduler_close_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+// The per carrier contexts and the plot data account for themselves, we add the static buffers here
+static void mem_report_static(){
+    ngscope_mem_report_add(NGSCOPE_MEM_DCI_BUFFER, sizeof(dci_buffer) + sizeof(cell_stat_buffer) + sizeof(log_stat_buffer));
+}
+
+// The prewarm ue_sync is only built for its plans, it never receives any sample
+static int prewarm_recv(void* h, cf_t* data[SRSRAN_MAX_CHANNELS], uint32_t nsamples, srsran_timestamp_t* t){
+    return SRSRAN_ERROR;
+}
+
+// Build the same plans as a carrier of each LTE bandwidth (sync, MIB, DCI decoders and SIB worker) so that
+// the FFTW wisdom is ready and the decoders start up without measuring the FFTs again. The objects are
+// initialized the way the carrier does it, with the antennas and decimation of prog_args
+int ngscope_prewarm_fftw(prog_args_t prog_args){
+    uint32_t prb_list[] = {6, 15, 25, 50, 75, 100};
+    uint32_t nof_rx_ant = prog_args.rf_nof_rx_ant;
+    int      decimate   = (prog_args.decimate > 0 && prog_args.decimate <= 4) ? prog_args.decimate : 0;
+
+    for(int p=0; p<sizeof(prb_list)/sizeof(prb_list[0]); p++){
+        srsran_cell_t cell;
+        memset(&cell, 0, sizeof(srsran_cell_t));
+        cell.nof_prb    = prb_list[p];
+        cell.nof_ports  = 1;
+        cell.cp         = SRSRAN_CP_NORM;
+        cell.frame_type = SRSRAN_FDD;
+
+        uint32_t max_num_samples = 3 * SRSRAN_SF_LEN_PRB(cell.nof_prb);
+        cf_t* buffer[SRSRAN_MAX_PORTS] = {NULL};
+        for(int j=0; j<nof_rx_ant; j++){
+            buffer[j] = srsran_vec_cf_malloc(max_num_samples);
+        }
+
+        printf("Building FFTW plans for %d PRB ...\n", cell.nof_prb);
+
+        srsran_ue_sync_t ue_sync;
+        if(srsran_ue_sync_init_multi_decim(&ue_sync, cell.nof_prb, false, prewarm_recv, nof_rx_ant, buffer, decimate) ||
+                srsran_ue_sync_set_cell(&ue_sync, cell)){
+            ERROR("Error initiating ue_sync");
+            return SRSRAN_ERROR;
+        }
+
+        srsran_ue_mib_t ue_mib;
+        if(srsran_ue_mib_init(&ue_mib, buffer[0], cell.nof_prb) || srsran_ue_mib_set_cell(&ue_mib, cell)){
+            ERROR("Error initiating ue_mib");
+            return SRSRAN_ERROR;
+        }
+
+        // the DCI decoders: control channels only, with the batch FFT (see dci_decoder_init).
+        // The plans of all the batch sizes up to DCI_BATCH_MAX_SF, whatever batch_max_sf the config sets
+        srsran_ue_dl_t ue_dl;
+        if(srsran_ue_dl_init_ctrl(&ue_dl, buffer, cell.nof_prb, nof_rx_ant) || srsran_ue_dl_set_cell(&ue_dl, cell) ||
+                srsran_ue_dl_batch_init(&ue_dl, DCI_BATCH_MAX_SF)){
+            ERROR("Error initiating UE downlink processing module");
+            return SRSRAN_ERROR;
+        }
+
+        // the PDSCH decoder of the SIB worker
+        srsran_ue_dl_t ue_dl_sib;
+        if(srsran_ue_dl_init(&ue_dl_sib, buffer, cell.nof_prb, nof_rx_ant) || srsran_ue_dl_set_cell(&ue_dl_sib, cell)){
+            ERROR("Error initiating UE downlink processing module");
+            return SRSRAN_ERROR;
+        }
+
+        srsran_ue_dl_free(&ue_dl_sib);
+        srsran_ue_dl_free(&ue_dl);
+        srsran_ue_mib_free(&ue_mib);
+        srsran_ue_sync_free(&ue_sync);
+        for(int j=0; j<nof_rx_ant; j++){
+            free(buffer[j]);
+        }
+    }
+
+    return srsran_dft_export_wisdom();
+}
 
 int ngscope_main(ngscope_config_t* config){
-    int nof_rf_dev;
+    int nof_rf_dev = config->nof_rf_dev;
 
-	prog_args_t prog_args[MAX_NOF_RF_DEV];
-    // default parameters
+    // one context per carrier, on the NUMA node of its threads
+    if(ngscope_carrier_list_init(nof_rf_dev)){
+        exit(-1);
+    }
+    for(int i=0; i<nof_rf_dev; i++){
+        if(ngscope_carrier_create(i, config->rf_config[i].nof_thread, config->rf_config[i].numa_node) == NULL){
+            ERROR("Error creating the context of carrier %d", i);
+            exit(-1);
+        }
+    }
+
+	prog_args_t* prog_args = (prog_args_t*)calloc(nof_rf_dev, sizeof(prog_args_t));
+    pthread_t*   task_thd  = (pthread_t*)calloc(nof_rf_dev, sizeof(pthread_t));
 
-    // Init the cell
-    for(int i=0; i<MAX_NOF_RF_DEV; i++){
+    // default parameters
+    for(int i=0; i<nof_rf_dev; i++){
     	args_default(&prog_args[i]);
-        memset(&cell_vec[i], 0, sizeof(srsran_cell_t));
     }
 
-    nof_rf_dev = config->nof_rf_dev;
-	
-	for(int i=0; i<MAX_NOF_RF_DEV; i++){
-		printf("RF-DEV:%d\n", task_scheduler_closed[i]);
-	}
+    mem_report_static();
+    ngscope_mem_report_print(stdout, "start-up");
+
+    // The hybrid search of every carrier starts from its rnti list of the config
+    for(int i=0; i<nof_rf_dev; i++){
+        ngscope_target_rnti_set(&ngscope_carrier(i)->target_rnti, config->rf_config[i].target_rnti,
+                                    config->rf_config[i].nof_target_rnti);
+    }
 
     /* Task scheduler thread */
-    pthread_t task_thd[MAX_NOF_RF_DEV];
     for(int i=0; i<nof_rf_dev; i++){
-		task_scheduler_up[i] 		= true;
-		task_scheduler_closed[i] 	= false;
+		ngscope_carrier(i)->scheduler_up 	 = true;
+		ngscope_carrier(i)->scheduler_closed = false;
 
 		prog_args[i].nof_rf_dev       = nof_rf_dev;
 		prog_args[i].log_dl           = config->dci_log_config.log_dl;
@@ -88,10 +163,14 @@ int ngscope_main(ngscope_config_t* config){
 		prog_args[i].remote_enable    = config->remote_enable;
 		prog_args[i].decode_single_ue = config->decode_single_ue;
 		prog_args[i].decode_SIB 	  = config->decode_SIB;
+		prog_args[i].adaptive_llr_gate = config->adaptive_llr_gate;
+		prog_args[i].hybrid_search    = config->hybrid_search;
+		prog_args[i].full_search_interval = config->full_search_interval;
+		prog_args[i].batch_max_sf     = config->batch_max_sf;
+		prog_args[i].batch_threshold  = config->batch_threshold;
 
         prog_args[i].rf_index      = i;
         prog_args[i].rf_freq       = config->rf_config[i].rf_freq;
-        prog_args[i].rf_freq_vec[i]= config->rf_config[i].rf_freq;
 
         prog_args[i].force_N_id_2  = config->rf_config[i].N_id_2;
         prog_args[i].nof_decoder   = config->rf_config[i].nof_thread;
@@ -100,6 +179,15 @@ int ngscope_main(ngscope_config_t* config){
         prog_args[i].rf_args    = (char*) malloc(100 * sizeof(char));
         strcpy(prog_args[i].rf_args, config->rf_config[i].rf_args);
         strcpy(prog_args[i].sib_logs, config->sib_logs_path);
+
+        // the config outlives the carriers
+        prog_args[i].ctrl_capture      = config->rf_config[i].ctrl_capture[0] ? config->rf_config[i].ctrl_capture : NULL;
+        prog_args[i].ctrl_capture_bits = config->rf_config[i].ctrl_capture_bits;
+        prog_args[i].ctrl_replay       = config->rf_config[i].ctrl_replay[0] ? config->rf_config[i].ctrl_replay : NULL;
+        prog_args[i].iq_snapshot_ms      = config->rf_config[i].iq_snapshot_ms;
+        prog_args[i].iq_snapshot_path    = config->rf_config[i].iq_snapshot_path;
+        prog_args[i].iq_snapshot_skip    = config->rf_config[i].iq_snapshot_skip;
+        prog_args[i].iq_snapshot_min_dci = config->rf_config[i].iq_snapshot_min_dci;
         pthread_create(&task_thd[i], NULL, task_scheduler_thread, (void*)( &prog_args[i] ));
     }
 
@@ -115,5 +203,12 @@ int ngscope_main(ngscope_config_t* config){
         pthread_join(task_thd[i], NULL);
     }
     pthread_join(status_thd, NULL);
+
+    for(int i=0; i<nof_rf_dev; i++){
+        free(prog_args[i].rf_args);
+    }
+    free(prog_args);
+    free(task_thd);
+    ngscope_carrier_list_free();
     return 1;
 }
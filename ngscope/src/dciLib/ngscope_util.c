@@ -228,6 +228,15 @@ int tti_difference(uint16_t a, uint16_t b){
 	int diff = abs((int) array[0] - (int)array[1]);
 	return diff;
 }
+int tti_offset(uint16_t a, uint16_t b){
+	int d = ((int)a - (int)b) % MAX_TTI;
+	if(d > MAX_TTI / 2){
+		d -= MAX_TTI;
+	}else if(d <= -MAX_TTI / 2){
+		d += MAX_TTI;
+	}
+	return d;
+}
 // tti compare
 bool tti_a_l_b(uint16_t a, uint16_t b){
 	uint16_t array[] = {a, b};
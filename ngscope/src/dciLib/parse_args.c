@@ -40,6 +40,18 @@ void args_default(prog_args_t* args)
   args->remote_enable                      = false;
   args->decode_single_ue                   = false;
   args->decode_SIB                   	   = false;
+  args->adaptive_llr_gate                  = false;
+  args->hybrid_search                      = false;
+  args->full_search_interval               = FULL_SEARCH_INTERVAL;
+  args->batch_max_sf                       = DCI_BATCH_DEFAULT_SF;
+  args->batch_threshold                    = DCI_BATCH_THRESHOLD;
+  args->ctrl_capture                       = NULL;
+  args->ctrl_capture_bits                  = 8;
+  args->ctrl_replay                        = NULL;
+  args->iq_snapshot_ms                     = 0;
+  args->iq_snapshot_path                   = (char*)"iq_snapshot";
+  args->iq_snapshot_skip                   = 0;
+  args->iq_snapshot_min_dci                = 0;
 
   args->enable_cfo_ref                     = false;
   args->estimator_alg                      = (char*)"interpolate";
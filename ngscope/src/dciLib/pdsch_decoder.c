@@ -0,0 +1,109 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "srsran/srsran.h"
+
+#include "ngscope/hdr/dciLib/pdsch_decoder.h"
+#include "ngscope/hdr/dciLib/decode_sib.h"
+#include "ngscope/hdr/dciLib/mem_report.h"
+
+static int64_t pdsch_decoder_mem(ngscope_pdsch_decoder_t* q){
+    return (int64_t)q->nof_rx_ant * q->sf_len * sizeof(cf_t) + SRSRAN_MAX_CODEWORDS * 2000 * 8;
+}
+
+int ngscope_pdsch_decoder_init(ngscope_pdsch_decoder_t* q, prog_args_t prog_args, srsran_cell_t* cell){
+    memset(q, 0, sizeof(ngscope_pdsch_decoder_t));
+    q->nof_rx_ant   = prog_args.rf_nof_rx_ant;
+    q->sf_len       = SRSRAN_SF_LEN_PRB(cell->nof_prb);
+
+    for(int j=0; j<q->nof_rx_ant; j++){
+        q->input[j] = srsran_vec_cf_malloc(q->sf_len);
+        if(q->input[j] == NULL){
+            ERROR("Allocating the PDSCH decoder buffer");
+            return SRSRAN_ERROR;
+        }
+    }
+    for(int i=0; i<SRSRAN_MAX_CODEWORDS; i++){
+        q->data[i] = srsran_vec_u8_malloc(2000 * 8);
+        if(q->data[i] == NULL){
+            ERROR("Allocating the PDSCH data");
+            return SRSRAN_ERROR;
+        }
+    }
+    ngscope_mem_report_add(NGSCOPE_MEM_IQ_BUFFER, pdsch_decoder_mem(q));
+
+    if (srsran_ue_dl_init(&q->ue_dl, q->input, cell->nof_prb, q->nof_rx_ant)) {
+        ERROR("Error initiating UE downlink processing module");
+        return SRSRAN_ERROR;
+    }
+    if (srsran_ue_dl_set_cell(&q->ue_dl, *cell)) {
+        ERROR("Error initiating UE downlink processing module");
+        return SRSRAN_ERROR;
+    }
+
+    // the same channel estimation as the dci decoders
+    srsran_chest_dl_cfg_t chest_pdsch_cfg = {};
+    chest_pdsch_cfg.cfo_estimate_enable   = prog_args.enable_cfo_ref;
+    chest_pdsch_cfg.cfo_estimate_sf_mask  = 1023;
+    chest_pdsch_cfg.estimator_alg         = srsran_chest_dl_str2estimator_alg(prog_args.estimator_alg);
+    chest_pdsch_cfg.sync_error_enable     = true;
+    q->ue_dl_cfg.chest_cfg                = chest_pdsch_cfg;
+
+    // SIBs are always sent with tm1
+    q->ue_dl_cfg.cfg.tm                                = (srsran_tm_t)1;
+    q->ue_dl_cfg.cfg.pdsch.use_tbs_index_alt           = false;
+    q->ue_dl_cfg.cfg.dci.multiple_csi_request_enabled  = false;
+
+    q->pdsch_cfg.meas_evm_en = true;
+    q->pdsch_cfg.rnti        = SRSRAN_SIRNTI;
+    for (uint32_t i = 0; i < SRSRAN_MAX_CODEWORDS; i++) {
+        q->pdsch_cfg.softbuffers.rx[i] = &q->softbuffers[i];
+        srsran_softbuffer_rx_init(q->pdsch_cfg.softbuffers.rx[i], cell->nof_prb);
+    }
+
+    return SRSRAN_SUCCESS;
+}
+
+void ngscope_pdsch_decoder_free(ngscope_pdsch_decoder_t* q){
+    srsran_ue_dl_free(&q->ue_dl);
+    for (uint32_t i = 0; i < SRSRAN_MAX_CODEWORDS; i++) {
+        srsran_softbuffer_rx_free(&q->softbuffers[i]);
+        if(q->data[i] != NULL){
+            free(q->data[i]);
+        }
+    }
+    for(int j=0; j<q->nof_rx_ant; j++){
+        if(q->input[j] != NULL){
+            free(q->input[j]);
+        }
+    }
+    ngscope_mem_report_add(NGSCOPE_MEM_IQ_BUFFER, -pdsch_decoder_mem(q));
+    memset(q, 0, sizeof(ngscope_pdsch_decoder_t));
+}
+
+int ngscope_pdsch_decoder_decode_sib(ngscope_pdsch_decoder_t*   q,
+                                        cf_t*                   iq[SRSRAN_MAX_PORTS],
+                                        srsran_dl_sf_cfg_t*     dl_sf,
+                                        srsran_dci_dl_t*        dci,
+                                        bool                    sib1)
+{
+    bool acks[SRSRAN_MAX_CODEWORDS] = {false};
+    int ret;
+
+    for(int j=0; j<q->nof_rx_ant; j++){
+        srsran_vec_cf_copy(q->input[j], iq[j], q->sf_len);
+    }
+    q->dl_sf = *dl_sf;
+
+    // the PDSCH position depends on the CFI, so we estimate the subframe again
+    srsran_ue_dl_set_mi_auto(&q->ue_dl);
+    ret = srsran_ue_dl_decode_fft_estimate(&q->ue_dl, &q->dl_sf, &q->ue_dl_cfg);
+    if(ret >= 0){
+        ret = srsran_ue_dl_decode_sib_pdsch(&q->ue_dl, &q->dl_sf, &q->ue_dl_cfg, &q->pdsch_cfg, dci, q->data, acks, sib1);
+    }
+
+    return ret;
+}
@@ -15,8 +15,6 @@
 #include "ngscope/hdr/dciLib/phich_decoder.h"
 
 
-extern pthread_mutex_t     ack_mutex;
-
 // Computes SF->TTI at which PHICH will be received according to TS 36.213 Table 9.1.2-1.
 // TS 36.213 Table 9.1.2-1.
 const static uint32_t k_phich[7][10] = {{0, 0, 4, 7, 6, 0, 0, 4, 7, 6},
@@ -54,88 +52,71 @@ uint32_t get_phich_tti_tdd(uint32_t tti, uint32_t sf_config) {
   return tti_res;
 }
 
-void init_pending_ack(pend_ack_list* ack_list){
-    for(int i=0; i< TTIMOD_SZ;i++){
-        ack_list->pending_ack[i].enabled  = false;
-        ack_list->pending_ack[i].I_lowest = 0;
-        ack_list->pending_ack[i].n_dmrs   = 0;
-    }
-}
-
-void phich_reset_pending_ack(pend_ack_list* ack_list, uint32_t tti) {
-  ack_list->pending_ack[TTIMOD(tti)].enabled = false;
+uint32_t phich_get_ack_tti(srsran_cell_t* cell, uint32_t sf_config, uint32_t tti){
+  if(cell->frame_type == SRSRAN_TDD){
+    return get_phich_tti_tdd(tti, sf_config);
+  }
+  return TTI_RX_ACK(tti);
 }
 
-void phich_set_pending_ack(pend_ack_list* ack_list, uint32_t tti, uint32_t I_lowest, uint32_t n_dmrs) {
-  ack_list->pending_ack[TTIMOD(tti)].enabled  = true;
-  ack_list->pending_ack[TTIMOD(tti)].I_lowest = I_lowest;
-  ack_list->pending_ack[TTIMOD(tti)].n_dmrs = n_dmrs;
+void phich_state_init(ngscope_phich_state_t* q){
+  for(int i=0; i<PHICH_NOF_SLOTS; i++){
+    __atomic_store_n(&q->slot[i].seq, 0, __ATOMIC_RELEASE);
+    q->slot[i].nof_ack = 0;
+  }
 }
 
-bool phich_get_pending_ack(pend_ack_list* ack_list, uint32_t tti, uint32_t *I_lowest, uint32_t *n_dmrs) {
-  if (I_lowest) {
-    *I_lowest = ack_list->pending_ack[TTIMOD(tti)].I_lowest;
+void phich_set_pending_ack(ngscope_phich_state_t* q, uint32_t tti, const pending_ack_element* ack, int nof_ack){
+  phich_slot_t* slot = &q->slot[PHICH_SLOT(tti)];
+  if(nof_ack > PHICH_MAX_ACK){
+    nof_ack = PHICH_MAX_ACK;
   }
-  if (n_dmrs) {
-    *n_dmrs = ack_list->pending_ack[TTIMOD(tti)].n_dmrs;
+  // a reader that started before sees seq change and drops what it copied
+  __atomic_store_n(&slot->seq, 0, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  slot->nof_ack = nof_ack;
+  if(nof_ack > 0){
+    memcpy(slot->ack, ack, nof_ack * sizeof(pending_ack_element));
   }
-  return ack_list->pending_ack[TTIMOD(tti)].enabled;
+  __atomic_store_n(&slot->seq, tti + 1, __ATOMIC_RELEASE);
 }
 
+int phich_get_pending_ack(ngscope_phich_state_t* q, uint32_t tti, pending_ack_element ack[PHICH_MAX_ACK]){
+  phich_slot_t* slot = &q->slot[PHICH_SLOT(tti)];
+  if(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != tti + 1){
+    return 0;
+  }
+  int nof_ack = slot->nof_ack;
+  if(nof_ack <= 0){
+    return 0;
+  }
+  if(nof_ack > PHICH_MAX_ACK){
+    nof_ack = PHICH_MAX_ACK;
+  }
+  memcpy(ack, slot->ack, nof_ack * sizeof(pending_ack_element));
 
-bool phich_is_ack_enabled(pend_ack_list* ack_list, uint32_t tti) {
-  return phich_get_pending_ack(ack_list, tti, NULL, NULL);
-}
-
-bool phich_is_any_pending_ack(pend_ack_list* ack_list) {
-  for (int i=0;i<TTIMOD_SZ;i++) {
-    if (ack_list->pending_ack[i].enabled) {
-      return true;
-    }
+  // the writer has moved on to a later subframe while we were copying
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  if(__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != tti + 1){
+    return 0;
   }
-  return false;
+  return nof_ack;
 }
 
 bool decode_phich(srsran_ue_dl_t* ue_dl,
                   srsran_dl_sf_cfg_t* sf_cfg_dl,
                   srsran_ue_dl_cfg_t* ue_dl_cfg,
-                  srsran_cell_t* cell,
-                  pend_ack_list* ack_list,
+                  const pending_ack_element* ack,
                   srsran_phich_res_t* phich_res)
 {
-    uint32_t I_lowest, n_dmrs;
     srsran_phich_grant_t phich_grant = {};
 
-    if (phich_get_pending_ack(ack_list, sf_cfg_dl->tti, &I_lowest, &n_dmrs)) {
-        phich_grant.n_prb_lowest    = I_lowest;
-        phich_grant.n_dmrs          = n_dmrs;
-        phich_grant.I_phich         = 0;
-        if (srsran_ue_dl_decode_phich(ue_dl, sf_cfg_dl, ue_dl_cfg, &phich_grant, phich_res)!=0) {
-            perror("Error decoding PHICH");
-            phich_reset_pending_ack(ack_list, sf_cfg_dl->tti);
-            return false;
-        }
-
-        // If a NACK is received, set a new PHICH for later tti.
-        if (phich_res->ack_value==0) {
-            // printf("PHICH: NACK, Set New PHICH\n");
-            uint32_t tti = sf_cfg_dl->tti;
-            uint32_t tti_phich = 0;
-
-            if(cell->frame_type == SRSRAN_FDD){
-              tti_phich = TTI_RX_ACK(tti);
-            } else if(cell->frame_type == SRSRAN_TDD){
-              tti_phich = get_phich_tti_tdd(tti, sf_cfg_dl->tdd_config.sf_config);
-            }
-
-            pthread_mutex_lock(&ack_mutex);
-            phich_set_pending_ack(ack_list, tti_phich, I_lowest, n_dmrs);
-            pthread_mutex_unlock(&ack_mutex);
-        }
-        
-        // Reset PHICH for current tti.
-        phich_reset_pending_ack(ack_list, sf_cfg_dl->tti);
-    }else{
+    phich_grant.n_prb_lowest    = ack->I_lowest;
+    phich_grant.n_dmrs          = ack->n_dmrs;
+    phich_grant.I_phich         = 0;
+    if (srsran_ue_dl_decode_phich(ue_dl, sf_cfg_dl, ue_dl_cfg, &phich_grant, phich_res)!=0) {
+        perror("Error decoding PHICH");
         return false;
     }
     return true;
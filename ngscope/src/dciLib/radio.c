@@ -22,6 +22,37 @@
 
 extern bool go_exit;
 
+/* One cell search (PSS/SSS and MIB) on the tuned frequency. On success the
+ * sampling rate is set back to the one of the cell. The rx stream is left stopped.
+ * Returns 1 if the cell is found, 0 if not and -1 on error */
+int radio_search_cell(srsran_rf_t* rf, 
+                    srsran_cell_t* cell, 
+                    prog_args_t prog_args, 
+                    cell_search_cfg_t* cell_detect_config, 
+                    float* search_cell_cfo){
+    int ret = rf_search_and_decode_mib(
+        rf, prog_args.rf_nof_rx_ant, cell_detect_config, prog_args.force_N_id_2, cell, search_cell_cfo);
+    if (ret <= 0) {
+      return ret;
+    }
+
+    /* set sampling frequency */
+    int srate = srsran_sampling_freq_hz(cell->nof_prb);
+    if (srate != -1) {
+      printf("Setting sampling rate %.2f MHz\n", (float)srate / 1000000);
+      float srate_rf = srsran_rf_set_rx_srate(rf, (double)srate);
+      printf("srate_rf:%f\n",srate_rf);
+      if (srate_rf != srate) {
+        ERROR("Could not set sampling rate");
+        return SRSRAN_ERROR;
+      }
+    } else {
+      ERROR("Invalid number of PRB %d", cell->nof_prb);
+      return SRSRAN_ERROR;
+    }
+    return 1;
+}
+
 int radio_init_and_start(srsran_rf_t* rf, 
                     srsran_cell_t* cell, 
                     prog_args_t prog_args, 
@@ -49,12 +80,14 @@ int radio_init_and_start(srsran_rf_t* rf,
 
     /* set receiver frequency */
     printf("Tunning receiver to %.3f MHz\n", (prog_args.rf_freq + prog_args.file_offset_freq) / 1000000);
-    srsran_rf_set_rx_freq(rf, prog_args.rf_nof_rx_ant, prog_args.rf_freq + prog_args.file_offset_freq);
+    if (srsran_rf_set_rx_freq(rf, prog_args.rf_nof_rx_ant, prog_args.rf_freq + prog_args.file_offset_freq) < 0) {
+      ERROR("Error tuning the receiver");
+      exit(-1);
+    }
 
     uint32_t ntrial = 0;
     do {
-      ret = rf_search_and_decode_mib(
-          rf, prog_args.rf_nof_rx_ant, cell_detect_config, prog_args.force_N_id_2, cell, search_cell_cfo);
+      ret = radio_search_cell(rf, cell, prog_args, cell_detect_config, search_cell_cfo);
       if (ret < 0) {
         ERROR("Error searching for cell");
         exit(-1);
@@ -68,20 +101,6 @@ int radio_init_and_start(srsran_rf_t* rf,
       exit(0);
     }
 
-    /* set sampling frequency */
-    int srate = srsran_sampling_freq_hz(cell->nof_prb);
-    if (srate != -1) {
-      printf("Setting sampling rate %.2f MHz\n", (float)srate / 1000000);
-      float srate_rf = srsran_rf_set_rx_srate(rf, (double)srate);
-      printf("srate_rf:%f\n",srate_rf);
-      if (srate_rf != srate) {
-        ERROR("Could not set sampling rate");
-        exit(-1);
-      }
-    } else {
-       ERROR("Invalid number of PRB %d", cell->nof_prb);
-      exit(-1);
-    }
     // start rx stream
     srsran_rf_start_rx_stream(rf, false);
     return SRSRAN_SUCCESS;
@@ -0,0 +1,52 @@
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <stdint.h>
+
+#include "ngscope/hdr/dciLib/rf_clock.h"
+
+void rf_clock_init(ngscope_rf_clock_t* q){
+    __atomic_store_n(&q->offset_us, 0, __ATOMIC_RELEASE);
+    q->win_min_us   = INT64_MAX;
+    q->win_cnt      = 0;
+    q->nof_recv     = 0;
+}
+
+void rf_clock_update(ngscope_rf_clock_t* q, srsran_timestamp_t* end, int64_t now_us){
+    // radios without a time source return zero
+    if(end == NULL || srsran_timestamp_iszero(end)){
+        return;
+    }
+    int64_t offset_us = now_us - (int64_t)srsran_timestamp_uint64(end, 1e6);
+    if(offset_us < q->win_min_us){
+        q->win_min_us = offset_us;
+    }
+    q->nof_recv++;
+    q->win_cnt++;
+
+    // during the first window the running minimum is better than nothing
+    if(q->nof_recv <= RF_CLOCK_WINDOW || q->win_cnt == RF_CLOCK_WINDOW){
+        __atomic_store_n(&q->offset_us, q->win_min_us, __ATOMIC_RELEASE);
+    }
+    if(q->win_cnt == RF_CLOCK_WINDOW){
+        q->win_cnt    = 0;
+        q->win_min_us = INT64_MAX;
+    }
+    return;
+}
+
+int64_t rf_clock_to_wall_us(ngscope_rf_clock_t* q, srsran_timestamp_t* t){
+    int64_t offset_us = __atomic_load_n(&q->offset_us, __ATOMIC_ACQUIRE);
+    if(offset_us == 0 || srsran_timestamp_iszero(t)){
+        return 0;
+    }
+    return (int64_t)srsran_timestamp_uint64(t, 1e6) + offset_us;
+}
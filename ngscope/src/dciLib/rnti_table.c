@@ -0,0 +1,134 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ngscope/hdr/dciLib/rnti_table.h"
+
+// fibonacci hashing, the rnti are often allocated in sequence
+static uint32_t home_slot(ngscope_rnti_table_t* q, uint16_t rnti){
+	uint32_t bits = __builtin_ctz(q->size);
+	return (uint32_t)(((uint32_t)rnti * 2654435769u) >> (32 - bits));
+}
+
+static int alloc_slots(ngscope_rnti_table_t* q, uint32_t size){
+	ngscope_rnti_entry_t* entry = (ngscope_rnti_entry_t*)calloc(size, sizeof(ngscope_rnti_entry_t));
+	if(entry == NULL){
+		printf("rnti table: failed to allocate %d slots\n", size);
+		return -1;
+	}
+	ngscope_rnti_entry_t* old_entry = q->entry;
+	uint32_t old_size = q->size;
+
+	q->entry 		= entry;
+	q->size 		= size;
+	q->nof_entry 	= 0;
+
+	// move the old entries into the new slots
+	for(uint32_t i=0; i<old_size; i++){
+		if(old_entry[i].used){
+			uint32_t mask = q->size - 1;
+			uint32_t idx  = home_slot(q, old_entry[i].rnti);
+			while(q->entry[idx].used){
+				idx = (idx + 1) & mask;
+			}
+			q->entry[idx] = old_entry[i];
+			q->nof_entry++;
+		}
+	}
+	if(old_entry != NULL){
+		free(old_entry);
+	}
+	ngscope_mem_report_add(q->subsys, ((int64_t)size - old_size) * sizeof(ngscope_rnti_entry_t));
+	return 0;
+}
+
+void ngscope_rnti_table_init(ngscope_rnti_table_t* q, ngscope_mem_subsys_t subsys){
+	q->entry 		= NULL;
+	q->size 		= 0;
+	q->nof_entry 	= 0;
+	q->subsys 		= subsys;
+}
+
+void ngscope_rnti_table_free(ngscope_rnti_table_t* q){
+	if(q->entry != NULL){
+		free(q->entry);
+		ngscope_mem_report_add(q->subsys, -(int64_t)q->size * sizeof(ngscope_rnti_entry_t));
+	}
+	q->entry 		= NULL;
+	q->size 		= 0;
+	q->nof_entry 	= 0;
+}
+
+ngscope_rnti_entry_t* ngscope_rnti_table_find(ngscope_rnti_table_t* q, uint16_t rnti){
+	if(q->entry == NULL){
+		return NULL;
+	}
+	uint32_t mask = q->size - 1;
+	uint32_t idx  = home_slot(q, rnti);
+	while(q->entry[idx].used){
+		if(q->entry[idx].rnti == rnti){
+			return &q->entry[idx];
+		}
+		idx = (idx + 1) & mask;
+	}
+	return NULL;
+}
+
+ngscope_rnti_entry_t* ngscope_rnti_table_insert(ngscope_rnti_table_t* q, uint16_t rnti){
+	ngscope_rnti_entry_t* entry = ngscope_rnti_table_find(q, rnti);
+	if(entry != NULL){
+		return entry;
+	}
+	// keep the load factor below 3/4 so that the probing stays short
+	if(q->entry == NULL){
+		if(alloc_slots(q, RNTI_TABLE_INIT_SIZE) < 0){
+			return NULL;
+		}
+	}else if((q->nof_entry + 1) * 4 > q->size * 3){
+		if(alloc_slots(q, q->size * 2) < 0){
+			return NULL;
+		}
+	}
+	uint32_t mask = q->size - 1;
+	uint32_t idx  = home_slot(q, rnti);
+	while(q->entry[idx].used){
+		idx = (idx + 1) & mask;
+	}
+	memset(&q->entry[idx], 0, sizeof(ngscope_rnti_entry_t));
+	q->entry[idx].rnti = rnti;
+	q->entry[idx].used = true;
+	q->nof_entry++;
+	return &q->entry[idx];
+}
+
+// backward shift deletion, no tombstone is left behind
+void ngscope_rnti_table_remove(ngscope_rnti_table_t* q, uint16_t rnti){
+	ngscope_rnti_entry_t* entry = ngscope_rnti_table_find(q, rnti);
+	if(entry == NULL){
+		return;
+	}
+	uint32_t mask = q->size - 1;
+	uint32_t hole = (uint32_t)(entry - q->entry);
+	uint32_t idx  = hole;
+	while(true){
+		idx = (idx + 1) & mask;
+		if(!q->entry[idx].used){
+			break;
+		}
+		uint32_t home = home_slot(q, q->entry[idx].rnti);
+		// the entry stays if its home slot lies cyclically inside (hole, idx]
+		bool stay = (hole <= idx) ? (hole < home && home <= idx) : (hole < home || home <= idx);
+		if(!stay){
+			q->entry[hole] = q->entry[idx];
+			hole = idx;
+		}
+	}
+	memset(&q->entry[hole], 0, sizeof(ngscope_rnti_entry_t));
+	q->nof_entry--;
+}
+
+size_t ngscope_rnti_table_mem(ngscope_rnti_table_t* q){
+	return (size_t)q->size * sizeof(ngscope_rnti_entry_t);
+}
@@ -0,0 +1,276 @@
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "ngscope/hdr/dciLib/rx_ring.h"
+#include "ngscope/hdr/dciLib/time_stamp.h"
+
+extern bool go_exit;
+
+// How long the consumer blocks before it re-checks the exit flags
+#define RX_RING_WAIT_TIMEOUT_MS 100
+// At most one report of the dropped slots per interval
+#define RX_RING_REPORT_MS 1000
+// Receive errors: wait between two attempts (doubled up to the max), give up after that many in a row
+#define RX_RING_ERROR_BACKOFF_MS 1
+#define RX_RING_ERROR_BACKOFF_MAX_MS 100
+#define RX_RING_MAX_RECV_ERROR 30
+
+int rx_ring_init(ngscope_rx_ring_t* q, srsran_rf_t* rf, int rf_idx, uint32_t nof_rx_ant, uint32_t nof_prb){
+    memset(q, 0, sizeof(ngscope_rx_ring_t));
+
+    q->rf           = rf;
+    q->rf_idx       = rf_idx;
+    q->nof_rx_ant   = nof_rx_ant;
+    q->slot_len     = SRSRAN_SF_LEN_PRB(nof_prb);
+    q->srate        = (double)srsran_sampling_freq_hz(nof_prb);
+
+    if(q->srate <= 0){
+        ERROR("Invalid sampling rate for %d PRB", nof_prb);
+        return SRSRAN_ERROR;
+    }
+
+    for(int i=0; i<RX_RING_NOF_SLOTS + 1; i++){
+        for(int p=0; p<nof_rx_ant; p++){
+            q->slot[i].IQ_buffer[p] = srsran_vec_cf_malloc(q->slot_len);
+            if(q->slot[i].IQ_buffer[p] == NULL){
+                ERROR("Error allocating rx ring buffer");
+                return SRSRAN_ERROR;
+            }
+        }
+    }
+
+    if(sem_init(&q->nof_filled, 0, 0) != 0){
+        ERROR("Error initializing rx ring semaphore");
+        return SRSRAN_ERROR;
+    }
+
+    rf_clock_init(&q->clock);
+
+    // report roughly once per second
+    stage_slack_init(&q->slack, "RX", rf_idx, 1000);
+    return SRSRAN_SUCCESS;
+}
+
+void rx_ring_free(ngscope_rx_ring_t* q){
+    for(int i=0; i<RX_RING_NOF_SLOTS + 1; i++){
+        for(int p=0; p<q->nof_rx_ant; p++){
+            if(q->slot[i].IQ_buffer[p] != NULL){
+                free(q->slot[i].IQ_buffer[p]);
+                q->slot[i].IQ_buffer[p] = NULL;
+            }
+        }
+    }
+    sem_destroy(&q->nof_filled);
+    return;
+}
+
+bool rx_ring_failed(ngscope_rx_ring_t* q){
+    return __atomic_load_n(&q->failed, __ATOMIC_ACQUIRE);
+}
+
+uint32_t rx_ring_len(ngscope_rx_ring_t* q){
+    uint32_t header = __atomic_load_n(&q->header, __ATOMIC_ACQUIRE);
+    uint32_t tail   = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+    return header - tail;
+}
+
+/* The RX stage: keep the radio drained and hand 1 ms slots to the sync stage.
+ * The slack of this stage is the free space left in the ring. */
+static void* rx_ring_thread(void* p){
+    ngscope_rx_ring_t* q = (ngscope_rx_ring_t*)p;
+    int64_t slot_us = (int64_t)(1e6 * q->slot_len / q->srate);
+
+    while(!go_exit && __atomic_load_n(&q->running, __ATOMIC_ACQUIRE)){
+        uint32_t header = q->header;
+        uint32_t len    = header - __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+        bool     full   = (len >= RX_RING_NOF_SLOTS);
+
+        // If the sync stage is too slow we still have to drain the radio,
+        // so the samples go to the spare slot and get dropped
+        rx_ring_slot_t* slot = full ? &q->slot[RX_RING_NOF_SLOTS] : &q->slot[header % RX_RING_NOF_SLOTS];
+
+        void* ptr[SRSRAN_MAX_PORTS] = {NULL};
+        for(int i=0; i<q->nof_rx_ant; i++){
+            ptr[i] = slot->IQ_buffer[i];
+        }
+        int n = srsran_rf_recv_with_time_multi(q->rf, ptr, q->slot_len, true,
+                                    &slot->timestamp.full_secs, &slot->timestamp.frac_secs);
+        int64_t now_us = timestamp_us();
+        if(n < 0){
+            // a dead or unplugged radio fails right away, do not spin on it
+            q->nof_recv_error++;
+            if(q->nof_recv_error == 1){
+                ERROR("RF:%d error receiving samples", q->rf_idx);
+            }
+            if(q->nof_recv_error >= RX_RING_MAX_RECV_ERROR){
+                ERROR("RF:%d %d receive errors in a row, stopping the rx ring", q->rf_idx, q->nof_recv_error);
+                __atomic_store_n(&q->failed, true, __ATOMIC_RELEASE);
+                break;
+            }
+            uint32_t shift = SRSRAN_MIN(q->nof_recv_error - 1, 7);
+            usleep(1000 * SRSRAN_MIN(RX_RING_ERROR_BACKOFF_MS << shift, RX_RING_ERROR_BACKOFF_MAX_MS));
+            continue;
+        }
+        if(q->nof_recv_error > 0){
+            printf("RF:%d receiving samples again after %d errors\n", q->rf_idx, q->nof_recv_error);
+            q->nof_recv_error = 0;
+        }
+        if(!srsran_timestamp_iszero(&slot->timestamp)){
+            srsran_timestamp_t end = slot->timestamp;
+            srsran_timestamp_add(&end, 0, q->slot_len / q->srate);
+            rf_clock_update(&q->clock, &end, now_us);
+        }
+
+        if(full){
+            // no printing here, the consumer reports the drops
+            __atomic_add_fetch(&q->nof_overflow, 1, __ATOMIC_RELAXED);
+            stage_slack_update(&q->slack, -slot_us);
+        }else{
+            __atomic_store_n(&q->header, header + 1, __ATOMIC_RELEASE);
+            sem_post(&q->nof_filled);
+            stage_slack_update(&q->slack, (RX_RING_NOF_SLOTS - len - 1) * slot_us);
+        }
+    }
+
+    // wake up the consumer in case it is blocked on an empty ring
+    sem_post(&q->nof_filled);
+    printf("RF:%d rx ring thread CLOSED!\n", q->rf_idx);
+    return NULL;
+}
+
+int rx_ring_start(ngscope_rx_ring_t* q){
+    q->nof_recv_error = 0;
+    __atomic_store_n(&q->failed, false, __ATOMIC_RELEASE);
+    __atomic_store_n(&q->running, true, __ATOMIC_RELEASE);
+    if(pthread_create(&q->rx_thd, NULL, rx_ring_thread, (void*)q) != 0){
+        ERROR("Error creating rx ring thread");
+        q->running = false;
+        return SRSRAN_ERROR;
+    }
+    return SRSRAN_SUCCESS;
+}
+
+void rx_ring_stop(ngscope_rx_ring_t* q){
+    if(__atomic_exchange_n(&q->running, false, __ATOMIC_ACQ_REL)){
+        pthread_join(q->rx_thd, NULL);
+    }
+    return;
+}
+
+/* Drop the buffered slots, e.g. after a re-tune. The RX thread must be stopped */
+void rx_ring_flush(ngscope_rx_ring_t* q){
+    while(sem_trywait(&q->nof_filled) == 0){
+    }
+    q->header       = 0;
+    q->tail         = 0;
+    q->read_offset  = 0;
+    // the RF time may restart with the stream
+    rf_clock_init(&q->clock);
+    return;
+}
+
+void rx_ring_skipped_sf(ngscope_rx_ring_t* q, uint32_t buf_len){
+    q->nof_skipped++;
+    q->skipped_buf_len = buf_len;
+}
+
+/* Report the slots the RX thread dropped and the subframes no decoder took, from the consumer side
+ * and at most once per RX_RING_REPORT_MS */
+static void rx_ring_report_overflow(ngscope_rx_ring_t* q){
+    uint64_t nof_overflow = __atomic_load_n(&q->nof_overflow, __ATOMIC_RELAXED);
+    if(nof_overflow == q->nof_overflow_reported && q->nof_skipped == q->nof_skipped_reported){
+        return;
+    }
+    int64_t now_us = timestamp_us();
+    if(now_us - q->t_overflow_report_us < RX_RING_REPORT_MS * 1000){
+        return;
+    }
+    if(nof_overflow != q->nof_overflow_reported){
+        printf("RF:%d rx ring full, dropped %ld slots of %d samples (overflow:%ld)\n", q->rf_idx,
+                    nof_overflow - q->nof_overflow_reported, q->slot_len, nof_overflow);
+    }
+    if(q->nof_skipped != q->nof_skipped_reported){
+        printf("RF:%d decoders busy, skipped %ld subframes (total:%ld) ring buf len:%d\n", q->rf_idx,
+                    q->nof_skipped - q->nof_skipped_reported, q->nof_skipped, q->skipped_buf_len);
+    }
+    q->nof_overflow_reported = nof_overflow;
+    q->nof_skipped_reported  = q->nof_skipped;
+    q->t_overflow_report_us  = now_us;
+}
+
+/* Block until the RX thread has filled the next slot */
+static int rx_ring_wait(ngscope_rx_ring_t* q){
+    int64_t t1 = timestamp_us();
+    struct timespec ts;
+
+    while(true){
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += RX_RING_WAIT_TIMEOUT_MS * 1000000L;
+        if(ts.tv_nsec >= 1000000000L){
+            ts.tv_sec  += 1;
+            ts.tv_nsec -= 1000000000L;
+        }
+        if(go_exit || !__atomic_load_n(&q->running, __ATOMIC_ACQUIRE) || rx_ring_failed(q)){
+            return SRSRAN_ERROR;
+        }
+        if(sem_timedwait(&q->nof_filled, &ts) == 0){
+            // the exit wake-up does not carry any samples
+            if(rx_ring_len(q) == 0){
+                return SRSRAN_ERROR;
+            }
+            break;
+        }
+    }
+    q->wait_us += timestamp_us() - t1;
+    return SRSRAN_SUCCESS;
+}
+
+int rx_ring_recv_wrapper(void* h, cf_t* data[SRSRAN_MAX_PORTS], uint32_t nsamples, srsran_timestamp_t* t)
+{
+    ngscope_rx_ring_t* q = (ngscope_rx_ring_t*)h;
+    uint32_t nof_copied = 0;
+
+    DEBUG(" ----  Receive %d samples from rx ring ----", nsamples);
+    while(nof_copied < nsamples){
+        if(q->read_offset == 0){
+            if(rx_ring_wait(q) < 0){
+                return SRSRAN_ERROR;
+            }
+        }
+        rx_ring_slot_t* slot = &q->slot[q->tail % RX_RING_NOF_SLOTS];
+
+        // the timestamp refers to the first sample we hand out
+        if(nof_copied == 0 && t != NULL){
+            srsran_timestamp_copy(t, &slot->timestamp);
+            srsran_timestamp_add(t, 0, q->read_offset / q->srate);
+        }
+
+        uint32_t n = SRSRAN_MIN(nsamples - nof_copied, q->slot_len - q->read_offset);
+        for(int p=0; p<q->nof_rx_ant; p++){
+            if(data[p] != NULL){
+                memcpy(&data[p][nof_copied], &slot->IQ_buffer[p][q->read_offset], n * sizeof(cf_t));
+            }
+        }
+        nof_copied     += n;
+        q->read_offset += n;
+
+        // give the slot back to the RX thread
+        if(q->read_offset == q->slot_len){
+            q->read_offset = 0;
+            __atomic_store_n(&q->tail, q->tail + 1, __ATOMIC_RELEASE);
+            rx_ring_report_overflow(q);
+        }
+    }
+    return nof_copied;
+}
@@ -0,0 +1,313 @@
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "srsran/srsran.h"
+
+#include "ngscope/hdr/dciLib/sib_worker.h"
+#include "ngscope/hdr/dciLib/mem_report.h"
+
+#define FNV_OFFSET 	14695981039346656037ull
+#define FNV_PRIME 	1099511628211ull
+
+static uint64_t fnv1a(uint64_t hash, const void* data, size_t len){
+	const uint8_t* p = (const uint8_t*)data;
+	for(size_t i=0; i<len; i++){
+		hash ^= p[i];
+		hash *= FNV_PRIME;
+	}
+	return hash;
+}
+
+// the grant of a SIB, without the redundancy version which changes every transmission
+static uint64_t sib_dci_hash(srsran_dci_dl_t* dci, uint32_t sf_idx){
+	size_t alloc_len = SRSRAN_MAX(sizeof(dci->type0_alloc), SRSRAN_MAX(sizeof(dci->type1_alloc), sizeof(dci->type2_alloc)));
+	uint64_t hash = FNV_OFFSET;
+	hash = fnv1a(hash, &sf_idx, sizeof(uint32_t));
+	hash = fnv1a(hash, &dci->format, sizeof(dci->format));
+	hash = fnv1a(hash, &dci->alloc_type, sizeof(dci->alloc_type));
+	hash = fnv1a(hash, &dci->type0_alloc, alloc_len);
+	hash = fnv1a(hash, &dci->tb[0].mcs_idx, sizeof(dci->tb[0].mcs_idx));
+	return hash;
+}
+
+static int64_t sib_worker_mem(ngscope_sib_worker_t* q){
+	return (int64_t)SIB_QUEUE_SIZE * q->nof_rx_ant * q->sf_len * sizeof(cf_t);
+}
+
+/********************** publishing to the decoders **********************/
+static void sib_worker_publish(ngscope_sib_worker_t* q, ngscope_si_params_t* params){
+	pthread_mutex_lock(&q->params_mutex);
+	q->params = *params;
+	// the decoders see the new seq once the params are in place
+	__atomic_add_fetch(&q->params_seq, 1, __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&q->params_mutex);
+}
+
+uint32_t ngscope_sib_worker_params_seq(ngscope_sib_worker_t* q){
+	return __atomic_load_n(&q->params_seq, __ATOMIC_ACQUIRE);
+}
+
+uint32_t ngscope_sib_worker_get_params(ngscope_sib_worker_t* q, ngscope_si_params_t* params){
+	pthread_mutex_lock(&q->params_mutex);
+	*params 	 = q->params;
+	uint32_t seq = __atomic_load_n(&q->params_seq, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&q->params_mutex);
+	return seq;
+}
+
+static void sib_worker_add_skip(ngscope_sib_worker_t* q, uint64_t dci_hash){
+	uint32_t n = q->nof_skip;
+	if(n >= SIB_MAX_KNOWN){
+		return;
+	}
+	__atomic_store_n(&q->skip_hash[n], dci_hash, __ATOMIC_RELAXED);
+	__atomic_store_n(&q->nof_skip, n + 1, __ATOMIC_RELEASE);
+}
+
+// the SI changed (new systemInfoValueTag), forget what we know about the SI messages
+static void sib_worker_reset_known(ngscope_sib_worker_t* q){
+	__atomic_store_n(&q->nof_skip, 0, __ATOMIC_RELEASE);
+	q->nof_known = 0;
+}
+
+/********************** decoder side **********************/
+bool ngscope_sib_worker_need_decode(ngscope_sib_worker_t* q, uint32_t tti, bool sib1, srsran_dci_dl_t* dci){
+	if(sib1){
+		int32_t last = __atomic_load_n(&q->last_sib1_tti, __ATOMIC_ACQUIRE);
+		if(last < 0){
+			return true;
+		}
+		return (tti + 10240 - last) % 10240 >= SIB1_CHECK_PERIOD;
+	}
+	uint64_t dci_hash = sib_dci_hash(dci, tti % 10);
+	uint32_t n = __atomic_load_n(&q->nof_skip, __ATOMIC_ACQUIRE);
+	for(uint32_t i=0; i<n; i++){
+		if(__atomic_load_n(&q->skip_hash[i], __ATOMIC_RELAXED) == dci_hash){
+			return false;
+		}
+	}
+	return true;
+}
+
+int ngscope_sib_worker_push(ngscope_sib_worker_t*   q,
+                            cf_t*                   iq[SRSRAN_MAX_PORTS],
+                            srsran_dl_sf_cfg_t*     dl_sf,
+                            srsran_dci_dl_t*        dci,
+                            bool                    sib1)
+{
+	ngscope_sib_job_t* job;
+	uint32_t pos = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+
+	// claim a slot, the slot is free once its ticket equals our position
+	while(true){
+		job = &q->job[pos & (SIB_QUEUE_SIZE - 1)];
+		uint32_t seq = __atomic_load_n(&job->seq, __ATOMIC_ACQUIRE);
+		int32_t diff = (int32_t)(seq - pos);
+		if(diff == 0){
+			if(__atomic_compare_exchange_n(&q->head, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)){
+				break;
+			}
+		}else if(diff < 0){
+			// the worker is behind, the SIB is broadcast again anyway
+			__atomic_add_fetch(&q->nof_drop, 1, __ATOMIC_RELAXED);
+			return -1;
+		}else{
+			pos = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+		}
+	}
+
+	for(int j=0; j<q->nof_rx_ant; j++){
+		srsran_vec_cf_copy(job->IQ_buffer[j], iq[j], q->sf_len);
+	}
+	job->dl_sf 	= *dl_sf;
+	job->dci 	= *dci;
+	job->sib1 	= sib1;
+	__atomic_store_n(&job->seq, pos + 1, __ATOMIC_RELEASE);
+	__atomic_add_fetch(&q->nof_push, 1, __ATOMIC_RELAXED);
+
+	sem_post(&q->job_sem);
+	return 0;
+}
+
+/********************** worker side **********************/
+static ngscope_sib_known_t* sib_worker_known(ngscope_sib_worker_t* q, uint64_t dci_hash){
+	for(uint32_t i=0; i<q->nof_known; i++){
+		if(q->known[i].dci_hash == dci_hash){
+			return &q->known[i];
+		}
+	}
+	if(q->nof_known >= SIB_MAX_KNOWN){
+		return NULL;
+	}
+	ngscope_sib_known_t* k = &q->known[q->nof_known++];
+	memset(k, 0, sizeof(ngscope_sib_known_t));
+	k->dci_hash = dci_hash;
+	return k;
+}
+
+// true if the payload is the same as before
+static bool sib_worker_unchanged(ngscope_sib_worker_t* q, ngscope_sib_job_t* job, uint64_t payload_hash){
+	if(job->sib1){
+		bool same = (payload_hash == q->sib1_hash);
+		q->sib1_hash = payload_hash;
+		return same;
+	}
+
+	bool seen = false;
+	for(uint32_t i=0; i<q->nof_known; i++){
+		if(q->known[i].hits > 0 && q->known[i].payload_hash == payload_hash){
+			seen = true;
+			break;
+		}
+	}
+
+	// the decoders skip the grants that carried the same payload twice
+	ngscope_sib_known_t* k = sib_worker_known(q, sib_dci_hash(&job->dci, job->dl_sf.tti % 10));
+	if(k != NULL){
+		if(k->hits == 0){
+			k->payload_hash = payload_hash;
+			k->hits 		= 1;
+		}else if(k->payload_hash == payload_hash){
+			k->hits++;
+			if(k->hits == 2 && !k->conflict){
+				sib_worker_add_skip(q, k->dci_hash);
+			}
+		}else{
+			k->conflict 	= true;
+			k->payload_hash = payload_hash;
+		}
+	}
+	return seen;
+}
+
+static void sib_worker_process(ngscope_sib_worker_t* q, ngscope_sib_job_t* job){
+	uint32_t tti = job->dl_sf.tti;
+
+	int len = ngscope_pdsch_decoder_decode_sib(&q->pdsch_decoder, job->IQ_buffer, &job->dl_sf, &job->dci, job->sib1);
+	if(len <= 0){
+		return;
+	}
+	q->nof_decoded++;
+	if(job->sib1){
+		__atomic_store_n(&q->last_sib1_tti, (int32_t)tti, __ATOMIC_RELEASE);
+	}
+
+	uint8_t* payload = q->pdsch_decoder.data[0];
+	if(sib_worker_unchanged(q, job, fnv1a(FNV_OFFSET, payload, len))){
+		q->nof_unchanged++;
+		return;
+	}
+
+	// new system information, the worker is the only writer of the params
+	ngscope_si_params_t old_params;
+	ngscope_sib_worker_get_params(q, &old_params);
+	ngscope_si_params_t params = old_params;
+	char types[SIB_TYPES_LEN];
+	if(ngscope_sib_parse(payload, len, job->sib1, &params, types, SIB_TYPES_LEN) != SRSRAN_SUCCESS){
+		return;
+	}
+	printf("TTI:%d Successfully decoded %s!\n", tti, types[0] != '\0' ? types : "an SI message without SIB");
+
+	if(job->sib1 && old_params.value_tag >= 0 && params.value_tag != old_params.value_tag){
+		printf("TTI:%d SI value tag %d -> %d, decoding the SI messages again\n", tti, old_params.value_tag, params.value_tag);
+		sib_worker_reset_known(q);
+	}
+	sib_worker_publish(q, &params);
+
+	if(q->asn_decoder != NULL){
+		push_asn_payload(q->asn_decoder, payload, len, SIB_4G, tti);
+	}
+}
+
+static ngscope_sib_job_t* sib_worker_pop(ngscope_sib_worker_t* q){
+	ngscope_sib_job_t* job = &q->job[q->tail & (SIB_QUEUE_SIZE - 1)];
+	if(__atomic_load_n(&job->seq, __ATOMIC_ACQUIRE) != q->tail + 1){
+		return NULL;
+	}
+	return job;
+}
+
+static void sib_worker_release(ngscope_sib_worker_t* q, ngscope_sib_job_t* job){
+	__atomic_store_n(&job->seq, q->tail + SIB_QUEUE_SIZE, __ATOMIC_RELEASE);
+	q->tail++;
+}
+
+static void* sib_worker_thread(void* p){
+	ngscope_sib_worker_t* q = (ngscope_sib_worker_t*)p;
+
+	while(true){
+		// every push posts once, we sleep until there is a subframe to decode
+		sem_wait(&q->job_sem);
+		if(!__atomic_load_n(&q->running, __ATOMIC_ACQUIRE)){
+			break;
+		}
+		// drain the queue: the post may belong to a job queued behind a slot that is claimed
+		// but not published yet, the post of that slot wakes us again for both of them
+		ngscope_sib_job_t* job;
+		while((job = sib_worker_pop(q)) != NULL){
+			sib_worker_process(q, job);
+			sib_worker_release(q, job);
+		}
+	}
+	return NULL;
+}
+
+int ngscope_sib_worker_init(ngscope_sib_worker_t* q, prog_args_t prog_args, srsran_cell_t* cell, ASNDecoder* asn_decoder){
+	memset(q, 0, sizeof(ngscope_sib_worker_t));
+	q->asn_decoder 		= asn_decoder;
+	q->nof_rx_ant 		= prog_args.rf_nof_rx_ant;
+	q->sf_len 			= SRSRAN_SF_LEN_PRB(cell->nof_prb);
+	q->last_sib1_tti 	= -1;
+	q->params.value_tag = -1;
+	pthread_mutex_init(&q->params_mutex, NULL);
+
+	if(ngscope_pdsch_decoder_init(&q->pdsch_decoder, prog_args, cell)){
+		return SRSRAN_ERROR;
+	}
+
+	for(int i=0; i<SIB_QUEUE_SIZE; i++){
+		q->job[i].seq = i;
+		for(int j=0; j<q->nof_rx_ant; j++){
+			q->job[i].IQ_buffer[j] = srsran_vec_cf_malloc(q->sf_len);
+			if(q->job[i].IQ_buffer[j] == NULL){
+				ERROR("Allocating the SIB queue");
+				return SRSRAN_ERROR;
+			}
+		}
+	}
+	ngscope_mem_report_add(NGSCOPE_MEM_IQ_BUFFER, sib_worker_mem(q));
+
+	sem_init(&q->job_sem, 0, 0);
+	q->running = true;
+	if(pthread_create(&q->thd, NULL, sib_worker_thread, (void*)q)){
+		ERROR("Error creating the SIB worker");
+		return SRSRAN_ERROR;
+	}
+	return SRSRAN_SUCCESS;
+}
+
+void ngscope_sib_worker_free(ngscope_sib_worker_t* q){
+	__atomic_store_n(&q->running, false, __ATOMIC_RELEASE);
+	sem_post(&q->job_sem);
+	pthread_join(q->thd, NULL);
+	sem_destroy(&q->job_sem);
+
+	printf("SIB worker: %lu subframes pushed, %lu dropped, %lu decoded, %lu unchanged\n",
+				q->nof_push, q->nof_drop, q->nof_decoded, q->nof_unchanged);
+
+	for(int i=0; i<SIB_QUEUE_SIZE; i++){
+		for(int j=0; j<q->nof_rx_ant; j++){
+			if(q->job[i].IQ_buffer[j] != NULL){
+				free(q->job[i].IQ_buffer[j]);
+			}
+		}
+	}
+	ngscope_mem_report_add(NGSCOPE_MEM_IQ_BUFFER, -sib_worker_mem(q));
+	ngscope_pdsch_decoder_free(&q->pdsch_decoder);
+	pthread_mutex_destroy(&q->params_mutex);
+}
@@ -0,0 +1,49 @@
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <stdint.h>
+
+#include "ngscope/hdr/dciLib/stage_slack.h"
+
+static void stage_slack_reset(ngscope_stage_slack_t* q){
+    q->nof_sample   = 0;
+    q->nof_overrun  = 0;
+    q->sum_slack_us = 0;
+    q->min_slack_us = INT64_MAX;
+}
+
+void stage_slack_init(ngscope_stage_slack_t* q, const char* name, int rf_idx, uint32_t report_period){
+    strncpy(q->name, name, sizeof(q->name) - 1);
+    q->name[sizeof(q->name) - 1] = '\0';
+    q->rf_idx           = rf_idx;
+    q->report_period    = report_period;
+    stage_slack_reset(q);
+}
+
+/* Record the slack of one item (subframe, frame, ...) and print
+ * a summary every report_period items */
+void stage_slack_update(ngscope_stage_slack_t* q, int64_t slack_us){
+    q->nof_sample++;
+    q->sum_slack_us += slack_us;
+    if(slack_us < q->min_slack_us){
+        q->min_slack_us = slack_us;
+    }
+    if(slack_us < 0){
+        q->nof_overrun++;
+    }
+
+    if(q->nof_sample >= q->report_period){
+        printf("RF:%d %s slack avg:%ld min:%ld (us) overrun:%d/%d\n", q->rf_idx, q->name,
+                    q->sum_slack_us / q->nof_sample, q->min_slack_us, q->nof_overrun, q->nof_sample);
+        stage_slack_reset(q);
+    }
+    return;
+}
@@ -16,6 +16,8 @@
 #include "srsgui/srsgui.h"
 #endif
 #include "ngscope/hdr/dciLib/status_plot.h"
+#include "ngscope/hdr/dciLib/carrier.h"
+#include "ngscope/hdr/dciLib/mem_report.h"
 
 #define NOF_PLOT_SF 500
 #define MOV_AVE_LEN 5 
@@ -24,10 +26,43 @@ extern pthread_mutex_t     plot_mutex;
 extern ngscope_plot_t      plot_data;
 extern pthread_cond_t      plot_cond;
 
-extern pthread_mutex_t dci_plot_mutex;
-extern cf_t* pdcch_buf;
-extern float csi_amp[110 * 15 * 2048];
-extern pthread_cond_t 	dci_plot_cond;
+int plot_data_init(ngscope_plot_t* q, int nof_cell, uint16_t targetRNTI){
+    pthread_mutex_lock(&plot_mutex);
+    q->targetRNTI       = targetRNTI;
+    q->header           = 0;
+    q->cell_prb         = (int*)calloc(nof_cell, sizeof(int));
+    q->plot_data_cell   = (ngscope_plot_cell_t*)calloc(nof_cell, sizeof(ngscope_plot_cell_t));
+    if(q->cell_prb == NULL || q->plot_data_cell == NULL){
+        free(q->cell_prb);
+        free(q->plot_data_cell);
+        q->cell_prb         = NULL;
+        q->plot_data_cell   = NULL;
+        q->nof_cell         = 0;
+        pthread_mutex_unlock(&plot_mutex);
+        printf("plot: failed to allocate the plot data of %d cells\n", nof_cell);
+        return -1;
+    }
+    for(int i=0; i<nof_cell; i++){
+        q->cell_prb[i] = ngscope_carrier_nof_prb(i);
+    }
+    q->nof_cell = nof_cell;
+    pthread_mutex_unlock(&plot_mutex);
+    ngscope_mem_report_add(NGSCOPE_MEM_PLOT, nof_cell * (sizeof(int) + sizeof(ngscope_plot_cell_t)));
+    return 0;
+}
+
+void plot_data_free(ngscope_plot_t* q){
+    pthread_mutex_lock(&plot_mutex);
+    if(q->plot_data_cell != NULL){
+        ngscope_mem_report_add(NGSCOPE_MEM_PLOT, -(int64_t)(q->nof_cell * (sizeof(int) + sizeof(ngscope_plot_cell_t))));
+    }
+    free(q->cell_prb);
+    free(q->plot_data_cell);
+    q->cell_prb         = NULL;
+    q->plot_data_cell   = NULL;
+    q->nof_cell         = 0;
+    pthread_mutex_unlock(&plot_mutex);
+}
 //	
 //void init_plot_data(ngscope_CA_status_t* q, int nof_dev){
 //    pthread_mutex_lock(&plot_mutex);
@@ -68,6 +103,11 @@ int status_tracker_handle_plot(ngscope_status_buffer_t* dci_buffer){
 
     idx = tti % PLOT_SF;
     pthread_mutex_lock(&plot_mutex);
+    if(cell_idx >= plot_data.nof_cell){
+        // the plot data is not allocated yet
+        pthread_mutex_unlock(&plot_mutex);
+        return 0;
+    }
     max_prb = plot_data.cell_prb[cell_idx];
         
     /* Enqueue CSI */
@@ -294,8 +334,10 @@ void* plot_pdcch_run(void* arg)
 	printf("init 0!\n");
 	decoder_plot_t* q = (decoder_plot_t*)arg;
 	//int decoder_idx 		= q->decoder_idx; 
+	int rf_idx 				= q->rf_idx;
 	int nof_pdcch_sample 	= q->nof_pdcch_sample;
 	int size 				= q->size;
+	ngscope_carrier_t* carrier = ngscope_carrier(rf_idx);
 
     plot_scatter_t pdcch;
     plot_real_t csi;
@@ -317,12 +359,12 @@ void* plot_pdcch_run(void* arg)
 
 
     while(!go_exit){
-        pthread_mutex_lock(&dci_plot_mutex);    
+        pthread_mutex_lock(&carrier->plot_mutex);    
 		//printf("waiting for signal!\n");
-        pthread_cond_wait(&dci_plot_cond, &dci_plot_mutex); 
-      	plot_scatter_setNewData(&pdcch, pdcch_buf, nof_pdcch_sample);
-      	plot_real_setNewData(&csi, csi_amp, size);
-        pthread_mutex_unlock(&dci_plot_mutex);    
+        pthread_cond_wait(&carrier->plot_cond, &carrier->plot_mutex); 
+      	plot_scatter_setNewData(&pdcch, carrier->pdcch_buf, nof_pdcch_sample);
+      	plot_real_setNewData(&csi, carrier->csi_amp, size);
+        pthread_mutex_unlock(&carrier->plot_mutex);    
 	}
 #endif
 
@@ -22,6 +22,7 @@
 #include "ngscope/hdr/dciLib/sync_dci_remote.h"
 #include "ngscope/hdr/dciLib/load_config.h"
 #include "ngscope/hdr/dciLib/thread_exit.h"
+#include "ngscope/hdr/dciLib/carrier.h"
 
 #include "ngscope/hdr/dciLib/dci_sink_def.h"
 #include "ngscope/hdr/dciLib/dci_sink_serv.h"
@@ -31,10 +32,6 @@
 
 extern bool go_exit;
 
-//Waiting for the rf to be ready 
-extern pthread_mutex_t     cell_mutex;
-extern srsran_cell_t       cell_vec[MAX_NOF_RF_DEV];
-
 //  DCI-Decoder <--- DCI buffer ---> Status-Tracker
 extern dci_ready_t                  dci_ready;
 extern ngscope_status_buffer_t      dci_buffer[MAX_DCI_BUFFER];
@@ -53,34 +50,24 @@ ngscope_plot_t      plot_data;
 
 ngscope_dci_sink_serv_t dci_sink_serv;
 
-extern bool task_scheduler_closed[MAX_NOF_RF_DEV];
-
 void wait_for_radio(ngscope_status_tracker_t* q, int nof_dev){
     bool radio_ready = true;
     while(true){
         if(go_exit) break;
 
         radio_ready = true;
-        pthread_mutex_lock(&cell_mutex);
         for(int i=0; i<nof_dev; i++){
-            if(cell_vec[i].nof_prb == 0){
+            if(ngscope_carrier_nof_prb(i) == 0){
                 radio_ready = false;
                 break;
             }
         }
-        pthread_mutex_unlock(&cell_mutex);
         if(radio_ready){
             break;
         }else{
             usleep(10000);
         }
     }     
-    pthread_mutex_lock(&cell_mutex);
-    for(int i=0; i<nof_dev; i++){
-        q->cell_prb[i] = cell_vec[i].nof_prb;
-    }
-    pthread_mutex_unlock(&cell_mutex);
-
     return;
 }
 
@@ -117,16 +104,22 @@ void* status_tracker_thread(void* p){
 	log_config_t dci_log_config;
 	memcpy(&dci_log_config.config, config, sizeof(ngscope_config_t));
 
-	uint16_t cell_prb[MAX_NOF_RF_DEV];	
+	plot_data_init(&plot_data, nof_dev, targetRNTI);
+
 	cell_config_t 	cell_config;
+	memset(&cell_config, 0, sizeof(cell_config_t));
 
-	cell_config.nof_cell 	= nof_dev;
+	// the sink protocol carries at most MAX_NOF_CELL cells
+	int nof_sink_cell = nof_dev;
+	if(nof_sink_cell > MAX_NOF_CELL){
+		printf("WARNING: %d cells, only the first %d are reported to the dci sink clients\n", nof_dev, MAX_NOF_CELL);
+		nof_sink_cell = MAX_NOF_CELL;
+	}
+	cell_config.nof_cell 	= nof_sink_cell;
 	cell_config.rnti 		= targetRNTI;
 
-	for(int i=0; i<nof_dev; i++){
-		cell_prb[i] = status_tracker.cell_prb[i];
-		cell_config.cell_prb[i] = status_tracker.cell_prb[i];
-		dci_log_config.cell_prb[i] = status_tracker.cell_prb[i];
+	for(int i=0; i<nof_sink_cell; i++){
+		cell_config.cell_prb[i] = ngscope_carrier_nof_prb(i);
 	}
 
 	// remote can be any program on the same device or 
@@ -152,8 +145,10 @@ void* status_tracker_thread(void* p){
 	info.nof_cell 		= nof_dev;
 	info.remote_sock 	= status_tracker.remote_sock;
 	info.remote_enable 	= remote_enable;
+	info.reorder_latency = config->reorder_latency;
+	info.stats_window 	= config->stats_window;
+	info.stats_interval = config->stats_interval;
 
-	memcpy(info.cell_prb, status_tracker.cell_prb, nof_dev * sizeof(int));
     pthread_create(&cell_stat_thd, NULL, cell_status_thread, (void*)(&info));
 
 	/* create the dci logging thread */
@@ -258,6 +253,7 @@ void* status_tracker_thread(void* p){
     }
 
     //status_tracker_print_ue_freq(&status_tracker);
+    plot_data_free(&plot_data);
 
     printf("Status Tracker CLOSED!\n");
     return NULL;
@@ -0,0 +1,132 @@
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ngscope/hdr/dciLib/target_rnti.h"
+
+static int find_rnti(ngscope_target_rnti_t* q, uint16_t rnti){
+	for(int i=0; i<q->nof_rnti; i++){
+		if(q->rnti[i] == rnti){
+			return i;
+		}
+	}
+	return -1;
+}
+
+// the caller holds the mutex
+static bool add_rnti(ngscope_target_rnti_t* q, uint16_t rnti){
+	// 0 is not a valid rnti
+	if(rnti == 0 || find_rnti(q, rnti) >= 0){
+		return false;
+	}
+	if(q->nof_rnti >= MAX_TARGET_RNTI){
+		printf("target rnti list is full, skip rnti:%d\n", rnti);
+		return false;
+	}
+	q->rnti[q->nof_rnti++] = rnti;
+	return true;
+}
+
+// the caller holds the mutex
+static bool remove_rnti(ngscope_target_rnti_t* q, uint16_t rnti){
+	int idx = find_rnti(q, rnti);
+	if(idx < 0){
+		return false;
+	}
+	// keep the order of the list
+	for(int i=idx; i<q->nof_rnti-1; i++){
+		q->rnti[i] = q->rnti[i+1];
+	}
+	q->nof_rnti--;
+	return true;
+}
+
+void ngscope_target_rnti_set(ngscope_target_rnti_t* q, const uint16_t* rnti, int nof_rnti){
+	pthread_mutex_lock(&q->mutex);
+	q->nof_rnti = 0;
+	for(int i=0; i<nof_rnti; i++){
+		add_rnti(q, rnti[i]);
+	}
+	pthread_mutex_unlock(&q->mutex);
+	return;
+}
+
+bool ngscope_target_rnti_add(ngscope_target_rnti_t* q, uint16_t rnti){
+	pthread_mutex_lock(&q->mutex);
+	bool ret = add_rnti(q, rnti);
+	pthread_mutex_unlock(&q->mutex);
+	return ret;
+}
+
+bool ngscope_target_rnti_remove(ngscope_target_rnti_t* q, uint16_t rnti){
+	pthread_mutex_lock(&q->mutex);
+	bool ret = remove_rnti(q, rnti);
+	pthread_mutex_unlock(&q->mutex);
+	return ret;
+}
+
+int ngscope_target_rnti_get(ngscope_target_rnti_t* q, uint16_t rnti[MAX_TARGET_RNTI]){
+	pthread_mutex_lock(&q->mutex);
+	int nof_rnti = q->nof_rnti;
+	memcpy(rnti, q->rnti, nof_rnti * sizeof(uint16_t));
+	pthread_mutex_unlock(&q->mutex);
+	return nof_rnti;
+}
+
+int ngscope_target_rnti_msg_cell(const char* buf, int len){
+	if(len < 6){
+		return -1;
+	}
+	int nof_rnti = (uint8_t)buf[5];
+	// the cell index is optional, older clients edit all the cells
+	if(len < 7 + 2 * nof_rnti){
+		return 0xFF;
+	}
+	return (uint8_t)buf[6 + 2 * nof_rnti];
+}
+
+int ngscope_target_rnti_handle_msg(ngscope_target_rnti_t* q, const char* buf, int len){
+	// preamble + op + nof_rnti
+	if(len < 6){
+		return -1;
+	}
+	uint8_t op 		 = (uint8_t)buf[4];
+	int     nof_rnti = (uint8_t)buf[5];
+	if(nof_rnti > MAX_TARGET_RNTI || len < 6 + 2 * nof_rnti){
+		return -1;
+	}
+	uint16_t rnti[MAX_TARGET_RNTI];
+	memcpy(rnti, &buf[6], nof_rnti * sizeof(uint16_t));
+
+	switch(op){
+		case TARGET_RNTI_SET:
+			ngscope_target_rnti_set(q, rnti, nof_rnti);
+			break;
+		case TARGET_RNTI_ADD:
+			for(int i=0; i<nof_rnti; i++){
+				ngscope_target_rnti_add(q, rnti[i]);
+			}
+			break;
+		case TARGET_RNTI_REMOVE:
+			for(int i=0; i<nof_rnti; i++){
+				ngscope_target_rnti_remove(q, rnti[i]);
+			}
+			break;
+		default:
+			return -1;
+	}
+	return nof_rnti;
+}
+
+void ngscope_target_rnti_print(ngscope_target_rnti_t* q){
+	uint16_t rnti[MAX_TARGET_RNTI];
+	int nof_rnti = ngscope_target_rnti_get(q, rnti);
+	printf("target rnti (%d): ", nof_rnti);
+	for(int i=0; i<nof_rnti; i++){
+		printf("%d ", rnti[i]);
+	}
+	printf("\n");
+	return;
+}
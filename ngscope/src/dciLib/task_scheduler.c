@@ -23,145 +23,50 @@
 #include "ngscope/hdr/dciLib/thread_exit.h"
 #include "ngscope/hdr/dciLib/ue_tracker.h"
 #include "ngscope/hdr/dciLib/decode_sib.h"
+#include "ngscope/hdr/dciLib/mem_report.h"
+#include "ngscope/hdr/dciLib/sib_worker.h"
+#include "ngscope/hdr/dciLib/carrier.h"
 
 extern bool go_exit;
 
 extern pthread_mutex_t     cell_mutex; 
-extern srsran_cell_t       cell_vec[MAX_NOF_RF_DEV];
 
 extern dci_ready_t              dci_ready;
 extern ngscope_status_buffer_t  dci_buffer[MAX_DCI_BUFFER];
 
-extern bool dci_decoder_up[MAX_NOF_RF_DEV][MAX_NOF_DCI_DECODER];
-extern bool task_scheduler_up[MAX_NOF_RF_DEV];
-extern bool task_scheduler_closed[MAX_NOF_RF_DEV];
 extern pthread_mutex_t     scheduler_close_mutex;
 
-/******************* Global buffer for passing subframe IQ  ******************/ 
-ngscope_sf_buffer_t sf_buffer[MAX_NOF_RF_DEV][MAX_NOF_DCI_DECODER] = 
-{
-{
-    {false, 0, 0, {NULL}, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-    {false, 0, 0, {NULL}, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-    {false, 0, 0, {NULL}, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-    {false, 0, 0, {NULL}, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-},
-{
-    {false, 0, 0, {NULL}, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-    {false, 0, 0, {NULL}, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-    {false, 0, 0, {NULL}, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-    {false, 0, 0, {NULL}, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-},
-{
-    {false, 0, 0, {NULL}, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-    {false, 0, 0, {NULL}, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-    {false, 0, 0, {NULL}, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-    {false, 0, 0, {NULL}, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-},
-{
-    {false, 0, 0, {NULL}, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-    {false, 0, 0, {NULL}, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-    {false, 0, 0, {NULL}, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-    {false, 0, 0, {NULL}, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-}
-};
-bool                sf_token[MAX_NOF_RF_DEV][MAX_NOF_DCI_DECODER];
-
-pthread_mutex_t     token_mutex[MAX_NOF_RF_DEV] = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
-					 								PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER};
-
-pend_ack_list       ack_list;
-pthread_mutex_t     ack_mutex = PTHREAD_MUTEX_INITIALIZER;
-
-ngscope_ue_tracker_t ue_tracker[MAX_NOF_RF_DEV];
-pthread_mutex_t      ue_tracker_mutex[MAX_NOF_RF_DEV] = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
-					 								PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER};
-
-
-// This is the container for dci that are not allocated 
-task_skip_tti_t 	skip_tti[MAX_NOF_RF_DEV];
-
-task_tmp_buffer_t   task_tmp_buffer[MAX_NOF_RF_DEV];
-pthread_mutex_t     tmp_buf_mutex[MAX_NOF_RF_DEV] = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
-					 								PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER};
-
-int find_idle_decoder(int rf_idx, int nof_decoder){
+int find_idle_decoder(ngscope_carrier_t* carrier, int nof_decoder){
     int idle_idx = -1;
-    pthread_mutex_lock(&token_mutex[rf_idx]);
+    pthread_mutex_lock(&carrier->token_mutex);
     for(int i=0;i<nof_decoder;i++){
-        if(sf_token[rf_idx][i] == false){       
+        if(carrier->sf_token[i] == false){       
             idle_idx = i;
             // Set the token to true to mark that this decoder has been taken
             // Do remember to free the token 
-            sf_token[rf_idx][idle_idx] = true;
+            carrier->sf_token[idle_idx] = true;
             break;
         } 
     } 
-    pthread_mutex_unlock(&token_mutex[rf_idx]);
+    pthread_mutex_unlock(&carrier->token_mutex);
     return idle_idx;
 }
 /*****************************************************************************/
 
 
 /********************** callback wrapper **********************/ 
-int srsran_rf_recv_wrapper(void* h, cf_t* data_[SRSRAN_MAX_PORTS], uint32_t nsamples, srsran_timestamp_t* t)
-{
-  DEBUG(" ----  Receive %d samples  ----", nsamples);
-  void* ptr[SRSRAN_MAX_PORTS];
-  for (int i = 0; i < SRSRAN_MAX_PORTS; i++) {
-    ptr[i] = data_[i];
-  }
-  //return srsran_rf_recv_with_time_multi(h, ptr, nsamples, true, NULL, NULL);
-  return srsran_rf_recv_with_time_multi(h, ptr, nsamples, true, &t->full_secs, &t->frac_secs);
-}
-
+// The AGC handler is the stream handler of ue_sync, which is the rx ring
 static SRSRAN_AGC_CALLBACK(srsran_rf_set_rx_gain_th_wrapper_)
 {
-  srsran_rf_set_rx_gain_th((srsran_rf_t*)h, gain_db);
+  srsran_rf_set_rx_gain_th(((ngscope_rx_ring_t*)h)->rf, gain_db);
 }
 /******************** End of callback wrapper ********************/ 
 
-// Init MIB
-int mib_init_imp(srsran_ue_mib_t*   ue_mib,
-                    cf_t*           sf_buffer[SRSRAN_MAX_PORTS],
-                    srsran_cell_t*  cell)
-{
-    if (srsran_ue_mib_init(ue_mib, sf_buffer[0], cell->nof_prb)) {
-        ERROR("Error initaiting UE MIB decoder");
-        exit(-1);
-    }
-    if (srsran_ue_mib_set_cell(ue_mib, *cell)) {
-        ERROR("Error initaiting UE MIB decoder");
-        exit(-1);
-    }
-    return SRSRAN_SUCCESS;
-}
-
-int ue_mib_decode_sfn(srsran_ue_mib_t*   ue_mib,
-                        srsran_cell_t*   cell,
-                        uint32_t*        sfn,
-                        bool             decode_pdcch)
-{
-    uint8_t bch_payload[SRSRAN_BCH_PAYLOAD_LEN];
-    int     sfn_offset;
-    int n = srsran_ue_mib_decode(ue_mib, bch_payload, NULL, &sfn_offset);
-    if (n < 0) {
-      ERROR("Error decoding UE MIB");
-      exit(-1);
-    } else if (n == SRSRAN_UE_MIB_FOUND) {
-      srsran_pbch_mib_unpack(bch_payload, cell, sfn);
-      if(!decode_pdcch){
-          srsran_cell_fprint(stdout, cell, *sfn);
-          printf("Decoded MIB. SFN: %d, offset: %d\n", *sfn, sfn_offset);
-      }
-      *sfn   = (*sfn + sfn_offset) % 1024;
-    }
-    return SRSRAN_SUCCESS;
-}
-
 // Initialize UE sync
+// The samples are pulled from the rx ring instead of the radio
 int ue_sync_init_imp(srsran_ue_sync_t*      ue_sync,
                         srsran_rf_t*        rf, 
+                        ngscope_rx_ring_t*  rx_ring,
                         srsran_cell_t*      cell,
                         cell_search_cfg_t*  cell_detect_config,
                         prog_args_t         prog_args,
@@ -179,9 +84,9 @@ int ue_sync_init_imp(srsran_ue_sync_t*      ue_sync,
     if (srsran_ue_sync_init_multi_decim(ue_sync,
                                         cell->nof_prb,
                                         cell->id == 1000,
-                                        srsran_rf_recv_wrapper,
+                                        rx_ring_recv_wrapper,
                                         prog_args.rf_nof_rx_ant,
-                                        (void*)rf,
+                                        (void*)rx_ring,
                                         decimate)) {
       ERROR("Error initiating ue_sync");
       exit(-1);
@@ -212,13 +117,33 @@ int ue_sync_init_imp(srsran_ue_sync_t*      ue_sync,
     return SRSRAN_SUCCESS;
 }
 
+/* Replay of a control region capture: the cell and the antennas come from
+ * the capture, there is no radio, sync or MIB stage */
+static int task_scheduler_init_replay(ngscope_task_scheduler_t* task_scheduler){
+    prog_args_t* prog_args = &task_scheduler->prog_args;
+    if(ctrl_replay_open(&task_scheduler->ctrl_replay, prog_args->ctrl_replay)){
+        exit(-1);
+    }
+    ctrl_replay_cell(&task_scheduler->ctrl_replay, &task_scheduler->cell);
+    prog_args->rf_nof_rx_ant = task_scheduler->ctrl_replay.header.nof_rx_ant;
+    // only the control region is recorded, there is no PDSCH to decode the SIBs from
+    prog_args->decode_SIB    = false;
+
+    ngscope_carrier_t* carrier = ngscope_carrier(prog_args->rf_index);
+    pthread_mutex_lock(&cell_mutex); 
+    memcpy(&carrier->cell, &(task_scheduler->cell), sizeof(srsran_cell_t));
+    pthread_mutex_unlock(&cell_mutex); 
+
+    phich_state_init(&carrier->phich);
+    return SRSRAN_SUCCESS;
+}
+
 // Init the task scheduler 
 int task_scheduler_init(ngscope_task_scheduler_t* task_scheduler,
                             prog_args_t prog_args){
                             //srsran_rf_t* rf, 
                             //srsran_cell_t* cell, 
                             //srsran_ue_sync_t* ue_sync){
-    float search_cell_cfo = 0;
     task_scheduler->prog_args = prog_args;
 
     cell_search_cfg_t cell_detect_config = {.max_frames_pbch      = SRSRAN_DEFAULT_MAX_FRAMES_PBCH,
@@ -226,31 +151,100 @@ int task_scheduler_init(ngscope_task_scheduler_t* task_scheduler,
                                         .nof_valid_pss_frames = SRSRAN_DEFAULT_NOF_VALID_PSS_FRAMES,
                                         .init_agc             = 0,
                                         .force_tdd            = false};
+    task_scheduler->cell_detect_config  = cell_detect_config;
+    task_scheduler->search_cell_cfo     = 0;
    
     // Copy the prameters 
     task_scheduler->prog_args = prog_args;
+
+    if(prog_args.ctrl_replay != NULL){
+        return task_scheduler_init_replay(task_scheduler);
+    }
  
     // First of all, start the radio and get the cell information
     radio_init_and_start(&task_scheduler->rf, &task_scheduler->cell, prog_args, 
-                                                &cell_detect_config, &search_cell_cfo);
+                                &task_scheduler->cell_detect_config, &task_scheduler->search_cell_cfo);
            
-    // Copy the cell info to the  
+    // Copy the cell info to the carrier
+    ngscope_carrier_t* carrier = ngscope_carrier(prog_args.rf_index);
     pthread_mutex_lock(&cell_mutex); 
-    memcpy(&cell_vec[prog_args.rf_index], &(task_scheduler->cell), sizeof(srsran_cell_t));
-    printf("\n\nFinished copying to cell:%d prb:%d \n", prog_args.rf_index, cell_vec[prog_args.rf_index].nof_prb);
+    memcpy(&carrier->cell, &(task_scheduler->cell), sizeof(srsran_cell_t));
+    printf("\n\nFinished copying to cell:%d prb:%d \n", prog_args.rf_index, carrier->cell.nof_prb);
     pthread_mutex_unlock(&cell_mutex); 
 
+    // The RX stage buffers the radio samples for the sync stage
+    if(rx_ring_init(&task_scheduler->rx_ring, &task_scheduler->rf, prog_args.rf_index,
+                        prog_args.rf_nof_rx_ant, task_scheduler->cell.nof_prb)){
+        ERROR("Error initializing the rx ring");
+        exit(-1);
+    }
+
     // Next, let's get the ue_sync ready
-    ue_sync_init_imp(&task_scheduler->ue_sync, &task_scheduler->rf, &task_scheduler->cell, 
-                                          &cell_detect_config, prog_args, search_cell_cfo); 
+    ue_sync_init_imp(&task_scheduler->ue_sync, &task_scheduler->rf, &task_scheduler->rx_ring, &task_scheduler->cell, 
+                        &task_scheduler->cell_detect_config, prog_args, task_scheduler->search_cell_cfo); 
+
+    // The MIB stage verifies the SFN without blocking the sync stage
+    if(mib_sync_init(&task_scheduler->mib_sync, &task_scheduler->cell, prog_args.rf_index)){
+        ERROR("Error initializing the MIB decoder");
+        exit(-1);
+    }
 
-    pthread_mutex_lock(&ack_mutex); 
-    init_pending_ack(&ack_list);
-    pthread_mutex_unlock(&ack_mutex); 
+    if(supervisor_init(&task_scheduler->supervisor, prog_args.rf_index)){
+        ERROR("Error initializing the supervisor");
+        exit(-1);
+    }
+
+    // no UL grant is pending on a new cell
+    phich_state_init(&carrier->phich);
 
     return SRSRAN_SUCCESS;
 }
 
+/* Search the cell again after a sync loss. Only the RX and sync stages are
+ * restarted, the decoders, their buffers and the other carriers keep running.
+ * Returns true if the same cell is found again */
+static bool task_scheduler_research(ngscope_task_scheduler_t* q){
+    srsran_cell_t   cell;
+    float           cfo = 0;
+    bool            found = false;
+    prog_args_t     prog_args = q->prog_args;
+
+    // we look for the same cell only
+    prog_args.force_N_id_2 = q->cell.id % 3;
+
+    // the cell search owns the radio while it runs
+    rx_ring_stop(&q->rx_ring);
+    srsran_rf_stop_rx_stream(&q->rf);
+
+    int ret = radio_search_cell(&q->rf, &cell, prog_args, &q->cell_detect_config, &cfo);
+    if(ret < 0){
+        ERROR("RF:%d error searching for cell", prog_args.rf_index);
+    }else if(ret == 0){
+        printf("RF:%d cell %d not found\n", prog_args.rf_index, q->cell.id);
+    }else if(cell.id != q->cell.id || cell.nof_prb != q->cell.nof_prb){
+        // the buffers are sized for the old cell, this needs a restart
+        printf("RF:%d found cell id:%d prb:%d instead of id:%d prb:%d, please restart NG-Scope\n",
+                    prog_args.rf_index, cell.id, cell.nof_prb, q->cell.id, q->cell.nof_prb);
+    }else{
+        found = true;
+        q->search_cell_cfo = cfo;
+    }
+
+    // the search changes the sampling rate, go back to the one of our cell
+    srsran_rf_set_rx_srate(&q->rf, (double)srsran_sampling_freq_hz(q->cell.nof_prb));
+    srsran_rf_start_rx_stream(&q->rf, false);
+
+    // the buffered samples are from before the search
+    rx_ring_flush(&q->rx_ring);
+    rx_ring_start(&q->rx_ring);
+
+    srsran_ue_sync_reset(&q->ue_sync);
+    q->ue_sync.cfo_current_value = q->search_cell_cfo / 15000;
+    mib_sync_reset(&q->mib_sync);
+
+    return found;
+}
+
 void copy_sf_sync_buffer(cf_t* source[SRSRAN_MAX_PORTS],
                          cf_t* dest[SRSRAN_MAX_PORTS],
                          uint32_t max_num_samples)
@@ -262,84 +256,136 @@ void copy_sf_sync_buffer(cf_t* source[SRSRAN_MAX_PORTS],
 }
 
 /* Assign the decoding task to available idle decoder */
-void assign_task_to_decoder(int 	 rf_idx,
+void assign_task_to_decoder(ngscope_carrier_t* carrier,
 							int      idle_idx, 
                             uint32_t rf_nof_rx_ant,
                             uint32_t sf_idx, 
                             uint32_t sfn,
+                            int64_t  air_time_us,
                             uint32_t max_num_samples,
                             cf_t*    IQ_buffer[SRSRAN_MAX_PORTS])
 {
     //--> Lock sf buffer
-    pthread_mutex_lock(&sf_buffer[rf_idx][idle_idx].sf_mutex);
+    pthread_mutex_lock(&carrier->sf_buffer[idle_idx].sf_mutex);
 
     // Tell the scheduler that we now busy
-    pthread_mutex_lock(&token_mutex[rf_idx]);
-    sf_token[rf_idx][idle_idx] = true;
-    pthread_mutex_unlock(&token_mutex[rf_idx]);
+    pthread_mutex_lock(&carrier->token_mutex);
+    carrier->sf_token[idle_idx] = true;
+    pthread_mutex_unlock(&carrier->token_mutex);
 
     //printf("TTI:%d --> sfn:%d sf_idx:%d\n", sf_idx + sfn * 10, sfn, sf_idx);
-    sf_buffer[rf_idx][idle_idx].sf_idx  	= sf_idx;
-    sf_buffer[rf_idx][idle_idx].sfn     	= sfn;
-    sf_buffer[rf_idx][idle_idx].empty_sf    = false; // not empty subframe
+    carrier->sf_buffer[idle_idx].sf_idx  	= sf_idx;
+    carrier->sf_buffer[idle_idx].sfn     	= sfn;
+    carrier->sf_buffer[idle_idx].air_time_us = air_time_us;
+    carrier->sf_buffer[idle_idx].empty_sf    = false; // not empty subframe
 
     // copy the buffer source:sync_buffer dest: IQ_buffer
-    //copy_sf_sync_buffer(sync_buffer, sf_buffer[rf_idx][idle_idx].IQ_buffer, max_num_samples);
+    //copy_sf_sync_buffer(sync_buffer, carrier->sf_buffer[idle_idx].IQ_buffer, max_num_samples);
     for(int p=0; p<rf_nof_rx_ant; p++){
-        memcpy(sf_buffer[rf_idx][idle_idx].IQ_buffer[p], IQ_buffer[p], max_num_samples*sizeof(cf_t));
+        memcpy(carrier->sf_buffer[idle_idx].IQ_buffer[p], IQ_buffer[p], max_num_samples*sizeof(cf_t));
     }
 
     // Tell the corresponding idle thread to process the signal
     //printf("Send the conditional signal to the %d-th decoder!\n", idle_idx);
-    pthread_cond_signal(&sf_buffer[rf_idx][idle_idx].sf_cond);
+    pthread_cond_signal(&carrier->sf_buffer[idle_idx].sf_cond);
 
     //--> Unlock sf buffer
-    pthread_mutex_unlock(&sf_buffer[rf_idx][idle_idx].sf_mutex);
+    pthread_mutex_unlock(&carrier->sf_buffer[idle_idx].sf_mutex);
 
     return;
 }
 
 /* Assign the empty task to available idle decoder */
-void assign_empty_task_to_decoder(int 		 rf_idx,
+void assign_empty_task_to_decoder(ngscope_carrier_t* carrier,
 									int      idle_idx, 
 									uint32_t sf_idx, 
 									uint32_t sfn)
 {
     //--> Lock sf buffer
-    pthread_mutex_lock(&sf_buffer[rf_idx][idle_idx].sf_mutex);
+    pthread_mutex_lock(&carrier->sf_buffer[idle_idx].sf_mutex);
 
     // Tell the scheduler that we now busy
-    pthread_mutex_lock(&token_mutex[rf_idx]);
-    sf_token[rf_idx][idle_idx] = true;
-    pthread_mutex_unlock(&token_mutex[rf_idx]);
+    pthread_mutex_lock(&carrier->token_mutex);
+    carrier->sf_token[idle_idx] = true;
+    pthread_mutex_unlock(&carrier->token_mutex);
 
     //printf("TTI:%d --> sfn:%d sf_idx:%d\n", sf_idx + sfn * 10, sfn, sf_idx);
-    sf_buffer[rf_idx][idle_idx].sf_idx  	= sf_idx;
-    sf_buffer[rf_idx][idle_idx].sfn     	= sfn;
-    sf_buffer[rf_idx][idle_idx].empty_sf    = true; // not empty subframe
+    carrier->sf_buffer[idle_idx].sf_idx  	= sf_idx;
+    carrier->sf_buffer[idle_idx].sfn     	= sfn;
+    carrier->sf_buffer[idle_idx].air_time_us = 0;    // no samples, no air time
+    carrier->sf_buffer[idle_idx].empty_sf    = true; // not empty subframe
 
     // Tell the corresponding idle thread to process the signal
     //printf("Send the conditional signal to the %d-th decoder!\n", idle_idx);
-    pthread_cond_signal(&sf_buffer[rf_idx][idle_idx].sf_cond);
+    pthread_cond_signal(&carrier->sf_buffer[idle_idx].sf_cond);
 
     //--> Unlock sf buffer
-    pthread_mutex_unlock(&sf_buffer[rf_idx][idle_idx].sf_mutex);
+    pthread_mutex_unlock(&carrier->sf_buffer[idle_idx].sf_mutex);
 
     return;
 }
 
+/* Assign up to batch_max_sf subframes from the tmp buffer to one idle decoder
+ * The subframes are copied into the batch input of the decoder's ue_dl */
+int assign_batch_task_to_decoder(ngscope_carrier_t* carrier,
+								int      idle_idx, 
+								uint32_t rf_nof_rx_ant,
+								uint32_t sf_num_samples,
+								int      batch_max_sf)
+{
+    int nof_sf = 0;
+
+    //--> Lock sf buffer
+    pthread_mutex_lock(&carrier->sf_buffer[idle_idx].sf_mutex);
+
+    // Tell the scheduler that we now busy
+    pthread_mutex_lock(&carrier->token_mutex);
+    carrier->sf_token[idle_idx] = true;
+    pthread_mutex_unlock(&carrier->token_mutex);
+
+    while(nof_sf < batch_max_sf && !task_sf_ring_buffer_empty(&carrier->tmp_buffer)){
+        int tmp_buf_idx = carrier->tmp_buffer.tail;
+        task_tmp_sf_buffer_t* tmp_sf = &carrier->tmp_buffer.sf_buf[tmp_buf_idx];
+
+        carrier->sf_buffer[idle_idx].batch_sf_idx[nof_sf] = tmp_sf->sf_idx;
+        carrier->sf_buffer[idle_idx].batch_sfn[nof_sf]    = tmp_sf->sfn;
+        carrier->sf_buffer[idle_idx].batch_air_time_us[nof_sf] = tmp_sf->air_time_us;
+        for(int p=0; p<rf_nof_rx_ant; p++){
+            memcpy(carrier->sf_buffer[idle_idx].batch_IQ[nof_sf][p], tmp_sf->IQ_buffer[p], sf_num_samples*sizeof(cf_t));
+        }
+        nof_sf++;
+
+		// advance the tail 
+       	task_sf_ring_buffer_get(&carrier->tmp_buffer);
+    }
+    carrier->sf_buffer[idle_idx].nof_batch_sf = nof_sf;
+    carrier->sf_buffer[idle_idx].empty_sf     = false;
+
+    // Tell the corresponding idle thread to process the signal
+    pthread_cond_signal(&carrier->sf_buffer[idle_idx].sf_cond);
+
+    //--> Unlock sf buffer
+    pthread_mutex_unlock(&carrier->sf_buffer[idle_idx].sf_mutex);
+
+    return nof_sf;
+}
+
 typedef struct{
     int         nof_decoder;
     uint32_t    rf_nof_rx_ant;
     uint32_t    max_num_samples;
 	int 		rf_idx;
+    uint32_t    sf_num_samples; // samples of one subframe
+    ngscope_carrier_t* carrier;
+    int         batch_max_sf;   // 1: no batch
+    int         batch_threshold;
 }tmp_para_t;
 
-int  get_nof_buffered_sf(int rf_idx){
-	if(task_tmp_buffer[rf_idx].header !=  task_tmp_buffer[rf_idx].tail){
-		int idx = task_tmp_buffer[rf_idx].tail;
+int  get_nof_buffered_sf(ngscope_carrier_t* carrier){
+	if(carrier->tmp_buffer.header !=  carrier->tmp_buffer.tail){
+		int idx = carrier->tmp_buffer.tail;
 		int cnt = 0;
-		while(idx != task_tmp_buffer[rf_idx].header){
+		while(idx != carrier->tmp_buffer.header){
 			cnt++;
 			idx = (idx+1) % MAX_TMP_BUFFER;
 		}
@@ -353,66 +399,78 @@ void* handle_tmp_buffer_thread(void* p){
     uint32_t    rf_nof_rx_ant   = (*(tmp_para_t *)p).rf_nof_rx_ant;
     uint32_t    max_num_samples = (*(tmp_para_t *)p).max_num_samples;
     int         rf_idx     		= (*(tmp_para_t *)p).rf_idx;
+    uint32_t    sf_num_samples  = (*(tmp_para_t *)p).sf_num_samples;
+    ngscope_carrier_t* carrier  = (*(tmp_para_t *)p).carrier;
+    int         batch_max_sf    = (*(tmp_para_t *)p).batch_max_sf;
+    int         batch_threshold = (*(tmp_para_t *)p).batch_threshold;
 
     while(!go_exit){
         /* Before fetching we check if we have sf in tmp buffer*/ 
         /* we give higher priority to subframes stored inside the tmp buffer */
 
         //uint64_t t1 = timestamp_us();        
-        pthread_mutex_lock(&tmp_buf_mutex[rf_idx]);
-		if(!skip_tti_empty(&skip_tti[rf_idx])){
+        pthread_mutex_lock(&carrier->tmp_buf_mutex);
+		if(!skip_tti_empty(&carrier->skip_tti)){
 			while(!go_exit){
-				int idle_idx  =  find_idle_decoder(rf_idx, nof_decoder);
+				int idle_idx  =  find_idle_decoder(carrier, nof_decoder);
                 if(idle_idx < 0){ 
                     break;  
                 }else{
-					//printf("1-> len:%d sfn:%d sf_idx:%d \n",  skip_tti[rf_idx].nof_tti,\
-								skip_tti[rf_idx].sf[skip_tti[rf_idx].nof_tti-1], \
-								skip_tti[rf_idx].sf_idx[skip_tti[rf_idx].nof_tti-1]);
-					uint32_t tti 	= skip_tti_get(&skip_tti[rf_idx]);
+					//printf("1-> len:%d sfn:%d sf_idx:%d \n",  carrier->skip_tti.nof_tti,\
+								carrier->skip_tti.sf[carrier->skip_tti.nof_tti-1], \
+								carrier->skip_tti.sf_idx[carrier->skip_tti.nof_tti-1]);
+					uint32_t tti 	= skip_tti_get(&carrier->skip_tti);
 					uint32_t sfn 	= tti / 10;
 					uint32_t sf_idx = tti % 10;
-					//printf("2-> len:%d sfn:%d sf_idx:%d tti:%d\n",  skip_tti[rf_idx].nof_tti,\
+					//printf("2-> len:%d sfn:%d sf_idx:%d tti:%d\n",  carrier->skip_tti.nof_tti,\
 								sfn, sf_idx, tti);
-                    assign_empty_task_to_decoder(rf_idx, idle_idx, sf_idx, sfn);
-					//printf("after assignment skip tti:%d\n", skip_tti[rf_idx].nof_tti);
+                    assign_empty_task_to_decoder(carrier, idle_idx, sf_idx, sfn);
+					//printf("after assignment skip tti:%d\n", carrier->skip_tti.nof_tti);
                	}  
-				if(skip_tti_empty(&skip_tti[rf_idx])){
+				if(skip_tti_empty(&carrier->skip_tti)){
 					break;
 				}
 			}
 		}
 
-        if(!task_sf_ring_buffer_empty(&task_tmp_buffer[rf_idx])){
-			//int nof_buf_sf = get_nof_buffered_sf(rf_idx);
+        if(!task_sf_ring_buffer_empty(&carrier->tmp_buffer)){
+			//int nof_buf_sf = get_nof_buffered_sf(carrier);
             //printf("We have %d subframes the tmp buffer!\n", nof_buf_sf); 
             while(!go_exit){
-                int idle_idx  =  find_idle_decoder(rf_idx, nof_decoder);
+                int idle_idx  =  find_idle_decoder(carrier, nof_decoder);
                 if(idle_idx < 0){ 
                     break;  
+                }else if(batch_max_sf > 1 && task_sf_ring_buffer_len(&carrier->tmp_buffer) >= batch_threshold &&
+                            carrier->sf_buffer[idle_idx].batch_IQ[0][0] != NULL){
+                    // We are falling behind, let one decoder demodulate several subframes at once
+                    assign_batch_task_to_decoder(carrier, idle_idx, rf_nof_rx_ant, sf_num_samples, batch_max_sf);
+                    if(task_sf_ring_buffer_empty(&carrier->tmp_buffer)){
+                        break;
+                    }
                 }else{
                     // Assign the Task to the corresponding decoder
-                    int tmp_buf_idx = task_tmp_buffer[rf_idx].tail;
-                    int tmp_sf_idx  = task_tmp_buffer[rf_idx].sf_buf[tmp_buf_idx].sf_idx;
-                    int tmp_sfn     = task_tmp_buffer[rf_idx].sf_buf[tmp_buf_idx].sfn;
+                    int tmp_buf_idx = carrier->tmp_buffer.tail;
+                    int tmp_sf_idx  = carrier->tmp_buffer.sf_buf[tmp_buf_idx].sf_idx;
+                    int tmp_sfn     = carrier->tmp_buffer.sf_buf[tmp_buf_idx].sfn;
+                    int64_t tmp_air_time_us = carrier->tmp_buffer.sf_buf[tmp_buf_idx].air_time_us;
 
                     //printf("Assigning tti:%d to the %d-th decoder since it is idle!\n\n", \
                                                     tmp_sfn * 10 + tmp_sf_idx, idle_idx); 
-                    assign_task_to_decoder(rf_idx, idle_idx, rf_nof_rx_ant, tmp_sf_idx, tmp_sfn, max_num_samples,
-                             task_tmp_buffer[rf_idx].sf_buf[tmp_buf_idx].IQ_buffer);
+                    assign_task_to_decoder(carrier, idle_idx, rf_nof_rx_ant, tmp_sf_idx, tmp_sfn, tmp_air_time_us, max_num_samples,
+                             carrier->tmp_buffer.sf_buf[tmp_buf_idx].IQ_buffer);
 
 					// advance the tail 
-                   	task_sf_ring_buffer_get(&task_tmp_buffer[rf_idx]);
+                   	task_sf_ring_buffer_get(&carrier->tmp_buffer);
 
                     // Exit when the tmp buffer is empty
                     //if(task_tmp_buffer.header == task_tmp_buffer.tail){
-                    if(task_sf_ring_buffer_empty(&task_tmp_buffer[rf_idx])){
+                    if(task_sf_ring_buffer_empty(&carrier->tmp_buffer)){
                         break;
                     }
                 }
             }
         }
-        pthread_mutex_unlock(&tmp_buf_mutex[rf_idx]);
+        pthread_mutex_unlock(&carrier->tmp_buf_mutex);
         //uint64_t t2 = timestamp_us();        
         //printf("Handle tmp buffer time_spend:%ld (us)\n", t2-t1);
 
@@ -423,9 +481,69 @@ void* handle_tmp_buffer_thread(void* p){
     return NULL;
 }
 
+/* Hand the subframes of the capture to the decoders, as fast as they decode them.
+ * The REs are read straight into the control symbols of the idle decoder */
+static void task_scheduler_replay(ngscope_task_scheduler_t* q, ngscope_carrier_t* carrier, int nof_decoder){
+    ngscope_ctrl_replay_t* replay = &q->ctrl_replay;
+    uint32_t tti = 0;
+    int64_t  air_time_us = 0;
+    int      ret = 1;
+
+    while(!go_exit && ret > 0){
+        int idle_idx = find_idle_decoder(carrier, nof_decoder);
+        if(idle_idx < 0){
+            usleep(50);
+            continue;
+        }
+        ngscope_sf_buffer_t* sf_buf = &carrier->sf_buffer[idle_idx];
+        pthread_mutex_lock(&sf_buf->sf_mutex);
+        ret = ctrl_replay_read(replay, sf_buf->ctrl_RE, &tti, &air_time_us);
+        if(ret > 0){
+            sf_buf->sf_idx           = tti % 10;
+            sf_buf->sfn              = tti / 10;
+            sf_buf->air_time_us      = air_time_us;
+            sf_buf->empty_sf         = false;
+            sf_buf->nof_ctrl_symbols = replay->header.nof_symbols;
+            pthread_cond_signal(&sf_buf->sf_cond);
+        }else{
+            // nothing for the decoder, give the token back
+            pthread_mutex_lock(&carrier->token_mutex);
+            carrier->sf_token[idle_idx] = false;
+            pthread_mutex_unlock(&carrier->token_mutex);
+        }
+        pthread_mutex_unlock(&sf_buf->sf_mutex);
+    }
+    if(ret < 0){
+        ERROR("Error reading the ctrl capture");
+    }
+
+    // let the decoders finish the last subframes before we stop
+    for(int i=0; i<nof_decoder && !go_exit; i++){
+        while(!go_exit){
+            pthread_mutex_lock(&carrier->token_mutex);
+            bool busy = carrier->sf_token[i];
+            pthread_mutex_unlock(&carrier->token_mutex);
+            if(!busy){
+                break;
+            }
+            usleep(1000);
+        }
+    }
+    printf("RF:%d ctrl replay finished: %lu subframes, %lu dropped during the capture\n",
+                q->prog_args.rf_index, replay->nof_record, replay->nof_drop);
+    go_exit = true;
+    return;
+}
+
 void* task_scheduler_thread(void* p){
 
     prog_args_t* prog_args = (prog_args_t*)p;
+    ngscope_carrier_t* carrier = ngscope_carrier(prog_args->rf_index);
+
+    // the threads of the carrier (rx, sync, mib, decoders) inherit the cpu mask, 
+    // so that their buffers are allocated on the node of the carrier context
+    ngscope_numa_bind_thread(carrier->numa_node);
+
     ngscope_task_scheduler_t task_scheduler;
     task_scheduler_init(&task_scheduler, *prog_args);
 
@@ -435,6 +553,7 @@ void* task_scheduler_thread(void* p){
     int nof_decoder = task_scheduler.prog_args.nof_decoder;
     int rf_idx      = task_scheduler.prog_args.rf_index;
     uint32_t rf_nof_rx_ant = task_scheduler.prog_args.rf_nof_rx_ant;
+    bool     replay        = task_scheduler.prog_args.ctrl_replay != NULL;
     
 
     ngscope_dci_per_sub_t       dci_per_sub; // empty place hoder for skipped frames 
@@ -444,6 +563,7 @@ void* task_scheduler_thread(void* p){
     memset(&dci_ret, 0, sizeof(ngscope_status_buffer_t));
 
     uint32_t max_num_samples = 3 * SRSRAN_SF_LEN_PRB(task_scheduler.cell.nof_prb); /// Length in complex samples
+    uint32_t sf_len          = SRSRAN_SF_LEN_PRB(task_scheduler.cell.nof_prb);
     printf("nof_prb:%d max_sample:%d\n", task_scheduler.cell.nof_prb, max_num_samples);
 
     /************** Setting up the UE sync buffer ******************/
@@ -453,6 +573,7 @@ void* task_scheduler_thread(void* p){
     for (int j = 0; j < task_scheduler.prog_args.rf_nof_rx_ant; j++) {
         sync_buffer[j] = srsran_vec_cf_malloc(max_num_samples);
     }
+    ngscope_mem_report_add(NGSCOPE_MEM_IQ_BUFFER, (int64_t)rf_nof_rx_ant * max_num_samples * sizeof(cf_t));
 
     // Set the buffer for ue_sync
     for (int p = 0; p < SRSRAN_MAX_PORTS; p++) {
@@ -461,26 +582,54 @@ void* task_scheduler_thread(void* p){
     /************** END OF setting up the UE sync buffer ******************/
 
     // init the subframe buffer
-    ngscope_dci_decoder_t   dci_decoder[MAX_NOF_DCI_DECODER];
-    pthread_t               dci_thd[MAX_NOF_DCI_DECODER];
-
-    // Init the UE MIB decoder
-    srsran_ue_mib_t         ue_mib;    
-    mib_init_imp(&ue_mib, sync_buffer, &task_scheduler.cell);
+    ngscope_dci_decoder_t*  dci_decoder = (ngscope_dci_decoder_t*)calloc(nof_decoder, sizeof(ngscope_dci_decoder_t));
+    pthread_t*              dci_thd     = (pthread_t*)calloc(nof_decoder, sizeof(pthread_t));
+    if(dci_decoder == NULL || dci_thd == NULL){
+        ERROR("Error allocating %d decoders", nof_decoder);
+        exit(-1);
+    }
 
     /********************** Set up the tmp buffer **********************/
-	task_sf_ring_buffer_init(&task_tmp_buffer[rf_idx], max_num_samples);
-	skip_tti_init(&skip_tti[rf_idx]);
+	task_sf_ring_buffer_init(&carrier->tmp_buffer, rf_nof_rx_ant, max_num_samples);
+	skip_tti_init(&carrier->skip_tti);
     /********** End of setting up the tmp buffer **********************/
    
     // Start the tmp buffer handling thd
     // which allocates the buffered Subframe to corresponding decoder
     pthread_t tmp_buf_thd;
-    tmp_para_t tmp_para = {nof_decoder, rf_nof_rx_ant, max_num_samples, rf_idx};
+    tmp_para_t tmp_para = {nof_decoder, rf_nof_rx_ant, max_num_samples, rf_idx, 
+                            SRSRAN_SF_LEN_PRB(task_scheduler.cell.nof_prb), carrier,
+                            task_scheduler.prog_args.batch_max_sf, task_scheduler.prog_args.batch_threshold};
     pthread_create(&tmp_buf_thd, NULL, handle_tmp_buffer_thread, (void*)&tmp_para);
-		
-	//cell_args_t 		cell_args[MAX_NOF_DCI_DECODER];
 
+    // The control region of the synced subframes is recorded by its own writer thread
+    bool ctrl_capture = !replay && task_scheduler.prog_args.ctrl_capture != NULL;
+    if(ctrl_capture){
+        if(ctrl_capture_init(&task_scheduler.ctrl_capture, task_scheduler.prog_args.ctrl_capture, &task_scheduler.cell,
+                        rf_nof_rx_ant, task_scheduler.prog_args.ctrl_capture_bits, prog_args->rf_freq, rf_idx)){
+            ERROR("Error initializing the ctrl capture, continuing without it");
+            ctrl_capture = false;
+        }else if(ctrl_capture_start(&task_scheduler.ctrl_capture)){
+            ctrl_capture_free(&task_scheduler.ctrl_capture);
+            ctrl_capture = false;
+        }
+    }
+
+    // The last synced subframes are kept in a ring for a post-mortem dump
+    bool iq_snapshot = !replay && task_scheduler.prog_args.iq_snapshot_ms > 0;
+    if(iq_snapshot){
+        if(iq_snapshot_init(&carrier->iq_snapshot, task_scheduler.prog_args.iq_snapshot_path,
+                        task_scheduler.prog_args.iq_snapshot_ms, &task_scheduler.cell, rf_nof_rx_ant,
+                        prog_args->rf_freq, rf_idx, carrier->numa_node, task_scheduler.prog_args.iq_snapshot_skip,
+                        task_scheduler.prog_args.iq_snapshot_min_dci, &carrier->nof_dci_decoded)){
+            ERROR("Error initializing the IQ snapshot, continuing without it");
+            iq_snapshot = false;
+        }else if(iq_snapshot_start(&carrier->iq_snapshot)){
+            iq_snapshot_free(&carrier->iq_snapshot);
+            iq_snapshot = false;
+        }
+    }
+		
     /* Initialize ASN decoder */
     decoder = init_asn_decoder(prog_args->sib_logs, prog_args->rf_freq);
 	if(decoder == NULL) {
@@ -488,28 +637,77 @@ void* task_scheduler_thread(void* p){
 		return NULL;
 	}
 
-  	srsran_softbuffer_rx_t 	rx_softbuffers[SRSRAN_MAX_CODEWORDS];
+    // one worker (and pdsch decoder) for the SIBs of the cell, fed by all the decoders
+    ngscope_sib_worker_t sib_worker;
+    bool decode_SIB = task_scheduler.prog_args.decode_SIB;
+    if(decode_SIB){
+        if(ngscope_sib_worker_init(&sib_worker, task_scheduler.prog_args, &task_scheduler.cell, decoder)){
+            ERROR("Error initiating the SIB worker");
+            exit(-1);
+        }
+    }
+
+    ngscope_carrier_decoders_reset(carrier);
+
+    // the rnti table of the tracker grows with the observed ue
+    ngscope_ue_tracker_init(&carrier->ue_tracker);
 
     for(int i=0;i<nof_decoder;i++){
-        // init the subframe buffer 
-        for (int j = 0; j < SRSRAN_MAX_PORTS; j++) {
-            sf_buffer[rf_idx][i].IQ_buffer[j] = srsran_vec_cf_malloc(max_num_samples);
+        // init the subframe buffer, ue_dl only reads the antennas we receive from
+        for (int j = 0; j < rf_nof_rx_ant; j++) {
+            carrier->sf_buffer[i].IQ_buffer[j] = srsran_vec_cf_malloc(max_num_samples);
         }
+        ngscope_mem_report_add(NGSCOPE_MEM_IQ_BUFFER, (int64_t)rf_nof_rx_ant * max_num_samples * sizeof(cf_t));
 
 		dci_decoder_init(&dci_decoder[i], task_scheduler.prog_args, &task_scheduler.cell, \
-                           sf_buffer[rf_idx][i].IQ_buffer, rx_softbuffers, i, decoder);
+                           carrier->sf_buffer[i].IQ_buffer, decode_SIB ? &sib_worker : NULL, i, decoder);
 
-        //mib_init_imp(&ue_mib[i], sf_buffer[rf_idx][i].IQ_buffer, &task_scheduler->cell);
-        pthread_create( &dci_thd[i], NULL, dci_decoder_thread, (void*)&dci_decoder[i]);
+        // the batch of backlogged subframes is copied straight into the ue_dl batch input
+        for (int k = 0; k < task_scheduler.prog_args.batch_max_sf && k < DCI_BATCH_MAX_SF; k++) {
+            for (int j = 0; j < rf_nof_rx_ant; j++) {
+                carrier->sf_buffer[i].batch_IQ[k][j] = srsran_ue_dl_batch_input(&dci_decoder[i].ue_dl, k, j);
+            }
+        }
+        // and the replayed control region into its control symbols
+        for (int j = 0; j < rf_nof_rx_ant; j++) {
+            carrier->sf_buffer[i].ctrl_RE[j] = srsran_ue_dl_ctrl_symbols(&dci_decoder[i].ue_dl, j);
+        }
+
+        // The decoder is busy until it waits for its first subframe
+        pthread_mutex_lock(&carrier->token_mutex);
+        carrier->sf_token[i] = true;
+        pthread_mutex_unlock(&carrier->token_mutex);
+
+		// fill the dci decoder status, a decoder that fails to start clears it
+		carrier->decoder_up[i] = true;
 
-		// fill the dci decoder status
-		dci_decoder_up[rf_idx][i] = true;
+        //mib_init_imp(&ue_mib[i], carrier->sf_buffer[i].IQ_buffer, &task_scheduler->cell);
+        pthread_create( &dci_thd[i], NULL, dci_decoder_thread, (void*)&dci_decoder[i]);
     }
     
-    // Let's sleep for 1 second and wait for the decoder to be ready!
-    sleep(1);
+    // Wait for all the decoders to be ready. If one failed we close everything down
+    bool decoders_ok = ngscope_carrier_wait_decoders(carrier, nof_decoder) == SRSRAN_SUCCESS;
+    if(!decoders_ok){
+        go_exit = true;
+    }
+    char stage[32];
+    sprintf(stage, "RF-%d decoders up", rf_idx);
+    ngscope_mem_report_print(stdout, stage);
     //srsran_ue_mib_t ue_mib;    
-    //mib_init_imp(&ue_mib, sf_buffer[rf_idx][i].sf_buffer, cell);
+    //mib_init_imp(&ue_mib, carrier->sf_buffer[i].sf_buffer, cell);
+
+    // Start the pipeline: RX stage -> sync stage (this thread) -> decoders
+    //                                         \-> MIB stage
+    // or feed the decoders from the capture
+    if(decoders_ok && replay){
+        task_scheduler_replay(&task_scheduler, carrier, nof_decoder);
+    }else if(decoders_ok){
+        rx_ring_start(&task_scheduler.rx_ring);
+        mib_sync_start(&task_scheduler.mib_sync);
+    }
+
+    ngscope_stage_slack_t sync_slack;
+    stage_slack_init(&sync_slack, "SYNC", rf_idx, 1000);
 
     int         sf_cnt = 0; 
     uint32_t    sfn = 0;
@@ -528,40 +726,102 @@ void* task_scheduler_thread(void* p){
 
 	//uint64_t t1=0, t2=0, t3=0;
 	//uint64_t t1_sf_idx =0, t2_sf_idx=0;
-    while(!go_exit && (sf_cnt < task_scheduler.prog_args.nof_subframes || task_scheduler.prog_args.nof_subframes == -1)) {
+    while(!go_exit && !replay && (sf_cnt < task_scheduler.prog_args.nof_subframes || task_scheduler.prog_args.nof_subframes == -1)) {
     	//fprintf(fd, "%d\t%d\t%d\t%ld\t%ld\t\n", sfn*10+sf_idx, sfn, sf_idx, t2-t1, t3-t1);
 
     	/*  Get the subframe data and put it into the buffer */
-        //t1 = timestamp_us();        
-        ret = srsran_ue_sync_zerocopy(&(task_scheduler.ue_sync), buffers, max_num_samples);
+        // The slack of the sync stage excludes the time we wait for the RX stage
+        int64_t t_start = timestamp_us();
+        int64_t t_wait  = task_scheduler.rx_ring.wait_us;
+
+        // While the cell is tracked ue_sync receives one subframe per call, straight into the snapshot ring.
+        // Otherwise (or if the next slot is still being dumped) it uses the sync buffer
+        bool in_ring = false;
+        if(iq_snapshot){
+            iq_snapshot_poll(&carrier->iq_snapshot);
+            in_ring = decode_pdcch && task_scheduler.ue_sync.state == SF_TRACK &&
+                        iq_snapshot_next(&carrier->iq_snapshot, buffers);
+        }
+        if(!in_ring){
+            for (int p = 0; p < SRSRAN_MAX_PORTS; p++) {
+                buffers[p] = sync_buffer[p];
+            }
+        }
+
+        // The RX stage gave up on the radio: the supervisor restarts it with a cell search, after its backoff
+        if(rx_ring_failed(&task_scheduler.rx_ring)){
+            if(supervisor_rf_failed(&task_scheduler.supervisor) == SUPERVISOR_ACTION_RESEARCH){
+                bool found = task_scheduler_research(&task_scheduler);
+                supervisor_research_done(&task_scheduler.supervisor, found);
+                decode_pdcch = false;
+            }else{
+                usleep(10000);
+            }
+            continue;
+        }
+
+        ret = srsran_ue_sync_zerocopy(&(task_scheduler.ue_sync), buffers, in_ring ? carrier->iq_snapshot.slot_len : max_num_samples);
         //t2 = timestamp_us();        
         //printf("time_spend:%ld (us)\n", t2-t1);
         //printf("RET is:%d\n", ret); 
         if (ret < 0) {
             ERROR("Error calling srsran_ue_sync_work()");
-        }else if(ret == 1){
+        }
+        /********************* Sync supervision *********************/
+        // the MIB result is fetched here so that the supervisor sees the SFN corrections
+        int  sfn_delta  = 0;
+        bool mib_result = (ret == 1) && mib_sync_get_result(&task_scheduler.mib_sync, &sfn_delta);
+        bool sfn_locked = decode_pdcch || mib_result;
+        ngscope_supervisor_action_t action = supervisor_update(&task_scheduler.supervisor, ret == 1,
+                                    srsran_sync_get_peak_value(&task_scheduler.ue_sync.strack),
+                                    sfn_locked, mib_result && decode_pdcch && sfn_delta != 0);
+        if(action == SUPERVISOR_ACTION_RESYNC){
+            if(iq_snapshot){
+                iq_snapshot_trigger(&carrier->iq_snapshot, IQ_SNAPSHOT_SYNC_LOSS);
+            }
+            srsran_ue_sync_reset(&task_scheduler.ue_sync);
+            mib_sync_reset(&task_scheduler.mib_sync);
+            decode_pdcch = false;
+            continue;
+        }else if(action == SUPERVISOR_ACTION_RESEARCH){
+            bool found = task_scheduler_research(&task_scheduler);
+            supervisor_research_done(&task_scheduler.supervisor, found);
+            decode_pdcch = false;
+            continue;
+        }
+        /******************* END OF sync supervision *******************/
+        if(ret == 1){
         	//t1_sf_idx = timestamp_us();        
             sf_idx = srsran_ue_sync_get_sfidx(&task_scheduler.ue_sync);
         	//t2_sf_idx = timestamp_us();        
+            // The air time comes from the RF timestamp of the first sample of the subframe.
+            // Radios without a time source fall back to the time we got the subframe
+            srsran_timestamp_t rf_time;
+            srsran_ue_sync_get_last_timestamp(&task_scheduler.ue_sync, &rf_time);
+            int64_t air_time_us = rf_clock_to_wall_us(&task_scheduler.rx_ring.clock, &rf_time);
+            if(air_time_us == 0){
+                air_time_us = timestamp_us();
+            }
             //printf("Get %d-th subframe TTI:%d \n", sf_idx, sf_idx+ sfn*10);
 			//printf("task -> finish get index!\n");
             sf_cnt ++; 
 			//fprintf(fd_1, "%d\t%d\t%d\t", sf_idx + sfn*10, sf_idx, sfn);
             /********************* SFN handling *********************/
-            if ( (sf_idx == 0) || (decode_pdcch == false) ) {
-                // update SFN when sf_idx is 0 
-                uint32_t sfn_tmp = 0;
-                ue_mib_decode_sfn(&ue_mib, &task_scheduler.cell, &sfn_tmp, decode_pdcch);
-
+            // Apply the result of the MIB stage, if there is one
+            if(mib_result){
+                uint32_t sfn_tmp = (sfn + 1024 + sfn_delta) % 1024;
                 if(sfn != sfn_tmp){
                     printf("current sfn:%d decoded sfn:%d\n",sfn, sfn_tmp);
                 }
-                if(sfn_tmp > 0){
-                    //printf("decoded sfn from:%d\n",sfn_tmp);
-                    sfn = sfn_tmp;
-                    decode_pdcch = true;
+                if(!decode_pdcch){
+                    srsran_cell_fprint(stdout, &task_scheduler.cell, sfn_tmp);
                 }
-                //printf("\n");
+                sfn = sfn_tmp;
+                decode_pdcch = true;
+            }
+            // Hand subframe 0 to the MIB stage, it decides whether a verification is due
+            if(sf_idx == 0){
+                mib_sync_frame(&task_scheduler.mib_sync, buffers, sfn, decode_pdcch);
             }
             //printf("Get %d-th subframe TTI:%d \n", sf_idx, sf_idx+ sfn*10);
 			tti = sfn*10 + sf_idx;
@@ -576,10 +836,17 @@ void* task_scheduler_thread(void* p){
 					printf("Last tti:%d current tti:%d\n", last_tti, tti);
 				}
 				last_tti = tti;
+
+                if(ctrl_capture){
+                    ctrl_capture_subframe(&task_scheduler.ctrl_capture, buffers, tti, air_time_us);
+                }
+                if(in_ring){
+                    iq_snapshot_commit(&carrier->iq_snapshot, tti, air_time_us);
+                }
                 /** Now we need to know where shall we put the IQ data of each subframe*/
                 int idle_idx  = -1;
 
-                idle_idx  =  find_idle_decoder(rf_idx, nof_decoder);
+                idle_idx  =  find_idle_decoder(carrier, nof_decoder);
                 
                 // If we cannot find any idle decoder (all of them are busy!)
                 // store them inside a temporal buffer
@@ -587,19 +854,22 @@ void* task_scheduler_thread(void* p){
                     //printf("Skiping %d subframe since Decoder Blocked! \
                             We suggest increasing the number deocder per cell.\n", sfn*10 + sf_idx);
 
-                    pthread_mutex_lock(&tmp_buf_mutex[rf_idx]);
+                    pthread_mutex_lock(&carrier->tmp_buf_mutex);
                     /* Store the data into a tmp buffer. Later, when we have idle decoder, we will decode it*/ 
 					//printf("put %d subframe into the buffer\n", sfn*10+sf_idx);
-					if(task_sf_ring_buffer_put(&task_tmp_buffer[rf_idx], buffers, sfn, sf_idx, 
-								task_scheduler.prog_args.rf_nof_rx_ant, max_num_samples) == 0){
-						int nof_buf_sf = task_sf_ring_buffer_len(&task_tmp_buffer[rf_idx]);
-						printf("Skip %d subframe ring buf len:%d \n", sfn*10+sf_idx, nof_buf_sf);
-						skip_tti_put(&skip_tti[rf_idx], sfn, sf_idx);			
+					if(task_sf_ring_buffer_put(&carrier->tmp_buffer, buffers, sfn, sf_idx, air_time_us,
+								task_scheduler.prog_args.rf_nof_rx_ant, sf_len) == 0){
+						// reported with the dropped RX slots, at most once a second
+						rx_ring_skipped_sf(&task_scheduler.rx_ring, task_sf_ring_buffer_len(&carrier->tmp_buffer));
+						skip_tti_put(&carrier->skip_tti, sfn, sf_idx);			
+						if(iq_snapshot){
+							iq_snapshot_skipped(&carrier->iq_snapshot);
+						}
 					}
-					//int nof_buf_sf = get_nof_buffered_sf(rf_idx);
-					int nof_buf_sf = task_sf_ring_buffer_len(&task_tmp_buffer[rf_idx]);
-					fprintf(fd,"%d\t%d\t%d\n",task_tmp_buffer[rf_idx].header, task_tmp_buffer[rf_idx].tail, nof_buf_sf);
-                    pthread_mutex_unlock(&tmp_buf_mutex[rf_idx]);
+					//int nof_buf_sf = get_nof_buffered_sf(carrier);
+					int nof_buf_sf = task_sf_ring_buffer_len(&carrier->tmp_buffer);
+					fprintf(fd,"%d\t%d\t%d\n",carrier->tmp_buffer.header, carrier->tmp_buffer.tail, nof_buf_sf);
+                    pthread_mutex_unlock(&carrier->tmp_buf_mutex);
                     
                     if((sf_idx == 9)) {
                         sfn++;  // we increase the sfn incase MIB decoding failed
@@ -607,24 +877,28 @@ void* task_scheduler_thread(void* p){
                     }
 					//printf("task -> finish move signal to tmp buf!\n");
   					//t3 = timestamp_us();        
+                    stage_slack_update(&sync_slack, 1000 - (timestamp_us() - t_start - (task_scheduler.rx_ring.wait_us - t_wait)));
                     continue;
                 }else{
 					//printf("Directly Assign TTI: %d \n", sf_idx + sfn*10);
                     // Assign the task to the corresponding idle decoder 
-                    assign_task_to_decoder(rf_idx, idle_idx, rf_nof_rx_ant, \
-									sf_idx, sfn, max_num_samples, sync_buffer);
+                    // only the subframe is copied, the ring slots are not longer than that
+                    assign_task_to_decoder(carrier, idle_idx, rf_nof_rx_ant, \
+									sf_idx, sfn, air_time_us, sf_len, buffers);
                 }
             }
-           	pthread_mutex_lock(&tmp_buf_mutex[rf_idx]);
-			int nof_buf_sf = get_nof_buffered_sf(rf_idx);
-			fprintf(fd,"%d\t%d\t%d\n",task_tmp_buffer[rf_idx].header, task_tmp_buffer[rf_idx].tail, nof_buf_sf);
-           	pthread_mutex_unlock(&tmp_buf_mutex[rf_idx]);
+           	pthread_mutex_lock(&carrier->tmp_buf_mutex);
+			int nof_buf_sf = get_nof_buffered_sf(carrier);
+			fprintf(fd,"%d\t%d\t%d\n",carrier->tmp_buffer.header, carrier->tmp_buffer.tail, nof_buf_sf);
+           	pthread_mutex_unlock(&carrier->tmp_buf_mutex);
 
 			//printf("task -> end of while!\n");
             if((sf_idx == 9)) {
                 sfn++;  // we increase the sfn incase MIB decoding failed
                 if(sfn == 1024){ sfn = 0; }
             }// endof if(decode_pdcch)
+
+            stage_slack_update(&sync_slack, 1000 - (timestamp_us() - t_start - (task_scheduler.rx_ring.wait_us - t_wait)));
         }// end of i(ret)
   		//t3 = timestamp_us();        
         //printf("time_spend:%ld (us)\n", t2-t1);
@@ -634,6 +908,22 @@ void* task_scheduler_thread(void* p){
 	fclose(fd);
 	//fclose(fd_1);
 
+	// stop the RX and MIB stages
+	if(!replay){
+		rx_ring_stop(&task_scheduler.rx_ring);
+		mib_sync_stop(&task_scheduler.mib_sync);
+	}
+	// the queued subframes are still written
+	if(ctrl_capture){
+		ctrl_capture_stop(&task_scheduler.ctrl_capture);
+		ctrl_capture_free(&task_scheduler.ctrl_capture);
+	}
+	// a dump in progress is completed
+	if(iq_snapshot){
+		iq_snapshot_stop(&carrier->iq_snapshot);
+		iq_snapshot_free(&carrier->iq_snapshot);
+	}
+
 //--> Deal with the exit and free memory 
 
 	// wait until its our turn to close
@@ -641,14 +931,14 @@ void* task_scheduler_thread(void* p){
 
 	wait_for_scheduler_ready_to_close(rf_idx);
 
-	task_scheduler_up[rf_idx] = false;
+	carrier->scheduler_up = false;
 
     /* Wait for the decoder thread to finish*/
     for(int i=0;i<nof_decoder;i++){
         // Tell the decoder thread to exit in case 
         // they are still waiting for the signal
 		printf("Signling %d-th decoder!\n",i);
-        pthread_cond_signal(&sf_buffer[rf_idx][i].sf_cond);
+        pthread_cond_signal(&carrier->sf_buffer[i].sf_cond);
 	}
 
     for(int i=0;i<nof_decoder;i++){
@@ -658,27 +948,47 @@ void* task_scheduler_thread(void* p){
 	// free the ue dl and the related buffer
     for(int i=0;i<nof_decoder;i++){
         srsran_ue_dl_free(&dci_decoder[i].ue_dl);
+        memset(carrier->sf_buffer[i].batch_IQ, 0, sizeof(carrier->sf_buffer[i].batch_IQ));
         //free the buffer
         for(int j=0;  j < task_scheduler.prog_args.rf_nof_rx_ant; j++){
-            free(sf_buffer[rf_idx][i].IQ_buffer[j]);
+            free(carrier->sf_buffer[i].IQ_buffer[j]);
+            carrier->sf_buffer[i].IQ_buffer[j] = NULL;
         }
+        ngscope_mem_report_add(NGSCOPE_MEM_IQ_BUFFER, -(int64_t)rf_nof_rx_ant * max_num_samples * sizeof(cf_t));
     } 
+    free(dci_decoder);
+    free(dci_thd);
+    if(decode_SIB){
+        ngscope_sib_worker_free(&sib_worker);
+    }
+    pthread_mutex_lock(&carrier->ue_tracker_mutex);
+    ngscope_ue_tracker_free(&carrier->ue_tracker);
+    pthread_mutex_unlock(&carrier->ue_tracker_mutex);
         
-    srsran_ue_mib_free(&ue_mib);
-
-    // free the ue_sync
-    srsran_ue_sync_free(&task_scheduler.ue_sync);
+    if(replay){
+        ctrl_replay_close(&task_scheduler.ctrl_replay);
+    }else{
+        mib_sync_free(&task_scheduler.mib_sync);
+        supervisor_free(&task_scheduler.supervisor);
+
+        // free the ue_sync
+        srsran_ue_sync_free(&task_scheduler.ue_sync);
+    }
 
     for(int j=0; j<task_scheduler.prog_args.rf_nof_rx_ant; j++){
         free(sync_buffer[j]);
     }
+    ngscope_mem_report_add(NGSCOPE_MEM_IQ_BUFFER, -(int64_t)rf_nof_rx_ant * max_num_samples * sizeof(cf_t));
 
-    radio_stop(&task_scheduler.rf);
+    if(!replay){
+        radio_stop(&task_scheduler.rf);
+        rx_ring_free(&task_scheduler.rx_ring);
+    }
 
 	// close the tmp buffer handling thread
     pthread_join(tmp_buf_thd, NULL);
 
-	task_sf_ring_buffer_free(&task_tmp_buffer[rf_idx]);
+	task_sf_ring_buffer_free(&carrier->tmp_buffer);
 //
 //    for(int i=0; i<MAX_TMP_BUFFER; i++){
 //        for (int j = 0; j < SRSRAN_MAX_PORTS; j++) {
@@ -687,7 +997,7 @@ void* task_scheduler_thread(void* p){
 //    }
 // 
     pthread_mutex_lock(&scheduler_close_mutex);
-	task_scheduler_closed[rf_idx] = true;
+	carrier->scheduler_closed = true;
     pthread_mutex_unlock(&scheduler_close_mutex);
 
     printf("TASK-Scheduler of %d-th RF devices CLOSED!\n", rf_idx);
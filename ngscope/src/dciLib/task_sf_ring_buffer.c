@@ -12,29 +12,35 @@
 #include <stdint.h>
 
 #include "ngscope/hdr/dciLib/task_sf_ring_buffer.h"
+#include "ngscope/hdr/dciLib/mem_report.h"
 
-int task_sf_ring_buffer_init(task_tmp_buffer_t* q, int max_num_samples){
+int task_sf_ring_buffer_init(task_tmp_buffer_t* q, int nof_rx_ant, int max_num_samples){
 	/********************** Set up the tmp buffer **********************/
     q->header  	= 0;
     q->tail     = 0;
     q->len 		= 0;
 	q->full 	= false;
+	q->nof_rx_ant 		= nof_rx_ant;
+	q->max_num_samples 	= max_num_samples;
     //task_tmp_buffer.nof_buf  = 0;
     // init the buffer
     for(int i=0; i<MAX_TMP_BUFFER; i++){
-        for (int j = 0; j < SRSRAN_MAX_PORTS; j++) {
+        for (int j = 0; j < nof_rx_ant; j++) {
             q->sf_buf[i].IQ_buffer[j] = srsran_vec_cf_malloc(max_num_samples);
         }
     }
+	ngscope_mem_report_add(NGSCOPE_MEM_IQ_BUFFER, (int64_t)MAX_TMP_BUFFER * nof_rx_ant * max_num_samples * sizeof(cf_t));
 	return 0;
 }
 
 int task_sf_ring_buffer_free(task_tmp_buffer_t* q){
     for(int i=0; i<MAX_TMP_BUFFER; i++){
-        for (int j = 0; j < SRSRAN_MAX_PORTS; j++) {
+        for (int j = 0; j < q->nof_rx_ant; j++) {
             free(q->sf_buf[i].IQ_buffer[j]);
+            q->sf_buf[i].IQ_buffer[j] = NULL;
         }
     }
+	ngscope_mem_report_add(NGSCOPE_MEM_IQ_BUFFER, -(int64_t)MAX_TMP_BUFFER * q->nof_rx_ant * q->max_num_samples * sizeof(cf_t));
 	return 0; 
 }
 
@@ -42,6 +48,7 @@ int task_sf_ring_buffer_put(task_tmp_buffer_t* q,
 							cf_t* buffers[SRSRAN_MAX_CHANNELS],
 							uint32_t sfn, 
 							uint32_t sf_idx,
+							int64_t air_time_us,
 							int rf_nof_rx_ant,
 							int max_num_samples)
 {
@@ -53,6 +60,7 @@ int task_sf_ring_buffer_put(task_tmp_buffer_t* q,
 	//printf("Nof buffer:%d %d\n", task_tmp_buffer.header, task_tmp_buffer.nof_buf);
 	q->sf_buf[q->header].sf_idx   = sf_idx;
 	q->sf_buf[q->header].sfn      = sfn;
+	q->sf_buf[q->header].air_time_us = air_time_us;
 	for(int p=0; p<rf_nof_rx_ant; p++){
 		memcpy(q->sf_buf[q->header].IQ_buffer[p], 
 								buffers[p], max_num_samples*sizeof(cf_t));
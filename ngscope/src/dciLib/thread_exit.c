@@ -13,11 +13,8 @@
 
 
 #include "ngscope/hdr/dciLib/thread_exit.h"
-extern bool dci_decoder_up[MAX_NOF_RF_DEV][MAX_NOF_DCI_DECODER];
-extern bool task_scheduler_up[MAX_NOF_RF_DEV];
+#include "ngscope/hdr/dciLib/carrier.h"
 
-//bool dci_decoder_closed[MAX_NOF_RF_DEV][MAX_NOF_DCI_DECODER] = {{true}};
-extern bool task_scheduler_closed[MAX_NOF_RF_DEV];
 extern pthread_mutex_t     scheduler_close_mutex;
 
 bool wait_for_ALL_RF_DEV_close(){
@@ -25,8 +22,8 @@ bool wait_for_ALL_RF_DEV_close(){
 		bool ret = true;
 		// wait until the task schedulers of all RF devs are closed
     	pthread_mutex_lock(&scheduler_close_mutex);
-		for(int i=0; i<MAX_NOF_RF_DEV; i++){
-			if(task_scheduler_closed[i]==false){
+		for(int i=0; i<ngscope_nof_carrier(); i++){
+			if(ngscope_carrier(i)->scheduler_closed == false){
 				ret = false;
 			}
 		}
@@ -43,8 +40,8 @@ bool wait_for_scheduler_ready_to_close(int rf_idx){
 	while(!ret){
 		ret = true;
     	pthread_mutex_lock(&scheduler_close_mutex);
-		for(int i=rf_idx+1; i<MAX_NOF_RF_DEV; i++){
-			if(task_scheduler_closed[i] == false){
+		for(int i=rf_idx+1; i<ngscope_nof_carrier(); i++){
+			if(ngscope_carrier(i)->scheduler_closed == false){
 				ret = false;
 			}
 		}
@@ -56,14 +53,15 @@ bool wait_for_scheduler_ready_to_close(int rf_idx){
 
 
 bool wait_for_decoder_ready_to_close(int  rf_idx, int  decoder_idx){
+	ngscope_carrier_t* carrier = ngscope_carrier(rf_idx);
 	bool ret = false;
 	while(!ret){
 		ret = true;
 		// the task scheduler must be ready to close
-		if(task_scheduler_up[rf_idx] == false){
+		if(carrier->scheduler_up == false){
 			// its our turn to close to dci decoder
-			for(int i=decoder_idx+1; i<MAX_NOF_DCI_DECODER; i++){
-				if(dci_decoder_up[rf_idx][i] == true){
+			for(int i=decoder_idx+1; i<carrier->nof_decoder; i++){
+				if(carrier->decoder_up[i] == true){
 					ret = false;
 				}
 			}
@@ -0,0 +1,105 @@
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <stdint.h>
+
+#include "ngscope/hdr/dciLib/tti_reorder.h"
+#include "ngscope/hdr/dciLib/ngscope_util.h"
+
+int tti_reorder_init(ngscope_tti_reorder_t* q, int buf_size, uint32_t max_latency){
+    memset(q, 0, sizeof(ngscope_tti_reorder_t));
+    if(buf_size <= 0 || MAX_TTI % buf_size != 0 || max_latency >= (uint32_t)buf_size){
+        printf("ERROR: tti reorder buffer of %d slots with a latency of %d subframes\n", buf_size, max_latency);
+        return -1;
+    }
+    q->buf_size     = buf_size;
+    q->max_latency  = max_latency;
+    q->filled       = (bool*)calloc(buf_size, sizeof(bool));
+    if(q->filled == NULL){
+        printf("ERROR: fail to allocate the tti reorder buffer!\n");
+        return -1;
+    }
+    return 0;
+}
+
+void tti_reorder_free(ngscope_tti_reorder_t* q){
+    free(q->filled);
+    q->filled = NULL;
+}
+
+void tti_reorder_reset(ngscope_tti_reorder_t* q){
+    memset(q->filled, 0, q->buf_size * sizeof(bool));
+    q->started = false;
+}
+
+int tti_reorder_put(ngscope_tti_reorder_t* q, uint32_t tti){
+    tti = tti % MAX_TTI;
+    if(!q->started){
+        q->started      = true;
+        q->next_tti     = tti;
+        q->newest_tti   = tti;
+    }
+    int d = tti_offset(tti, q->next_tti);
+    if(d < 0){
+        q->nof_late++;
+        return TTI_REORDER_LATE;
+    }
+    if(d >= q->buf_size){
+        q->nof_jump++;
+        return TTI_REORDER_JUMP;
+    }
+    if(tti_offset(tti, q->newest_tti) > 0){
+        q->newest_tti = tti;
+    }
+    int slot = tti % q->buf_size;
+    q->filled[slot] = true;
+    return slot;
+}
+
+uint32_t tti_reorder_frontier(ngscope_tti_reorder_t* q){
+    uint32_t tti = q->next_tti;
+    if(!q->started){
+        return tti;
+    }
+    // only the few pending TTIs are visited, not the whole ring
+    while(tti_offset(q->newest_tti, tti) >= 0){
+        if(!q->filled[tti % q->buf_size] && tti_offset(q->newest_tti, tti) < (int)q->max_latency){
+            break;
+        }
+        tti = (tti + 1) % MAX_TTI;
+    }
+    return tti;
+}
+
+uint32_t tti_reorder_end(ngscope_tti_reorder_t* q){
+    if(!q->started){
+        return q->next_tti;
+    }
+    return (q->newest_tti + 1) % MAX_TTI;
+}
+
+int tti_reorder_pop(ngscope_tti_reorder_t* q, uint32_t limit, uint32_t* tti, int* slot){
+    if(!q->started || tti_offset(limit, q->next_tti) <= 0){
+        return TTI_REORDER_NONE;
+    }
+    *tti  = q->next_tti;
+    *slot = q->next_tti % q->buf_size;
+
+    int ret = q->filled[*slot] ? TTI_REORDER_DATA : TTI_REORDER_GAP;
+    if(ret == TTI_REORDER_DATA){
+        q->nof_data++;
+    }else{
+        q->nof_gap++;
+    }
+    q->filled[*slot] = false;
+    q->next_tti      = (q->next_tti + 1) % MAX_TTI;
+    return ret;
+}
@@ -14,30 +14,47 @@
 
 #include "ngscope/hdr/dciLib/ue_list.h"
 
+void ngscope_ue_list_init(ngscope_ue_list_t* q){
+    ngscope_rnti_table_init(&q->ue, NGSCOPE_MEM_UE_LIST);
+    q->max_freq_ue      = 0;
+    q->max_dl_freq_ue   = 0;
+    q->max_ul_freq_ue   = 0;
+    q->nof_active_ue    = 0;
+    return;
+}
+
+void ngscope_ue_list_free(ngscope_ue_list_t* q){
+    ngscope_rnti_table_free(&q->ue);
+    return;
+}
+
 void enqueue_ue_list_per_rnti(ngscope_ue_list_t* q, uint32_t tti, uint16_t rnti, bool dl){
-    if(q->ue_cnt[rnti] == 0){
-        q->ue_enter_time[rnti] = tti;
+    ngscope_rnti_entry_t* ue = ngscope_rnti_table_insert(&q->ue, rnti);
+    if(ue == NULL){
+        return;
+    }
+    if(ue->cnt == 0){
+        ue->enter_time = tti;
     }    
-    q->ue_cnt[rnti]++;
-    q->ue_last_active[rnti] = tti; 
+    ue->cnt++;
+    ue->last_active = tti; 
     if(dl){
-        q->ue_dl_cnt[rnti]++;
+        ue->dl_cnt++;
     }else{
-        q->ue_ul_cnt[rnti]++;
+        ue->ul_cnt++;
     }
     return;
 }
 
-void ngscope_ue_list_enqueue_rnti_per_sf_per_cell(ngscope_ue_list_t q[MAX_NOF_RF_DEV], ngscope_status_buffer_t* dci_buf){
+void ngscope_ue_list_enqueue_rnti_per_sf(ngscope_ue_list_t* q, ngscope_status_buffer_t* dci_buf){
 
-	int cell_idx = dci_buf->cell_idx;	
 	for(int j=0; j<dci_buf->dci_per_sub.nof_dl_dci; j++){
-		enqueue_ue_list_per_rnti(&(q[cell_idx]), dci_buf->tti, \
+		enqueue_ue_list_per_rnti(q, dci_buf->tti, \
 				dci_buf->dci_per_sub.dl_msg[j].rnti, true);
 	}
 
 	for(int j=0; j<dci_buf->dci_per_sub.nof_ul_dci; j++){
-		enqueue_ue_list_per_rnti(&(q[cell_idx]), dci_buf->tti, \
+		enqueue_ue_list_per_rnti(q, dci_buf->tti, \
 				dci_buf->dci_per_sub.ul_msg[j].rnti, false);
 	}
 	
@@ -50,18 +67,22 @@ void find_max_freq_ue(ngscope_ue_list_t* q){
     int max_cnt = 0, idx = 0; 
     int max_dl_cnt =0, dl_idx = 0;
     int max_ul_cnt =0, ul_idx = 0;
-    for(int i=10; i<65524; i++){
-        if(q->ue_cnt[i] > max_cnt){
-            max_cnt = q->ue_cnt[i];
-            idx     = i;
+    for(uint32_t i=0; i<q->ue.size; i++){
+        ngscope_rnti_entry_t* ue = &q->ue.entry[i];
+        if(!ue->used || ue->rnti < 10 || ue->rnti >= 65524){
+            continue;
+        }
+        if(ue->cnt > max_cnt){
+            max_cnt = ue->cnt;
+            idx     = ue->rnti;
         } 
-        if(q->ue_dl_cnt[i] > max_dl_cnt){
-            max_dl_cnt = q->ue_dl_cnt[i];
-            dl_idx     = i;
+        if(ue->dl_cnt > max_dl_cnt){
+            max_dl_cnt = ue->dl_cnt;
+            dl_idx     = ue->rnti;
         }
-        if(q->ue_ul_cnt[i] > max_ul_cnt){
-            max_ul_cnt = q->ue_ul_cnt[i];
-            ul_idx     = i;
+        if(ue->ul_cnt > max_ul_cnt){
+            max_ul_cnt = ue->ul_cnt;
+            ul_idx     = ue->rnti;
         }
     }
     q->max_freq_ue = idx;
@@ -70,16 +91,22 @@ void find_max_freq_ue(ngscope_ue_list_t* q){
     return;
 }
 
+static uint32_t ue_cnt(ngscope_ue_list_t* q, uint16_t rnti, int dir){
+    ngscope_rnti_entry_t* ue = ngscope_rnti_table_find(&q->ue, rnti);
+    if(ue == NULL){
+        return 0;
+    }
+    return dir == 0 ? ue->cnt : (dir == 1 ? ue->dl_cnt : ue->ul_cnt);
+}
+
 int ngscope_ue_list_print_ue_freq(ngscope_ue_list_t* q){
 	// find the max frequency ue in the ue list
 	find_max_freq_ue(q);
 
 	// print the max frequency ue in the ue list
     printf("High Freq UE: DL rnti:%d freq:%d | UL rnti:%d freq:%d | Total rnti:%d freq: %d\n",
-        q->max_dl_freq_ue, q->ue_dl_cnt[q->max_dl_freq_ue], 
-        q->max_ul_freq_ue, q->ue_ul_cnt[q->max_ul_freq_ue], 
-        q->max_freq_ue, q->ue_cnt[q->max_freq_ue]);
+        q->max_dl_freq_ue, ue_cnt(q, q->max_dl_freq_ue, 1), 
+        q->max_ul_freq_ue, ue_cnt(q, q->max_ul_freq_ue, 2), 
+        q->max_freq_ue, ue_cnt(q, q->max_freq_ue, 0));
     return 0;
 }
-
-
@@ -0,0 +1,424 @@
+#include "ngscope/hdr/dciLib/ue_stats.h"
+#include "ngscope/hdr/dciLib/mem_report.h"
+#include "srsran/adt/accumulators.h"
+
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#define UE_STATS_NOF_DL_HARQ 16 // 8 in FDD, up to 15 in TDD
+#define UE_STATS_NOF_UL_HARQ 8  // FDD, the UL HARQ process is synchronous: tti % 8
+#define UE_STATS_NOF_FRAME (MAX_TTI / UE_STATS_BUCKET_SF)
+
+namespace {
+
+// Counters of one radio frame
+struct frame_bucket_t {
+  uint32_t dl_bits      = 0;
+  uint32_t ul_bits      = 0;
+  uint32_t dl_reTx_bits = 0;
+  uint32_t ul_reTx_bits = 0;
+  uint16_t dl_prb       = 0;
+  uint16_t ul_prb       = 0;
+  uint16_t dl_nof_tb    = 0;
+  uint16_t ul_nof_tb    = 0;
+  uint16_t dl_nof_reTx  = 0;
+  uint16_t ul_nof_reTx  = 0;
+  uint16_t nof_dci      = 0;
+  uint16_t dl_mcs_hist[UE_STATS_MCS_BINS] = {};
+  uint16_t ul_mcs_hist[UE_STATS_MCS_BINS] = {};
+};
+
+// Sums of the frames inside the window
+struct window_sum_t {
+  uint64_t dl_bits      = 0;
+  uint64_t ul_bits      = 0;
+  uint64_t dl_reTx_bits = 0;
+  uint64_t ul_reTx_bits = 0;
+  uint32_t dl_prb       = 0;
+  uint32_t ul_prb       = 0;
+  uint32_t dl_nof_tb    = 0;
+  uint32_t ul_nof_tb    = 0;
+  uint32_t dl_nof_reTx  = 0;
+  uint32_t ul_nof_reTx  = 0;
+  uint32_t nof_dci      = 0;
+  uint32_t dl_mcs_hist[UE_STATS_MCS_BINS] = {};
+  uint32_t ul_mcs_hist[UE_STATS_MCS_BINS] = {};
+
+  // sign: 1 when the frame enters the window, -1 when it leaves
+  void add(const frame_bucket_t& b, int sign)
+  {
+    dl_bits += sign * (int64_t)b.dl_bits;
+    ul_bits += sign * (int64_t)b.ul_bits;
+    dl_reTx_bits += sign * (int64_t)b.dl_reTx_bits;
+    ul_reTx_bits += sign * (int64_t)b.ul_reTx_bits;
+    dl_prb += sign * b.dl_prb;
+    ul_prb += sign * b.ul_prb;
+    dl_nof_tb += sign * b.dl_nof_tb;
+    ul_nof_tb += sign * b.ul_nof_tb;
+    dl_nof_reTx += sign * b.dl_nof_reTx;
+    ul_nof_reTx += sign * b.ul_nof_reTx;
+    nof_dci += sign * b.nof_dci;
+    for (int i = 0; i < UE_STATS_MCS_BINS; i++) {
+      dl_mcs_hist[i] += sign * b.dl_mcs_hist[i];
+      ul_mcs_hist[i] += sign * b.ul_mcs_hist[i];
+    }
+  }
+};
+
+struct harq_state_t {
+  int      ndi = -1; // -1: no DCI of the process seen yet
+  uint32_t tbs = 0;
+};
+
+/* A window of frames with its sum. The sum follows each push in O(1): the
+ * frame that leaves the window is subtracted, the new one is added */
+template <typename B, typename S>
+struct frame_window_t {
+  explicit frame_window_t(uint32_t nof_frame) : frames(nof_frame, B()) {}
+
+  void close_frame()
+  {
+    sum.add(frames.oldest(), -1);
+    sum.add(cur, 1);
+    frames.push(cur);
+    cur = B();
+  }
+
+  srsran::detail::sliding_window<B> frames;
+  S                                 sum; // of the closed frames inside the window
+  B                                 cur; // the radio frame in progress
+};
+
+struct cell_bucket_t {
+  uint32_t dl_prb = 0;
+  uint32_t ul_prb = 0;
+  uint32_t nof_sf = 0; // decoded subframes, without the gaps
+};
+
+struct cell_sum_t {
+  uint32_t dl_prb = 0;
+  uint32_t ul_prb = 0;
+  uint32_t nof_sf = 0;
+
+  void add(const cell_bucket_t& b, int sign)
+  {
+    dl_prb += sign * b.dl_prb;
+    ul_prb += sign * b.ul_prb;
+    nof_sf += sign * b.nof_sf;
+  }
+};
+
+struct ue_state_t {
+  explicit ue_state_t(uint32_t nof_frame) : window(nof_frame) {}
+
+  frame_window_t<frame_bucket_t, window_sum_t> window;
+  harq_state_t                                 dl_harq[UE_STATS_NOF_DL_HARQ][SRSRAN_MAX_CODEWORDS];
+  harq_state_t                                 ul_harq[UE_STATS_NOF_UL_HARQ];
+};
+
+uint32_t mcs_bin(uint32_t mcs)
+{
+  return std::min<uint32_t>(mcs / 4, UE_STATS_MCS_BINS - 1);
+}
+
+float share(uint32_t prb, uint32_t capacity)
+{
+  return capacity > 0 ? (float)prb / capacity : 0;
+}
+
+} // namespace
+
+struct ngscope_ue_stats_s {
+  ngscope_ue_stats_s(int cell_idx_, uint32_t nof_prb_, bool tdd_, uint32_t nof_frame_) :
+    cell_idx(cell_idx_), nof_prb(nof_prb_), tdd(tdd_), nof_frame(nof_frame_), cell(nof_frame_)
+  {}
+
+  int      cell_idx;
+  uint32_t nof_prb;
+  bool     tdd;
+  uint32_t nof_frame; // frames of the window
+
+  bool     started     = false;
+  uint32_t frame       = 0; // radio frame in progress, tti / 10
+  uint32_t nof_closed  = 0; // closed frames inside the window
+  bool     new_frame   = false;
+  uint16_t last_tti    = 0;
+  uint64_t last_air_us = 0;
+
+  frame_window_t<cell_bucket_t, cell_sum_t>  cell;
+  std::unordered_map<uint16_t, ue_state_t> ue;
+};
+
+static size_t ue_state_mem(ngscope_ue_stats_t* q)
+{
+  return sizeof(ue_state_t) + q->nof_frame * sizeof(frame_bucket_t);
+}
+
+static ue_state_t& find_ue(ngscope_ue_stats_t* q, uint16_t rnti)
+{
+  auto it = q->ue.find(rnti);
+  if (it == q->ue.end()) {
+    it = q->ue.emplace(rnti, ue_state_t(q->nof_frame)).first;
+    ngscope_mem_report_add(NGSCOPE_MEM_UE_STATS, ue_state_mem(q));
+  }
+  return it->second;
+}
+
+/* Close the frames up to the new one. A UE without DCI inside the window is
+ * removed, all its sums are zero */
+static void advance_frame(ngscope_ue_stats_t* q, uint32_t frame)
+{
+  uint32_t nof_new = (frame + UE_STATS_NOF_FRAME - q->frame) % UE_STATS_NOF_FRAME;
+  if (nof_new == 0 || nof_new > UE_STATS_NOF_FRAME / 2) {
+    // same frame, or an older one: the subframes come in TTI order, only a resync moves backward
+    return;
+  }
+  // after a whole window every frame is empty
+  uint32_t nof_push = std::min(nof_new, q->nof_frame);
+  for (uint32_t i = 0; i < nof_push; i++) {
+    q->cell.close_frame();
+    for (auto& it : q->ue) {
+      it.second.window.close_frame();
+    }
+  }
+  for (auto it = q->ue.begin(); it != q->ue.end();) {
+    if (it->second.window.sum.nof_dci == 0 && it->second.window.cur.nof_dci == 0) {
+      it = q->ue.erase(it);
+      ngscope_mem_report_add(NGSCOPE_MEM_UE_STATS, -(int64_t)ue_state_mem(q));
+    } else {
+      ++it;
+    }
+  }
+  q->frame      = frame;
+  q->nof_closed = std::min(q->nof_closed + nof_new, q->nof_frame);
+  q->new_frame  = true;
+}
+
+static void ue_stats_dl(ue_state_t& ue, const ngscope_dci_msg_t& msg)
+{
+  frame_bucket_t& b = ue.window.cur;
+  b.nof_dci++;
+  b.dl_prb += msg.prb;
+
+  uint32_t pid = msg.harq % UE_STATS_NOF_DL_HARQ;
+  for (int i = 0; i < msg.nof_tb && i < SRSRAN_MAX_CODEWORDS; i++) {
+    const ngscope_dci_tb_t& tb = msg.tb[i];
+    harq_state_t&           h  = ue.dl_harq[pid][i];
+
+    // the NDI toggles for a new transport block, without history only the RV tells
+    bool new_tb = (h.ndi < 0) ? (tb.rv == 0) : ((int)tb.ndi != h.ndi);
+    h.ndi       = tb.ndi;
+    if (new_tb) {
+      if (tb.tbs == 0) {
+        continue;
+      }
+      h.tbs = tb.tbs;
+      b.dl_bits += tb.tbs;
+      b.dl_nof_tb++;
+      b.dl_mcs_hist[mcs_bin(tb.mcs)]++;
+    } else {
+      // the MCS 29-31 of a retransmission only carry the RV, the size is the one of the first transmission
+      b.dl_reTx_bits += tb.tbs > 0 ? tb.tbs : h.tbs;
+      b.dl_nof_reTx++;
+    }
+  }
+}
+
+static void ue_stats_ul(ngscope_ue_stats_t* q, ue_state_t& ue, const ngscope_dci_msg_t& msg, uint16_t tti)
+{
+  frame_bucket_t& b = ue.window.cur;
+  b.nof_dci++;
+  b.ul_prb += msg.prb;
+
+  const ngscope_dci_tb_t& tb = msg.tb[0];
+  harq_state_t*           h  = q->tdd ? NULL : &ue.ul_harq[tti % UE_STATS_NOF_UL_HARQ];
+
+  // a NACK on the PHICH is inserted as a DCI with RV 4, see ngscope_enqueue_ul_reTx_dci_msg
+  bool phich_nack = tb.rv > 3;
+  bool new_tb;
+  if (phich_nack) {
+    new_tb = false;
+  } else if (h == NULL || h->ndi < 0) {
+    // TDD: the process of a grant depends on the UL/DL configuration, the RV tells the retransmissions
+    new_tb = tb.rv == 0;
+  } else {
+    new_tb = (int)tb.ndi != h->ndi;
+  }
+  if (h != NULL && !phich_nack) {
+    h->ndi = tb.ndi;
+  }
+
+  if (new_tb) {
+    if (tb.tbs == 0) {
+      return;
+    }
+    if (h != NULL) {
+      h->tbs = tb.tbs;
+    }
+    b.ul_bits += tb.tbs;
+    b.ul_nof_tb++;
+    b.ul_mcs_hist[mcs_bin(tb.mcs)]++;
+  } else {
+    uint32_t tbs = tb.tbs;
+    if (tbs == 0 && h != NULL) {
+      tbs = h->tbs;
+    }
+    b.ul_reTx_bits += tbs;
+    b.ul_nof_reTx++;
+  }
+}
+
+ngscope_ue_stats_t* ngscope_ue_stats_create(int cell_idx, uint32_t nof_prb, bool tdd, int window_ms)
+{
+  if (window_ms < UE_STATS_MIN_WINDOW || window_ms > UE_STATS_MAX_WINDOW) {
+    printf("ue stats: window of %d ms out of range, using %d ms\n", window_ms, UE_STATS_DEFAULT_WINDOW);
+    window_ms = UE_STATS_DEFAULT_WINDOW;
+  }
+  uint32_t nof_frame = window_ms / UE_STATS_BUCKET_SF;
+  return new ngscope_ue_stats_s(cell_idx, nof_prb, tdd, nof_frame);
+}
+
+void ngscope_ue_stats_free(ngscope_ue_stats_t* q)
+{
+  if (q == NULL) {
+    return;
+  }
+  ngscope_mem_report_add(NGSCOPE_MEM_UE_STATS, -(int64_t)(q->ue.size() * ue_state_mem(q)));
+  delete q;
+}
+
+void ngscope_ue_stats_reset(ngscope_ue_stats_t* q)
+{
+  ngscope_mem_report_add(NGSCOPE_MEM_UE_STATS, -(int64_t)(q->ue.size() * ue_state_mem(q)));
+  q->ue.clear();
+  q->cell        = frame_window_t<cell_bucket_t, cell_sum_t>(q->nof_frame);
+  q->started     = false;
+  q->nof_closed  = 0;
+  q->new_frame   = false;
+  q->last_air_us = 0;
+}
+
+void ngscope_ue_stats_push_sf(ngscope_ue_stats_t* q, sf_status_t* sf)
+{
+  uint32_t frame = sf->tti / UE_STATS_BUCKET_SF;
+  if (!q->started) {
+    q->started = true;
+    q->frame   = frame;
+  } else {
+    advance_frame(q, frame);
+  }
+  q->last_tti = sf->tti;
+  if (sf->gap) {
+    return;
+  }
+  if (sf->timestamp_us > 0) {
+    q->last_air_us = sf->timestamp_us;
+  }
+
+  cell_bucket_t& cell = q->cell.cur;
+  cell.nof_sf++;
+  for (int i = 0; i < sf->nof_dl_msg && i < MAX_DCI_PER_SUB; i++) {
+    cell.dl_prb += sf->dl_msg[i].prb;
+    ue_stats_dl(find_ue(q, sf->dl_msg[i].rnti), sf->dl_msg[i]);
+  }
+  for (int i = 0; i < sf->nof_ul_msg && i < MAX_DCI_PER_SUB; i++) {
+    cell.ul_prb += sf->ul_msg[i].prb;
+    ue_stats_ul(q, find_ue(q, sf->ul_msg[i].rnti), sf->ul_msg[i], sf->tti);
+  }
+}
+
+bool ngscope_ue_stats_publish(ngscope_ue_stats_t* q, ngscope_ue_stats_report_t* report)
+{
+  if (!q->new_frame) {
+    return false;
+  }
+  q->new_frame = false;
+
+  const cell_sum_t& cell     = q->cell.sum;
+  uint32_t          capacity = q->nof_prb * cell.nof_sf;
+  uint32_t          window   = q->nof_closed * UE_STATS_BUCKET_SF;
+
+  ue_stats_header_t header = {};
+  header.cell_idx          = q->cell_idx;
+  header.tti               = q->last_tti;
+  header.time_stamp        = q->last_air_us;
+  header.window_ms         = window;
+  header.nof_sf            = cell.nof_sf;
+  header.nof_prb           = q->nof_prb;
+  header.cell_dl_prb_share = share(cell.dl_prb, capacity);
+  header.cell_ul_prb_share = share(cell.ul_prb, capacity);
+
+  // the UEs with the most traffic
+  std::vector<std::pair<uint64_t, uint16_t> > order;
+  order.reserve(q->ue.size());
+  for (auto& it : q->ue) {
+    const window_sum_t& s = it.second.window.sum;
+    if (s.nof_dci > 0) {
+      order.emplace_back(s.dl_bits + s.ul_bits + s.dl_reTx_bits + s.ul_reTx_bits, it.first);
+    }
+  }
+  size_t nof_ue = std::min<size_t>(order.size(), UE_STATS_MAX_UE);
+  std::partial_sort(order.begin(), order.begin() + nof_ue, order.end(), std::greater<std::pair<uint64_t, uint16_t> >());
+
+  ue_stats_t ue[UE_STATS_MAX_UE];
+  for (size_t i = 0; i < nof_ue; i++) {
+    const window_sum_t& s = q->ue.at(order[i].second).window.sum;
+    ue_stats_t&         u = ue[i];
+    u.rnti                = order[i].second;
+    u.dl_bits             = s.dl_bits;
+    u.ul_bits             = s.ul_bits;
+    u.dl_reTx_bits        = s.dl_reTx_bits;
+    u.ul_reTx_bits        = s.ul_reTx_bits;
+    // bits per ms are kbit/s
+    u.dl_kbps      = window > 0 ? (float)s.dl_bits / window : 0;
+    u.ul_kbps      = window > 0 ? (float)s.ul_bits / window : 0;
+    u.dl_nof_tb    = s.dl_nof_tb;
+    u.ul_nof_tb    = s.ul_nof_tb;
+    u.dl_nof_reTx  = s.dl_nof_reTx;
+    u.ul_nof_reTx  = s.ul_nof_reTx;
+    u.dl_prb_share = share(s.dl_prb, capacity);
+    u.ul_prb_share = share(s.ul_prb, capacity);
+    memcpy(u.dl_mcs_hist, s.dl_mcs_hist, sizeof(u.dl_mcs_hist));
+    memcpy(u.ul_mcs_hist, s.ul_mcs_hist, sizeof(u.ul_mcs_hist));
+  }
+  header.nof_ue = nof_ue;
+
+  pthread_mutex_lock(&report->mutex);
+  report->header = header;
+  memcpy(report->ue, ue, nof_ue * sizeof(ue_stats_t));
+  report->valid = true;
+  pthread_mutex_unlock(&report->mutex);
+  return true;
+}
+
+void ngscope_ue_stats_report_init(ngscope_ue_stats_report_t* report)
+{
+  report->valid = false;
+  memset(&report->header, 0, sizeof(ue_stats_header_t));
+  pthread_mutex_init(&report->mutex, NULL);
+}
+
+int ngscope_ue_stats_report_get(ngscope_ue_stats_report_t* report,
+                                uint16_t                   rnti,
+                                ue_stats_header_t*         header,
+                                ue_stats_t                 ue[UE_STATS_MAX_UE])
+{
+  pthread_mutex_lock(&report->mutex);
+  if (!report->valid) {
+    pthread_mutex_unlock(&report->mutex);
+    return -1;
+  }
+  *header    = report->header;
+  int nof_ue = 0;
+  for (int i = 0; i < report->header.nof_ue; i++) {
+    if (rnti == 0 || report->ue[i].rnti == rnti) {
+      ue[nof_ue++] = report->ue[i];
+    }
+  }
+  pthread_mutex_unlock(&report->mutex);
+
+  header->nof_ue = nof_ue;
+  return nof_ue;
+}
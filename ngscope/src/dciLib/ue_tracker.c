@@ -15,14 +15,8 @@
 
 // inti the structure
 void ngscope_ue_tracker_init(ngscope_ue_tracker_t* q){
-	for(int i=0; i<65535; i++){
-		q->active_ue_list[i] 	= false;
-		q->ue_cnt[i] 			= 0;
-		q->ue_dl_cnt[i] 		= 0;
-		q->ue_ul_cnt[i] 		= 0;
-		q->ue_last_active[i] 	= 0;
-		q->ue_enter_time[i] 	= 0;
-	}
+	// the rnti table allocates its slots when the first ue is observed
+	ngscope_rnti_table_init(&q->ue, NGSCOPE_MEM_UE_TRACKER);
 	for(int i=0; i<TOPN; i++){
 		q->top_N_ue_rnti[i] 	= 0;
 		q->top_N_ue_freq[i] 	= 0;
@@ -34,14 +28,26 @@ void ngscope_ue_tracker_init(ngscope_ue_tracker_t* q){
 
 	return;
 }
+
+void ngscope_ue_tracker_free(ngscope_ue_tracker_t* q){
+	ngscope_rnti_table_free(&q->ue);
+	return;
+}
+
+bool ngscope_ue_tracker_is_active(ngscope_ue_tracker_t* q, uint16_t rnti){
+	ngscope_rnti_entry_t* ue = ngscope_rnti_table_find(&q->ue, rnti);
+	return (ue != NULL) && ue->active;
+}
+
 int find_top_n_ue(ngscope_ue_tracker_t* q, int top_n){
 	int max_i = 0;
 	uint32_t max_v = 0;
 	uint32_t max_freq 	= q->top_N_ue_freq[top_n-1];
-	for(int i=0; i<=65535; i++){
-		if( (q->ue_cnt[i] < max_freq) && (q->ue_cnt[i] > max_v) && (q->active_ue_list[i]) ){
-			max_i = i;
-			max_v = q->ue_cnt[i];
+	for(uint32_t i=0; i<q->ue.size; i++){
+		ngscope_rnti_entry_t* ue = &q->ue.entry[i];
+		if( ue->used && (ue->cnt < max_freq) && (ue->cnt > max_v) && (ue->active) ){
+			max_i = ue->rnti;
+			max_v = ue->cnt;
 		}
 	}
 	return max_i;
@@ -49,13 +55,8 @@ int find_top_n_ue(ngscope_ue_tracker_t* q, int top_n){
 
 void remove_ue_from_list(ngscope_ue_tracker_t* q, uint16_t rnti){
 	//printf("remove %d from the list!\n", rnti);
-	q->ue_cnt[rnti] 		= 0;
-	q->ue_last_active[rnti] = 0;
-	q->ue_enter_time[rnti] 	= 0;
-    q->ue_dl_cnt[rnti] 		= 0;
-    q->ue_ul_cnt[rnti] 		= 0;
+	ngscope_rnti_table_remove(&q->ue, rnti);
 
-	q->active_ue_list[rnti] = false;
 	// remove the ue from topN
 	for(int i=0; i<TOPN; i++){
 		if(q->top_N_ue_rnti[i] == rnti){
@@ -71,7 +72,7 @@ void remove_ue_from_list(ngscope_ue_tracker_t* q, uint16_t rnti){
 
 			if(index > 0){
 				q->top_N_ue_rnti[TOPN-1] = (uint16_t)index;
-				q->top_N_ue_freq[TOPN-1] = q->ue_cnt[index];
+				q->top_N_ue_freq[TOPN-1] = ngscope_rnti_table_find(&q->ue, index)->cnt;
 			}
 
 			break;
@@ -82,8 +83,9 @@ void remove_ue_from_list(ngscope_ue_tracker_t* q, uint16_t rnti){
 
 // NOTE: TOP-N array ue freq is always sorted 
 // when we insert the rnti, we want to check whether we find top 20 most frequently observed rnti 
-bool update_ue_tracker_topN(ngscope_ue_tracker_t* q, uint16_t rnti){
-	uint32_t ue_cnt = q->ue_cnt[rnti];
+bool update_ue_tracker_topN(ngscope_ue_tracker_t* q, ngscope_rnti_entry_t* ue){
+	uint16_t rnti 	= ue->rnti;
+	uint32_t ue_cnt = ue->cnt;
 	bool ret = false;
 	int idx = -1;
 	// check if the rnti is in top N or not
@@ -111,7 +113,7 @@ bool update_ue_tracker_topN(ngscope_ue_tracker_t* q, uint16_t rnti){
 	// if rnti is not inside TOPN and now we need to delete one in the array
 	// (only happen if we found that the RNTI is active  
 	else{
-		if(q->active_ue_list[rnti]){
+		if(ue->active){
 			// shift the array and insert new rnti
 			for(int i=0; i<TOPN; i++){
 				if(q->top_N_ue_freq[i] < ue_cnt){
@@ -134,25 +136,26 @@ bool update_ue_tracker_topN(ngscope_ue_tracker_t* q, uint16_t rnti){
 
 int kick_inactive_ue(ngscope_ue_tracker_t* q, uint32_t tti){
 	int active_ue = 0;
-	for(int i=0; i<=65535; i++){
-		if(q->active_ue_list[i] && q->ue_cnt[i]){
-			int t_diff = tti_difference(q->ue_last_active[i], tti);
-			// if the active ue is inactive for INACTIVE_UE_THD_T ms 
-			if(t_diff >= ACTIVE_UE_THD_T){
-				remove_ue_from_list(q, i);
-			}
-		}else{
-			if(q->ue_cnt[i]){
-				int t_diff = tti_difference(q->ue_last_active[i], tti);
-				// if the non-active ue hasn't been observed for 500 ms 
-				if(t_diff >= INACTIVE_UE_THD_T){
-					remove_ue_from_list(q, i);
-				}
+	uint32_t i = 0;
+	while(i < q->ue.size){
+		ngscope_rnti_entry_t* ue = &q->ue.entry[i];
+		if(ue->used){
+			// active ue are kept for ACTIVE_UE_THD_T ms,
+			// non-active ue are removed if they haven't been observed for 500 ms 
+			int thd 	= ue->active ? ACTIVE_UE_THD_T : INACTIVE_UE_THD_T;
+			int t_diff 	= tti_difference(ue->last_active, tti);
+			if(t_diff >= thd){
+				remove_ue_from_list(q, ue->rnti);
+				// the removal may shift another entry into this slot
+				continue;
 			}
 		}
+		i++;
+	}
 
-		// just for statistics
-		if(q->active_ue_list[i]){
+	// just for statistics
+	for(i=0; i<q->ue.size; i++){
+		if(q->ue.entry[i].used && q->ue.entry[i].active){
 			active_ue++;
 		}
 	}
@@ -160,32 +163,36 @@ int kick_inactive_ue(ngscope_ue_tracker_t* q, uint32_t tti){
 }
 
 void ngscope_ue_tracker_enqueue_ue_rnti(ngscope_ue_tracker_t* q, uint32_t tti, uint16_t rnti, bool dl){
+	ngscope_rnti_entry_t* ue = ngscope_rnti_table_insert(&q->ue, rnti);
+	if(ue == NULL){
+		return;
+	}
 	// if the ue is not active before
-    if(q->ue_cnt[rnti] == 0){
-        q->ue_enter_time[rnti] = tti;
+    if(ue->cnt == 0){
+        ue->enter_time = tti;
     }    
-    q->ue_cnt[rnti]++;
+    ue->cnt++;
     if(dl){
-        q->ue_dl_cnt[rnti]++;
+        ue->dl_cnt++;
     }else{
-        q->ue_ul_cnt[rnti]++;
+        ue->ul_cnt++;
     }
 
 	// judge whether this ue is active or not
-	if(tti_difference(q->ue_last_active[rnti], tti) < ACTIVE_TTI_T || 
-			q->ue_cnt[rnti] > ACTIVE_UE_CNT_THD){
-		q->active_ue_list[rnti] = true;
-		//printf("tti:%d found active UE: cnt:%d \n", tti, q->ue_cnt[rnti]);
+	if(tti_difference(ue->last_active, tti) < ACTIVE_TTI_T || 
+			ue->cnt > ACTIVE_UE_CNT_THD){
+		ue->active = true;
+		//printf("tti:%d found active UE: cnt:%d \n", tti, ue->cnt);
 	}
 		
 	// then we update its last active tti
-    q->ue_last_active[rnti] = tti; 
+    ue->last_active = tti; 
 
 	// check whether we need to update the top N
 	bool updated; 
-	updated = update_ue_tracker_topN(q, rnti);
+	updated = update_ue_tracker_topN(q, ue);
 
-	//printf("TTI:%d enqueue rnti:%d is active:%d ue_cnt:%d updated inside the TopN:%d\n", tti, rnti, q->active_ue_list[rnti], q->ue_cnt[rnti], updated);
+	//printf("TTI:%d enqueue rnti:%d is active:%d ue_cnt:%d updated inside the TopN:%d\n", tti, rnti, ue->active, ue->cnt, updated);
     return;
 }
 
@@ -18,6 +18,7 @@
 #include "ngscope/hdr/dciLib/load_config.h"
 #include "ngscope/hdr/dciLib/ngscope_main.h"
 #include "ngscope/hdr/dciLib/asn_decoder.h"
+#include "ngscope/hdr/dciLib/mem_report.h"
 
 #define DEFAULT_SIB_OUTPUT "decoded_sibs"
 #define DEFAULT_DCI_OUTPUT "dci_output"
@@ -42,6 +43,8 @@ void print_help()
   printf("  -c <Config File>\t\t[Mandatory] NG-Scope configuration file.\n");
   printf("  -s <SIB Output File>\t\t[Optional] Ouput file where the decoded SIB messages will be stored.\n");
   printf("  -o <DCI Output Folder>\t[Optional] Ouput folder where DCI logs will be stored.\n");
+  printf("  --prewarm\t\t\t[Optional] Build the FFTW wisdom for all LTE bandwidths (exits if no -c is given).\n");
+  printf("  --mem-report\t\t\t[Optional] Print the memory of each subsystem at start-up.\n");
   printf("  -h\t\t\t\t[Optional] Show this menu.\n");
 }
 
@@ -52,10 +55,23 @@ int main(int argc, char** argv){
     char * config_path = NULL;
     char * sib_path = NULL;
     char * out_path = NULL;
+    bool prewarm = false;
+
+    static struct option long_options[] = {
+      {"prewarm", no_argument, 0, 'w'},
+      {"mem-report", no_argument, 0, 'm'},
+      {0, 0, 0, 0}
+    };
 
     /* Parsing command line arguments */
-    while ((c = getopt (argc, argv, "c:s:o:h")) != -1) {
+    while ((c = getopt_long (argc, argv, "c:s:o:h", long_options, NULL)) != -1) {
       switch (c) {
+        case 'w':
+          prewarm = true;
+          break;
+        case 'm':
+          ngscope_mem_report_enable(true);
+          break;
         case 'c':
           config_path = optarg;
           break;
@@ -84,6 +100,17 @@ int main(int argc, char** argv){
           return 1;
         }
     }
+    /* Build the FFTW wisdom before any decoder is started, for the antennas the carriers are started with */
+    if(prewarm) {
+      prog_args_t prog_args;
+      args_default(&prog_args);
+      if(ngscope_prewarm_fftw(prog_args) != SRSRAN_SUCCESS) {
+        fprintf (stderr, "Error building the FFTW wisdom\n");
+        return 1;
+      }
+      if(config_path == NULL)
+        return 0;
+    }
     /* Check that the config file has been provided */
     if(config_path == NULL) {
       print_help();